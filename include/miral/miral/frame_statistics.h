@@ -0,0 +1,91 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIRAL_FRAME_STATISTICS_H
+#define MIRAL_FRAME_STATISTICS_H
+
+#include <mir/geometry/rectangle.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace mir { class Server; }
+
+namespace miral
+{
+/// Access to the compositor's per-output frame timings.
+///
+/// These are collected whichever --compositor-report is selected, so they are suitable for
+/// monitoring a production server.
+/// \remark Since MirAL 3.9
+class FrameStatistics
+{
+public:
+    FrameStatistics();
+    ~FrameStatistics();
+    FrameStatistics(FrameStatistics const&);
+    auto operator=(FrameStatistics const&) -> FrameStatistics&;
+
+    void operator()(mir::Server& server) const;
+
+    /// A histogram of durations
+    struct Histogram
+    {
+        /// The inclusive upper limit of each bucket. The last bucket is unbounded, and has a limit
+        /// of std::chrono::microseconds::max().
+        std::vector<std::chrono::microseconds> bucket_limits;
+        /// The number of samples in each bucket
+        std::vector<uint64_t> counts;
+
+        uint64_t count;
+        std::chrono::microseconds total;
+        std::chrono::microseconds max;
+    };
+
+    struct Output
+    {
+        mir::geometry::Rectangle area;
+
+        uint64_t frames;
+        /// Frames put on screen without GL compositing (by bypass or overlay planes)
+        uint64_t bypassed_frames;
+        /// Refresh periods (estimated from frame_interval) in which the output had a frame pending but
+        /// did not receive one
+        uint64_t missed_vblanks;
+
+        /// From the start of a frame until it is rendered (GL-composited frames only)
+        Histogram render_time;
+        /// From rendering (or, for bypassed frames, the start of the frame) until it has been posted
+        Histogram post_time;
+        /// From the scene changing until the frame showing it is started
+        Histogram scene_change_to_composite;
+        /// Between the ends of consecutive frames, when the compositor did not idle in between
+        Histogram frame_interval;
+    };
+
+    /// Statistics for each output since the compositor was last started (or reconfigured).
+    /// This is empty until the server has started.
+    auto outputs() const -> std::vector<Output>;
+
+private:
+    struct Self;
+    std::shared_ptr<Self> self;
+};
+}
+
+#endif //MIRAL_FRAME_STATISTICS_H
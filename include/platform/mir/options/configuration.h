@@ -46,6 +46,11 @@ extern char const* const wayland_extensions_opt;
 extern char const* const add_wayland_extensions_opt;
 extern char const* const drop_wayland_extensions_opt;
 extern char const* const idle_timeout_opt;
+extern char const* const timer_wheel_alarms_opt;
+extern char const* const main_loop_opt;
+extern char const* const gl_program_cache_opt;
+extern char const* const wayland_record_opt;
+extern char const* const hidden_frame_interval_opt;
 
 extern char const* const enable_key_repeat_opt;
 
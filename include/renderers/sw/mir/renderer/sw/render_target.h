@@ -0,0 +1,75 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_SW_RENDER_TARGET_H_
+#define MIR_RENDERER_SW_RENDER_TARGET_H_
+
+#include "mir/renderer/sw/pixel_source.h"
+
+#include <mir/geometry/forward.h>
+
+#include <memory>
+
+namespace mir
+{
+namespace renderer
+{
+namespace software
+{
+
+/**
+ * A render target drawn to by the CPU, such as a KMS dumb buffer or a shared memory buffer.
+ *
+ * A NativeDisplayBuffer that implements this (rather than gl::RenderTarget) is composited
+ * by the software renderer.
+ */
+class RenderTarget
+{
+public:
+    virtual ~RenderTarget() = default;
+
+    /** Returns the current size in pixels of the render target */
+    virtual auto size() const -> geometry::Size = 0;
+
+    /**
+     * Map the buffer the next frame is to be drawn into.
+     *
+     * The mapping must be destroyed before swap_buffers() is called. Only 32 bit per pixel
+     * formats (argb_8888, xrgb_8888, abgr_8888 and xbgr_8888) are supported.
+     */
+    virtual auto map_back_buffer() -> std::unique_ptr<Mapping<unsigned char>> = 0;
+
+    /**
+     * The number of frames since the content of the back buffer was drawn: 1 if it holds the
+     * previous frame, 2 for the frame before that, and so on. 0 means the content is undefined
+     * and the whole buffer must be drawn.
+     */
+    virtual auto back_buffer_age() const -> unsigned = 0;
+
+    /** Present the back buffer */
+    virtual void swap_buffers() = 0;
+
+protected:
+    RenderTarget() = default;
+    RenderTarget(RenderTarget const&) = delete;
+    RenderTarget& operator=(RenderTarget const&) = delete;
+};
+
+}
+}
+}
+
+#endif /* MIR_RENDERER_SW_RENDER_TARGET_H_ */
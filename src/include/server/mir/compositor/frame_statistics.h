@@ -0,0 +1,94 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_FRAME_STATISTICS_H_
+#define MIR_COMPOSITOR_FRAME_STATISTICS_H_
+
+#include "mir/compositor/compositor_report.h"
+#include "mir/geometry/rectangle.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace mir
+{
+namespace compositor
+{
+/// A histogram of durations in power-of-two buckets from 125µs to 128ms
+class DurationHistogram
+{
+public:
+    using Duration = std::chrono::microseconds;
+
+    static size_t const bucket_count = 12;
+
+    /// The (inclusive) upper limit of bucket i; the last bucket has no limit and reports Duration::max()
+    static auto bucket_limit(size_t i) -> Duration;
+
+    void add(Duration sample);
+
+    auto buckets() const -> std::array<uint64_t, bucket_count> const& { return counts; }
+    auto count() const -> uint64_t { return samples; }
+    auto total() const -> Duration { return sum; }
+    auto max() const -> Duration { return largest; }
+
+private:
+    std::array<uint64_t, bucket_count> counts{};
+    uint64_t samples{0};
+    Duration sum{0};
+    Duration largest{0};
+};
+
+/// Frame timings of a single output, since the compositor last started
+struct OutputFrameStatistics
+{
+    CompositorReport::SubCompositorId id;
+    geometry::Rectangle area;
+
+    uint64_t frames{0};
+    /// Frames put on screen by DisplayBuffer::overlay() (bypass or overlay planes) without GL compositing
+    uint64_t bypassed_frames{0};
+    /// Estimated from frame_interval: the number of refresh periods skipped between consecutive frames
+    uint64_t missed_vblanks{0};
+
+    /// From the start of a frame until it is rendered (GL-composited frames only)
+    DurationHistogram render_time;
+    /// From rendering (or, for bypassed frames, the start of the frame) until it has been posted
+    DurationHistogram post_time;
+    /// From the scene changing until the frame showing it is started
+    DurationHistogram scene_change_to_composite;
+    /// Between the ends of consecutive frames, when the compositor did not idle in between
+    DurationHistogram frame_interval;
+};
+
+/// Access to the frame timings collected by the compositor
+class FrameStatistics
+{
+public:
+    virtual auto output_statistics() const -> std::vector<OutputFrameStatistics> = 0;
+
+protected:
+    FrameStatistics() = default;
+    virtual ~FrameStatistics() = default;
+    FrameStatistics(FrameStatistics const&) = delete;
+    FrameStatistics& operator=(FrameStatistics const&) = delete;
+};
+}
+}
+
+#endif // MIR_COMPOSITOR_FRAME_STATISTICS_H_
@@ -0,0 +1,152 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_EPOLL_MAIN_LOOP_H_
+#define MIR_EPOLL_MAIN_LOOP_H_
+
+#include "mir/main_loop.h"
+#include "mir/time/clock.h"
+#include "mir/fd.h"
+
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <csignal>
+
+namespace mir
+{
+namespace time
+{
+class TimerWheel;
+}
+
+/**
+ * A MainLoop that waits directly on an epoll fd.
+ *
+ * Alarms are multiplexed onto a single timerfd (see time::TimerWheel) and
+ * enqueued ServerActions are signalled through an eventfd, so each wakeup
+ * costs a single epoll_wait() regardless of the number of registered handlers.
+ *
+ * Unlike GLibMainLoop this has no GMainContext; it is not suitable for
+ * components (such as the logind console) that rely on GLib/GIO.
+ */
+class EpollMainLoop : public MainLoop
+{
+public:
+    EpollMainLoop(std::shared_ptr<time::Clock> const& clock);
+    ~EpollMainLoop();
+
+    void run() override;
+    void stop() override;
+    bool running() const override;
+
+    void register_signal_handler(
+        std::initializer_list<int> signals,
+        std::function<void(int)> const& handler) override;
+
+    void register_signal_handler(
+        std::initializer_list<int> signals,
+        mir::UniqueModulePtr<std::function<void(int)>> handler) override;
+
+    void register_fd_handler(
+        std::initializer_list<int> fds,
+        void const* owner,
+        std::function<void(int)> const& handler) override;
+
+    void register_fd_handler(
+        std::initializer_list<int> fds,
+        void const* owner,
+        mir::UniqueModulePtr<std::function<void(int)>> handler) override;
+
+    void unregister_fd_handler(void const* owner) override;
+
+    void enqueue(void const* owner, ServerAction const& action) override;
+    void enqueue_with_guaranteed_execution(ServerAction const& action) override;
+
+    void pause_processing_for(void const* owner) override;
+    void resume_processing_for(void const* owner) override;
+
+    std::unique_ptr<mir::time::Alarm> create_alarm(
+        std::function<void()> const& callback) override;
+
+    std::unique_ptr<mir::time::Alarm> create_alarm(
+        std::unique_ptr<LockableCallback> callback) override;
+
+    void spawn(std::function<void()>&& work) override;
+
+private:
+    struct FdHandler;
+    struct SignalHandler
+    {
+        std::vector<int> sigs;
+        std::function<void(int)> handler;
+    };
+    struct QueuedAction
+    {
+        void const* owner;
+        ServerAction action;
+        bool pausable;
+    };
+
+    void add_fd_handler(int fd, void const* owner, std::function<void(int)> const& handler);
+    void remove_fd_handlers_owned_by(void const* owner);
+    void dispatch_fd(int fd);
+
+    void add_signal_handler(std::vector<int> const& sigs, std::function<void(int)> const& handler);
+    void ensure_signal_is_handled(int sig);
+    void dispatch_pending_signals();
+
+    void add_action(void const* owner, ServerAction const& action, bool pausable);
+    void dispatch_actions();
+    bool should_process_actions_for(void const* owner);
+
+    void iterate();
+    void halt();
+    void wake();
+    void handle_exception(std::exception_ptr const& e);
+
+    Fd const epoll_fd;
+    Fd const wake_fd;
+    Fd signal_read_fd;
+    Fd signal_write_fd;
+    std::atomic<bool> running_;
+    std::atomic<bool> stop_requested;
+    std::unique_ptr<time::TimerWheel> const timer_wheel;
+
+    std::mutex fd_handlers_mutex;
+    std::unordered_map<int, std::vector<std::shared_ptr<FdHandler>>> fd_handlers;
+
+    std::mutex signal_handlers_mutex;
+    std::vector<SignalHandler> signal_handlers;
+    std::unordered_map<int, struct sigaction> handled_signals;
+
+    std::mutex actions_mutex;
+    std::deque<QueuedAction> actions;
+    std::mutex do_not_process_mutex;
+    std::vector<void const*> do_not_process;
+
+    std::mutex run_on_halt_mutex;
+    std::deque<ServerAction> run_on_halt_queue;
+    std::exception_ptr main_loop_exception;
+};
+}
+
+#endif // MIR_EPOLL_MAIN_LOOP_H_
@@ -19,6 +19,7 @@
 
 #include "mir/main_loop.h"
 #include "mir/glib_main_loop_sources.h"
+#include "mir/time/timer_wheel.h"
 
 #include <atomic>
 #include <vector>
@@ -50,7 +51,14 @@ private:
 class GLibMainLoop : public MainLoop
 {
 public:
+    enum class AlarmStrategy
+    {
+        gsource_per_alarm,  ///< Each pending Alarm is a separate GSource
+        timer_wheel         ///< All Alarms share a single timerfd (see time::TimerWheel)
+    };
+
     GLibMainLoop(std::shared_ptr<time::Clock> const& clock);
+    GLibMainLoop(std::shared_ptr<time::Clock> const& clock, AlarmStrategy alarm_strategy);
 
     void run() override;
     void stop() override;
@@ -163,6 +171,7 @@ private:
     std::shared_ptr<time::Clock> const clock;
     detail::GMainContextHandle const main_context;
     std::atomic<bool> running_;
+    std::unique_ptr<time::TimerWheel> const timer_wheel;
     detail::FdSources fd_sources;
     detail::SignalSources signal_sources;
     std::mutex do_not_process_mutex;
@@ -32,7 +32,7 @@ namespace mir
 template<class Observer>
 class ObserverRegistrar;
 
-namespace compositor { class Compositor; class DisplayBufferCompositorFactory; class CompositorReport; }
+namespace compositor { class Compositor; class DisplayBufferCompositorFactory; class CompositorReport; class FrameStatistics; }
 namespace graphics { class Cursor; class DisplayPlatform; class RenderingPlatform; class Display; class GLConfig; class DisplayConfigurationPolicy; class DisplayConfigurationObserver; }
 namespace input { class CompositeEventFilter; class InputDispatcher; class CursorListener; class CursorImages; class TouchVisualizer; class InputDeviceHub;}
 namespace logging { class Logger; }
@@ -338,6 +338,9 @@ public:
     /// \return the compositor report.
     auto the_compositor_report() const -> std::shared_ptr<compositor::CompositorReport>;
 
+    /// \return the compositor's frame statistics, or nullptr if the compositor report has been overridden.
+    auto the_frame_statistics() const -> std::shared_ptr<compositor::FrameStatistics>;
+
     /// \return the composite event filter.
     auto the_composite_event_filter() const -> std::shared_ptr<input::CompositeEventFilter>;
 
@@ -0,0 +1,70 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_TIME_TIMER_WHEEL_H_
+#define MIR_TIME_TIMER_WHEEL_H_
+
+#include "mir/time/alarm_factory.h"
+#include "mir/time/clock.h"
+#include "mir/dispatch/dispatchable.h"
+#include "mir/fd.h"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+
+namespace mir
+{
+namespace time
+{
+/**
+ * An AlarmFactory that multiplexes every Alarm onto a single timerfd.
+ *
+ * Pending alarms are kept in a hierarchical timer wheel: scheduling and
+ * cancelling are O(1) and alarms that expire within the same tick are
+ * dispatched together from a single wakeup. Alarms never fire early, but may
+ * fire up to one tick late.
+ *
+ * The owner is responsible for calling dispatch() when watch_fd() becomes
+ * readable; alarm callbacks are invoked from the thread calling dispatch().
+ */
+class TimerWheel : public AlarmFactory, public dispatch::Dispatchable
+{
+public:
+    using Tick = std::chrono::milliseconds;
+
+    TimerWheel(
+        std::shared_ptr<Clock> const& clock,
+        std::function<void()> const& exception_handler);
+    ~TimerWheel();
+
+    std::unique_ptr<Alarm> create_alarm(std::function<void()> const& callback) override;
+    std::unique_ptr<Alarm> create_alarm(std::unique_ptr<LockableCallback> callback) override;
+
+    Fd watch_fd() const override;
+    bool dispatch(dispatch::FdEvents events) override;
+    dispatch::FdEvents relevant_events() const override;
+
+private:
+    class Wheel;
+    class AlarmImpl;
+
+    std::shared_ptr<Wheel> const wheel;
+};
+}
+}
+
+#endif // MIR_TIME_TIMER_WHEEL_H_
@@ -27,6 +27,7 @@
 #include "miral/zone.h"
 #include "miral/output.h"
 #include "mru_window_list.h"
+#include "info_map.h"
 
 #include <mir/geometry/rectangles.h>
 #include <mir/observer_registrar.h>
@@ -233,8 +234,8 @@ private:
         std::set<Window> attached_windows; ///< Maximized/anchored/etc windows attached to this area
     };
 
-    using SurfaceInfoMap = std::map<std::weak_ptr<mir::scene::Surface>, WindowInfo, std::owner_less<std::weak_ptr<mir::scene::Surface>>>;
-    using SessionInfoMap = std::map<std::weak_ptr<mir::scene::Session>, ApplicationInfo, std::owner_less<std::weak_ptr<mir::scene::Session>>>;
+    using SurfaceInfoMap = InfoMap<mir::scene::Surface, WindowInfo>;
+    using SessionInfoMap = InfoMap<mir::scene::Session, ApplicationInfo>;
 
     mir::shell::FocusController* const focus_controller;
     std::shared_ptr<mir::shell::DisplayLayout> const display_layout;
@@ -0,0 +1,91 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "miral/frame_statistics.h"
+
+#include <mir/compositor/frame_statistics.h>
+#include <mir/server.h>
+
+#include <mutex>
+
+namespace mc = mir::compositor;
+
+namespace
+{
+auto histogram_from(mc::DurationHistogram const& from) -> miral::FrameStatistics::Histogram
+{
+    miral::FrameStatistics::Histogram result;
+    for (auto i = 0u; i != mc::DurationHistogram::bucket_count; ++i)
+    {
+        result.bucket_limits.push_back(mc::DurationHistogram::bucket_limit(i));
+    }
+    result.counts.assign(from.buckets().begin(), from.buckets().end());
+    result.count = from.count();
+    result.total = from.total();
+    result.max = from.max();
+    return result;
+}
+}
+
+struct miral::FrameStatistics::Self
+{
+    std::mutex mutable mutex;
+    std::weak_ptr<mc::FrameStatistics> statistics;
+};
+
+miral::FrameStatistics::FrameStatistics() : self{std::make_shared<Self>()} {}
+miral::FrameStatistics::~FrameStatistics() = default;
+miral::FrameStatistics::FrameStatistics(FrameStatistics const&) = default;
+auto miral::FrameStatistics::operator=(FrameStatistics const&) -> FrameStatistics& = default;
+
+void miral::FrameStatistics::operator()(mir::Server& server) const
+{
+    server.add_init_callback([self=self, &server]
+        {
+            std::lock_guard lock{self->mutex};
+            self->statistics = server.the_frame_statistics();
+        });
+}
+
+auto miral::FrameStatistics::outputs() const -> std::vector<Output>
+{
+    std::shared_ptr<mc::FrameStatistics> statistics;
+    {
+        std::lock_guard lock{self->mutex};
+        statistics = self->statistics.lock();
+    }
+
+    std::vector<Output> result;
+    if (!statistics)
+    {
+        return result;
+    }
+
+    for (auto const& output : statistics->output_statistics())
+    {
+        result.push_back(Output{
+            output.area,
+            output.frames,
+            output.bypassed_frames,
+            output.missed_vblanks,
+            histogram_from(output.render_time),
+            histogram_from(output.post_time),
+            histogram_from(output.scene_change_to_composite),
+            histogram_from(output.frame_interval)});
+    }
+
+    return result;
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIRAL_INFO_MAP_H
+#define MIRAL_INFO_MAP_H
+
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace miral
+{
+/// Associates an Info with each of a set of objects referenced by weak_ptr.
+///
+/// This behaves as a std::map<std::weak_ptr<Object>, Info, std::owner_less<...>>, and iterates in
+/// the same order: the next/previous walks of BasicWindowManager (such as focus_next_application())
+/// depend on that order. Lookups of live objects go through a hash index on the object's address
+/// rather than a tree walk.
+///
+/// Keys that have expired can still be found and erased.
+template<typename Object, typename Info>
+class InfoMap
+{
+public:
+    using key_type = std::weak_ptr<Object>;
+    using value_type = std::pair<key_type const, Info>;
+    using Entries = std::map<key_type, Info, std::owner_less<key_type>>;
+    using iterator = typename Entries::iterator;
+    using const_iterator = typename Entries::const_iterator;
+
+    auto begin() -> iterator { return entries.begin(); }
+    auto end() -> iterator { return entries.end(); }
+    auto begin() const -> const_iterator { return entries.begin(); }
+    auto end() const -> const_iterator { return entries.end(); }
+    auto size() const -> size_t { return entries.size(); }
+    auto empty() const -> bool { return entries.empty(); }
+
+    auto find(key_type const& key) -> iterator
+    {
+        if (auto const object = key.lock())
+        {
+            auto const i = index.find(object.get());
+            if (i != index.end() && same_owner(i->second->first, key))
+                return i->second;
+            return entries.end();
+        }
+
+        return entries.find(key);
+    }
+
+    auto find(key_type const& key) const -> const_iterator
+    {
+        return const_cast<InfoMap*>(this)->find(key);
+    }
+
+    /// \throws std::out_of_range if key is not present
+    auto at(key_type const& key) -> Info&
+    {
+        auto const i = find(key);
+        if (i == entries.end())
+            throw std::out_of_range{"miral::InfoMap::at"};
+        return i->second;
+    }
+
+    auto at(key_type const& key) const -> Info const&
+    {
+        return const_cast<InfoMap*>(this)->at(key);
+    }
+
+    auto emplace(key_type const& key, Info&& info) -> std::pair<iterator, bool>
+    {
+        if (auto const i = find(key); i != entries.end())
+            return {i, false};
+
+        auto const i = entries.emplace(key, std::move(info)).first;
+        if (auto const object = key.lock())
+        {
+            // Any existing index entry for this address belongs to an object that has expired
+            index[object.get()] = i;
+        }
+        return {i, true};
+    }
+
+    auto operator[](key_type const& key) -> Info&
+    {
+        if (auto const i = find(key); i != entries.end())
+            return i->second;
+
+        return emplace(key, Info{}).first->second;
+    }
+
+    auto erase(iterator i) -> iterator
+    {
+        if (auto const object = i->first.lock())
+        {
+            if (auto const j = index.find(object.get()); j != index.end() && j->second == i)
+                index.erase(j);
+        }
+        else
+        {
+            for (auto j = index.begin(); j != index.end(); ++j)
+            {
+                if (j->second == i)
+                {
+                    index.erase(j);
+                    break;
+                }
+            }
+        }
+
+        return entries.erase(i);
+    }
+
+    auto erase(key_type const& key) -> size_t
+    {
+        if (auto const i = find(key); i != entries.end())
+        {
+            erase(i);
+            return 1;
+        }
+        return 0;
+    }
+
+private:
+    Entries entries;
+    std::unordered_map<Object const*, iterator> index;
+
+    static auto same_owner(key_type const& lhs, key_type const& rhs) -> bool
+    {
+        return !lhs.owner_before(rhs) && !rhs.owner_before(lhs);
+    }
+};
+}
+
+#endif //MIRAL_INFO_MAP_H
@@ -29,15 +29,52 @@ bool visible(miral::Window const& window)
 }
 }
 
+auto miral::MRUWindowList::find(Window const& window) -> Windows::iterator
+{
+    if (std::shared_ptr<mir::scene::Surface> const surface{window})
+    {
+        auto const i = index.find(surface.get());
+        if (i == index.end())
+            return end(windows);
+        if (*i->second == window)
+            return i->second;
+    }
+
+    // Either the surface has gone, or the index refers to a different Window for the same surface
+    return std::find(begin(windows), end(windows), window);
+}
+
 void miral::MRUWindowList::push(Window const& window)
 {
-    windows.erase(remove(begin(windows), end(windows), window), end(windows));
-    windows.push_back(window);
+    auto const i = find(window);
+    if (i != end(windows))
+    {
+        windows.splice(end(windows), windows, i);
+        return;
+    }
+
+    auto const j = windows.insert(end(windows), window);
+    if (std::shared_ptr<mir::scene::Surface> const surface{window})
+        index[surface.get()] = j;
 }
 
 void miral::MRUWindowList::erase(Window const& window)
 {
-    windows.erase(remove(begin(windows), end(windows), window), end(windows));
+    auto const i = find(window);
+    if (i == end(windows))
+        return;
+
+    if (std::shared_ptr<mir::scene::Surface> const surface{window})
+    {
+        if (auto const j = index.find(surface.get()); j != index.end() && j->second == i)
+            index.erase(j);
+    }
+    else
+    {
+        std::erase_if(index, [i](auto const& entry) { return entry.second == i; });
+    }
+
+    windows.erase(i);
 }
 
 auto miral::MRUWindowList::top() const -> Window
@@ -20,7 +20,10 @@
 #include <miral/window.h>
 
 #include <functional>
-#include <vector>
+#include <list>
+#include <unordered_map>
+
+namespace mir { namespace scene { class Surface; } }
 
 namespace miral
 {
@@ -30,6 +33,8 @@ public:
 
     void push(Window const& window);
     void erase(Window const& window);
+    /// The most recently used window that isn't hidden
+    /// \note  Hidden windows are skipped by a linear search from the most recently used end
     auto top() const -> Window;
 
     using Enumerator = std::function<bool(Window& window)>;
@@ -37,7 +42,14 @@ public:
     void enumerate(Enumerator const& enumerator) const;
 
 private:
-    std::vector<Window> windows;
+    using Windows = std::list<Window>;
+
+    /// Least recently used first
+    Windows windows;
+    /// Finds a window in the list by its surface without a linear search
+    std::unordered_map<mir::scene::Surface const*, Windows::iterator> index;
+
+    auto find(Window const& window) -> Windows::iterator;
 };
 }
 
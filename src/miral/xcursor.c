@@ -892,3 +892,81 @@ xcursor_load_theme(const char *theme, int size,
 	if (inherits)
 		free(inherits);
 }
+
+static XcursorImages *
+load_cursor_from_theme(const char *theme, const char *name, int size, int depth)
+{
+	char *full, *dir;
+	char *inherits = NULL;
+	const char *path, *i;
+	FILE *f;
+	XcursorImages *images = NULL;
+
+	/* Guard against themes that (indirectly) inherit from themselves */
+	if (depth > 16)
+		return NULL;
+
+	for (path = XcursorLibraryPath();
+	     path && !images;
+	     path = _XcursorNextPath(path)) {
+		dir = _XcursorBuildThemeDir(path, theme);
+		if (!dir)
+			continue;
+
+		full = _XcursorBuildFullname(dir, "cursors", name);
+
+		if (full) {
+			f = fopen(full, "r");
+			if (f) {
+				images = XcursorFileLoadImages(f, size);
+				if (images)
+					XcursorImagesSetName(images, name);
+				fclose(f);
+			}
+			free(full);
+		}
+
+		if (!images && !inherits) {
+			full = _XcursorBuildFullname(dir, "", "index.theme");
+			if (full) {
+				inherits = _XcursorThemeInherits(full);
+				free(full);
+			}
+		}
+
+		free(dir);
+	}
+
+	for (i = inherits; i && !images; i = _XcursorNextPath(i))
+		images = load_cursor_from_theme(i, name, size, depth + 1);
+
+	if (inherits)
+		free(inherits);
+
+	return images;
+}
+
+/** Load a single cursor from a theme
+ *
+ * This function looks for the named cursor in the given theme and,
+ * failing that, in the themes it inherits from. Only the images
+ * closest to the requested nominal size are loaded. Unlike
+ * xcursor_load_theme() no other cursor files are opened.
+ *
+ * \param theme The name of theme that should be searched
+ * \param name The name of the cursor (e.g. "arrow")
+ * \param size The desired size of the cursor images
+ * \return The loaded images, or NULL if the cursor was not found. The
+ * caller is expected to destroy the result with XcursorImagesDestroy().
+ */
+XcursorImages *
+xcursor_load_cursor(const char *theme, const char *name, int size)
+{
+	if (!name || strchr(name, '/'))
+		return NULL;
+
+	if (!theme)
+		theme = "default";
+
+	return load_cursor_from_theme(theme, name, size, 0);
+}
@@ -18,7 +18,10 @@
 
 #include <mir/graphics/cursor_image.h>
 
-#include <stdexcept>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
 
 #include <mir_toolkit/cursors.h>
 
@@ -36,37 +39,60 @@ namespace geom = mir::geometry;
 
 namespace
 {
+// Holds a copy of a single frame so that the rest of the XcursorImages can be freed
 class XCursorImage : public mg::CursorImage
 {
 public:
-    XCursorImage(_XcursorImage *image, std::shared_ptr<_XcursorImages> const& save_resource)
-        : image(image),
-          save_resource(save_resource)
-    {
-    }
-
-    ~XCursorImage()
+    explicit XCursorImage(_XcursorImage const* image)
+        : pixels(image->pixels, image->pixels + image->width * image->height),
+          size_{image->width, image->height},
+          hotspot_{image->xhot, image->yhot}
     {
     }
 
     void const* as_argb_8888() const override
     {
-        return image->pixels;
+        return pixels.data();
     }
     geom::Size size() const override
     {
-        return {image->width, image->height};
+        return size_;
     }
     geom::Displacement hotspot() const override
     {
-        return {image->xhot, image->yhot};
+        return hotspot_;
     }
 
 private:
-    _XcursorImage *image;
-    std::shared_ptr<_XcursorImages> const save_resource;
+    std::vector<XcursorPixel> const pixels;
+    geom::Size const size_;
+    geom::Displacement const hotspot_;
 };
 
+auto load_cursor(std::string const& theme, std::string const& name, uint32_t nominal_size)
+    -> std::shared_ptr<mg::CursorImage>
+{
+    std::unique_ptr<_XcursorImages, void(*)(_XcursorImages*)> const images{
+        xcursor_load_cursor(theme.c_str(), name.c_str(), nominal_size),
+        &XcursorImagesDestroy};
+
+    if (!images || images->nimage < 1)
+        return nullptr;
+
+    // XCursor has already picked the closest nominal size; prefer an exact match
+    // from the frames it found, otherwise the first one.
+    for (int i = 0; i < images->nimage; i++)
+    {
+        _XcursorImage const* const candidate = images->images[i];
+        if (candidate->width == nominal_size && candidate->height == nominal_size)
+        {
+            return std::make_shared<XCursorImage>(candidate);
+        }
+    }
+
+    return std::make_shared<XCursorImage>(images->images[0]);
+}
+
 std::string const
 xcursor_name_for_mir_cursor(std::string const& mir_cursor_name)
 {
@@ -137,74 +163,65 @@ xcursor_name_for_mir_cursor(std::string const& mir_cursor_name)
 }
 }
 
-miral::XCursorLoader::XCursorLoader()
-{
-    load_cursor_theme("default");
-}
-
-miral::XCursorLoader::XCursorLoader(std::string const& theme)
+class miral::XCursorLoader::Cache
 {
-    load_cursor_theme(theme);
-}
+public:
+    static auto instance() -> std::shared_ptr<Cache>
+    {
+        // Shared by all loaders while any exist, so each cursor is decoded once per process
+        static std::mutex mutex;
+        static std::weak_ptr<Cache> cache;
 
-// Each XcursorImages represents images for the different sizes of a given symbolic cursor.
-void miral::XCursorLoader::load_appropriately_sized_image(_XcursorImages *images)
-{
-    // We would rather take this lock in load_cursor_theme but the Xcursor lib style
-    // makes it difficult to use our standard 'pass the lg around to _locked members' pattern
-    std::lock_guard lg(guard);
-
-    // We have to save all the images as XCursor expects us to free them.
-    // This contains the actual image data though, so we need to ensure they stay alive
-    // with the lifetime of the mg::CursorImage instance which refers to them.
-    auto saved_xcursor_library_resource = std::shared_ptr<_XcursorImages>(images, [](_XcursorImages *images)
+        std::lock_guard lock{mutex};
+        auto result = cache.lock();
+        if (!result)
         {
-            XcursorImagesDestroy(images);
-        });
+            result = std::make_shared<Cache>();
+            cache = result;
+        }
+        return result;
+    }
 
-    for (int i = 0; i < images->nimage; i++)
+    auto image(std::string const& theme, std::string const& name, uint32_t nominal_size)
+        -> std::shared_ptr<mg::CursorImage>
     {
-        _XcursorImage *candidate = images->images[i];
-        if (candidate->width == mi::default_cursor_size.width.as_uint32_t() &&
-            candidate->height == mi::default_cursor_size.height.as_uint32_t())
-        {
-            loaded_images[std::string(images->name)] = std::make_shared<XCursorImage>(candidate, saved_xcursor_library_resource);
-            return;
-        }
+        std::lock_guard lock{mutex};
+
+        auto const key = std::make_tuple(theme, name, nominal_size);
+        if (auto const i = images.find(key); i != images.end())
+            return i->second;
+
+        // Remember failed lookups too, so missing cursors don't rescan the theme directories
+        return images[key] = load_cursor(theme, name, nominal_size);
     }
 
-    loaded_images[std::string(images->name)] = std::make_shared<XCursorImage>(images->images[0], saved_xcursor_library_resource);
+private:
+    std::mutex mutex;
+    std::map<std::tuple<std::string, std::string, uint32_t>, std::shared_ptr<mg::CursorImage>> images;
+};
+
+miral::XCursorLoader::XCursorLoader()
+    : XCursorLoader{"default"}
+{
 }
 
-void miral::XCursorLoader::load_cursor_theme(std::string const& theme_name)
+miral::XCursorLoader::XCursorLoader(std::string const& theme)
+    : theme{theme},
+      cache{Cache::instance()}
 {
-    // Cursors are named by their square dimension...called the nominal size in XCursor terminology, so we just look up by width.
-    // Later we verify the actual size.
-    xcursor_load_theme(theme_name.c_str(), mi::default_cursor_size.width.as_uint32_t(),
-        [](XcursorImages* images, void *this_ptr)  -> void
-        {
-            // Can't use lambda capture as this lambda is thunked to a C function ptr
-            auto p = static_cast<miral::XCursorLoader*>(this_ptr);
-            p->load_appropriately_sized_image(images);
-        }, this);
 }
 
 std::shared_ptr<mg::CursorImage> miral::XCursorLoader::image(
     std::string const& cursor_name,
-    geom::Size const& /*size*/)
+    geom::Size const& size)
 {
-    auto xcursor_name = xcursor_name_for_mir_cursor(cursor_name);
-
-    std::lock_guard lg(guard);
+    // Cursors are named by their square dimension...called the nominal size in XCursor terminology, so we just look up by width.
+    auto const nominal_size = size.width.as_uint32_t() ?
+        size.width.as_uint32_t() : mi::default_cursor_size.width.as_uint32_t();
 
-    auto it = loaded_images.find(xcursor_name);
-    if (it != loaded_images.end())
-        return it->second;
+    if (auto const image = cache->image(theme, xcursor_name_for_mir_cursor(cursor_name), nominal_size))
+        return image;
 
     // Fall back
-    it = loaded_images.find("arrow");
-    if (it != loaded_images.end())
-        return it->second;
-
-    return nullptr;
+    return cache->image(theme, "arrow", nominal_size);
 }
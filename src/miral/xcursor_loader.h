@@ -22,19 +22,16 @@
 
 #include <memory>
 #include <string>
-#include <map>
-#include <mutex>
-
-// Unfortunately this library does not compile as C++ so we can not namespace it.
-extern "C"
-{
-struct _XcursorImages;
-}
 
 namespace mir { namespace graphics { class CursorImage; } }
 
 namespace miral
 {
+/// Loads cursor images from an XCursor theme.
+///
+/// Cursors are loaded on first use, one (name, nominal size) pair at a time, rather than
+/// decoding the whole theme up front. Only the selected frame is kept, and the decoded
+/// images are shared between all loaders (and so all seats and outputs) using the theme.
 class XCursorLoader : public mir::input::CursorImages
 {
 public:
@@ -44,6 +41,8 @@ public:
 
     virtual ~XCursorLoader() = default;
 
+    /// The nominal size is taken from the requested width. The image is not scaled to
+    /// suit the output it is shown on: a single cursor image is shown on every output.
     std::shared_ptr<mir::graphics::CursorImage> image(std::string const& cursor_name, mir::geometry::Size const& size);
 
 protected:
@@ -51,12 +50,10 @@ protected:
     XCursorLoader& operator=(XCursorLoader const&) = delete;
 
 private:
-    std::mutex guard;
-
-    std::map<std::string, std::shared_ptr<mir::graphics::CursorImage>> loaded_images;
+    class Cache;
 
-    void load_cursor_theme(std::string const& theme_name);
-    void load_appropriately_sized_image(_XcursorImages *images);
+    std::string const theme;
+    std::shared_ptr<Cache> const cache;
 };
 }
 
@@ -0,0 +1,52 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dmabuf_import_guard.h"
+
+#define MIR_LOG_COMPONENT "linux-dmabuf-import"
+#include "mir/log.h"
+
+namespace mg = mir::graphics;
+
+auto mg::DmaBufImportGuard::import(std::function<GLuint()> const& import_texture) -> GLuint
+{
+    if (failed_)
+    {
+        return 0;
+    }
+
+    try
+    {
+        return import_texture();
+    }
+    catch (std::exception const&)
+    {
+        if (!failed_.exchange(true))
+        {
+            mir::log(
+                mir::logging::Severity::error,
+                MIR_LOG_COMPONENT,
+                std::current_exception(),
+                "Failed to import client dmabuf; it will not be rendered");
+        }
+        return 0;
+    }
+}
+
+auto mg::DmaBufImportGuard::failed() const -> bool
+{
+    return failed_;
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_DMABUF_IMPORT_GUARD_H_
+#define MIR_GRAPHICS_DMABUF_IMPORT_GUARD_H_
+
+#include <GLES2/gl2.h>
+
+#include <atomic>
+#include <functional>
+
+namespace mir
+{
+namespace graphics
+{
+/**
+ * Remembers whether importing a client's dmabuf has failed
+ *
+ * One guard is shared by every buffer submitted from the same client wl_buffer,
+ * so a dmabuf the driver rejects is reported once rather than reimported (and
+ * logged) on every frame.
+ */
+class DmaBufImportGuard
+{
+public:
+    /**
+     * Run \a import_texture unless an earlier import of this client buffer failed
+     *
+     * \return  The texture from \a import_texture, or 0 if it threw or an
+     *          earlier import failed. Only the first failure is logged.
+     */
+    auto import(std::function<GLuint()> const& import_texture) -> GLuint;
+
+    auto failed() const -> bool;
+
+private:
+    std::atomic<bool> failed_{false};
+};
+}
+}
+
+#endif /* MIR_GRAPHICS_DMABUF_IMPORT_GUARD_H_ */
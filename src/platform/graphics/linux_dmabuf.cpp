@@ -30,6 +30,7 @@
 #include "mir/graphics/buffer_basic.h"
 #include "mir/graphics/dmabuf_buffer.h"
 #include "mir/graphics/egl_context_executor.h"
+#include "dmabuf_import_guard.h"
 
 #define MIR_LOG_COMPONENT "linux-dmabuf-import"
 #include "mir/log.h"
@@ -227,6 +228,109 @@ BufferGLDescription const ExternalOES = {
     "}\n"
 };
 
+struct EGLPlaneAttribs
+{
+    EGLint fd;
+    EGLint offset;
+    EGLint pitch;
+    EGLint modifier_lo;
+    EGLint modifier_hi;
+};
+constexpr std::array<EGLPlaneAttribs, 4> egl_attribs = {
+    EGLPlaneAttribs {
+        EGL_DMA_BUF_PLANE0_FD_EXT,
+        EGL_DMA_BUF_PLANE0_OFFSET_EXT,
+        EGL_DMA_BUF_PLANE0_PITCH_EXT,
+        EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT,
+        EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT
+    },
+    EGLPlaneAttribs {
+        EGL_DMA_BUF_PLANE1_FD_EXT,
+        EGL_DMA_BUF_PLANE1_OFFSET_EXT,
+        EGL_DMA_BUF_PLANE1_PITCH_EXT,
+        EGL_DMA_BUF_PLANE1_MODIFIER_LO_EXT,
+        EGL_DMA_BUF_PLANE1_MODIFIER_HI_EXT
+    },
+    EGLPlaneAttribs {
+        EGL_DMA_BUF_PLANE2_FD_EXT,
+        EGL_DMA_BUF_PLANE2_OFFSET_EXT,
+        EGL_DMA_BUF_PLANE2_PITCH_EXT,
+        EGL_DMA_BUF_PLANE2_MODIFIER_LO_EXT,
+        EGL_DMA_BUF_PLANE2_MODIFIER_HI_EXT
+    },
+    EGLPlaneAttribs {
+        EGL_DMA_BUF_PLANE3_FD_EXT,
+        EGL_DMA_BUF_PLANE3_OFFSET_EXT,
+        EGL_DMA_BUF_PLANE3_PITCH_EXT,
+        EGL_DMA_BUF_PLANE3_MODIFIER_LO_EXT,
+        EGL_DMA_BUF_PLANE3_MODIFIER_HI_EXT
+    }
+};
+
+/**
+ * Import dmabufs into EGL
+ *
+ * This does not need a current EGL context, so may be called from any thread.
+ *
+ * \return  An EGLImageKHR handle to the imported buffer, owned by the caller
+ * \throws  A std::system_error containing the EGL error on failure.
+ */
+auto import_egl_image(
+    EGLDisplay dpy,
+    mg::EGLExtensions const& egl_extensions,
+    geom::Size size,
+    uint32_t format,
+    uint64_t modifier,
+    std::vector<PlaneInfo> const& planes) -> EGLImageKHR
+{
+    std::vector<EGLint> attributes;
+
+    attributes.push_back(EGL_WIDTH);
+    attributes.push_back(size.width.as_int());
+    attributes.push_back(EGL_HEIGHT);
+    attributes.push_back(size.height.as_int());
+    attributes.push_back(EGL_LINUX_DRM_FOURCC_EXT);
+    attributes.push_back(format);
+
+    for(auto i = 0u; i < planes.size(); ++i)
+    {
+        auto const& attrib_names = egl_attribs[i];
+        auto const& plane = planes[i];
+
+        attributes.push_back(attrib_names.fd);
+        attributes.push_back(static_cast<int>(plane.dma_buf));
+        attributes.push_back(attrib_names.offset);
+        attributes.push_back(plane.offset);
+        attributes.push_back(attrib_names.pitch);
+        attributes.push_back(plane.stride);
+        if (modifier != DRM_FORMAT_MOD_INVALID)
+        {
+            attributes.push_back(attrib_names.modifier_lo);
+            attributes.push_back(modifier & 0xFFFFFFFF);
+            attributes.push_back(attrib_names.modifier_hi);
+            attributes.push_back(modifier >> 32);
+        }
+    }
+    attributes.push_back(EGL_NONE);
+
+    auto const image = egl_extensions.base(dpy).eglCreateImageKHR(
+        dpy,
+        EGL_NO_CONTEXT,
+        EGL_LINUX_DMA_BUF_EXT,
+        nullptr,
+        attributes.data());
+
+    if (image == EGL_NO_IMAGE_KHR)
+    {
+        auto const msg = planes.size() > 1 ?
+            "Failed to import supplied dmabufs" :
+            "Failed to import supplied dmabuf";
+        BOOST_THROW_EXCEPTION((mg::egl_error(msg)));
+    }
+
+    return image;
+}
+
 /**
  * Holds on to all imported dmabuf buffers, and allows looking up by wl_buffer
  *
@@ -303,61 +407,21 @@ public:
     /**
      * Reimport dmabufs into EGL
      *
-     * This is necessary to call each time the buffer is re-submitted by the client,
-     * to ensure any state is properly synchronised.
+     * This validates the client's parameters when the wl_buffer is created. Each time
+     * the buffer is submitted the resulting WaylandDmabufTexBuffer performs its own
+     * import (on first bind) to ensure any state is properly synchronised.
      *
      * \return  An EGLImageKHR handle to the imported
      * \throws  A std::system_error containing the EGL error on failure.
      */
     auto reimport_egl_image() -> EGLImageKHR
     {
-        std::vector<EGLint> attributes;
-
-        attributes.push_back(EGL_WIDTH);
-        attributes.push_back(width);
-        attributes.push_back(EGL_HEIGHT);
-        attributes.push_back(height);
-        attributes.push_back(EGL_LINUX_DRM_FOURCC_EXT);
-        attributes.push_back(format());
-
-        for(auto i = 0u; i < planes_.size(); ++i)
-        {
-            auto const& attrib_names = egl_attribs[i];
-            auto const& plane = planes()[i];
-
-            attributes.push_back(attrib_names.fd);
-            attributes.push_back(static_cast<int>(plane.dma_buf));
-            attributes.push_back(attrib_names.offset);
-            attributes.push_back(plane.offset);
-            attributes.push_back(attrib_names.pitch);
-            attributes.push_back(plane.stride);
-            if (modifier() != DRM_FORMAT_MOD_INVALID)
-            {
-                attributes.push_back(attrib_names.modifier_lo);
-                attributes.push_back(modifier() & 0xFFFFFFFF);
-                attributes.push_back(attrib_names.modifier_hi);
-                attributes.push_back(modifier() >> 32);
-            }
-        }
-        attributes.push_back(EGL_NONE);
         if (image != EGL_NO_IMAGE_KHR)
         {
             egl_extensions->base(dpy).eglDestroyImageKHR(dpy, image);
+            image = EGL_NO_IMAGE_KHR;
         }
-        image = egl_extensions->base(dpy).eglCreateImageKHR(
-            dpy,
-            EGL_NO_CONTEXT,
-            EGL_LINUX_DMA_BUF_EXT,
-            nullptr,
-            attributes.data());
-
-        if (image == EGL_NO_IMAGE_KHR)
-        {
-            auto const msg = planes_.size() > 1 ?
-                "Failed to import supplied dmabufs" :
-                "Failed to import supplied dmabuf";
-            BOOST_THROW_EXCEPTION((mg::egl_error(msg)));
-        }
+        image = import_egl_image(dpy, *egl_extensions, size(), format(), modifier(), planes());
 
         return image;
     }
@@ -371,6 +435,11 @@ public:
     {
         return planes_;
     }
+
+    auto import_guard() const -> std::shared_ptr<mg::DmaBufImportGuard> const&
+    {
+        return import_guard_;
+    }
 private:
     EGLDisplay const dpy;
     std::shared_ptr<mg::EGLExtensions> const egl_extensions;
@@ -381,45 +450,7 @@ private:
     uint64_t const modifier_;
     std::vector<PlaneInfo> const planes_;
     EGLImageKHR image;
-
-    struct EGLPlaneAttribs
-    {
-        EGLint fd;
-        EGLint offset;
-        EGLint pitch;
-        EGLint modifier_lo;
-        EGLint modifier_hi;
-    };
-    static constexpr std::array<EGLPlaneAttribs, 4> egl_attribs = {
-        EGLPlaneAttribs {
-            EGL_DMA_BUF_PLANE0_FD_EXT,
-            EGL_DMA_BUF_PLANE0_OFFSET_EXT,
-            EGL_DMA_BUF_PLANE0_PITCH_EXT,
-            EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT,
-            EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT
-        },
-        EGLPlaneAttribs {
-            EGL_DMA_BUF_PLANE1_FD_EXT,
-            EGL_DMA_BUF_PLANE1_OFFSET_EXT,
-            EGL_DMA_BUF_PLANE1_PITCH_EXT,
-            EGL_DMA_BUF_PLANE1_MODIFIER_LO_EXT,
-            EGL_DMA_BUF_PLANE1_MODIFIER_HI_EXT
-        },
-        EGLPlaneAttribs {
-            EGL_DMA_BUF_PLANE2_FD_EXT,
-            EGL_DMA_BUF_PLANE2_OFFSET_EXT,
-            EGL_DMA_BUF_PLANE2_PITCH_EXT,
-            EGL_DMA_BUF_PLANE2_MODIFIER_LO_EXT,
-            EGL_DMA_BUF_PLANE2_MODIFIER_HI_EXT
-        },
-        EGLPlaneAttribs {
-            EGL_DMA_BUF_PLANE3_FD_EXT,
-            EGL_DMA_BUF_PLANE3_OFFSET_EXT,
-            EGL_DMA_BUF_PLANE3_PITCH_EXT,
-            EGL_DMA_BUF_PLANE3_MODIFIER_LO_EXT,
-            EGL_DMA_BUF_PLANE3_MODIFIER_HI_EXT
-        }
-    };
+    std::shared_ptr<mg::DmaBufImportGuard> const import_guard_{std::make_shared<mg::DmaBufImportGuard>()};
 };
 
 class LinuxDmaBufParams : public mir::wayland::LinuxBufferParamsV1
@@ -755,15 +786,18 @@ class WaylandDmabufTexBuffer :
     public mg::DMABufBuffer
 {
 public:
-    // Note: Must be called with a current EGL context
+    /* Note: This does not touch EGL or GL state; the dmabufs are imported on first bind(),
+     * on the compositor thread, so the Wayland thread doesn't need a current EGL context.
+     */
     WaylandDmabufTexBuffer(
         WlDmaBufBuffer& source,
-        mg::EGLExtensions const& extensions,
+        std::shared_ptr<mg::EGLExtensions> extensions,
         EGLDisplay dpy,
         std::shared_ptr<mgc::EGLContextExecutor> egl_delegate,
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release)
-        : tex{get_tex_id()},
+        : dpy{dpy},
+          extensions{std::move(extensions)},
           desc{source.descriptor()},
           on_consumed{std::move(on_consumed)},
           on_release{std::move(on_release)},
@@ -773,30 +807,22 @@ public:
           planes_{source.planes()},
           modifier_{source.modifier()},
           fourcc{source.format()},
+          import_modifier{source.modifier()},
+          import_guard{source.import_guard()},
           egl_delegate{std::move(egl_delegate)}
     {
-        eglBindAPI(EGL_OPENGL_ES_API);
-
-        auto const target = source.descriptor().target;
-
-        glBindTexture(target, tex);
-        extensions.base(dpy).glEGLImageTargetTexture2DOES(target, source.reimport_egl_image());
-        // tex is now an EGLImage sibling, so we can free the EGLImage without
-        // freeing the backing data.
-
-        glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     }
 
     ~WaylandDmabufTexBuffer() override
     {
-        egl_delegate->spawn(
-            [tex = tex]()
-            {
-              glDeleteTextures(1, &tex);
-            });
+        if (tex != 0)
+        {
+            egl_delegate->spawn(
+                [tex = tex]()
+                {
+                  glDeleteTextures(1, &tex);
+                });
+        }
 
         on_release();
     }
@@ -843,6 +869,13 @@ public:
 
     void bind() override
     {
+        {
+            std::lock_guard lock{tex_mutex};
+            if (tex == 0)
+            {
+                tex = import_guard->import([this]() { return import_to_texture(); });
+            }
+        }
         glBindTexture(desc.target, tex);
 
         std::lock_guard lock(consumed_mutex);
@@ -870,7 +903,33 @@ public:
     }
 
 private:
-    GLuint const tex;
+    // Must be called with a current EGL context; throws if EGL rejects the dmabufs
+    auto import_to_texture() -> GLuint
+    {
+        auto const image = import_egl_image(dpy, *extensions, size_, fourcc, import_modifier, planes_);
+
+        auto const target = desc.target;
+        auto const new_tex = get_tex_id();
+
+        glBindTexture(target, new_tex);
+        extensions->base(dpy).glEGLImageTargetTexture2DOES(target, image);
+        // tex is now an EGLImage sibling, so we can free the EGLImage without
+        // freeing the backing data.
+        extensions->base(dpy).eglDestroyImageKHR(dpy, image);
+
+        glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        return new_tex;
+    }
+
+    EGLDisplay const dpy;
+    std::shared_ptr<mg::EGLExtensions> const extensions;
+
+    std::mutex tex_mutex;
+    GLuint tex{0};
     BufferGLDescription const& desc;
 
     std::mutex consumed_mutex;
@@ -884,6 +943,8 @@ private:
     std::vector<mg::DMABufBuffer::PlaneDescriptor> const planes_;
     std::optional<uint64_t> const modifier_;
     uint32_t const fourcc;
+    uint64_t const import_modifier;
+    std::shared_ptr<mg::DmaBufImportGuard> const import_guard;
 
     std::shared_ptr<mgc::EGLContextExecutor> const egl_delegate;
 };
@@ -953,7 +1014,7 @@ auto mg::LinuxDmaBufUnstable::buffer_from_resource(
     {
         return std::make_shared<WaylandDmabufTexBuffer>(
             *dmabuf,
-            *egl_extensions,
+            egl_extensions,
             dpy,
             std::move(egl_delegate),
             std::move(on_consumed),
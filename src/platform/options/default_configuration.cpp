@@ -44,6 +44,11 @@ char const* const mo::wayland_extensions_opt      = "wayland-extensions";
 char const* const mo::add_wayland_extensions_opt  = "add-wayland-extensions";
 char const* const mo::drop_wayland_extensions_opt = "drop-wayland-extensions";
 char const* const mo::idle_timeout_opt            = "idle-timeout";
+char const* const mo::timer_wheel_alarms_opt      = "timer-wheel-alarms";
+char const* const mo::main_loop_opt               = "main-loop";
+char const* const mo::gl_program_cache_opt        = "gl-program-cache";
+char const* const mo::wayland_record_opt          = "wayland-record";
+char const* const mo::hidden_frame_interval_opt   = "hidden-frame-interval";
 
 char const* const mo::off_opt_value = "off";
 char const* const mo::log_opt_value = "log";
@@ -179,6 +184,26 @@ mo::DefaultConfiguration::DefaultConfiguration(
         (idle_timeout_opt, po::value<int>()->default_value(0),
             "Time (in seconds) Mir will remain idle before turning off the display, "
             "or 0 to keep display on forever.")
+        (timer_wheel_alarms_opt, po::value<bool>()->default_value(false),
+            "Multiplex server alarms (key repeat, timeouts, etc.) onto a single "
+            "timer wheel instead of creating a main loop source for each alarm.")
+        (main_loop_opt, po::value<std::string>()->default_value("glib"),
+            "Main loop implementation to use [{glib,epoll}]. The epoll loop "
+            "always uses a timer wheel for alarms and does not support the "
+            "logind console provider.")
+        (gl_program_cache_opt, po::value<bool>()->default_value(false),
+            "Save linked GL shader programs under $XDG_CACHE_HOME/mir and reuse "
+            "them on later runs (if the driver supports GL_OES_get_program_binary). "
+            "Off by default, so that servers (and tests) don't write to the user's cache.")
+        (wayland_record_opt, po::value<std::string>(),
+            "Directory to record the requests (and SHM buffer contents) of every Wayland client "
+            "into, for replaying as a deterministic test. Recordings include everything clients "
+            "send, such as typed text and clipboard content.")
+        (hidden_frame_interval_opt, po::value<int>()->default_value(1000),
+            "Interval (in milliseconds) between frame callbacks for Wayland surfaces that can't "
+            "be seen: occluded, off-screen, minimised or hidden. 0 sends them no frame callbacks "
+            "until they can be seen again. Surfaces that can be seen get their frame callbacks "
+            "as they are composited.")
         (fatal_except_opt, "On \"fatal error\" conditions [e.g. drivers behaving "
             "in unexpected ways] throw an exception (instead of a core dump)")
         (debug_opt, "Enable extra development debugging. "
@@ -111,6 +111,11 @@ size_t mgk::DRMModeResources::num_connectors() const
     return resources->count_connectors;
 }
 
+std::vector<uint32_t> mgk::DRMModeResources::connector_ids() const
+{
+    return {resources->connectors, resources->connectors + resources->count_connectors};
+}
+
 size_t mgk::DRMModeResources::num_encoders() const
 {
     return resources->count_encoders;
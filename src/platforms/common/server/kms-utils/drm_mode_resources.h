@@ -24,6 +24,7 @@
 #include <functional>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace mir
 {
@@ -146,6 +147,8 @@ public:
     void for_each_crtc(std::function<void(DRMModeCrtcUPtr)> const& f) const;
 
     size_t num_connectors() const;
+    /// The IDs of all connectors, without probing them (unlike connectors() and for_each_connector())
+    std::vector<uint32_t> connector_ids() const;
 
     size_t num_encoders() const;
 
@@ -44,6 +44,10 @@
 
 #include <stdexcept>
 #include <algorithm>
+#include <cstdlib>
+#include <future>
+#include <mutex>
+#include <optional>
 #include <unordered_map>
 
 namespace mgg = mir::graphics::gbm;
@@ -169,11 +173,28 @@ void log_drm_details(std::vector<std::shared_ptr<mgg::helpers::DRMHelper>> const
     }
 }
 
+/* Hotplug uevents for a single connector name it (Linux 5.6 and later); other uevents,
+ * such as those from hotplug polling, don't and may affect any connector on the device.
+ */
+auto connector_from_uevent(mir::udev::Device const& device) -> std::optional<uint32_t>
+{
+    if (auto const connector = device.property("CONNECTOR"))
+    {
+        char* end;
+        auto const id = strtoul(connector, &end, 10);
+        if (*connector && !*end)
+        {
+            return static_cast<uint32_t>(id);
+        }
+    }
+    return std::nullopt;
+}
 }
 
 mgg::Display::Display(std::vector<std::shared_ptr<helpers::DRMHelper>> const& drm,
                       std::shared_ptr<helpers::GBMHelper> const& gbm,
                       mgg::BypassOption bypass_option,
+                      mgg::CompositingOption compositing_option,
                       std::shared_ptr<DisplayConfigurationPolicy> const& initial_conf_policy,
                       std::shared_ptr<GLConfig> const& gl_config,
                       std::shared_ptr<DisplayReport> const& listener)
@@ -200,9 +221,25 @@ mgg::Display::Display(std::vector<std::shared_ptr<helpers::DRMHelper>> const& dr
       current_display_configuration{output_container},
       dirty_configuration{false},
       bypass_option(bypass_option),
+      compositing_option{compositing_option},
       gl_config{gl_config}
 {
-    shared_egl.setup(*gbm);
+    if (compositing_option == CompositingOption::dumb_buffers)
+    {
+        // Nothing we put on screen needs GL, so carry on without it if the driver is unusable
+        try
+        {
+            shared_egl.setup(*gbm);
+        }
+        catch (std::exception const& error)
+        {
+            mir::log_warning("Failed to set up EGL, GL contexts will not be available: %s", error.what());
+        }
+    }
+    else
+    {
+        shared_egl.setup(*gbm);
+    }
 
     monitor.filter_by_subsystem_and_type("drm", "drm_minor");
     monitor.enable();
@@ -271,8 +308,11 @@ void mgg::Display::register_configuration_change_handler(
             [conf_change_handler, this](int)
             {
                 monitor.process_events([conf_change_handler, this]
-                                       (mir::udev::Monitor::EventType, mir::udev::Device const&)
+                                       (mir::udev::Monitor::EventType, mir::udev::Device const& device)
                                        {
+                                            output_container->mark_changed(
+                                                device.devnum(),
+                                                connector_from_uevent(device));
                                             dirty_configuration = true;
                                             conf_change_handler();
                                        });
@@ -439,6 +479,30 @@ auto get_equivalent_other_alphaness_format(mg::DRMFormat const format) -> std::o
     }
 }
 
+/*
+ * Runs each of the builders, concurrently if there is more than one, and returns their results in order.
+ *
+ * Any exception is rethrown once every builder has finished.
+ */
+template<typename T>
+auto build_concurrently(std::vector<std::function<T()>> const& builders) -> std::vector<T>
+{
+    std::vector<T> results;
+    if (builders.empty())
+        return results;
+
+    std::vector<std::future<T>> others;
+    for (auto i = 1u; i < builders.size(); ++i)
+        others.push_back(std::async(std::launch::async, builders[i]));
+
+    // Make use of this thread, too. (Should this throw, destroying `others` waits for the rest.)
+    results.push_back(builders.front()());
+    for (auto& other : others)
+        results.push_back(other.get());
+
+    return results;
+}
+
 auto make_surface_with_egl_context(
     geom::Size size,
     mg::DRMFormat format,
@@ -532,6 +596,22 @@ void mgg::Display::configure_locked(
     OverlappingOutputGrouping grouping{kms_conf};
     auto group_idx = 0;
 
+    /*
+     * Each new DisplayBuffer has its own surface and EGL context, so we set them all up
+     * concurrently; the driver work (first buffer allocation, clear and swap, and FB
+     * creation) would otherwise add up over the number of outputs.
+     */
+    std::vector<std::function<std::unique_ptr<DisplayBuffer>()>> display_buffer_builders;
+    /*
+     * Serialises creating the GBM surface, and the EGL surface and context for it. GBM does
+     * not promise that surface creation is thread-safe, and each new context shares
+     * shared_egl's, which the other builders are sharing at the same time.
+     *
+     * After that, each builder only uses its own surface and context, which DisplayBuffer
+     * releases before returning, so the rest of the setup can run concurrently.
+     */
+    auto const surface_creation_mutex = std::make_shared<std::mutex>();
+
     grouping.for_each_group(
         [&](OverlappingOutputGroup const& group)
         {
@@ -577,43 +657,89 @@ void mgg::Display::configure_locked(
 
                 for (auto const& group : kms_output_groups)
                 {
-                    // TODO: Pull this out of the configuration
-                    // TODO: Actually query available formats!
-                    mg::DRMFormat format{GBM_FORMAT_XRGB8888};
-                    /*
-                     * In a hybrid setup a scanout surface needs to be allocated differently if it
-                     * needs to be able to be shared across GPUs. This likely reduces performance.
-                     *
-                     * As a first cut, assume every scanout buffer in a hybrid setup might need
-                     * to be shared.
-                     */
-                    auto [surface, egl] = make_surface_with_egl_context(
-                        current_mode_resolution,
-                        format,
-                        *gbm,
-                        *gl_config,
-                        shared_egl.context(),
-                        drm.size() != 1);
-                    auto db = std::make_unique<DisplayBuffer>(
-                        bypass_option,
-                        listener,
-                        group,
-                        GBMOutputSurface{
-                            group.front()->drm_fd(),
-                            std::move(surface),
-                            width, height,
-                            std::move(egl)
-                        },
-                        bounding_rect,
-                        transformation);
-
-                    display_buffers_new.push_back(std::move(db));
+                    if (compositing_option == CompositingOption::dumb_buffers)
+                    {
+                        display_buffer_builders.push_back(
+                            [this, group, bounding_rect, transformation, current_mode_resolution]()
+                            {
+                                /*
+                                 * Unless we're driving a single output DisplayBuffer::post() returns
+                                 * before the last frame is on screen, so the next frame needs a third
+                                 * buffer to be drawn into.
+                                 */
+                                auto const buffer_count = group.size() == 1 ? 2 : 3;
+                                return std::make_unique<DisplayBuffer>(
+                                    bypass_option,
+                                    listener,
+                                    group,
+                                    std::make_unique<DumbOutputSurface>(
+                                        group.front()->drm_fd(),
+                                        current_mode_resolution,
+                                        buffer_count),
+                                    bounding_rect,
+                                    transformation);
+                            });
+                        continue;
+                    }
+
+                    display_buffer_builders.push_back(
+                        [this, group, width, height, bounding_rect, transformation, current_mode_resolution,
+                            surface_creation_mutex, shared_context = shared_egl.context()]()
+                        {
+                            // TODO: Pull this out of the configuration
+                            // TODO: Actually query available formats!
+                            mg::DRMFormat format{GBM_FORMAT_XRGB8888};
+                            /*
+                             * In a hybrid setup a scanout surface needs to be allocated differently if it
+                             * needs to be able to be shared across GPUs. This likely reduces performance.
+                             *
+                             * As a first cut, assume every scanout buffer in a hybrid setup might need
+                             * to be shared.
+                             */
+                            // Creates the EGL context too, so keep that under the lock
+                            std::unique_lock lock{*surface_creation_mutex};
+                            auto [surface, egl] = make_surface_with_egl_context(
+                                current_mode_resolution,
+                                format,
+                                *gbm,
+                                *gl_config,
+                                shared_context,
+                                drm.size() != 1);
+                            lock.unlock();
+
+                            return std::make_unique<DisplayBuffer>(
+                                bypass_option,
+                                listener,
+                                group,
+                                GBMOutputSurface{
+                                    group.front()->drm_fd(),
+                                    std::move(surface),
+                                    width, height,
+                                    std::move(egl)
+                                },
+                                bounding_rect,
+                                transformation);
+                        });
                 }
             }
         });
 
     if (!comp)
+    {
+        display_buffers_new = build_concurrently(display_buffer_builders);
+
+        /*
+         * Only light up the outputs once they all have a frame to show, so the
+         * modesets happen back-to-back rather than spread out over setup.
+         *
+         * (Without atomic modesetting support in KMSOutput this is still one
+         * drmModeSetCrtc() per CRTC.)
+         */
+        for (auto const& db : display_buffers_new)
+            db->set_initial_crtc();
+
         display_buffers = std::move(display_buffers_new);
+    }
 
     /* Store applied configuration */
     current_display_configuration = kms_conf;
@@ -59,6 +59,7 @@ public:
     Display(std::vector<std::shared_ptr<helpers::DRMHelper>> const& drm,
             std::shared_ptr<helpers::GBMHelper> const& gbm,
             BypassOption bypass_option,
+            CompositingOption compositing_option,
             std::shared_ptr<DisplayConfigurationPolicy> const& initial_conf_policy,
             std::shared_ptr<GLConfig> const& gl_config,
             std::shared_ptr<DisplayReport> const& listener);
@@ -104,6 +105,7 @@ private:
         std::lock_guard<decltype(configuration_mutex)> const&);
 
     BypassOption bypass_option;
+    CompositingOption const compositing_option;
     std::weak_ptr<Cursor> cursor;
     std::shared_ptr<GLConfig> const gl_config;
 };
@@ -27,6 +27,7 @@
 #include "mir/graphics/egl_error.h"
 #include "mir/graphics/gl_config.h"
 #include "mir/graphics/dmabuf_buffer.h"
+#include "mir/renderer/sw/pixel_source.h"
 
 #include <boost/throw_exception.hpp>
 #include <EGL/egl.h>
@@ -446,11 +447,11 @@ mgg::DisplayBuffer::DisplayBuffer(
 
     glClear(GL_COLOR_BUFFER_BIT);
 
-    surface.swap_buffers();
+    surface->swap_buffers();
 
     listener->report_successful_egl_buffer_swap_on_construction();
 
-    auto temporary_front = surface.lock_front();
+    auto temporary_front = surface->lock_front();
     if (!temporary_front)
         fatal_error("Failed to get frontbuffer");
 
@@ -461,8 +462,8 @@ mgg::DisplayBuffer::DisplayBuffer(
             std::mem_fn(&EGLBufferCopier::copy_front_buffer_from),
             std::make_shared<EGLBufferCopier>(
                 mir::Fd{mir::IntOwnedFd{outputs.front()->drm_fd()}},
-                surface.size().width.as_int(),
-                surface.size().height.as_int(),
+                surface->size().width.as_int(),
+                surface->size().height.as_int(),
                 GBM_FORMAT_XRGB8888),
             std::placeholders::_1);
     }
@@ -487,19 +488,36 @@ mgg::DisplayBuffer::DisplayBuffer(
         }
     }
 
-    set_crtc(*outputs.front()->fb_for(visible_composite_frame));
-
     release_current();
 
-    listener->report_successful_drm_mode_set_crtc_on_construction();
     listener->report_successful_display_construction();
-    surface.report_egl_configuration(
+    surface->report_egl_configuration(
         [&listener] (EGLDisplay disp, EGLConfig cfg)
         {
             listener->report_egl_configuration(disp, cfg);
         });
 }
 
+mgg::DisplayBuffer::DisplayBuffer(
+    mgg::BypassOption option,
+    std::shared_ptr<DisplayReport> const& listener,
+    std::vector<std::shared_ptr<KMSOutput>> const& outputs,
+    std::unique_ptr<DumbOutputSurface> surface_dumb,
+    geom::Rectangle const& area,
+    glm::mat2 const& transformation)
+    : listener(listener),
+      bypass_option(option),
+      outputs(outputs),
+      dumb_surface{std::move(surface_dumb)},
+      area(area),
+      transform{transformation},
+      needs_set_crtc{false},
+      page_flips_pending{false}
+{
+    listener->report_successful_setup_of_native_resources();
+    listener->report_successful_display_construction();
+}
+
 mgg::DisplayBuffer::~DisplayBuffer()
 {
 }
@@ -522,6 +540,11 @@ void mgg::DisplayBuffer::set_transformation(glm::mat2 const& t, geometry::Rectan
 
 bool mgg::DisplayBuffer::overlay(RenderableList const& renderable_list)
 {
+    if (dumb_surface)
+    {
+        return overlay_by_copying(renderable_list);
+    }
+
     glm::mat2 static const no_transformation(1);
     if (transform == no_transformation &&
        (bypass_option == mgg::BypassOption::allowed))
@@ -533,7 +556,7 @@ bool mgg::DisplayBuffer::overlay(RenderableList const& renderable_list)
             auto bypass_buffer = (*bypass_it)->buffer();
             auto dmabuf_image = dynamic_cast<mg::DMABufBuffer*>(bypass_buffer->native_buffer_base());
             if (dmabuf_image &&
-                bypass_buffer->size() == surface.size())
+                bypass_buffer->size() == surface->size())
             {
                 if (auto bufobj = outputs.front()->fb_for(*dmabuf_image))
                 {
@@ -545,11 +568,81 @@ bool mgg::DisplayBuffer::overlay(RenderableList const& renderable_list)
         }
     }
 
+    if (transform == no_transformation && overlay_shm_by_copying(renderable_list))
+    {
+        return true;
+    }
+
     bypass_buf = nullptr;
     bypass_bufobj = nullptr;
     return false;
 }
 
+bool mgg::DisplayBuffer::overlay_by_copying(RenderableList const& renderable_list)
+{
+    /*
+     * A fullscreen client buffer can be copied straight into the next dumb buffer, which is
+     * cheaper than compositing it: there is no blending, scaling or format conversion.
+     * Unlike bypass the client buffer isn't held after this, so this doesn't need BypassOption.
+     */
+    glm::mat2 static const no_transformation(1);
+    if (transform != no_transformation)
+        return false;
+
+    mgg::BypassMatch bypass_match(area);
+    auto const fullscreen = std::find_if(renderable_list.rbegin(), renderable_list.rend(), bypass_match);
+    if (fullscreen == renderable_list.rend())
+        return false;
+
+    auto const buffer = (*fullscreen)->buffer();
+    auto const mappable = dynamic_cast<mir::renderer::software::ReadMappableBuffer*>(buffer->native_buffer_base());
+    return mappable && dumb_surface->copy_frame_from(*mappable);
+}
+
+bool mgg::DisplayBuffer::overlay_shm_by_copying(RenderableList const& renderable_list)
+{
+    /*
+     * A fullscreen wl_shm buffer can't be scanned out itself, but copying it into a dumb buffer
+     * that can be is much cheaper than uploading it to a texture and compositing. As with
+     * overlay_by_copying() the client buffer isn't held, so this doesn't need BypassOption.
+     */
+    if (shm_scanout_unavailable)
+        return false;
+
+    mgg::BypassMatch bypass_match(area);
+    auto const fullscreen = std::find_if(renderable_list.rbegin(), renderable_list.rend(), bypass_match);
+    if (fullscreen == renderable_list.rend())
+        return false;
+
+    auto const buffer = (*fullscreen)->buffer();
+    auto const mappable = dynamic_cast<mir::renderer::software::ReadMappableBuffer*>(buffer->native_buffer_base());
+    if (!mappable || buffer->size() != surface->size())
+        return false;
+
+    if (!shm_scanout)
+    {
+        try
+        {
+            // post() waits for each copied frame to reach the screen, so two buffers are enough
+            shm_scanout = std::make_unique<DumbOutputSurface>(outputs.front()->drm_fd(), surface->size(), 2);
+        }
+        catch (std::exception const& error)
+        {
+            mir::log_warning(
+                "Fullscreen SHM buffers will be composited: failed to allocate dumb buffers for them: %s",
+                error.what());
+            shm_scanout_unavailable = true;
+            return false;
+        }
+    }
+
+    if (!shm_scanout->copy_frame_from(*mappable))
+        return false;
+
+    bypass_bufobj = shm_scanout->front_fb();
+    return true;
+}
+
 void mgg::DisplayBuffer::for_each_display_buffer(
     std::function<void(graphics::DisplayBuffer&)> const& f)
 {
@@ -558,7 +651,8 @@ void mgg::DisplayBuffer::for_each_display_buffer(
 
 void mgg::DisplayBuffer::swap_buffers()
 {
-    surface.swap_buffers();
+    if (surface)
+        surface->swap_buffers();
     bypass_buf = nullptr;
     bypass_bufobj = nullptr;
 }
@@ -592,13 +686,17 @@ void mgg::DisplayBuffer::post()
     wait_for_page_flip();
 
     std::shared_ptr<mgg::FBHandle const> bufobj;
-    if (bypass_buf)
+    if (bypass_bufobj)
     {
         bufobj = bypass_bufobj;
     }
+    else if (dumb_surface)
+    {
+        bufobj = dumb_surface->front_fb();
+    }
     else
     {
-        scheduled_composite_frame = get_front_buffer(surface.lock_front());
+        scheduled_composite_frame = get_front_buffer(surface->lock_front());
         bufobj = outputs.front()->fb_for(scheduled_composite_frame);
         if (!bufobj)
             fatal_error("Failed to get front buffer object");
@@ -631,7 +729,7 @@ void mgg::DisplayBuffer::post()
     // Predicted worst case render time for the next frame...
     auto predicted_render_time = 50ms;
 
-    if (bypass_buf)
+    if (bypass_bufobj)
     {
         /*
          * For composited frames we defer wait_for_page_flip till just before
@@ -645,6 +743,13 @@ void mgg::DisplayBuffer::post()
         scheduled_bypass_frame = bypass_buf;
         wait_for_page_flip();
 
+        if (!bypass_buf)
+        {
+            // A copied SHM frame holds no client buffer, and is now on screen in place of the last frame
+            visible_bypass_frame = nullptr;
+            visible_composite_frame = nullptr;
+        }
+
         // It's very likely the next frame will be bypassed like this one so
         // we only need time for kernel page flip scheduling...
         predicted_render_time = 5ms;
@@ -731,22 +836,36 @@ void mgg::DisplayBuffer::wait_for_page_flip()
 
 auto mgg::DisplayBuffer::size() const -> geometry::Size
 {
-    return surface.size();
+    return surface ? surface->size() : dumb_surface->size();
 }
 
 void mgg::DisplayBuffer::make_current()
 {
-    surface.make_current();
+    if (surface)
+        surface->make_current();
 }
 
 void mgg::DisplayBuffer::bind()
 {
-    surface.bind();
+    if (surface)
+        surface->bind();
 }
 
 void mgg::DisplayBuffer::release_current()
 {
-    surface.release_current();
+    if (surface)
+        surface->release_current();
+}
+
+void mgg::DisplayBuffer::set_initial_crtc()
+{
+    if (dumb_surface)
+        // Dumb buffers are created zeroed, so any of them is a blank frame
+        set_crtc(*dumb_surface->front_fb());
+    else
+        set_crtc(*outputs.front()->fb_for(visible_composite_frame));
+
+    listener->report_successful_drm_mode_set_crtc_on_construction();
 }
 
 void mgg::DisplayBuffer::schedule_set_crtc()
@@ -756,6 +875,8 @@ void mgg::DisplayBuffer::schedule_set_crtc()
 
 mg::NativeDisplayBuffer* mgg::DisplayBuffer::native_display_buffer()
 {
+    if (dumb_surface)
+        return dumb_surface.get();
     return this;
 }
 
@@ -21,12 +21,14 @@
 #include "mir/graphics/display.h"
 #include "mir/renderer/gl/render_target.h"
 #include "display_helpers.h"
+#include "dumb_output_surface.h"
 #include "egl_helper.h"
 #include "platform_common.h"
 
 #include <vector>
 #include <memory>
 #include <atomic>
+#include <optional>
 
 namespace mir
 {
@@ -103,6 +105,18 @@ public:
                   GBMOutputSurface&& surface_gbm,
                   geometry::Rectangle const& area,
                   glm::mat2 const& transformation);
+    /**
+     * A DisplayBuffer composited on the CPU into dumb buffers, rather than with GL.
+     *
+     * Its native_display_buffer() is a renderer::software::RenderTarget, and the
+     * gl::RenderTarget methods do nothing.
+     */
+    DisplayBuffer(BypassOption bypass_options,
+                  std::shared_ptr<DisplayReport> const& listener,
+                  std::vector<std::shared_ptr<KMSOutput>> const& outputs,
+                  std::unique_ptr<DumbOutputSurface> surface_dumb,
+                  geometry::Rectangle const& area,
+                  glm::mat2 const& transformation);
     ~DisplayBuffer();
 
     geometry::Rectangle view_area() const override;
@@ -122,12 +136,17 @@ public:
     NativeDisplayBuffer* native_display_buffer() override;
 
     void set_transformation(glm::mat2 const& t, geometry::Rectangle const& a);
+    /// Puts the (blank) frame rendered at construction on screen.
+    /// This is separate from construction so that Display can bring up all its outputs together.
+    void set_initial_crtc();
     void schedule_set_crtc();
     void wait_for_page_flip();
 
 private:
     bool schedule_page_flip(FBHandle const& bufobj);
     void set_crtc(FBHandle const&);
+    bool overlay_by_copying(RenderableList const& renderlist);
+    bool overlay_shm_by_copying(RenderableList const& renderlist);
 
     std::shared_ptr<graphics::Buffer> visible_bypass_frame, scheduled_bypass_frame;
     std::shared_ptr<Buffer> bypass_buf{nullptr};
@@ -144,7 +163,12 @@ private:
      *  ii) The EGLBufferCopier hidden inside get_front_buffer
      */
     std::function<GBMOutputSurface::FrontBuffer(GBMOutputSurface::FrontBuffer&&)> get_front_buffer;
-    GBMOutputSurface surface;
+    /// Exactly one of surface and dumb_surface is set
+    std::optional<GBMOutputSurface> surface;
+    std::unique_ptr<DumbOutputSurface> const dumb_surface;
+    /// Fullscreen SHM buffers are copied into these for scanout (created on first use)
+    std::unique_ptr<DumbOutputSurface> shm_scanout;
+    bool shm_scanout_unavailable{false};
 
     GBMOutputSurface::FrontBuffer visible_composite_frame;
     GBMOutputSurface::FrontBuffer scheduled_composite_frame;
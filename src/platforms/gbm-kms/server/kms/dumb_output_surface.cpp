@@ -0,0 +1,210 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dumb_output_surface.h"
+#include "fb_handle.h"
+#include "mir/log.h"
+
+#include <boost/throw_exception.hpp>
+#include <drm_fourcc.h>
+#include <xf86drm.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstring>
+#include <system_error>
+
+namespace mg = mir::graphics;
+namespace mgg = mir::graphics::gbm;
+namespace mrs = mir::renderer::software;
+namespace geom = mir::geometry;
+
+class mgg::DumbOutputSurface::DumbBuffer
+{
+public:
+    DumbBuffer(int drm_fd, geom::Size size)
+        : drm_fd{drm_fd}
+    {
+        drm_mode_create_dumb params{};
+        params.width = size.width.as_uint32_t();
+        params.height = size.height.as_uint32_t();
+        params.bpp = 32;
+
+        if (drmIoctl(drm_fd, DRM_IOCTL_MODE_CREATE_DUMB, &params) != 0)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create dumb buffer"}));
+        }
+        gem_handle = params.handle;
+        pitch = params.pitch;
+        length = params.size;
+
+        try
+        {
+            uint32_t const handles[4] = {gem_handle, 0, 0, 0};
+            uint32_t const pitches[4] = {pitch, 0, 0, 0};
+            uint32_t const offsets[4] = {0, 0, 0, 0};
+            uint32_t fb_id;
+            if (auto const error = -drmModeAddFB2(
+                drm_fd, params.width, params.height, DRM_FORMAT_XRGB8888, handles, pitches, offsets, &fb_id, 0))
+            {
+                BOOST_THROW_EXCEPTION((std::system_error{error, std::system_category(), "Failed to attach dumb buffer to FB"}));
+            }
+            fb = std::make_shared<FBHandle>(drm_fd, fb_id);
+
+            drm_mode_map_dumb map_request{};
+            map_request.handle = gem_handle;
+            if (drmIoctl(drm_fd, DRM_IOCTL_MODE_MAP_DUMB, &map_request) != 0)
+            {
+                BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to map dumb buffer"}));
+            }
+
+            auto const map = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, drm_fd, map_request.offset);
+            if (map == MAP_FAILED)
+            {
+                BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to mmap() dumb buffer"}));
+            }
+            pixels = static_cast<unsigned char*>(map);
+        }
+        catch (...)
+        {
+            fb = nullptr;
+            destroy();
+            throw;
+        }
+
+        // Dumb buffers are zeroed on creation, which is already opaque black in XRGB8888
+    }
+
+    ~DumbBuffer()
+    {
+        munmap(pixels, length);
+        fb = nullptr;
+        destroy();
+    }
+
+    DumbBuffer(DumbBuffer const&) = delete;
+    DumbBuffer& operator=(DumbBuffer const&) = delete;
+
+    int const drm_fd;
+    uint32_t gem_handle;
+    uint32_t pitch;
+    size_t length;
+    unsigned char* pixels{nullptr};
+    std::shared_ptr<FBHandle const> fb;
+    /// The frame last drawn into this buffer, or 0 if there is none
+    unsigned frame{0};
+
+private:
+    void destroy()
+    {
+        drm_mode_destroy_dumb params{};
+        params.handle = gem_handle;
+        if (drmIoctl(drm_fd, DRM_IOCTL_MODE_DESTROY_DUMB, &params) != 0)
+        {
+            mir::log_warning("Failed to destroy dumb buffer: %s", std::strerror(errno));
+        }
+    }
+};
+
+mgg::DumbOutputSurface::DumbOutputSurface(int drm_fd, geom::Size size, size_t buffer_count)
+    : drm_fd{drm_fd},
+      size_{size}
+{
+    for (size_t i = 0; i != buffer_count; ++i)
+    {
+        buffers.push_back(std::make_unique<DumbBuffer>(drm_fd, size));
+    }
+}
+
+mgg::DumbOutputSurface::~DumbOutputSurface() = default;
+
+auto mgg::DumbOutputSurface::size() const -> geom::Size
+{
+    return size_;
+}
+
+auto mgg::DumbOutputSurface::map_back_buffer() -> std::unique_ptr<mrs::Mapping<unsigned char>>
+{
+    class Mapping : public mrs::Mapping<unsigned char>
+    {
+    public:
+        Mapping(DumbBuffer& buffer, geom::Size size)
+            : buffer{buffer},
+              size_{size}
+        {
+        }
+
+        auto format() const -> MirPixelFormat override { return mir_pixel_format_xrgb_8888; }
+        auto stride() const -> geom::Stride override { return geom::Stride{buffer.pitch}; }
+        auto size() const -> geom::Size override { return size_; }
+        auto data() -> unsigned char* override { return buffer.pixels; }
+        auto len() const -> size_t override { return buffer.length; }
+
+    private:
+        DumbBuffer& buffer;
+        geom::Size const size_;
+    };
+
+    return std::make_unique<Mapping>(*buffers[back], size_);
+}
+
+auto mgg::DumbOutputSurface::back_buffer_age() const -> unsigned
+{
+    auto const drawn = buffers[back]->frame;
+    return drawn ? frame_count - drawn + 1 : 0;
+}
+
+void mgg::DumbOutputSurface::swap_buffers()
+{
+    buffers[back]->frame = ++frame_count;
+    back = (back + 1) % buffers.size();
+}
+
+bool mgg::DumbOutputSurface::copy_frame_from(mrs::ReadMappableBuffer& source)
+{
+    // The FB ignores alpha, so ARGB can be scanned out as XRGB
+    if (source.size() != size_ ||
+        (source.format() != mir_pixel_format_xrgb_8888 && source.format() != mir_pixel_format_argb_8888))
+    {
+        return false;
+    }
+
+    auto const mapping = source.map_readable();
+    auto& target = *buffers[back];
+    auto const row_bytes = size_.width.as_uint32_t() * 4;
+    auto const src_stride = mapping->stride().as_uint32_t();
+    auto const src = mapping->data();
+
+    if (src_stride == target.pitch)
+    {
+        std::memcpy(target.pixels, src, target.pitch * size_.height.as_uint32_t());
+    }
+    else
+    {
+        for (uint32_t y = 0; y != size_.height.as_uint32_t(); ++y)
+        {
+            std::memcpy(target.pixels + y * target.pitch, src + y * src_stride, row_bytes);
+        }
+    }
+
+    swap_buffers();
+    return true;
+}
+
+auto mgg::DumbOutputSurface::front_fb() const -> std::shared_ptr<FBHandle const>
+{
+    return buffers[(back + buffers.size() - 1) % buffers.size()]->fb;
+}
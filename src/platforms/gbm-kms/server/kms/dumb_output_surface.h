@@ -0,0 +1,86 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_GBM_DUMB_OUTPUT_SURFACE_H_
+#define MIR_GRAPHICS_GBM_DUMB_OUTPUT_SURFACE_H_
+
+#include "mir/graphics/display_buffer.h"
+#include "mir/renderer/sw/render_target.h"
+#include "mir/geometry/size.h"
+
+#include <memory>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+namespace gbm
+{
+
+class FBHandle;
+
+/**
+ * A swapchain of DRM dumb buffers, drawn into by the CPU and scanned out directly.
+ *
+ * This needs nothing from the GPU driver beyond KMS, so it also works on display
+ * hardware without a usable GL implementation.
+ */
+class DumbOutputSurface : public NativeDisplayBuffer,
+                          public renderer::software::RenderTarget
+{
+public:
+    /**
+     * \param [in] buffer_count The number of buffers to cycle through. This must be at least
+     *                          the number of frames that can be on screen or queued for a
+     *                          page flip while the next is drawn.
+     */
+    DumbOutputSurface(int drm_fd, geometry::Size size, size_t buffer_count);
+    ~DumbOutputSurface();
+
+    // software::RenderTarget
+    auto size() const -> geometry::Size override;
+    auto map_back_buffer() -> std::unique_ptr<renderer::software::Mapping<unsigned char>> override;
+    auto back_buffer_age() const -> unsigned override;
+    void swap_buffers() override;
+
+    /**
+     * Copy a frame into the back buffer and swap it to the front, without compositing.
+     *
+     * \return  false (leaving the back buffer untouched) if the source is not the size of
+     *          the surface or not in a format that can be copied as-is.
+     */
+    bool copy_frame_from(renderer::software::ReadMappableBuffer& source);
+
+    /// The framebuffer holding the frame most recently swapped to the front
+    auto front_fb() const -> std::shared_ptr<FBHandle const>;
+
+private:
+    class DumbBuffer;
+
+    int const drm_fd;
+    geometry::Size const size_;
+    std::vector<std::unique_ptr<DumbBuffer>> buffers;
+    size_t back{0};
+    /// The number of frames swapped so far; DumbBuffer::frame is the value this had when it was drawn
+    unsigned frame_count{0};
+};
+
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_GBM_DUMB_OUTPUT_SURFACE_H_ */
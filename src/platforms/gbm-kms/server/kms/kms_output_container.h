@@ -20,6 +20,9 @@
 #include <cstdint>
 #include <memory>
 #include <functional>
+#include <optional>
+
+#include <sys/types.h>
 
 namespace mir
 {
@@ -39,8 +42,20 @@ public:
 
     /**
      * Re-probe hardware state and update output list.
+     *
+     * Outputs that already exist are only re-probed if they have been marked as changed
+     * since the last update (all outputs are initially marked as changed).
      */
     virtual void update_from_hardware_state() = 0;
+
+    /**
+     * Mark outputs as needing to be re-probed by the next update_from_hardware_state().
+     *
+     * \param drm_device   The device number of the DRM device that changed
+     * \param connector_id The connector that changed or, if unknown, std::nullopt to mark
+     *                     every output on the device.
+     */
+    virtual void mark_changed(dev_t drm_device, std::optional<uint32_t> connector_id) = 0;
 protected:
     KMSOutputContainer() = default;
     KMSOutputContainer(KMSOutputContainer const&) = delete;
@@ -33,6 +33,7 @@ mgg::Platform::Platform(std::shared_ptr<DisplayReport> const& listener,
                         ConsoleServices& vt,
                         EmergencyCleanupRegistry&,
                         BypassOption bypass_option,
+                        CompositingOption compositing_option,
                         std::unique_ptr<Quirks> quirks)
     : udev{std::make_shared<mir::udev::Context>()},
       drm{helpers::DRMHelper::open_all_devices(udev, vt, *quirks)},
@@ -42,7 +43,8 @@ mgg::Platform::Platform(std::shared_ptr<DisplayReport> const& listener,
       // TODO: expose multiple rendering GPUs to the shell.
       gbm{std::make_shared<mgmh::GBMHelper>(drm.front()->fd)},
       listener{listener},
-      bypass_option_{bypass_option}
+      bypass_option_{bypass_option},
+      compositing_option{compositing_option}
 {
 }
 
@@ -53,6 +55,7 @@ mir::UniqueModulePtr<mg::Display> mgg::Platform::create_display(
         drm,
         gbm,
         bypass_option_,
+        compositing_option,
         initial_conf_policy,
         gl_config,
         listener);
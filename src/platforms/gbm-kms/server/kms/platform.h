@@ -40,6 +40,7 @@ public:
                       ConsoleServices& vt,
                       EmergencyCleanupRegistry& emergency_cleanup_registry,
                       BypassOption bypass_option,
+                      CompositingOption compositing_option,
                       std::unique_ptr<Quirks> quirks);
 
     /* From Platform */
@@ -56,6 +57,7 @@ public:
     BypassOption bypass_option() const;
 private:
     BypassOption const bypass_option_;
+    CompositingOption const compositing_option;
 };
 }
 }
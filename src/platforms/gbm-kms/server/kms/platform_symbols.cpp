@@ -48,6 +48,7 @@ namespace mo = mir::options;
 namespace
 {
 char const* bypass_option_name{"bypass"};
+char const* dumb_buffers_option_name{"dumb-buffers"};
 
 }
 
@@ -70,10 +71,14 @@ mir::UniqueModulePtr<mg::DisplayPlatform> create_display_platform(
     if (!options->get<bool>(bypass_option_name))
         bypass_option = mgg::BypassOption::prohibited;
 
+    auto compositing_option = mgg::CompositingOption::gl;
+    if (options->get<bool>(dumb_buffers_option_name))
+        compositing_option = mgg::CompositingOption::dumb_buffers;
+
     auto quirks = std::make_unique<mgg::Quirks>(*options);
 
     return mir::make_module_ptr<mgg::Platform>(
-        report, *console, *emergency_cleanup_registry, bypass_option, std::move(quirks));
+        report, *console, *emergency_cleanup_registry, bypass_option, compositing_option, std::move(quirks));
 }
 
 void add_graphics_platform_options(boost::program_options::options_description& config)
@@ -82,7 +87,11 @@ void add_graphics_platform_options(boost::program_options::options_description&
     config.add_options()
         (bypass_option_name,
          boost::program_options::value<bool>()->default_value(false),
-         "[platform-specific] utilize the bypass optimization for fullscreen surfaces.");
+         "[platform-specific] utilize the bypass optimization for fullscreen surfaces.")
+        (dumb_buffers_option_name,
+         boost::program_options::value<bool>()->default_value(false),
+         "[platform-specific] composite on the CPU into DRM dumb buffers rather than with GL. "
+         "For display hardware without a working GPU driver.");
     mgg::Quirks::add_quirks_option(config);
 }
 
@@ -123,25 +132,31 @@ auto probe_display_platform(
         return {};
     }
 
-    // We also require GBM EGL platform
-    auto const* client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
-    if (!client_extensions)
-    {
-        // Doesn't support EGL client extensions; Mesa does, so this is unlikely to be gbm-kms.
-        mir::log_info("Unsupported: EGL platform does not support client extensions.");
-        return {};
-    }
-    if (strstr(client_extensions, "EGL_KHR_platform_gbm") == nullptr)
+    // Compositing into dumb buffers needs nothing from the GPU driver beyond KMS
+    bool const requires_gl = !options.get(dumb_buffers_option_name, false);
+
+    if (requires_gl)
     {
-        // Doesn't support the Khronos-standardised GBM platform…
-        mir::log_info("EGL platform does not support EGL_KHR_platform_gbm extension");
-        // …maybe we support the old pre-standardised Mesa GBM platform?
-        if (strstr(client_extensions, "EGL_MESA_platform_gbm") == nullptr)
+        // Otherwise, we also require GBM EGL platform
+        auto const* client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        if (!client_extensions)
         {
-            mir::log_info(
-                "Unsupported: EGL platform supports neither EGL_KHR_platform_gbm nor EGL_MESA_platform_gbm");
+            // Doesn't support EGL client extensions; Mesa does, so this is unlikely to be gbm-kms.
+            mir::log_info("Unsupported: EGL platform does not support client extensions.");
             return {};
         }
+        if (strstr(client_extensions, "EGL_KHR_platform_gbm") == nullptr)
+        {
+            // Doesn't support the Khronos-standardised GBM platform…
+            mir::log_info("EGL platform does not support EGL_KHR_platform_gbm extension");
+            // …maybe we support the old pre-standardised Mesa GBM platform?
+            if (strstr(client_extensions, "EGL_MESA_platform_gbm") == nullptr)
+            {
+                mir::log_info(
+                    "Unsupported: EGL platform supports neither EGL_KHR_platform_gbm nor EGL_MESA_platform_gbm");
+                return {};
+            }
+        }
     }
 
 
@@ -199,27 +214,30 @@ auto probe_display_platform(
                         std::string{"Failed to set DRM interface version on device "} + device.devnode()};
                 }
 
-                // For now, we *also* require our DisplayPlatform to support creating a HW EGL context                
-                mgg::helpers::GBMHelper gbm_device{tmp_fd};
-                mgg::helpers::EGLHelper egl{MinimalGLConfig()};
+                if (requires_gl)
+                {
+                    // For now, we *also* require our DisplayPlatform to support creating a HW EGL context
+                    mgg::helpers::GBMHelper gbm_device{tmp_fd};
+                    mgg::helpers::EGLHelper egl{MinimalGLConfig()};
 
-                egl.setup(gbm_device);
+                    egl.setup(gbm_device);
 
-                egl.make_current();
+                    egl.make_current();
 
-                auto const renderer_string = reinterpret_cast<char const*>(glGetString(GL_RENDERER));
-                if (!renderer_string)
-                {
-                    throw mg::gl_error(
-                        "Probe failed to query GL renderer");
-                }
+                    auto const renderer_string = reinterpret_cast<char const*>(glGetString(GL_RENDERER));
+                    if (!renderer_string)
+                    {
+                        throw mg::gl_error(
+                            "Probe failed to query GL renderer");
+                    }
 
-                using namespace std::literals::string_literals;
-                if ("llvmpipe"s == renderer_string)
-                {
-                    mir::log_info("KMS device only has associated software renderer: %s, device unsuitable", renderer_string);
-                    supported_devices.back().support_level = mg::PlatformPriority::unsupported;
-                    continue;
+                    using namespace std::literals::string_literals;
+                    if ("llvmpipe"s == renderer_string)
+                    {
+                        mir::log_info("KMS device only has associated software renderer: %s, device unsuitable", renderer_string);
+                        supported_devices.back().support_level = mg::PlatformPriority::unsupported;
+                        continue;
+                    }
                 }
 
                 /* Check if modesetting is supported on this DRM node
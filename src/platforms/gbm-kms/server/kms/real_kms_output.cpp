@@ -15,6 +15,7 @@
  */
 
 #include "real_kms_output.h"
+#include "fb_handle.h"
 #include "mir/graphics/display_configuration.h"
 #include "page_flipper.h"
 #include "kms-utils/kms_connector.h"
@@ -31,31 +32,6 @@ namespace mgg = mg::gbm;
 namespace mgk = mg::kms;
 namespace geom = mir::geometry;
 
-class mgg::FBHandle
-{
-public:
-    FBHandle(int drm_fd, uint32_t fb_id)
-        : drm_fd{drm_fd},
-          fb_id{fb_id}
-    {
-    }
-
-    ~FBHandle()
-    {
-        // TODO: Some sort of logging on failure?
-        drmModeRmFB(drm_fd, fb_id);
-    }
-
-    auto get_drm_fb_id() const -> uint32_t
-    {
-        return fb_id;
-    }
-private:
-    int const drm_fd;
-    uint32_t const fb_id;
-};
-
-
 mgg::RealKMSOutput::RealKMSOutput(
     int drm_fd,
     kms::DRMModeConnectorUPtr&& connector,
@@ -82,6 +58,8 @@ mgg::RealKMSOutput::RealKMSOutput(
             saved_crtc = *resources.crtc(encoder->crtc_id);
         }
     }
+
+    refresh_edid();
 }
 
 mgg::RealKMSOutput::~RealKMSOutput()
@@ -392,6 +370,7 @@ void mgg::RealKMSOutput::set_gamma(mg::GammaCurves const& gamma)
 void mgg::RealKMSOutput::refresh_hardware_state()
 {
     connector = kms::get_connector(drm_fd_, connector->connector_id);
+    refresh_edid();
     current_crtc = nullptr;
 
     if (connector->encoder_id)
@@ -539,6 +518,24 @@ std::vector<uint8_t> edid_for_connector(int drm_fd, uint32_t connector_id)
 }
 }
 
+void mgg::RealKMSOutput::refresh_edid()
+{
+    /* Only ask for the EDID on connected outputs. There's obviously no monitor EDID
+     * when there is no monitor connected!
+     *
+     * The configuration is read far more often than connectors are probed, so cache
+     * the EDID until the connector is next probed.
+     */
+    if (connector->connection == DRM_MODE_CONNECTED)
+    {
+        edid = edid_for_connector(drm_fd_, connector->connector_id);
+    }
+    else
+    {
+        edid.clear();
+    }
+}
+
 void mgg::RealKMSOutput::update_from_hardware_state(
     DisplayConfigurationOutput& output) const
 {
@@ -553,14 +550,6 @@ void mgg::RealKMSOutput::update_from_hardware_state(
     std::vector<MirPixelFormat> formats{mir_pixel_format_argb_8888,
                                         mir_pixel_format_xrgb_8888};
 
-    std::vector<uint8_t> edid;
-    if (connected) {
-        /* Only ask for the EDID on connected outputs. There's obviously no monitor EDID
-         * when there is no monitor connected!
-         */
-        edid = edid_for_connector(drm_fd_, connector->connector_id);
-    }
-
     drmModeModeInfo current_mode_info = drmModeModeInfo();
     GammaCurves gamma;
 
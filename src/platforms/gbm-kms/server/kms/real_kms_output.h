@@ -23,6 +23,7 @@
 
 #include <memory>
 #include <mutex>
+#include <vector>
 
 namespace mir
 {
@@ -76,6 +77,7 @@ public:
 private:
     bool ensure_crtc();
     void restore_saved_crtc();
+    void refresh_edid();
 
     int const drm_fd_;
     std::shared_ptr<PageFlipper> const page_flipper;
@@ -96,6 +98,7 @@ private:
     FBRegistry mutable framebuffers;
 
     kms::DRMModeConnectorUPtr connector;
+    std::vector<uint8_t> edid;      ///< As of the last probe of connector
     size_t mode_index;
     geometry::Displacement fb_offset;
     kms::DRMModeCrtcUPtr current_crtc;
@@ -19,13 +19,16 @@
 #include "real_kms_output.h"
 #include "kms-utils/drm_mode_resources.h"
 
+#include <sys/stat.h>
+
 namespace mgg = mir::graphics::gbm;
 
 mgg::RealKMSOutputContainer::RealKMSOutputContainer(
     std::vector<int> const& drm_fds,
     std::function<std::shared_ptr<PageFlipper>(int)> const& construct_page_flipper)
     : drm_fds{drm_fds},
-      construct_page_flipper{construct_page_flipper}
+      construct_page_flipper{construct_page_flipper},
+      changes{{drm_fds.begin(), drm_fds.end()}, {}}
 {
 }
 
@@ -38,6 +41,11 @@ void mgg::RealKMSOutputContainer::for_each_output(std::function<void(std::shared
 void mgg::RealKMSOutputContainer::update_from_hardware_state()
 {
     decltype(outputs) new_outputs;
+    Changes pending;
+    {
+        std::lock_guard lock{changes_mutex};
+        pending = std::exchange(changes, Changes{});
+    }
 
     // TODO: Accumulate errors and present them all.
     std::exception_ptr last_error;
@@ -55,17 +63,21 @@ void mgg::RealKMSOutputContainer::update_from_hardware_state()
             continue;
         }
 
-        for (auto &&connector : resources->connectors())
+        bool const all_connectors_changed = pending.all_connectors_on.contains(drm_fd);
+
+        // Only probe connectors that we don't know about or that have changed: probing a
+        // connector can mean reading its EDID over DDC, which takes milliseconds.
+        for (auto const connector_id : resources->connector_ids())
         {
             // Caution: O(n²) here, but n is the number of outputs, so should
             // conservatively be << 100.
             auto existing_output = std::find_if(
                 outputs.begin(),
                 outputs.end(),
-                [&connector, drm_fd](auto const &candidate)
+                [connector_id, drm_fd](auto const &candidate)
                 {
                     return
-                        connector->connector_id == candidate->id() &&
+                        connector_id == candidate->id() &&
                         drm_fd == candidate->drm_fd();
                 });
 
@@ -76,13 +88,16 @@ void mgg::RealKMSOutputContainer::update_from_hardware_state()
                 //
                 // That's a bit of a faff, so just do the simple thing for now.
                 new_outputs.push_back(*existing_output);
-                new_outputs.back()->refresh_hardware_state();
+                if (all_connectors_changed || pending.connectors.contains({drm_fd, connector_id}))
+                {
+                    new_outputs.back()->refresh_hardware_state();
+                }
             }
             else
             {
                 new_outputs.push_back(std::make_shared<RealKMSOutput>(
                     drm_fd,
-                    std::move(connector),
+                    resources->connector(connector_id),
                     construct_page_flipper(drm_fd)));
             }
         }
@@ -90,8 +105,40 @@ void mgg::RealKMSOutputContainer::update_from_hardware_state()
     }
     if (new_outputs.empty() && last_error)
     {
+        // Nothing has been probed, so make sure the next update tries again
+        std::lock_guard lock{changes_mutex};
+        changes.all_connectors_on.insert(drm_fds.begin(), drm_fds.end());
         std::rethrow_exception(last_error);
     }
 
     outputs = new_outputs;
 }
+
+void mgg::RealKMSOutputContainer::mark_changed(dev_t drm_device, std::optional<uint32_t> connector_id)
+{
+    std::lock_guard lock{changes_mutex};
+
+    bool known_device{false};
+    for (auto const drm_fd : drm_fds)
+    {
+        struct stat info;
+        if (fstat(drm_fd, &info) == 0 && info.st_rdev == drm_device)
+        {
+            known_device = true;
+            if (connector_id)
+            {
+                changes.connectors.emplace(drm_fd, *connector_id);
+            }
+            else
+            {
+                changes.all_connectors_on.insert(drm_fd);
+            }
+        }
+    }
+
+    if (!known_device)
+    {
+        // We can't tell which of our devices this is (if any), so fall back to re-probing everything
+        changes.all_connectors_on.insert(drm_fds.begin(), drm_fds.end());
+    }
+}
@@ -18,6 +18,10 @@
 #define MIR_GRAPHICS_GBM_REAL_KMS_OUTPUT_CONTAINER_H_
 
 #include "kms_output_container.h"
+
+#include <mutex>
+#include <set>
+#include <utility>
 #include <vector>
 
 namespace mir
@@ -39,10 +43,22 @@ public:
     void for_each_output(std::function<void(std::shared_ptr<KMSOutput> const&)> functor) const override;
 
     void update_from_hardware_state() override;
+    void mark_changed(dev_t drm_device, std::optional<uint32_t> connector_id) override;
 private:
     std::vector<int> const drm_fds;
     std::vector<std::shared_ptr<KMSOutput>> outputs;
     std::function<std::shared_ptr<PageFlipper>(int drm_fd)> const construct_page_flipper;
+
+    /* Outputs to re-probe on the next update. Hotplug events arrive on the main loop,
+     * while updates happen wherever the display configuration is read.
+     */
+    struct Changes
+    {
+        std::set<int> all_connectors_on;                    ///< By DRM fd
+        std::set<std::pair<int, uint32_t>> connectors;      ///< By DRM fd and connector ID
+    };
+    std::mutex changes_mutex;
+    Changes changes;
 };
 
 }
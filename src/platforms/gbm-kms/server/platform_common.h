@@ -30,6 +30,12 @@ enum class BypassOption
     prohibited
 };
 
+enum class CompositingOption
+{
+    gl,             ///< Composite with GL into GBM surfaces
+    dumb_buffers    ///< Composite on the CPU into DRM dumb buffers, without needing a GPU driver
+};
+
 }
 }
 }
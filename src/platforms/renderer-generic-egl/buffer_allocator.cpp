@@ -218,10 +218,7 @@ std::shared_ptr<mg::Buffer> mge::BufferAllocator::buffer_from_resource(
     std::function<void()>&& on_consumed,
     std::function<void()>&& on_release)
 {
-    auto context_guard = mir::raii::paired_calls(
-        [this]() { ctx->make_current(); },
-        [this]() { ctx->release_current(); });
-
+    // dmabufs are imported when first bound, so don't need a current context here
     if (auto dmabuf = dmabuf_extension->buffer_from_resource(
         buffer,
         std::function<void()>{on_consumed},
@@ -230,6 +227,11 @@ std::shared_ptr<mg::Buffer> mge::BufferAllocator::buffer_from_resource(
     {
         return dmabuf;
     }
+
+    auto context_guard = mir::raii::paired_calls(
+        [this]() { ctx->make_current(); },
+        [this]() { ctx->release_current(); });
+
     return mg::wayland::buffer_from_resource(
         buffer,
         std::move(on_consumed),
@@ -0,0 +1,198 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "display.h"
+#include "display_buffer.h"
+#include "display_configuration.h"
+#include "render_targets.h"
+#include "mir/graphics/display_report.h"
+#include <mir/graphics/display_configuration_policy.h>
+#include "mir/graphics/gl_config.h"
+
+#include <boost/throw_exception.hpp>
+
+#define MIR_LOG_COMPONENT "display"
+#include "mir/log.h"
+
+namespace mg = mir::graphics;
+namespace mgv = mg::virt;
+namespace geom = mir::geometry;
+
+namespace
+{
+// Report a plausible physical size: that of a 96 DPI monitor
+float const mm_per_pixel{25.4f / 96};
+}
+
+mgv::Display::Display(
+    std::vector<OutputSpec> const& output_specs,
+    RenderTargetType render_target,
+    bool unthrottled,
+    std::shared_ptr<DisplayConfigurationPolicy> const& initial_conf_policy,
+    std::shared_ptr<GLConfig> const& gl_config,
+    std::shared_ptr<DisplayReport> const& report)
+    : egl{*gl_config},
+      shared_context{egl, EGL_NO_CONTEXT}
+{
+    geom::Point top_left{0, 0};
+
+    for (auto const& spec : output_specs)
+    {
+        auto configuration = DisplayConfiguration::build_output(
+            mir_pixel_format_xrgb_8888,
+            spec.size,
+            top_left,
+            geom::Size{spec.size.width.as_int() * mm_per_pixel, spec.size.height.as_int() * mm_per_pixel},
+            spec.refresh_rate,
+            mir_orientation_normal);
+
+        std::unique_ptr<OutputTarget> target;
+        switch (render_target)
+        {
+        case RenderTargetType::gl:
+            target = std::make_unique<GLRenderTarget>(egl, shared_context.context(), spec.size);
+            break;
+
+        case RenderTargetType::cpu:
+            target = std::make_unique<CPURenderTarget>(spec.size);
+            break;
+        }
+
+        auto display_buffer = std::make_unique<mgv::DisplayBuffer>(
+            configuration->id,
+            configuration->extents(),
+            std::move(target),
+            spec.refresh_rate,
+            unthrottled,
+            report);
+        top_left.x += as_delta(configuration->extents().size.width);
+        outputs.push_back(Output{std::move(display_buffer), std::move(configuration)});
+    }
+
+    auto const display_config = configuration();
+    initial_conf_policy->apply_to(*display_config);
+    configure(*display_config);
+    report->report_successful_display_construction();
+}
+
+mgv::Display::~Display() noexcept = default;
+
+void mgv::Display::for_each_display_sync_group(std::function<void(mg::DisplaySyncGroup&)> const& f)
+{
+    std::lock_guard lock{mutex};
+    for (auto const& output : outputs)
+    {
+        f(*output.display_buffer);
+    }
+}
+
+std::unique_ptr<mg::DisplayConfiguration> mgv::Display::configuration() const
+{
+    std::lock_guard lock{mutex};
+    std::vector<DisplayConfigurationOutput> output_configurations;
+    for (auto const& output : outputs)
+    {
+        output_configurations.push_back(*output.config);
+    }
+    return std::make_unique<mgv::DisplayConfiguration>(output_configurations);
+}
+
+void mgv::Display::configure(mg::DisplayConfiguration const& new_configuration)
+{
+    std::lock_guard lock{mutex};
+
+    if (!new_configuration.valid())
+    {
+        BOOST_THROW_EXCEPTION(
+            std::logic_error("Invalid or inconsistent display configuration"));
+    }
+
+    new_configuration.for_each_output([&](DisplayConfigurationOutput const& conf_output)
+    {
+        bool found_info = false;
+
+        for (auto& output : outputs)
+        {
+            if (output.config->id == conf_output.id)
+            {
+                *output.config = conf_output;
+                output.display_buffer->set_view_area(output.config->extents());
+                switch (output.config->power_mode)
+                {
+                case mir_power_mode_on:
+                    output.display_buffer->set_transformation(output.config->transformation());
+                    break;
+
+                case mir_power_mode_standby:
+                case mir_power_mode_suspend:
+                case mir_power_mode_off:
+                    // Simulate an off display by setting a zeroed-out transform
+                    output.display_buffer->set_transformation(glm::mat2{0});
+                    break;
+                }
+                found_info = true;
+                break;
+            }
+        }
+
+        if (!found_info)
+            mir::log_error("Could not find info for output %d", conf_output.id.as_value());
+    });
+}
+
+void mgv::Display::register_configuration_change_handler(
+    EventHandlerRegister& /* event_handler*/,
+    DisplayConfigurationChangeHandler const& /*change_handler*/)
+{
+    // The outputs never change by themselves
+}
+
+void mgv::Display::pause()
+{
+}
+
+void mgv::Display::resume()
+{
+}
+
+auto mgv::Display::create_hardware_cursor() -> std::shared_ptr<Cursor>
+{
+    return nullptr;
+}
+
+std::unique_ptr<mir::renderer::gl::Context> mgv::Display::create_gl_context() const
+{
+    return std::make_unique<helpers::SurfacelessContext>(egl, shared_context.context());
+}
+
+bool mgv::Display::apply_if_configuration_preserves_display_buffers(
+    mg::DisplayConfiguration const& /*conf*/)
+{
+    return false;
+}
+
+mg::Frame mgv::Display::last_frame_on(unsigned output_id) const
+{
+    std::lock_guard lock{mutex};
+    for (auto const& output : outputs)
+    {
+        if (output.config->id.as_value() == static_cast<int>(output_id))
+        {
+            return output.display_buffer->last_frame();
+        }
+    }
+    return {};
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_VIRTUAL_DISPLAY_H_
+#define MIR_GRAPHICS_VIRTUAL_DISPLAY_H_
+
+#include "mir/graphics/display.h"
+#include "mir/renderer/gl/context_source.h"
+#include "egl_helper.h"
+#include "platform.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+class GLConfig;
+class DisplayReport;
+struct DisplayConfigurationOutput;
+class DisplayConfigurationPolicy;
+
+namespace virt
+{
+class DisplayBuffer;
+
+class Display : public graphics::Display
+{
+public:
+    Display(
+        std::vector<OutputSpec> const& output_specs,
+        RenderTargetType render_target,
+        bool unthrottled,
+        std::shared_ptr<DisplayConfigurationPolicy> const& initial_conf_policy,
+        std::shared_ptr<GLConfig> const& gl_config,
+        std::shared_ptr<DisplayReport> const& report);
+    ~Display() noexcept;
+
+    void for_each_display_sync_group(std::function<void(graphics::DisplaySyncGroup&)> const& f) override;
+
+    std::unique_ptr<graphics::DisplayConfiguration> configuration() const override;
+
+    bool apply_if_configuration_preserves_display_buffers(graphics::DisplayConfiguration const& conf) override;
+
+    void configure(graphics::DisplayConfiguration const&) override;
+
+    void register_configuration_change_handler(
+        EventHandlerRegister& handlers,
+        DisplayConfigurationChangeHandler const& conf_change_handler) override;
+
+    void pause() override;
+    void resume() override;
+
+    std::shared_ptr<Cursor> create_hardware_cursor() override;
+
+    std::unique_ptr<renderer::gl::Context> create_gl_context() const override;
+
+    Frame last_frame_on(unsigned output_id) const override;
+
+private:
+    struct Output
+    {
+        std::unique_ptr<DisplayBuffer> display_buffer;
+        std::shared_ptr<DisplayConfigurationOutput> config;
+    };
+
+    helpers::SurfacelessDisplay const egl;
+    helpers::SurfacelessContext const shared_context;
+
+    std::mutex mutable mutex;
+    std::vector<Output> outputs;
+};
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_VIRTUAL_DISPLAY_H_ */
@@ -0,0 +1,113 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "display_buffer.h"
+#include "mir/graphics/display_report.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace mg = mir::graphics;
+namespace mgv = mg::virt;
+namespace geom = mir::geometry;
+
+mgv::DisplayBuffer::DisplayBuffer(
+    DisplayConfigurationOutputId output_id,
+    geom::Rectangle const& view_area,
+    std::unique_ptr<OutputTarget> render_target,
+    double refresh_rate,
+    bool unthrottled,
+    std::shared_ptr<DisplayReport> const& report)
+    : output_id{output_id},
+      area{view_area},
+      transform(1),
+      render_target{std::move(render_target)},
+      epoch{std::chrono::steady_clock::now()},
+      refresh_period{std::chrono::nanoseconds{static_cast<int64_t>(1e9 / refresh_rate)}},
+      unthrottled{unthrottled},
+      report{report}
+{
+}
+
+geom::Rectangle mgv::DisplayBuffer::view_area() const
+{
+    return area;
+}
+
+bool mgv::DisplayBuffer::overlay(RenderableList const& /*renderlist*/)
+{
+    return false;
+}
+
+glm::mat2 mgv::DisplayBuffer::transformation() const
+{
+    return transform;
+}
+
+mg::NativeDisplayBuffer* mgv::DisplayBuffer::native_display_buffer()
+{
+    return render_target.get();
+}
+
+void mgv::DisplayBuffer::set_view_area(geom::Rectangle const& a)
+{
+    area = a;
+}
+
+void mgv::DisplayBuffer::set_transformation(glm::mat2 const& t)
+{
+    transform = t;
+}
+
+void mgv::DisplayBuffer::for_each_display_buffer(
+    std::function<void(graphics::DisplayBuffer&)> const& f)
+{
+    f(*this);
+}
+
+void mgv::DisplayBuffer::post()
+{
+    auto const previous = frame.load();
+    auto const now = std::chrono::steady_clock::now();
+    auto shown = now;
+    int64_t msc = previous.msc + 1;
+
+    if (!unthrottled)
+    {
+        // The first vblank after now, unless that has already shown a frame
+        msc = std::max<int64_t>(msc, (now - epoch) / refresh_period + 1);
+        shown = epoch + msc * refresh_period;
+        std::this_thread::sleep_until(shown);
+    }
+
+    // steady_clock is CLOCK_MONOTONIC, which is what clients' timestamps are relative to
+    Frame next;
+    next.msc = msc;
+    next.ust = {CLOCK_MONOTONIC, std::chrono::duration_cast<std::chrono::nanoseconds>(shown.time_since_epoch())};
+    frame.store(next);
+
+    report->report_vsync(output_id.as_value(), next);
+}
+
+std::chrono::milliseconds mgv::DisplayBuffer::recommended_sleep() const
+{
+    return std::chrono::milliseconds::zero();
+}
+
+auto mgv::DisplayBuffer::last_frame() const -> Frame
+{
+    return frame.load();
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_VIRTUAL_DISPLAY_BUFFER_H_
+#define MIR_GRAPHICS_VIRTUAL_DISPLAY_BUFFER_H_
+
+#include "mir/graphics/display_buffer.h"
+#include "mir/graphics/display_configuration.h"
+#include "mir/graphics/display.h"
+#include "mir/graphics/atomic_frame.h"
+#include "render_targets.h"
+
+#include <chrono>
+#include <memory>
+
+namespace mir
+{
+namespace graphics
+{
+class DisplayReport;
+
+namespace virt
+{
+/**
+ * An output with nothing behind it.
+ *
+ * post() simulates the output's vblank: frames are shown on a steady timeline of refresh
+ * periods, each at most once, and post() waits for the vblank that shows the frame (unless
+ * unthrottled, when the frame is shown as soon as it's posted).
+ */
+class DisplayBuffer : public graphics::DisplayBuffer,
+                      public graphics::DisplaySyncGroup
+{
+public:
+    DisplayBuffer(
+        DisplayConfigurationOutputId output_id,
+        geometry::Rectangle const& view_area,
+        std::unique_ptr<OutputTarget> render_target,
+        double refresh_rate,
+        bool unthrottled,
+        std::shared_ptr<DisplayReport> const& report);
+
+    geometry::Rectangle view_area() const override;
+    bool overlay(RenderableList const& renderlist) override;
+    glm::mat2 transformation() const override;
+    NativeDisplayBuffer* native_display_buffer() override;
+
+    void set_view_area(geometry::Rectangle const& a);
+    void set_transformation(glm::mat2 const& t);
+
+    void for_each_display_buffer(
+        std::function<void(graphics::DisplayBuffer&)> const& f) override;
+    void post() override;
+    std::chrono::milliseconds recommended_sleep() const override;
+
+    auto last_frame() const -> Frame;
+
+private:
+    DisplayConfigurationOutputId const output_id;
+    geometry::Rectangle area;
+    glm::mat2 transform;
+    std::unique_ptr<OutputTarget> const render_target;
+    std::chrono::steady_clock::time_point const epoch;
+    std::chrono::nanoseconds const refresh_period;
+    bool const unthrottled;
+    std::shared_ptr<DisplayReport> const report;
+    AtomicFrame frame;
+};
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_VIRTUAL_DISPLAY_BUFFER_H_ */
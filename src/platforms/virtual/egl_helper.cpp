@@ -0,0 +1,131 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "egl_helper.h"
+
+#include "mir/graphics/gl_config.h"
+#include "mir/graphics/egl_error.h"
+#include "mir/graphics/egl_extensions.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <cstring>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+namespace mg = mir::graphics;
+namespace mgvh = mg::virt::helpers;
+
+namespace
+{
+bool has_extension(char const* extensions, char const* extension)
+{
+    if (!extensions)
+        return false;
+
+    auto const length = strlen(extension);
+    for (auto found = strstr(extensions, extension); found; found = strstr(found + length, extension))
+    {
+        if ((found == extensions || found[-1] == ' ') && (found[length] == '\0' || found[length] == ' '))
+            return true;
+    }
+    return false;
+}
+}
+
+mgvh::SurfacelessDisplay::SurfacelessDisplay(GLConfig const& gl_config)
+    : egl_display{EGL_NO_DISPLAY},
+      egl_config{0}
+{
+    if (!has_extension(eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS), "EGL_MESA_platform_surfaceless"))
+        BOOST_THROW_EXCEPTION(std::runtime_error("EGL implementation doesn't support EGL_MESA_platform_surfaceless"));
+
+    mg::EGLExtensions::PlatformBaseEXT const platform_base;
+    egl_display = platform_base.eglGetPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (egl_display == EGL_NO_DISPLAY)
+        BOOST_THROW_EXCEPTION(mg::egl_error("Failed to get surfaceless EGL display"));
+
+    EGLint major, minor;
+    if (eglInitialize(egl_display, &major, &minor) == EGL_FALSE)
+        BOOST_THROW_EXCEPTION(mg::egl_error("Failed to initialize EGL display"));
+
+    if (!has_extension(eglQueryString(egl_display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context"))
+    {
+        eglTerminate(egl_display);
+        BOOST_THROW_EXCEPTION(std::runtime_error("EGL display doesn't support EGL_KHR_surfaceless_context"));
+    }
+
+    // Nothing is ever drawn to an EGLSurface, so any surface type will do
+    EGLint const config_attr[] = {
+        EGL_SURFACE_TYPE, 0,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, gl_config.depth_buffer_bits(),
+        EGL_STENCIL_SIZE, gl_config.stencil_buffer_bits(),
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+        EGL_NONE
+    };
+
+    EGLint num_egl_configs;
+    if (eglChooseConfig(egl_display, config_attr, &egl_config, 1, &num_egl_configs) == EGL_FALSE ||
+        num_egl_configs != 1)
+    {
+        eglTerminate(egl_display);
+        BOOST_THROW_EXCEPTION(mg::egl_error("Failed to choose ARGB EGL config"));
+    }
+}
+
+mgvh::SurfacelessDisplay::~SurfacelessDisplay() noexcept
+{
+    eglTerminate(egl_display);
+}
+
+mgvh::SurfacelessContext::SurfacelessContext(SurfacelessDisplay const& display, EGLContext shared_context)
+    : egl_display{display.display()}
+{
+    static EGLint const context_attr[] = {
+        EGL_CONTEXT_CLIENT_VERSION, 2,
+        EGL_NONE
+    };
+
+    eglBindAPI(EGL_OPENGL_ES_API);
+    egl_context = eglCreateContext(egl_display, display.config(), shared_context, context_attr);
+    if (egl_context == EGL_NO_CONTEXT)
+        BOOST_THROW_EXCEPTION(mg::egl_error("Failed to create EGL context"));
+}
+
+mgvh::SurfacelessContext::~SurfacelessContext() noexcept
+{
+    if (eglGetCurrentContext() == egl_context)
+        eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(egl_display, egl_context);
+}
+
+void mgvh::SurfacelessContext::make_current() const
+{
+    if (eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, egl_context) == EGL_FALSE)
+        BOOST_THROW_EXCEPTION(mg::egl_error("Failed to make EGL context current"));
+    eglBindAPI(EGL_OPENGL_ES_API);
+}
+
+void mgvh::SurfacelessContext::release_current() const
+{
+    eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_VIRTUAL_EGL_HELPER_H_
+#define MIR_GRAPHICS_VIRTUAL_EGL_HELPER_H_
+
+#include "mir/renderer/gl/context.h"
+
+#include <EGL/egl.h>
+
+namespace mir
+{
+namespace graphics
+{
+class GLConfig;
+
+namespace virt
+{
+namespace helpers
+{
+/**
+ * An EGL display with no window system behind it (EGL_MESA_platform_surfaceless).
+ *
+ * Mesa provides this for any GPU it drives, and for llvmpipe when there is none.
+ */
+class SurfacelessDisplay
+{
+public:
+    explicit SurfacelessDisplay(GLConfig const& gl_config);
+    ~SurfacelessDisplay() noexcept;
+
+    SurfacelessDisplay(SurfacelessDisplay const&) = delete;
+    SurfacelessDisplay& operator=(SurfacelessDisplay const&) = delete;
+
+    auto display() const -> EGLDisplay { return egl_display; }
+    auto config() const -> EGLConfig { return egl_config; }
+
+private:
+    EGLDisplay egl_display;
+    EGLConfig egl_config;
+};
+
+/// A GLES2 context, made current without a surface (EGL_KHR_surfaceless_context)
+class SurfacelessContext : public renderer::gl::Context
+{
+public:
+    SurfacelessContext(SurfacelessDisplay const& display, EGLContext shared_context);
+    ~SurfacelessContext() noexcept;
+
+    void make_current() const override;
+    void release_current() const override;
+
+    auto context() const -> EGLContext { return egl_context; }
+
+private:
+    EGLDisplay const egl_display;
+    EGLContext egl_context;
+};
+}
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_VIRTUAL_EGL_HELPER_H_ */
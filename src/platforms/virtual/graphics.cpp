@@ -0,0 +1,127 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/display_report.h"
+#include "mir/graphics/platform.h"
+#include "mir/options/option.h"
+#include "mir/options/configuration.h"
+#include "mir/options/program_option.h"
+#include "platform.h"
+#include "mir/module_deleter.h"
+#include "mir/assert_module_entry_point.h"
+#include "mir/libname.h"
+#include "mir/graphics/egl_logger.h"
+
+#include <boost/throw_exception.hpp>
+
+namespace mo = mir::options;
+namespace mg = mir::graphics;
+namespace mgv = mg::virt;
+
+namespace
+{
+char const* virtual_output_option_name{"virtual-output"};
+char const* virtual_render_target_option_name{"virtual-render-target"};
+char const* virtual_unthrottled_option_name{"virtual-unthrottled"};
+}
+
+mir::UniqueModulePtr<mg::DisplayPlatform> create_display_platform(
+    mg::SupportedDevice const&,
+    std::shared_ptr<mo::Option> const& options,
+    std::shared_ptr<mir::EmergencyCleanupRegistry> const&,
+    std::shared_ptr<mir::ConsoleServices> const&,
+    std::shared_ptr<mg::DisplayReport> const& report)
+{
+    mir::assert_entry_point_signature<mg::CreateDisplayPlatform>(&create_display_platform);
+
+    if (!options->is_set(virtual_output_option_name))
+        BOOST_THROW_EXCEPTION(std::runtime_error("The virtual platform needs at least one --virtual-output"));
+
+    if (options->is_set(mir::options::debug_opt))
+    {
+        mg::initialise_egl_logger();
+    }
+
+    return mir::make_module_ptr<mgv::Platform>(
+        mgv::Platform::parse_output_specs(options->get<std::string>(virtual_output_option_name)),
+        mgv::Platform::parse_render_target(options->get<std::string>(virtual_render_target_option_name)),
+        options->get<bool>(virtual_unthrottled_option_name),
+        report);
+}
+
+void add_graphics_platform_options(boost::program_options::options_description& config)
+{
+    mir::assert_entry_point_signature<mg::AddPlatformOptions>(&add_graphics_platform_options);
+    config.add_options()
+        (virtual_output_option_name,
+         boost::program_options::value<std::string>(),
+         "[mir-on-virtual specific] Colon separated list of WIDTHxHEIGHT sizes for headless outputs."
+         " @HZ may also be appended to any output to set its simulated refresh rate (default 60)."
+         " The virtual platform is only used when this is set");
+
+    config.add_options()
+        (virtual_render_target_option_name,
+         boost::program_options::value<std::string>()->default_value("gl"),
+         "[mir-on-virtual specific] What headless outputs are rendered into: "
+         "\"gl\" (an offscreen framebuffer on a surfaceless EGL context) or "
+         "\"cpu\" (memory, drawn by the software renderer)");
+
+    config.add_options()
+        (virtual_unthrottled_option_name,
+         boost::program_options::value<bool>()->default_value(false),
+         "[mir-on-virtual specific] Show frames on headless outputs as soon as they are posted, "
+         "rather than waiting for the simulated vblank");
+}
+
+auto probe_display_platform(
+    std::shared_ptr<mir::ConsoleServices> const&,
+    std::shared_ptr<mir::udev::Context> const&,
+    mo::ProgramOption const& options) -> std::vector<mg::SupportedDevice>
+{
+    mir::assert_entry_point_signature<mg::PlatformProbe>(&probe_display_platform);
+
+    // Headless outputs are only wanted when asked for, but then they're wanted regardless of
+    // what else is available
+    if (options.is_set(virtual_output_option_name))
+    {
+        std::vector<mg::SupportedDevice> result;
+        result.emplace_back(
+            mg::SupportedDevice{
+                nullptr,
+                mg::PlatformPriority::hosted,
+                nullptr
+            });
+        return result;
+    }
+    return {};
+}
+
+namespace
+{
+mir::ModuleProperties const description = {
+    "mir:virtual",
+    MIR_VERSION_MAJOR,
+    MIR_VERSION_MINOR,
+    MIR_VERSION_MICRO,
+    mir::libname()
+};
+}
+
+mir::ModuleProperties const* describe_graphics_module()
+{
+    mir::assert_entry_point_signature<mg::DescribeModule>(&describe_graphics_module);
+    return &description;
+}
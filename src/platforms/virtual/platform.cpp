@@ -0,0 +1,138 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "platform.h"
+#include "display.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <stdexcept>
+
+namespace mg = mir::graphics;
+namespace mgv = mg::virt;
+namespace geom = mir::geometry;
+
+namespace
+{
+double const default_refresh_rate{60.0};
+
+auto parse_size_dimension(std::string const& str) -> int
+{
+    try
+    {
+        size_t num_end = 0;
+        int const value = std::stoi(str, &num_end);
+        if (num_end != str.size())
+            BOOST_THROW_EXCEPTION(std::runtime_error("Output dimension \"" + str + "\" is not a valid number"));
+        if (value <= 0)
+            BOOST_THROW_EXCEPTION(std::runtime_error("Output dimensions must be greater than zero"));
+        return value;
+    }
+    catch (std::invalid_argument const &)
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error("Output dimension \"" + str + "\" is not a valid number"));
+    }
+    catch (std::out_of_range const &)
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error("Output dimension \"" + str + "\" is out of range"));
+    }
+}
+
+auto parse_refresh_rate(std::string const& str) -> double
+{
+    try
+    {
+        size_t num_end = 0;
+        double const value = std::stod(str, &num_end);
+        if (num_end != str.size())
+            BOOST_THROW_EXCEPTION(std::runtime_error("Refresh rate \"" + str + "\" is not a valid number"));
+        if (value < 1.0)
+            BOOST_THROW_EXCEPTION(std::runtime_error("Refresh rate must be at least 1Hz"));
+        return value;
+    }
+    catch (std::invalid_argument const &)
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error("Refresh rate \"" + str + "\" is not a valid number"));
+    }
+    catch (std::out_of_range const &)
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error("Refresh rate \"" + str + "\" is out of range"));
+    }
+}
+
+auto parse_output_spec(std::string const& str) -> mgv::OutputSpec
+{
+    auto const x = str.find('x'); // "x" between width and height
+    if (x == std::string::npos || x <= 0 || x >= str.size() - 1)
+        BOOST_THROW_EXCEPTION(std::runtime_error("Output size \"" + str + "\" does not have two dimensions"));
+    auto const rate_start = str.find('@'); // start of refresh rate
+    double refresh_rate = default_refresh_rate;
+    if (rate_start != std::string::npos)
+    {
+        if (rate_start >= str.size() - 1)
+            BOOST_THROW_EXCEPTION(std::runtime_error("In \"" + str + "\", '@' is not followed by a refresh rate"));
+        refresh_rate = parse_refresh_rate(str.substr(rate_start + 1));
+    }
+    return mgv::OutputSpec{
+        geom::Size{
+            parse_size_dimension(str.substr(0, x)),
+            parse_size_dimension(str.substr(x + 1, rate_start - x - 1))},
+        refresh_rate};
+}
+}
+
+auto mgv::Platform::parse_output_specs(std::string const& output_specs) -> std::vector<OutputSpec>
+{
+    std::vector<OutputSpec> specs;
+    for (size_t start = 0, end; start <= output_specs.size(); start = end + 1)
+    {
+        end = output_specs.find(':', start);
+        if (end == std::string::npos)
+            end = output_specs.size();
+        specs.push_back(parse_output_spec(output_specs.substr(start, end - start)));
+    }
+    return specs;
+}
+
+auto mgv::Platform::parse_render_target(std::string const& render_target) -> RenderTargetType
+{
+    if (render_target == "gl")
+        return RenderTargetType::gl;
+    if (render_target == "cpu")
+        return RenderTargetType::cpu;
+
+    BOOST_THROW_EXCEPTION(std::runtime_error("Unknown render target \"" + render_target + "\" (expected gl or cpu)"));
+}
+
+mgv::Platform::Platform(
+    std::vector<OutputSpec> outputs,
+    RenderTargetType render_target,
+    bool unthrottled,
+    std::shared_ptr<DisplayReport> const& report)
+    : outputs{std::move(outputs)},
+      render_target{render_target},
+      unthrottled{unthrottled},
+      report{report}
+{
+}
+
+mir::UniqueModulePtr<mg::Display> mgv::Platform::create_display(
+    std::shared_ptr<DisplayConfigurationPolicy> const& initial_conf_policy,
+    std::shared_ptr<GLConfig> const& gl_config)
+{
+    return make_module_ptr<mgv::Display>(
+        outputs, render_target, unthrottled, initial_conf_policy, gl_config, report);
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_VIRTUAL_PLATFORM_H_
+#define MIR_GRAPHICS_VIRTUAL_PLATFORM_H_
+
+#include "mir/graphics/platform.h"
+#include "mir/geometry/size.h"
+
+#include <string>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+class DisplayReport;
+
+namespace virt
+{
+struct OutputSpec
+{
+    geometry::Size size;
+    double refresh_rate;
+};
+
+/// What the outputs are drawn into
+enum class RenderTargetType
+{
+    gl,     ///< An offscreen framebuffer on a surfaceless EGL context
+    cpu     ///< Buffers in memory, drawn by the software renderer
+};
+
+class Platform : public graphics::DisplayPlatform
+{
+public:
+    // Parses colon separated list of outputs in the form WIDTHxHEIGHT@HZ (@HZ is optional)
+    static auto parse_output_specs(std::string const& output_specs) -> std::vector<OutputSpec>;
+    static auto parse_render_target(std::string const& render_target) -> RenderTargetType;
+
+    Platform(
+        std::vector<OutputSpec> outputs,
+        RenderTargetType render_target,
+        bool unthrottled,
+        std::shared_ptr<DisplayReport> const& report);
+
+    /* From Platform */
+    UniqueModulePtr<graphics::Display> create_display(
+        std::shared_ptr<DisplayConfigurationPolicy> const& initial_conf_policy,
+        std::shared_ptr<GLConfig> const& gl_config) override;
+
+private:
+    std::vector<OutputSpec> const outputs;
+    RenderTargetType const render_target;
+    bool const unthrottled;
+    std::shared_ptr<DisplayReport> const report;
+};
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_VIRTUAL_PLATFORM_H_ */
@@ -0,0 +1,146 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "render_targets.h"
+
+#include "mir/graphics/egl_error.h"
+
+#include <boost/throw_exception.hpp>
+
+namespace mg = mir::graphics;
+namespace mgv = mg::virt;
+namespace mrs = mir::renderer::software;
+namespace geom = mir::geometry;
+
+mgv::GLRenderTarget::GLRenderTarget(
+    helpers::SurfacelessDisplay const& display,
+    EGLContext shared_context,
+    geom::Size size)
+    : context{display, shared_context},
+      target_size{size}
+{
+}
+
+mgv::GLRenderTarget::~GLRenderTarget()
+{
+    if (framebuffer)
+    {
+        context.make_current();
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteTextures(1, &texture);
+        context.release_current();
+    }
+}
+
+auto mgv::GLRenderTarget::size() const -> geom::Size
+{
+    return target_size;
+}
+
+void mgv::GLRenderTarget::make_current()
+{
+    context.make_current();
+
+    if (!framebuffer)
+    {
+        // A texture, rather than a renderbuffer, as RGBA8 textures are colour-renderable in core GLES2
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(
+            GL_TEXTURE_2D, 0, GL_RGBA,
+            target_size.width.as_int(), target_size.height.as_int(),
+            0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+
+        auto const status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        if (status != GL_FRAMEBUFFER_COMPLETE)
+            BOOST_THROW_EXCEPTION(mg::gl_error(status, "Offscreen framebuffer is incomplete"));
+    }
+}
+
+void mgv::GLRenderTarget::release_current()
+{
+    context.release_current();
+}
+
+void mgv::GLRenderTarget::swap_buffers()
+{
+    // There's no display to wait for, so wait for the GPU (or llvmpipe's threads) instead
+    glFinish();
+}
+
+void mgv::GLRenderTarget::bind()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+mgv::CPURenderTarget::CPURenderTarget(geom::Size size)
+    : target_size{size},
+      stride{size.width.as_int() * 4}
+{
+    for (auto& buffer : buffers)
+    {
+        buffer.pixels = std::make_unique<unsigned char[]>(stride.as_uint32_t() * size.height.as_uint32_t());
+    }
+}
+
+auto mgv::CPURenderTarget::size() const -> geom::Size
+{
+    return target_size;
+}
+
+auto mgv::CPURenderTarget::map_back_buffer() -> std::unique_ptr<mrs::Mapping<unsigned char>>
+{
+    class Mapping : public mrs::Mapping<unsigned char>
+    {
+    public:
+        Mapping(unsigned char* pixels, geom::Size size, geom::Stride stride)
+            : pixels{pixels},
+              size_{size},
+              stride_{stride}
+        {
+        }
+
+        auto format() const -> MirPixelFormat override { return mir_pixel_format_xrgb_8888; }
+        auto stride() const -> geom::Stride override { return stride_; }
+        auto size() const -> geom::Size override { return size_; }
+        auto data() -> unsigned char* override { return pixels; }
+        auto len() const -> size_t override { return stride_.as_uint32_t() * size_.height.as_uint32_t(); }
+
+    private:
+        unsigned char* const pixels;
+        geom::Size const size_;
+        geom::Stride const stride_;
+    };
+
+    return std::make_unique<Mapping>(buffers[back].pixels.get(), target_size, stride);
+}
+
+auto mgv::CPURenderTarget::back_buffer_age() const -> unsigned
+{
+    auto const drawn = buffers[back].frame;
+    return drawn ? frame_count - drawn + 1 : 0;
+}
+
+void mgv::CPURenderTarget::swap_buffers()
+{
+    buffers[back].frame = ++frame_count;
+    back = (back + 1) % buffers.size();
+}
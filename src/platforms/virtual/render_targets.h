@@ -0,0 +1,99 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_VIRTUAL_RENDER_TARGETS_H_
+#define MIR_GRAPHICS_VIRTUAL_RENDER_TARGETS_H_
+
+#include "mir/graphics/display_buffer.h"
+#include "mir/renderer/gl/render_target.h"
+#include "mir/renderer/sw/render_target.h"
+#include "mir/geometry/size.h"
+#include "egl_helper.h"
+
+#include <GLES2/gl2.h>
+
+#include <array>
+#include <memory>
+
+namespace mir
+{
+namespace graphics
+{
+namespace virt
+{
+/// What an output is rendered into
+class OutputTarget : public NativeDisplayBuffer
+{
+public:
+    virtual ~OutputTarget() = default;
+};
+
+/**
+ * Renders into a framebuffer object on a surfaceless context.
+ *
+ * swap_buffers() waits for rendering to finish, so that the frame takes as long as it would to
+ * reach the screen on a real output.
+ */
+class GLRenderTarget : public OutputTarget, public renderer::gl::RenderTarget
+{
+public:
+    GLRenderTarget(helpers::SurfacelessDisplay const& display, EGLContext shared_context, geometry::Size size);
+    ~GLRenderTarget();
+
+    auto size() const -> geometry::Size override;
+    void make_current() override;
+    void release_current() override;
+    void swap_buffers() override;
+    void bind() override;
+
+private:
+    helpers::SurfacelessContext const context;
+    geometry::Size const target_size;
+    // Created on first use, as that's when the context is current
+    GLuint texture{0};
+    GLuint framebuffer{0};
+};
+
+/// Double-buffered memory, drawn into by the software renderer
+class CPURenderTarget : public OutputTarget, public renderer::software::RenderTarget
+{
+public:
+    explicit CPURenderTarget(geometry::Size size);
+
+    auto size() const -> geometry::Size override;
+    auto map_back_buffer() -> std::unique_ptr<renderer::software::Mapping<unsigned char>> override;
+    auto back_buffer_age() const -> unsigned override;
+    void swap_buffers() override;
+
+private:
+    struct Buffer
+    {
+        std::unique_ptr<unsigned char[]> pixels;
+        /// The frame last drawn into this buffer, or 0 if there is none
+        unsigned frame{0};
+    };
+
+    geometry::Size const target_size;
+    geometry::Stride const stride;
+    std::array<Buffer, 2> buffers;
+    size_t back{0};
+    unsigned frame_count{0};
+};
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_VIRTUAL_RENDER_TARGETS_H_ */
@@ -16,8 +16,11 @@
  */
 
 #include "displayclient.h"
+#include "host_buffers.h"
 #include "mir/graphics/egl_error.h"
+#include <mir/graphics/buffer.h>
 #include <mir/graphics/pixel_format_utils.h>
+#include <mir/graphics/renderable.h>
 
 #include <wayland-client.h>
 #include <wayland-egl.h>
@@ -66,6 +69,12 @@ public:
     xdg_surface* shell_surface{nullptr};
     xdg_toplevel* shell_toplevel{nullptr};
 
+    // A subsurface covering the output, showing a client buffer in place of the composited frame
+    wl_surface* overlay_surface{nullptr};
+    wl_subsurface* overlay_subsurface{nullptr};
+    wl_buffer* pending_overlay{nullptr};
+    bool overlay_shown{false};
+
     EGLContext eglctx{EGL_NO_CONTEXT};
     wl_egl_window* egl_window{nullptr};
     EGLSurface eglsurface{EGL_NO_SURFACE};
@@ -118,6 +127,52 @@ static EGLint const ctxattribs[] =
         EGL_CONTEXT_CLIENT_VERSION, 2,
         EGL_NONE
     };
+
+struct FrameSync
+{
+    explicit FrameSync(wl_surface* surface):
+        surface{surface}
+    {
+    }
+
+    void init()
+    {
+        callback = wl_surface_frame(surface);
+        static struct wl_callback_listener const frame_listener =
+            {
+                [](void* data, auto... args)
+                    { static_cast<FrameSync*>(data)->frame_done(args...); },
+            };
+        wl_callback_add_listener(callback, &frame_listener, this);
+    }
+
+    ~FrameSync()
+    {
+        wl_callback_destroy(callback);
+    }
+
+    void frame_done(wl_callback*, uint32_t)
+    {
+        {
+            std::lock_guard lock{mutex};
+            posted = true;
+        }
+        cv.notify_one();
+    }
+
+    void wait_for_done()
+    {
+        std::unique_lock lock{mutex};
+        cv.wait_for(lock, std::chrono::milliseconds{100}, [this]{ return posted; });
+    }
+
+    wl_surface* const surface;
+
+    wl_callback* callback;
+    std::mutex mutex;
+    bool posted = false;
+    std::condition_variable cv;
+};
 }
 
 mgw::DisplayClient::Output::Output(
@@ -172,6 +227,12 @@ mgw::DisplayClient::Output::~Output()
         xdg_surface_destroy(shell_surface);
     }
 
+    if (overlay_subsurface)
+    {
+        wl_subsurface_destroy(overlay_subsurface);
+        wl_surface_destroy(overlay_surface);
+    }
+
     wl_surface_destroy(surface);
 
     if (eglsurface != EGL_NO_SURFACE)
@@ -302,6 +363,23 @@ void mgw::DisplayClient::Output::done()
 
         xdg_toplevel_set_fullscreen(shell_toplevel, output);
         wl_surface_set_buffer_scale(surface, round(dcout.scale));
+
+        if (owner->subcompositor)
+        {
+            overlay_surface = wl_compositor_create_surface(owner->compositor);
+            overlay_subsurface = wl_subcompositor_get_subsurface(owner->subcompositor, overlay_surface, surface);
+
+            // Only opaque buffers are shown, and input should go to the output surface beneath
+            auto const region = wl_compositor_create_region(owner->compositor);
+            wl_region_add(region, 0, 0, INT32_MAX, INT32_MAX);
+            wl_surface_set_opaque_region(overlay_surface, region);
+            wl_region_destroy(region);
+            auto const empty_region = wl_compositor_create_region(owner->compositor);
+            wl_surface_set_input_region(overlay_surface, empty_region);
+            wl_region_destroy(empty_region);
+            wl_surface_commit(overlay_surface);
+        }
+
         wl_surface_commit(surface);
 
         // After the next roundtrip the surface should be configured
@@ -355,6 +433,30 @@ void mgw::DisplayClient::Output::for_each_display_buffer(std::function<void(Disp
 
 void mgw::DisplayClient::Output::post()
 {
+    if (!pending_overlay)
+    {
+        // The frame was composited, and swap_buffers() has presented it
+        return;
+    }
+
+    auto const frame_sync = std::make_shared<FrameSync>(surface);
+    owner->spawn([frame_sync]()
+        {
+            frame_sync->init();
+        });
+
+    wl_surface_set_buffer_scale(overlay_surface, round(dcout.scale));
+    wl_surface_attach(overlay_surface, pending_overlay, 0, 0);
+    wl_surface_damage(overlay_surface, 0, 0, INT32_MAX, INT32_MAX);
+    wl_surface_commit(overlay_surface);
+    pending_overlay = nullptr;
+    overlay_shown = true;
+
+    // The subsurface is synchronized, so its new buffer is shown when the output surface is committed
+    wl_surface_commit(surface);
+    wl_display_flush(owner->display);
+
+    frame_sync->wait_for_done();
 }
 
 auto mgw::DisplayClient::Output::recommended_sleep() const -> std::chrono::milliseconds
@@ -367,9 +469,40 @@ auto mgw::DisplayClient::Output::view_area() const -> geometry::Rectangle
     return dcout.extents();
 }
 
-bool mgw::DisplayClient::Output::overlay(mir::graphics::RenderableList const&)
+bool mgw::DisplayClient::Output::overlay(mir::graphics::RenderableList const& renderlist)
 {
-    return false;
+    if (!overlay_surface)
+    {
+        return false;
+    }
+
+    // The host can show the topmost renderable's buffer for us, if it covers the output and nothing shows through
+    auto const area = view_area();
+    auto const topmost = std::find_if(renderlist.rbegin(), renderlist.rend(),
+        [&](auto const& renderable) { return area.overlaps(renderable->screen_position()); });
+
+    if (topmost == renderlist.rend())
+    {
+        return false;
+    }
+
+    auto const& renderable = *topmost;
+    if (renderable->screen_position() != area ||
+        renderable->alpha() != 1.0f ||
+        renderable->shaped() ||
+        renderable->transformation() != glm::mat4{1})
+    {
+        return false;
+    }
+
+    auto const buffer = renderable->buffer();
+    if (buffer->size() != output_size)
+    {
+        return false;
+    }
+
+    pending_overlay = owner->host_buffers->wl_buffer_for(buffer);
+    return pending_overlay != nullptr;
 }
 
 auto mgw::DisplayClient::Output::transformation() const -> glm::mat2
@@ -403,58 +536,21 @@ void mgw::DisplayClient::Output::release_current()
 
 void mgw::DisplayClient::Output::swap_buffers()
 {
-    struct FrameSync
-    {
-        explicit FrameSync(wl_surface* surface):
-            surface{surface}
-        {
-        }
-
-        void init()
-        {
-            callback = wl_surface_frame(surface);
-            static struct wl_callback_listener const frame_listener =
-                {
-                    [](void* data, auto... args)
-                        { static_cast<FrameSync*>(data)->frame_done(args...); },
-                };
-            wl_callback_add_listener(callback, &frame_listener, this);
-        }
-
-        ~FrameSync()
-        {
-            wl_callback_destroy(callback);
-        }
-
-        void frame_done(wl_callback*, uint32_t)
-        {
-            {
-                std::lock_guard lock{mutex};
-                posted = true;
-            }
-            cv.notify_one();
-        }
-
-        void wait_for_done()
-        {
-            std::unique_lock lock{mutex};
-            cv.wait_for(lock, std::chrono::milliseconds{100}, [this]{ return posted; });
-        }
-
-        wl_surface* const surface;
-
-        wl_callback* callback;
-        std::mutex mutex;
-        bool posted = false;
-        std::condition_variable cv;
-    };
-
     auto const frame_sync = std::make_shared<FrameSync>(surface);
     owner->spawn([frame_sync]()
         {
             frame_sync->init();
         });
 
+    if (overlay_shown)
+    {
+        // Back to compositing, so stop the host showing the last overlaid buffer.
+        // The subsurface is synchronized, so this takes effect with the swap.
+        wl_surface_attach(overlay_surface, nullptr, 0, 0);
+        wl_surface_commit(overlay_surface);
+        overlay_shown = false;
+    }
+
     // Avoid throttling compositing by blocking in eglSwapBuffers().
     // Instead we use the frame "done" notification.
     eglSwapInterval(owner->egldisplay, 0);
@@ -474,6 +570,7 @@ mgw::DisplayClient::DisplayClient(
     std::shared_ptr<GLConfig> const& gl_config) :
     display{display},
     keyboard_context_{xkb_context_new(XKB_CONTEXT_NO_FLAGS)},
+    host_buffers{std::make_unique<HostBuffers>(display)},
     registry{nullptr, [](auto){}}
 {
     if (!keyboard_context_)
@@ -575,6 +672,7 @@ mgw::DisplayClient::~DisplayClient()
         std::lock_guard lock{outputs_mutex};
         bound_outputs.clear();
     }
+    host_buffers.reset();
     registry.reset();
 
     eglDestroyContext(egldisplay, eglctx);
@@ -603,6 +701,16 @@ void mgw::DisplayClient::new_global(
         // As luck would have it, I know that argb8888 is the only format we support :)
         // {arg} TODO needs fixing
         add_shm_listener(self, self->shm);
+        self->host_buffers->set_shm(self->shm);
+    }
+    else if (strcmp(interface, "wl_subcompositor") == 0)
+    {
+        self->subcompositor = static_cast<decltype(self->subcompositor)>(
+            wl_registry_bind(registry, id, &wl_subcompositor_interface, std::min(version, 1u)));
+    }
+    else if (strcmp(interface, zwp_linux_dmabuf_v1_interface.name) == 0)
+    {
+        self->host_buffers->bind_dmabuf(registry, id, version);
     }
     else if (strcmp(interface, "wl_seat") == 0)
     {
@@ -46,6 +46,7 @@ namespace graphics
 {
 namespace wayland
 {
+class HostBuffers;
 
 class DisplayClient
     : public Executor
@@ -131,6 +132,7 @@ protected:
     void delete_outputs_to_be_deleted();
 
     wl_compositor* compositor = nullptr;
+    wl_subcompositor* subcompositor = nullptr;
     xdg_wm_base* shell = nullptr;
     wl_seat* seat = nullptr;
     wl_shm* shm = nullptr;
@@ -162,6 +164,8 @@ protected:
     geometry::Displacement pointer_displacement; // Position of current output
     geometry::Displacement touch_displacement;   // Position of current output
 
+    /// Shares client buffers with the host, so outputs can show them without compositing
+    std::unique_ptr<HostBuffers> host_buffers;
     std::unique_ptr<wl_registry, decltype(&wl_registry_destroy)> registry;
 
     std::mutex mutable outputs_mutex;
@@ -0,0 +1,457 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "host_buffers.h"
+
+#include <mir/fd.h>
+#include <mir/log.h>
+#include <mir/graphics/buffer.h>
+#include <mir/graphics/dmabuf_buffer.h>
+#include <mir/renderer/sw/pixel_source.h>
+
+#include <boost/throw_exception.hpp>
+
+#include <drm_fourcc.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <system_error>
+
+namespace mgw = mir::graphics::wayland;
+namespace mrs = mir::renderer::software;
+namespace geom = mir::geometry;
+
+namespace
+{
+// Enough for a frame on screen, one queued, and one being copied
+size_t const max_shm_buffers = 3;
+
+/* The Buffer we're given is made afresh for each commit, so we can't see when the client destroys
+ * the wl_buffer behind it. Instead, an import is destroyed once its dmabuf hasn't been shown for a
+ * while, or to make room when the client cycles through more dmabufs than any sane swapchain has.
+ */
+uint64_t const max_idle_frames = 60;
+size_t const max_imports = 8;
+}
+
+struct mgw::HostBuffers::Import
+{
+    Import(HostBuffers* owner, ImportKey const& key, uint64_t frame) :
+        owner{owner},
+        key{key},
+        last_used{frame}
+    {
+    }
+
+    HostBuffers* const owner;
+    ImportKey const key;
+    uint64_t last_used;
+    /// The outstanding create request, until the host answers it
+    zwp_linux_buffer_params_v1* params{nullptr};
+    /// The host's buffer, once created
+    wl_buffer* buffer{nullptr};
+    /// The client buffer last attached, held until the host releases the wl_buffer
+    std::shared_ptr<Buffer> shown;
+
+    auto idle() const -> bool
+    {
+        return !params && !shown;
+    }
+};
+
+struct mgw::HostBuffers::ShmBuffer
+{
+    ShmBuffer(wl_shm* shm, geom::Size size, HostBuffers* owner) :
+        size{size},
+        stride{size.width.as_uint32_t() * 4},
+        len{stride * size.height.as_uint32_t()}
+    {
+        // As we're a Wayland client, create the shm file like Wayland clients.
+        // While using O_TMPFILE would be more elegant, this works with Snap-confined servers.
+        static auto const template_filename =
+            std::string{getenv("XDG_RUNTIME_DIR")} + "/wayland-overlay-shared-XXXXXX";
+
+        auto const filename = strdup(template_filename.c_str());
+        mir::Fd const fd{mkostemp(filename, O_CLOEXEC)};
+        unlink(filename);
+        free(filename);
+
+        if (fd < 0)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to open shm buffer"}));
+        }
+
+        if (auto error = posix_fallocate(fd, 0, len))
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{error, std::system_category(), "Failed to allocate shm buffer"}));
+        }
+
+        if ((data = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to mmap buffer"}));
+        }
+
+        auto const pool = wl_shm_create_pool(shm, fd, len);
+        // The renderable is opaque, so whatever is in the alpha channel is ignored
+        buffer = wl_shm_pool_create_buffer(
+            pool, 0, size.width.as_int(), size.height.as_int(), stride, WL_SHM_FORMAT_XRGB8888);
+        wl_shm_pool_destroy(pool);
+
+        static wl_buffer_listener const release_listener{&HostBuffers::shm_release};
+        wl_buffer_add_listener(buffer, &release_listener, owner);
+    }
+
+    ~ShmBuffer()
+    {
+        wl_buffer_destroy(buffer);
+        munmap(data, len);
+    }
+
+    ShmBuffer(ShmBuffer const&) = delete;
+    ShmBuffer& operator=(ShmBuffer const&) = delete;
+
+    geom::Size const size;
+    uint32_t const stride;
+    size_t const len;
+    void* data;
+    wl_buffer* buffer;
+    /// Attached to a surface, and not yet released by the host
+    bool busy{false};
+};
+
+mgw::HostBuffers::HostBuffers(wl_display* display) :
+    display{display}
+{
+}
+
+mgw::HostBuffers::~HostBuffers()
+{
+    for (auto const& [key, import] : imports)
+    {
+        if (import->params)
+        {
+            zwp_linux_buffer_params_v1_destroy(import->params);
+        }
+        if (import->buffer)
+        {
+            wl_buffer_destroy(import->buffer);
+        }
+    }
+
+    if (dmabuf)
+    {
+        zwp_linux_dmabuf_v1_destroy(dmabuf);
+    }
+}
+
+void mgw::HostBuffers::bind_dmabuf(wl_registry* registry, uint32_t id, uint32_t version)
+{
+    static zwp_linux_dmabuf_v1_listener const dmabuf_listener{
+        &HostBuffers::dmabuf_format,
+        &HostBuffers::dmabuf_modifier,
+    };
+
+    dmabuf = static_cast<zwp_linux_dmabuf_v1*>(
+        wl_registry_bind(registry, id, &zwp_linux_dmabuf_v1_interface, std::min(version, 3u)));
+    zwp_linux_dmabuf_v1_add_listener(dmabuf, &dmabuf_listener, this);
+}
+
+void mgw::HostBuffers::set_shm(wl_shm* shm)
+{
+    this->shm = shm;
+}
+
+void mgw::HostBuffers::dmabuf_format(void* data, zwp_linux_dmabuf_v1* dmabuf, uint32_t format)
+{
+    // Version 3 hosts send modifier events as well, which say which of these support implicit modifiers
+    if (zwp_linux_dmabuf_v1_get_version(dmabuf) < ZWP_LINUX_DMABUF_V1_MODIFIER_SINCE_VERSION)
+    {
+        auto const self = static_cast<HostBuffers*>(data);
+        std::lock_guard lock{self->mutex};
+        self->host_formats.emplace(format, DRM_FORMAT_MOD_INVALID);
+    }
+}
+
+void mgw::HostBuffers::dmabuf_modifier(
+    void* data,
+    zwp_linux_dmabuf_v1*,
+    uint32_t format,
+    uint32_t modifier_hi,
+    uint32_t modifier_lo)
+{
+    auto const self = static_cast<HostBuffers*>(data);
+    std::lock_guard lock{self->mutex};
+    self->host_formats.emplace(format, (uint64_t{modifier_hi} << 32) | modifier_lo);
+}
+
+void mgw::HostBuffers::import_created(void* data, zwp_linux_buffer_params_v1* params, wl_buffer* buffer)
+{
+    auto const import = static_cast<Import*>(data);
+
+    static wl_buffer_listener const release_listener{&HostBuffers::forwarded_release};
+    wl_buffer_add_listener(buffer, &release_listener, import);
+
+    std::lock_guard lock{import->owner->mutex};
+    import->buffer = buffer;
+    import->params = nullptr;
+    zwp_linux_buffer_params_v1_destroy(params);
+}
+
+void mgw::HostBuffers::import_failed(void* data, zwp_linux_buffer_params_v1* params)
+{
+    auto const import = static_cast<Import*>(data);
+    auto const self = import->owner;
+    auto const key = import->key;
+    auto const format = std::make_pair(std::get<4>(import->key), std::get<5>(import->key));
+
+    log_warning(
+        "Host failed to import dmabuf (format 0x%x, modifier 0x%llx); compositing buffers like it instead",
+        format.first,
+        static_cast<unsigned long long>(format.second));
+
+    zwp_linux_buffer_params_v1_destroy(params);
+
+    std::lock_guard lock{self->mutex};
+    self->failed_formats.insert(format);
+    self->imports.erase(key);
+}
+
+void mgw::HostBuffers::forwarded_release(void* data, wl_buffer*)
+{
+    auto const import = static_cast<Import*>(data);
+
+    std::shared_ptr<Buffer> client_buffer;
+    {
+        std::lock_guard lock{import->owner->mutex};
+        client_buffer = std::move(import->shown);
+    }
+
+    // The wl_buffer is kept in case the client shows this dmabuf again.
+    // Dropping the client buffer (outside the lock) lets the client reuse it.
+}
+
+void mgw::HostBuffers::shm_release(void* data, wl_buffer* buffer)
+{
+    auto const self = static_cast<HostBuffers*>(data);
+
+    std::lock_guard lock{self->mutex};
+    for (auto const& shm_buffer : self->shm_buffers)
+    {
+        if (shm_buffer->buffer == buffer)
+        {
+            shm_buffer->busy = false;
+        }
+    }
+}
+
+auto mgw::HostBuffers::wl_buffer_for(std::shared_ptr<Buffer> const& buffer) -> wl_buffer*
+{
+    auto const native = buffer->native_buffer_base();
+
+    if (auto const image = dynamic_cast<DMABufBuffer*>(native))
+    {
+        return dmabuf ? import_dmabuf(buffer, *image) : nullptr;
+    }
+
+    if (dynamic_cast<mrs::ReadMappableBuffer*>(native))
+    {
+        return shm ? copy_to_shm(*buffer) : nullptr;
+    }
+
+    return nullptr;
+}
+
+auto mgw::HostBuffers::import_dmabuf(std::shared_ptr<Buffer> const& buffer, DMABufBuffer const& image) -> wl_buffer*
+{
+    auto const modifier = image.modifier().value_or(DRM_FORMAT_MOD_INVALID);
+    auto const format = std::make_pair(image.drm_fourcc(), modifier);
+    auto const& planes = image.planes();
+
+    struct stat dmabuf_stat;
+    if (planes.empty() || fstat(planes.front().dma_buf, &dmabuf_stat) != 0)
+    {
+        return nullptr;
+    }
+
+    ImportKey const key{
+        dmabuf_stat.st_dev,
+        dmabuf_stat.st_ino,
+        planes.front().offset,
+        planes.front().stride,
+        format.first,
+        format.second,
+        image.size().width.as_int(),
+        image.size().height.as_int()};
+
+    std::lock_guard lock{mutex};
+    if (!host_formats.contains(format) || failed_formats.contains(format))
+    {
+        return nullptr;
+    }
+
+    auto const frame = ++dmabuf_frame;
+    std::erase_if(imports, [&](auto const& entry)
+        {
+            auto const& [entry_key, import] = entry;
+            if (entry_key == key || !import->idle() || frame - import->last_used <= max_idle_frames)
+            {
+                return false;
+            }
+            wl_buffer_destroy(import->buffer);
+            return true;
+        });
+
+    if (auto const existing = imports.find(key); existing != imports.end())
+    {
+        auto const& import = existing->second;
+        import->last_used = frame;
+        if (!import->buffer)
+        {
+            // Still waiting for the host; composite this frame ourselves
+            return nullptr;
+        }
+        import->shown = buffer;
+        return import->buffer;
+    }
+
+    if (imports.size() >= max_imports)
+    {
+        auto const oldest = std::min_element(imports.begin(), imports.end(), [](auto const& a, auto const& b)
+            {
+                return std::make_pair(!a.second->idle(), a.second->last_used) <
+                       std::make_pair(!b.second->idle(), b.second->last_used);
+            });
+        if (!oldest->second->idle())
+        {
+            return nullptr;
+        }
+        wl_buffer_destroy(oldest->second->buffer);
+        imports.erase(oldest);
+    }
+
+    /* This uses create() rather than create_immed() as the host can only report failure of the
+     * latter with a protocol error, which would take down the whole connection. We don't wait for
+     * the result: the frames until the host has created the buffer are composited as usual.
+     */
+    auto& import = imports[key];
+    import = std::make_unique<Import>(this, key, frame);
+    import->params = zwp_linux_dmabuf_v1_create_params(dmabuf);
+
+    static zwp_linux_buffer_params_v1_listener const params_listener{
+        &HostBuffers::import_created,
+        &HostBuffers::import_failed,
+    };
+    zwp_linux_buffer_params_v1_add_listener(import->params, &params_listener, import.get());
+
+    uint32_t plane_idx = 0;
+    for (auto const& plane : planes)
+    {
+        zwp_linux_buffer_params_v1_add(
+            import->params,
+            plane.dma_buf,
+            plane_idx++,
+            plane.offset,
+            plane.stride,
+            modifier >> 32,
+            modifier & 0xffffffff);
+    }
+
+    zwp_linux_buffer_params_v1_create(
+        import->params,
+        image.size().width.as_int(),
+        image.size().height.as_int(),
+        image.drm_fourcc(),
+        0);
+    wl_display_flush(display);
+
+    return nullptr;
+}
+
+auto mgw::HostBuffers::copy_to_shm(Buffer& buffer) -> wl_buffer*
+{
+    auto const mappable = dynamic_cast<mrs::ReadMappableBuffer*>(buffer.native_buffer_base());
+    if (mappable->format() != mir_pixel_format_xrgb_8888 && mappable->format() != mir_pixel_format_argb_8888)
+    {
+        return nullptr;
+    }
+
+    auto const size = mappable->size();
+    ShmBuffer* target{nullptr};
+    {
+        std::lock_guard lock{mutex};
+
+        // Buffers of another size won't be needed again, unless the client changes back
+        std::erase_if(shm_buffers, [&](auto const& b) { return !b->busy && b->size != size; });
+
+        auto const idle = std::find_if(
+            shm_buffers.begin(), shm_buffers.end(), [](auto const& b) { return !b->busy; });
+
+        if (idle != shm_buffers.end())
+        {
+            target = idle->get();
+        }
+        else if (shm_buffers.size() < max_shm_buffers)
+        {
+            try
+            {
+                target = shm_buffers.emplace_back(std::make_unique<ShmBuffer>(shm, size, this)).get();
+            }
+            catch (std::exception const& error)
+            {
+                // Composite instead; overlay() can't fail any other way
+                if (!shm_allocation_failed)
+                {
+                    log_warning(
+                        "Failed to allocate shm buffer to share with host; compositing instead: %s",
+                        error.what());
+                    shm_allocation_failed = true;
+                }
+                return nullptr;
+            }
+        }
+        else
+        {
+            // The host is holding on to all of them, so fall back to compositing
+            return nullptr;
+        }
+
+        target->busy = true;
+    }
+
+    auto const mapping = mappable->map_readable();
+    auto const src = mapping->data();
+    auto const src_stride = mapping->stride().as_uint32_t();
+    auto const dest = static_cast<unsigned char*>(target->data);
+
+    if (src_stride == target->stride)
+    {
+        std::memcpy(dest, src, target->len);
+    }
+    else
+    {
+        for (uint32_t y = 0; y != size.height.as_uint32_t(); ++y)
+        {
+            std::memcpy(dest + y * target->stride, src + y * src_stride, target->stride);
+        }
+    }
+
+    return target->buffer;
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_WAYLAND_HOST_BUFFERS_H_
+#define MIR_WAYLAND_HOST_BUFFERS_H_
+
+#include <mir/geometry/size.h>
+
+#include "protocol/linux-dmabuf-unstable-v1-client.h"
+#include <wayland-client.h>
+
+#include <sys/types.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+class Buffer;
+class DMABufBuffer;
+
+namespace wayland
+{
+
+/**
+ * Hands client buffers to the host compositor as wl_buffers, so that it can composite them itself.
+ *
+ * dmabufs are shared with the host through zwp_linux_dmabuf_v1; the client buffer is held until the
+ * host releases the wl_buffer. Imports are made asynchronously and kept for as long as the client keeps
+ * showing the same dmabuf, so each of its buffers is imported once rather than every frame. Buffers that
+ * can only be read by the CPU are copied into wl_shm buffers, which are reused once the host releases them.
+ */
+class HostBuffers
+{
+public:
+    explicit HostBuffers(wl_display* display);
+    ~HostBuffers();
+
+    HostBuffers(HostBuffers const&) = delete;
+    HostBuffers& operator=(HostBuffers const&) = delete;
+
+    /// Called from the registry listener, so the host's formats are received with the other globals
+    void bind_dmabuf(wl_registry* registry, uint32_t id, uint32_t version);
+    void set_shm(wl_shm* shm);
+
+    /**
+     * A wl_buffer showing the current content of buffer.
+     *
+     * The wl_buffer is valid until it has been attached to a surface once, committed, and released
+     * by the host.
+     *
+     * \return  nullptr if the buffer can't be shared with the host (yet)
+     */
+    auto wl_buffer_for(std::shared_ptr<Buffer> const& buffer) -> wl_buffer*;
+
+private:
+    struct ShmBuffer;
+    struct Import;
+
+    /// Identifies a client dmabuf: the device and inode of its first plane, that plane's offset and
+    /// stride, and the buffer's format, modifier and size
+    using ImportKey = std::tuple<dev_t, ino_t, uint32_t, uint32_t, uint32_t, uint64_t, int, int>;
+
+    static void dmabuf_format(void* data, zwp_linux_dmabuf_v1*, uint32_t format);
+    static void dmabuf_modifier(
+        void* data,
+        zwp_linux_dmabuf_v1*,
+        uint32_t format,
+        uint32_t modifier_hi,
+        uint32_t modifier_lo);
+    static void import_created(void* data, zwp_linux_buffer_params_v1* params, wl_buffer* buffer);
+    static void import_failed(void* data, zwp_linux_buffer_params_v1* params);
+    static void forwarded_release(void* data, wl_buffer* buffer);
+    static void shm_release(void* data, wl_buffer* buffer);
+
+    auto import_dmabuf(std::shared_ptr<Buffer> const& buffer, DMABufBuffer const& dmabuf) -> wl_buffer*;
+    auto copy_to_shm(Buffer& buffer) -> wl_buffer*;
+
+    wl_display* const display;
+    wl_shm* shm{nullptr};
+    zwp_linux_dmabuf_v1* dmabuf{nullptr};
+
+    std::mutex mutable mutex;
+    /// Format and modifier pairs the host has advertised, with DRM_FORMAT_MOD_INVALID for implicit modifiers
+    std::set<std::pair<uint32_t, uint64_t>> host_formats;
+    /// Format and modifier pairs the host has failed to import
+    std::set<std::pair<uint32_t, uint64_t>> failed_formats;
+    /// Client dmabufs imported (or being imported) into the host
+    std::map<ImportKey, std::unique_ptr<Import>> imports;
+    /// Counts dmabuf frames, to find imports the client is no longer showing
+    uint64_t dmabuf_frame{0};
+    std::vector<std::unique_ptr<ShmBuffer>> shm_buffers;
+    bool shm_allocation_failed{false};
+};
+}
+}
+}
+
+#endif //MIR_WAYLAND_HOST_BUFFERS_H_
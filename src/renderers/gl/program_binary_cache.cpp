@@ -0,0 +1,183 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIR_LOG_COMPONENT "GLRenderer"
+
+#include "program_binary_cache.h"
+#include "mir/log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include <unistd.h>
+
+namespace mrg = mir::renderer::gl;
+namespace fs = std::filesystem;
+
+namespace
+{
+char const magic[8] = {'M', 'I', 'R', 'G', 'L', 'P', 'B', '1'};
+
+// Binaries for the renderer's shaders are tens of KiB; anything much larger is not one of ours
+std::uint64_t const max_entry_size = 16 * 1024 * 1024;
+
+// A stable hash (unlike std::hash) so that file names survive a rebuild of Mir
+auto fnv1a(std::string const& s) -> std::uint64_t
+{
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    for (unsigned char c : s)
+    {
+        hash ^= c;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+template<typename T>
+void write_value(std::ostream& out, T value)
+{
+    out.write(reinterpret_cast<char const*>(&value), sizeof value);
+}
+
+template<typename T>
+auto read_value(std::istream& in) -> T
+{
+    T value{};
+    in.read(reinterpret_cast<char*>(&value), sizeof value);
+    return value;
+}
+}
+
+mrg::ProgramBinaryCache::ProgramBinaryCache(fs::path directory)
+    : directory{std::move(directory)}
+{
+}
+
+auto mrg::ProgramBinaryCache::for_current_user() -> std::shared_ptr<ProgramBinaryCache>
+{
+    fs::path base;
+    if (auto const xdg_cache_home = getenv("XDG_CACHE_HOME"); xdg_cache_home && *xdg_cache_home)
+    {
+        base = xdg_cache_home;
+    }
+    else if (auto const home = getenv("HOME"); home && *home)
+    {
+        base = fs::path{home} / ".cache";
+    }
+    else
+    {
+        return nullptr;
+    }
+
+    return std::make_shared<ProgramBinaryCache>(base / "mir" / "gl-programs");
+}
+
+auto mrg::ProgramBinaryCache::path_for(std::string const& key) const -> fs::path
+{
+    std::stringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << fnv1a(key) << ".bin";
+    return directory / name.str();
+}
+
+auto mrg::ProgramBinaryCache::load(std::string const& key) const -> std::optional<Binary>
+{
+    std::ifstream in{path_for(key), std::ios::binary};
+    if (!in)
+        return std::nullopt;
+
+    char file_magic[sizeof magic];
+    in.read(file_magic, sizeof file_magic);
+    if (!in || !std::equal(std::begin(magic), std::end(magic), file_magic))
+        return std::nullopt;
+
+    auto const key_size = read_value<std::uint32_t>(in);
+    if (!in || key_size != key.size())
+        return std::nullopt;
+
+    std::string file_key(key_size, '\0');
+    in.read(file_key.data(), key_size);
+    if (!in || file_key != key)
+        return std::nullopt;
+
+    Binary binary;
+    binary.format = read_value<std::uint32_t>(in);
+    auto const data_size = read_value<std::uint64_t>(in);
+    if (!in || data_size == 0 || data_size > max_entry_size)
+        return std::nullopt;
+
+    binary.data.resize(data_size);
+    in.read(binary.data.data(), data_size);
+    if (!in)
+        return std::nullopt;
+
+    return binary;
+}
+
+void mrg::ProgramBinaryCache::store(std::string const& key, Binary const& binary) const
+{
+    static std::atomic<unsigned> serial{0};
+
+    auto const path = path_for(key);
+    // Write to a private file and rename it into place, so that a concurrent
+    // (or interrupted) writer can never leave a partial entry behind.
+    auto temp_path = path;
+    temp_path += "." + std::to_string(getpid()) + "." + std::to_string(serial++);
+
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+    if (ec)
+    {
+        mir::log_warning("Failed to create GL program cache directory %s: %s",
+            directory.c_str(), ec.message().c_str());
+        return;
+    }
+
+    {
+        std::ofstream out{temp_path, std::ios::binary | std::ios::trunc};
+        out.write(magic, sizeof magic);
+        write_value<std::uint32_t>(out, key.size());
+        out.write(key.data(), key.size());
+        write_value<std::uint32_t>(out, binary.format);
+        write_value<std::uint64_t>(out, binary.data.size());
+        out.write(binary.data.data(), binary.data.size());
+        out.close();
+
+        if (!out)
+        {
+            mir::log_warning("Failed to write GL program cache entry %s", temp_path.c_str());
+            fs::remove(temp_path, ec);
+            return;
+        }
+    }
+
+    fs::rename(temp_path, path, ec);
+    if (ec)
+    {
+        mir::log_warning("Failed to write GL program cache entry %s: %s", path.c_str(), ec.message().c_str());
+        fs::remove(temp_path, ec);
+    }
+}
+
+void mrg::ProgramBinaryCache::discard(std::string const& key) const
+{
+    std::error_code ec;
+    fs::remove(path_for(key), ec);
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_GL_PROGRAM_BINARY_CACHE_H_
+#define MIR_RENDERER_GL_PROGRAM_BINARY_CACHE_H_
+
+#include <GLES2/gl2.h>
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace mir
+{
+namespace renderer
+{
+namespace gl
+{
+/**
+ * Persistent storage for linked GL program binaries (as produced by GL_OES_get_program_binary).
+ *
+ * Each binary is stored against a key, which the caller builds from everything that determines
+ * the binary: the driver identification strings and the shader sources. The full key is stored
+ * alongside the binary and checked on load, so a hash collision or a cache written by a different
+ * driver reads as a miss rather than as a bad binary.
+ *
+ * This class does no GL calls; it is safe to share between rendering threads.
+ */
+class ProgramBinaryCache
+{
+public:
+    struct Binary
+    {
+        GLenum format;
+        std::vector<char> data;
+    };
+
+    explicit ProgramBinaryCache(std::filesystem::path directory);
+
+    /// A cache in $XDG_CACHE_HOME/mir/gl-programs (falling back to $HOME/.cache), or nullptr if
+    /// neither variable is set.
+    static auto for_current_user() -> std::shared_ptr<ProgramBinaryCache>;
+
+    /// The binary stored for key, or nullopt if there is none (or it cannot be read)
+    auto load(std::string const& key) const -> std::optional<Binary>;
+
+    /// Stores binary for key, replacing any existing entry. Failure to write is logged, not thrown.
+    void store(std::string const& key, Binary const& binary) const;
+
+    /// Removes the entry for key; used when GL rejects a stored binary
+    void discard(std::string const& key) const;
+
+private:
+    auto path_for(std::string const& key) const -> std::filesystem::path;
+
+    std::filesystem::path const directory;
+};
+}
+}
+}
+
+#endif // MIR_RENDERER_GL_PROGRAM_BINARY_CACHE_H_
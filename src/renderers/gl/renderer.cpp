@@ -16,6 +16,7 @@
 #define MIR_LOG_COMPONENT "GLRenderer"
 
 #include "renderer.h"
+#include "program_binary_cache.h"
 #include "mir/compositor/buffer_stream.h"
 #include "mir/graphics/renderable.h"
 #include "mir/graphics/buffer.h"
@@ -32,12 +33,15 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <EGL/egl.h>
+#include <GLES2/gl2ext.h>
 
 #include <boost/throw_exception.hpp>
 #include <stdexcept>
 #include <cmath>
 #include <sstream>
 #include <mutex>
+#include <optional>
+#include <cstring>
 
 namespace mg = mir::graphics;
 namespace mgl = mir::gl;
@@ -146,14 +150,69 @@ const GLchar* const vertex_shader_src =
     "   v_texcoord = texcoord;\n"
     "}\n"
 };
+
+/// The GL_OES_get_program_binary entry points
+struct ProgramBinaryExtension
+{
+    PFNGLGETPROGRAMBINARYOESPROC const glGetProgramBinaryOES;
+    PFNGLPROGRAMBINARYOESPROC const glProgramBinaryOES;
+};
+
+// NOTE: This must be called with a current GL context
+auto program_binary_extension() -> std::optional<ProgramBinaryExtension>
+{
+    auto const extensions = reinterpret_cast<char const*>(glGetString(GL_EXTENSIONS));
+    if (!extensions)
+        return std::nullopt;
+
+    char const* const name = "GL_OES_get_program_binary";
+    auto const name_length = strlen(name);
+    bool found = false;
+    for (auto p = strstr(extensions, name); p && !found; p = strstr(p + 1, name))
+    {
+        found = (p == extensions || p[-1] == ' ') && (p[name_length] == ' ' || p[name_length] == '\0');
+    }
+    if (!found)
+        return std::nullopt;
+
+    // Drivers may expose the extension but support no formats (e.g. with their own cache disabled)
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &formats);
+    if (formats <= 0)
+        return std::nullopt;
+
+    auto const get_binary = reinterpret_cast<PFNGLGETPROGRAMBINARYOESPROC>(
+        eglGetProcAddress("glGetProgramBinaryOES"));
+    auto const set_binary = reinterpret_cast<PFNGLPROGRAMBINARYOESPROC>(
+        eglGetProcAddress("glProgramBinaryOES"));
+    if (!get_binary || !set_binary)
+        return std::nullopt;
+
+    return ProgramBinaryExtension{get_binary, set_binary};
+}
+
+// NOTE: This must be called with a current GL context
+auto driver_identity() -> std::string
+{
+    std::string identity;
+    for (auto const name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+    {
+        if (auto const value = reinterpret_cast<char const*>(glGetString(name)))
+            identity += value;
+        identity += '\n';
+    }
+    return identity;
+}
 }
 
 class mrg::Renderer::ProgramFactory : public mir::graphics::gl::ProgramFactory
 {
 public:
     // NOTE: This must be called with a current GL context
-    ProgramFactory()
-        : vertex_shader{compile_shader(GL_VERTEX_SHADER, vertex_shader_src)}
+    ProgramFactory(std::shared_ptr<ProgramBinaryCache> const& binary_cache)
+        : binary_extension{binary_cache ? program_binary_extension() : std::nullopt},
+          binary_cache{binary_extension ? binary_cache : nullptr},
+          driver{this->binary_cache ? driver_identity() : std::string{}}
     {
     }
 
@@ -213,22 +272,95 @@ public:
         // GL shader compilation is *not* threadsafe, and requires external synchronisation
         std::lock_guard lock{compilation_mutex};
 
-        ShaderHandle const opaque_shader{
-            compile_shader(GL_FRAGMENT_SHADER, opaque_fragment.str().c_str())};
-        ShaderHandle const alpha_shader{
-            compile_shader(GL_FRAGMENT_SHADER, alpha_fragment.str().c_str())};
+        auto opaque_program = create_program(opaque_fragment.str());
+        auto alpha_program = create_program(alpha_fragment.str());
 
         programs.emplace_back(id, std::make_unique<::Program>(
-            link_shader(vertex_shader, opaque_shader),
-            link_shader(vertex_shader, alpha_shader)));
+            std::move(opaque_program),
+            std::move(alpha_program)));
 
         return *programs.back().second;
-
-        // We delete opaque_shader and alpha_shader here. This is fine; it only marks them
-        // for deletion. GL will only delete them once the GL Program they're linked in is destroyed.
     }
 
 private:
+    // NOTE: This must be called with compilation_mutex held
+    auto create_program(std::string const& fragment_src) -> ProgramHandle
+    {
+        auto const cache_key = binary_cache ? driver + vertex_shader_src + fragment_src : std::string{};
+
+        if (binary_cache)
+        {
+            if (auto cached = load_cached_program(cache_key))
+            {
+                return std::move(*cached);
+            }
+        }
+
+        if (!vertex_shader)
+        {
+            vertex_shader.emplace(compile_shader(GL_VERTEX_SHADER, vertex_shader_src));
+        }
+
+        ShaderHandle const fragment_shader{compile_shader(GL_FRAGMENT_SHADER, fragment_src.c_str())};
+        auto program = link_shader(*vertex_shader, fragment_shader);
+
+        if (binary_cache)
+        {
+            store_program(cache_key, program);
+        }
+
+        return program;
+
+        // We delete fragment_shader here. This is fine; it only marks it for deletion.
+        // GL will only delete it once the GL Program it's linked in is destroyed.
+    }
+
+    auto load_cached_program(std::string const& key) -> std::optional<ProgramHandle>
+    {
+        auto const binary = binary_cache->load(key);
+        if (!binary)
+        {
+            return std::nullopt;
+        }
+
+        ProgramHandle program{glCreateProgram()};
+        binary_extension->glProgramBinaryOES(
+            program, binary->format, binary->data.data(), binary->data.size());
+
+        // The driver rejects binaries it can't use (e.g. after a driver update that kept the version string)
+        GLint ok = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &ok);
+        if (!ok)
+        {
+            mir::log_info("Discarding cached GL program binary rejected by the driver");
+            binary_cache->discard(key);
+            return std::nullopt;
+        }
+
+        return program;
+    }
+
+    void store_program(std::string const& key, ProgramHandle const& program)
+    {
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+        if (length <= 0)
+        {
+            return;
+        }
+
+        ProgramBinaryCache::Binary binary{0, std::vector<char>(length)};
+        GLsizei written = 0;
+        binary_extension->glGetProgramBinaryOES(program, length, &written, &binary.format, binary.data.data());
+        if (written <= 0)
+        {
+            return;
+        }
+        binary.data.resize(written);
+
+        binary_cache->store(key, binary);
+    }
+
     static GLuint compile_shader(GLenum type, GLchar const* src)
     {
         GLuint id = glCreateShader(type);
@@ -276,7 +408,12 @@ private:
         return program;
     }
 
-    ShaderHandle const vertex_shader;
+    std::optional<ProgramBinaryExtension> const binary_extension;
+    std::shared_ptr<ProgramBinaryCache> const binary_cache;
+    std::string const driver;
+
+    // Only compiled if we have to link a program ourselves
+    std::optional<ShaderHandle> vertex_shader;
     std::vector<std::pair<void const*, std::unique_ptr<::Program>>> programs;
     // GL requires us to synchronise multi-threaded access to the shader APIs.
     std::mutex compilation_mutex;
@@ -302,10 +439,10 @@ mrg::Renderer::Program::Program(GLuint program_id)
     alpha_uniform = glGetUniformLocation(id, "alpha");
 }
 
-mrg::Renderer::Renderer(RenderTarget& render_target)
+mrg::Renderer::Renderer(RenderTarget& render_target, std::shared_ptr<ProgramBinaryCache> const& binary_cache)
     : render_target(render_target),
       clear_color{0.0f, 0.0f, 0.0f, 1.0f},
-      program_factory{std::make_unique<ProgramFactory>()},
+      program_factory{std::make_unique<ProgramFactory>(binary_cache)},
       display_transform(1)
 {
     eglBindAPI(EGL_OPENGL_ES_API);
@@ -36,6 +36,7 @@ namespace renderer
 {
 namespace gl
 {
+class ProgramBinaryCache;
 
 class CurrentRenderTarget
 {
@@ -56,7 +57,8 @@ class Renderer : public renderer::Renderer
 {
 public:
     /// render_target is owned externally, and must be kept alive as long as this object.
-    Renderer(RenderTarget& render_target);
+    /// If binary_cache is non-null, linked shader programs are saved to and restored from it.
+    Renderer(RenderTarget& render_target, std::shared_ptr<ProgramBinaryCache> const& binary_cache = nullptr);
     virtual ~Renderer();
 
     // These are called with a valid GL context:
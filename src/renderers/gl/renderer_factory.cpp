@@ -19,8 +19,13 @@
 
 namespace mrg = mir::renderer::gl;
 
+mrg::RendererFactory::RendererFactory(std::shared_ptr<ProgramBinaryCache> binary_cache)
+    : binary_cache{std::move(binary_cache)}
+{
+}
+
 std::unique_ptr<mir::renderer::Renderer>
 mrg::RendererFactory::create_renderer_for(RenderTarget& render_target)
 {
-    return std::make_unique<Renderer>(render_target);
+    return std::make_unique<Renderer>(render_target, binary_cache);
 }
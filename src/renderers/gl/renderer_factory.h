@@ -19,6 +19,8 @@
 
 #include "mir/renderer/renderer_factory.h"
 
+#include <memory>
+
 namespace mir
 {
 namespace renderer
@@ -26,10 +28,19 @@ namespace renderer
 namespace gl
 {
 
+class ProgramBinaryCache;
+
 class RendererFactory : public renderer::RendererFactory
 {
 public:
+    RendererFactory() = default;
+    /// Renderers created by this factory share binary_cache (which may be null, for no cache)
+    explicit RendererFactory(std::shared_ptr<ProgramBinaryCache> binary_cache);
+
     std::unique_ptr<renderer::Renderer> create_renderer_for(RenderTarget& render_target) override;
+
+private:
+    std::shared_ptr<ProgramBinaryCache> const binary_cache;
 };
 
 }
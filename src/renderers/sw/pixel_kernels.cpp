@@ -0,0 +1,497 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pixel_kernels.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace mrs = mir::renderer::software;
+
+namespace
+{
+/* x/255, correctly rounded, for x in [0, 255·255]. The vector kernels use the same
+ * formula on 16 bit lanes (where it doesn't overflow), so all kernels agree exactly.
+ */
+inline auto div255(uint32_t x) -> uint32_t
+{
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+void over_scalar(uint32_t* dst, uint32_t const* src, size_t count, uint8_t alpha)
+{
+    for (size_t i = 0; i != count; ++i)
+    {
+        uint32_t const s = src[i];
+        uint32_t const d = dst[i];
+
+        uint32_t channel[4];
+        for (auto c = 0; c != 4; ++c)
+        {
+            channel[c] = div255(((s >> (8 * c)) & 0xff) * alpha);
+        }
+
+        uint32_t const inverse_alpha = 255 - channel[3];
+        uint32_t result = 0;
+        for (auto c = 0; c != 4; ++c)
+        {
+            auto const value = channel[c] + div255(((d >> (8 * c)) & 0xff) * inverse_alpha);
+            result |= std::min(value, 255u) << (8 * c);
+        }
+        dst[i] = result;
+    }
+}
+
+void swap_red_blue_scalar(uint32_t* dst, uint32_t const* src, size_t count)
+{
+    for (size_t i = 0; i != count; ++i)
+    {
+        uint32_t const s = src[i];
+        dst[i] = (s & 0xff00ff00) | ((s >> 16) & 0xff) | ((s & 0xff) << 16);
+    }
+}
+
+void make_opaque_scalar(uint32_t* dst, uint32_t const* src, size_t count)
+{
+    for (size_t i = 0; i != count; ++i)
+    {
+        dst[i] = src[i] | 0xff000000;
+    }
+}
+
+mrs::PixelKernels const scalar_kernels{&over_scalar, &swap_red_blue_scalar, &make_opaque_scalar, "scalar"};
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("sse2")))
+inline auto div255_sse2(__m128i x) -> __m128i
+{
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+__attribute__((target("avx2")))
+inline auto div255_avx2(__m256i x) -> __m256i
+{
+    x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+__attribute__((target("sse2")))
+void over_sse2(uint32_t* dst, uint32_t const* src, size_t count, uint8_t alpha)
+{
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const alpha_mask = _mm_set1_epi32(0xff000000);
+    __m128i const global_alpha = _mm_set1_epi16(alpha);
+    __m128i const c255 = _mm_set1_epi16(255);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i const s = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i));
+
+        if (alpha == 255)
+        {
+            // Opaque and fully transparent runs are common enough (window interiors, shadows) to skip the arithmetic
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, alpha_mask), alpha_mask)) == 0xffff)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), s);
+                continue;
+            }
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(s, zero)) == 0xffff)
+            {
+                continue;
+            }
+        }
+
+        __m128i const d = _mm_loadu_si128(reinterpret_cast<__m128i const*>(dst + i));
+
+        __m128i s_lo = _mm_unpacklo_epi8(s, zero);
+        __m128i s_hi = _mm_unpackhi_epi8(s, zero);
+        if (alpha != 255)
+        {
+            s_lo = div255_sse2(_mm_mullo_epi16(s_lo, global_alpha));
+            s_hi = div255_sse2(_mm_mullo_epi16(s_hi, global_alpha));
+        }
+
+        __m128i const a_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        __m128i const a_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+
+        __m128i const d_lo = div255_sse2(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(c255, a_lo)));
+        __m128i const d_hi = div255_sse2(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(c255, a_hi)));
+
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(dst + i),
+            _mm_packus_epi16(_mm_add_epi16(s_lo, d_lo), _mm_add_epi16(s_hi, d_hi)));
+    }
+
+    over_scalar(dst + i, src + i, count - i, alpha);
+}
+
+__attribute__((target("sse2")))
+void swap_red_blue_sse2(uint32_t* dst, uint32_t const* src, size_t count)
+{
+    __m128i const alpha_green = _mm_set1_epi32(0xff00ff00);
+    __m128i const low_byte = _mm_set1_epi32(0x000000ff);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i const s = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i));
+        __m128i const ag = _mm_and_si128(s, alpha_green);
+        __m128i const r = _mm_and_si128(_mm_srli_epi32(s, 16), low_byte);
+        __m128i const b = _mm_slli_epi32(_mm_and_si128(s, low_byte), 16);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(ag, _mm_or_si128(r, b)));
+    }
+
+    swap_red_blue_scalar(dst + i, src + i, count - i);
+}
+
+__attribute__((target("sse2")))
+void make_opaque_sse2(uint32_t* dst, uint32_t const* src, size_t count)
+{
+    __m128i const alpha_mask = _mm_set1_epi32(0xff000000);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i const s = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(s, alpha_mask));
+    }
+
+    make_opaque_scalar(dst + i, src + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void over_avx2(uint32_t* dst, uint32_t const* src, size_t count, uint8_t alpha)
+{
+    __m256i const zero = _mm256_setzero_si256();
+    __m256i const alpha_mask = _mm256_set1_epi32(0xff000000);
+    __m256i const global_alpha = _mm256_set1_epi16(alpha);
+    __m256i const c255 = _mm256_set1_epi16(255);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i const s = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + i));
+
+        if (alpha == 255)
+        {
+            if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_and_si256(s, alpha_mask), alpha_mask)) == -1)
+            {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), s);
+                continue;
+            }
+            if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(s, zero)) == -1)
+            {
+                continue;
+            }
+        }
+
+        __m256i const d = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(dst + i));
+
+        // The unpacks and the pack below both work within 128 bit lanes, so pixel order is preserved
+        __m256i s_lo = _mm256_unpacklo_epi8(s, zero);
+        __m256i s_hi = _mm256_unpackhi_epi8(s, zero);
+        if (alpha != 255)
+        {
+            s_lo = div255_avx2(_mm256_mullo_epi16(s_lo, global_alpha));
+            s_hi = div255_avx2(_mm256_mullo_epi16(s_hi, global_alpha));
+        }
+
+        __m256i const a_lo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s_lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        __m256i const a_hi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s_hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+
+        __m256i const d_lo = div255_avx2(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), _mm256_sub_epi16(c255, a_lo)));
+        __m256i const d_hi = div255_avx2(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), _mm256_sub_epi16(c255, a_hi)));
+
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(dst + i),
+            _mm256_packus_epi16(_mm256_add_epi16(s_lo, d_lo), _mm256_add_epi16(s_hi, d_hi)));
+    }
+
+    over_sse2(dst + i, src + i, count - i, alpha);
+}
+
+__attribute__((target("avx2")))
+void swap_red_blue_avx2(uint32_t* dst, uint32_t const* src, size_t count)
+{
+    __m256i const shuffle = _mm256_setr_epi8(
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i const s = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(s, shuffle));
+    }
+
+    swap_red_blue_sse2(dst + i, src + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void make_opaque_avx2(uint32_t* dst, uint32_t const* src, size_t count)
+{
+    __m256i const alpha_mask = _mm256_set1_epi32(0xff000000);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i const s = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_or_si256(s, alpha_mask));
+    }
+
+    make_opaque_sse2(dst + i, src + i, count - i);
+}
+
+mrs::PixelKernels const sse2_kernels{&over_sse2, &swap_red_blue_sse2, &make_opaque_sse2, "SSE2"};
+mrs::PixelKernels const avx2_kernels{&over_avx2, &swap_red_blue_avx2, &make_opaque_avx2, "AVX2"};
+
+#elif defined(__aarch64__)
+void over_neon(uint32_t* dst, uint32_t const* src, size_t count, uint8_t alpha)
+{
+    uint16x8_t const c128 = vdupq_n_u16(128);
+    uint16x8_t const c255 = vdupq_n_u16(255);
+    // Broadcasts the alpha lane (the 4th 16 bit lane of each pixel) across its pixel
+    uint8x16_t const alpha_index = {6, 7, 6, 7, 6, 7, 6, 7, 14, 15, 14, 15, 14, 15, 14, 15};
+
+    auto const div255 = [&](uint16x8_t x)
+        {
+            x = vaddq_u16(x, c128);
+            return vshrq_n_u16(vaddq_u16(x, vshrq_n_u16(x, 8)), 8);
+        };
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        uint32x4_t const s32 = vld1q_u32(src + i);
+
+        if (alpha == 255)
+        {
+            if (vminvq_u32(vshrq_n_u32(s32, 24)) == 0xff)
+            {
+                vst1q_u32(dst + i, s32);
+                continue;
+            }
+            if (vmaxvq_u32(s32) == 0)
+            {
+                continue;
+            }
+        }
+
+        uint8x16_t const s = vreinterpretq_u8_u32(s32);
+        uint8x16_t const d = vreinterpretq_u8_u32(vld1q_u32(dst + i));
+
+        uint16x8_t s_lo = vmovl_u8(vget_low_u8(s));
+        uint16x8_t s_hi = vmovl_high_u8(s);
+        if (alpha != 255)
+        {
+            s_lo = div255(vmulq_n_u16(s_lo, alpha));
+            s_hi = div255(vmulq_n_u16(s_hi, alpha));
+        }
+
+        uint16x8_t const a_lo = vreinterpretq_u16_u8(vqtbl1q_u8(vreinterpretq_u8_u16(s_lo), alpha_index));
+        uint16x8_t const a_hi = vreinterpretq_u16_u8(vqtbl1q_u8(vreinterpretq_u8_u16(s_hi), alpha_index));
+
+        uint16x8_t const d_lo = div255(vmulq_u16(vmovl_u8(vget_low_u8(d)), vsubq_u16(c255, a_lo)));
+        uint16x8_t const d_hi = div255(vmulq_u16(vmovl_high_u8(d), vsubq_u16(c255, a_hi)));
+
+        uint8x16_t const result = vcombine_u8(vqmovn_u16(vaddq_u16(s_lo, d_lo)), vqmovn_u16(vaddq_u16(s_hi, d_hi)));
+        vst1q_u32(dst + i, vreinterpretq_u32_u8(result));
+    }
+
+    over_scalar(dst + i, src + i, count - i, alpha);
+}
+
+void swap_red_blue_neon(uint32_t* dst, uint32_t const* src, size_t count)
+{
+    uint8x16_t const shuffle = {2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15};
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        uint8x16_t const s = vreinterpretq_u8_u32(vld1q_u32(src + i));
+        vst1q_u32(dst + i, vreinterpretq_u32_u8(vqtbl1q_u8(s, shuffle)));
+    }
+
+    swap_red_blue_scalar(dst + i, src + i, count - i);
+}
+
+void make_opaque_neon(uint32_t* dst, uint32_t const* src, size_t count)
+{
+    uint32x4_t const alpha_mask = vdupq_n_u32(0xff000000);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        vst1q_u32(dst + i, vorrq_u32(vld1q_u32(src + i), alpha_mask));
+    }
+
+    make_opaque_scalar(dst + i, src + i, count - i);
+}
+
+mrs::PixelKernels const neon_kernels{&over_neon, &swap_red_blue_neon, &make_opaque_neon, "NEON"};
+#endif
+
+auto select_kernels() -> mrs::PixelKernels const&
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return avx2_kernels;
+    if (__builtin_cpu_supports("sse2"))
+        return sse2_kernels;
+#elif defined(__aarch64__)
+    return neon_kernels;
+#endif
+    return scalar_kernels;
+}
+
+inline auto expand(uint32_t value, unsigned bits) -> uint32_t
+{
+    // Replicate the high bits into the low ones, so that (e.g.) 0x1f expands to 0xff
+    value <<= 8 - bits;
+    return value | (value >> bits);
+}
+
+inline auto load16(unsigned char const* src) -> uint16_t
+{
+    uint16_t value;
+    memcpy(&value, src, sizeof value);
+    return value;
+}
+
+inline auto pack(uint32_t a, uint32_t r, uint32_t g, uint32_t b) -> uint32_t
+{
+    return (a << 24) | (r << 16) | (g << 8) | b;
+}
+}
+
+auto mrs::pixel_kernels() -> PixelKernels const&
+{
+    static PixelKernels const& kernels = select_kernels();
+    return kernels;
+}
+
+auto mrs::scalar_pixel_kernels() -> PixelKernels const&
+{
+    return scalar_kernels;
+}
+
+auto mrs::can_convert_from(MirPixelFormat format) -> bool
+{
+    switch (format)
+    {
+    case mir_pixel_format_argb_8888:
+    case mir_pixel_format_xrgb_8888:
+    case mir_pixel_format_abgr_8888:
+    case mir_pixel_format_xbgr_8888:
+    case mir_pixel_format_rgb_888:
+    case mir_pixel_format_bgr_888:
+    case mir_pixel_format_rgb_565:
+    case mir_pixel_format_rgba_5551:
+    case mir_pixel_format_rgba_4444:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+void mrs::convert_row(
+    PixelKernels const& kernels,
+    MirPixelFormat format,
+    unsigned char const* src,
+    uint32_t* dst,
+    size_t count,
+    bool has_alpha)
+{
+    auto const src32 = reinterpret_cast<uint32_t const*>(src);
+
+    // Byte orders follow the GL formats the GL renderer uploads these as (see ShmBuffer)
+    switch (format)
+    {
+    case mir_pixel_format_argb_8888:
+        if (has_alpha)
+            memcpy(dst, src, count * sizeof *dst);
+        else
+            kernels.make_opaque(dst, src32, count);
+        break;
+
+    case mir_pixel_format_xrgb_8888:
+        kernels.make_opaque(dst, src32, count);
+        break;
+
+    case mir_pixel_format_abgr_8888:
+        kernels.swap_red_blue(dst, src32, count);
+        if (!has_alpha)
+            kernels.make_opaque(dst, dst, count);
+        break;
+
+    case mir_pixel_format_xbgr_8888:
+        kernels.swap_red_blue(dst, src32, count);
+        kernels.make_opaque(dst, dst, count);
+        break;
+
+    case mir_pixel_format_rgb_888:
+        for (size_t i = 0; i != count; ++i, src += 3)
+            dst[i] = pack(0xff, src[0], src[1], src[2]);
+        break;
+
+    case mir_pixel_format_bgr_888:
+        for (size_t i = 0; i != count; ++i, src += 3)
+            dst[i] = pack(0xff, src[2], src[1], src[0]);
+        break;
+
+    case mir_pixel_format_rgb_565:
+        for (size_t i = 0; i != count; ++i, src += 2)
+        {
+            uint32_t const v = load16(src);
+            dst[i] = pack(0xff, expand(v >> 11, 5), expand((v >> 5) & 0x3f, 6), expand(v & 0x1f, 5));
+        }
+        break;
+
+    case mir_pixel_format_rgba_5551:
+        for (size_t i = 0; i != count; ++i, src += 2)
+        {
+            uint32_t const v = load16(src);
+            uint32_t const a = (!has_alpha || (v & 1)) ? 0xff : 0;
+            dst[i] = pack(a, expand(v >> 11, 5), expand((v >> 6) & 0x1f, 5), expand((v >> 1) & 0x1f, 5));
+        }
+        break;
+
+    case mir_pixel_format_rgba_4444:
+        for (size_t i = 0; i != count; ++i, src += 2)
+        {
+            uint32_t const v = load16(src);
+            uint32_t const a = has_alpha ? (v & 0xf) * 0x11 : 0xff;
+            dst[i] = pack(a, (v >> 12) * 0x11, ((v >> 8) & 0xf) * 0x11, ((v >> 4) & 0xf) * 0x11);
+        }
+        break;
+
+    default:
+        // Callers check can_convert_from(); leave something recognisably wrong rather than garbage
+        std::fill_n(dst, count, 0xffff00ffu);
+        break;
+    }
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_SW_PIXEL_KERNELS_H_
+#define MIR_RENDERER_SW_PIXEL_KERNELS_H_
+
+#include "mir_toolkit/common.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mir
+{
+namespace renderer
+{
+namespace software
+{
+/**
+ * Row operations on 32 bit pixels, as used by the software renderer.
+ *
+ * Pixels are premultiplied, with alpha in the top byte: 0xAARRGGBB (or 0xAABBGGRR; only
+ * swap_red_blue cares which). Every implementation gives bit-identical results, so the
+ * scalar one serves as the reference for the vectorised ones.
+ */
+struct PixelKernels
+{
+    /// "Source over" composition: dst = src·alpha + dst·(1 - src_alpha·alpha), with alpha in [0, 255]
+    void (*over)(uint32_t* dst, uint32_t const* src, size_t count, uint8_t alpha);
+    /// dst = src with the red and blue channels exchanged
+    void (*swap_red_blue)(uint32_t* dst, uint32_t const* src, size_t count);
+    /// dst = src with the alpha channel set to 0xff
+    void (*make_opaque)(uint32_t* dst, uint32_t const* src, size_t count);
+
+    char const* name;
+};
+
+/// The fastest kernels this CPU supports (AVX2, SSE2, NEON or scalar)
+auto pixel_kernels() -> PixelKernels const&;
+
+/// The plain C++ kernels
+auto scalar_pixel_kernels() -> PixelKernels const&;
+
+/// Can convert_row() read format?
+auto can_convert_from(MirPixelFormat format) -> bool;
+
+/**
+ * Converts count pixels of format to 0xAARRGGBB.
+ *
+ * If has_alpha is false the source alpha channel (if any) is ignored and the result is opaque.
+ */
+void convert_row(
+    PixelKernels const& kernels,
+    MirPixelFormat format,
+    unsigned char const* src,
+    uint32_t* dst,
+    size_t count,
+    bool has_alpha);
+}
+}
+}
+
+#endif // MIR_RENDERER_SW_PIXEL_KERNELS_H_
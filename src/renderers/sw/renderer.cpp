@@ -0,0 +1,549 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIR_LOG_COMPONENT "SoftwareRenderer"
+
+#include "renderer.h"
+#include "pixel_kernels.h"
+#include "mir/graphics/buffer.h"
+#include "mir/geometry/rectangles.h"
+#include "mir/log.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+
+namespace mrs = mir::renderer::software;
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+struct mrs::Renderer::Layer
+{
+    geom::Rectangle position;   ///< Relative to the viewport
+    geom::Rectangle visible;    ///< Relative to the viewport, and clipped to it
+    uint8_t alpha;
+    bool shaped;
+    std::shared_ptr<mg::Buffer> buffer;
+    std::unique_ptr<Mapping<unsigned char const>> pixels;
+};
+
+namespace
+{
+uint32_t const clear_colour = 0xff000000;
+
+// Past this many separate rectangles, redrawing their bounding box is cheaper than the bookkeeping
+size_t const max_damage_rectangles = 16;
+
+auto is_empty(geom::Rectangle const& r) -> bool
+{
+    return r.size.width.as_int() <= 0 || r.size.height.as_int() <= 0;
+}
+
+auto to_alpha8(float alpha) -> uint8_t
+{
+    return std::lround(std::clamp(alpha, 0.0f, 1.0f) * 255.0f);
+}
+
+auto relative_to(geom::Rectangle const& r, geom::Rectangle const& viewport) -> geom::Rectangle
+{
+    return {geom::Point{} + (r.top_left - viewport.top_left), r.size};
+}
+
+auto bounding_box(std::vector<geom::Rectangle> const& rects) -> geom::Rectangle
+{
+    geom::Rectangles all;
+    for (auto const& r : rects)
+    {
+        all.add(r);
+    }
+    return all.bounding_rectangle();
+}
+
+auto has_red_first(MirPixelFormat format) -> bool
+{
+    return format == mir_pixel_format_abgr_8888 || format == mir_pixel_format_xbgr_8888;
+}
+
+auto is_supported_target(MirPixelFormat format) -> bool
+{
+    switch (format)
+    {
+    case mir_pixel_format_argb_8888:
+    case mir_pixel_format_xrgb_8888:
+    case mir_pixel_format_abgr_8888:
+    case mir_pixel_format_xbgr_8888:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+/// The output transform as entries in {-1, 0, 1}, or nullopt if it isn't a rotation by a multiple of 90° and/or a reflection
+auto as_integer_matrix(glm::mat2 const& t) -> std::optional<std::array<int, 4>>
+{
+    std::array<int, 4> result;
+    for (auto i = 0; i != 4; ++i)
+    {
+        auto const value = t[i / 2][i % 2];
+        result[i] = std::lround(value);
+        if (std::abs(value - result[i]) > 1e-3f || std::abs(result[i]) > 1)
+            return std::nullopt;
+    }
+
+    // Each axis must map to exactly one axis
+    auto const [a, b, c, d] = result;
+    if ((a == 0) == (c == 0) || (a == 0) != (d == 0) || (a == 0) == (b == 0))
+        return std::nullopt;
+
+    return result;
+}
+}
+
+auto mrs::Renderer::Drawn::visible_area() const -> geom::Rectangle
+{
+    return clip ? intersection_of(position, *clip) : position;
+}
+
+auto mrs::Renderer::Drawn::operator==(Drawn const& other) const -> bool
+{
+    return id == other.id &&
+           buffer == other.buffer &&
+           position == other.position &&
+           clip == other.clip &&
+           alpha == other.alpha &&
+           shaped == other.shaped;
+}
+
+auto mrs::Renderer::OutputTransform::apply(geom::Point p) const -> geom::Point
+{
+    auto const x = p.x.as_int(), y = p.y.as_int();
+    return {x0 + xx * x + xy * y, y0 + yx * x + yy * y};
+}
+
+auto mrs::Renderer::OutputTransform::apply(geom::Rectangle const& r) const -> geom::Rectangle
+{
+    if (is_empty(r))
+        return {};
+
+    auto const a = apply(r.top_left);
+    auto const b = apply(r.bottom_right() - geom::Displacement{1, 1});
+    auto const left = std::min(a.x, b.x);
+    auto const top = std::min(a.y, b.y);
+    auto const right = std::max(a.x, b.x) + geom::DeltaX{1};
+    auto const bottom = std::max(a.y, b.y) + geom::DeltaY{1};
+    return {{left, top}, {as_width(right - left), as_height(bottom - top)}};
+}
+
+auto mrs::Renderer::OutputTransform::invert(geom::Rectangle const& r) const -> geom::Rectangle
+{
+    // The linear part is orthogonal, so its inverse is its transpose
+    OutputTransform const inverse{
+        -(xx * x0 + yx * y0), xx, yx,
+        -(xy * x0 + yy * y0), xy, yy};
+    return inverse.apply(r);
+}
+
+mrs::Renderer::Renderer(RenderTarget& render_target)
+    : render_target{render_target},
+      kernels{pixel_kernels()}
+{
+    mir::log_info("Software renderer using %s pixel kernels", kernels.name);
+}
+
+mrs::Renderer::~Renderer() = default;
+
+void mrs::Renderer::set_viewport(geom::Rectangle const& rect)
+{
+    if (rect == viewport)
+        return;
+
+    viewport = rect;
+    shadow_valid = false;
+    full_copy_pending = true;
+}
+
+void mrs::Renderer::set_output_transform(glm::mat2 const& t)
+{
+    if (t == transform)
+        return;
+
+    if (!as_integer_matrix(t))
+    {
+        mir::log_warning("Software renderer only supports rotations by multiples of 90° and reflections; "
+                         "ignoring output transform");
+        return;
+    }
+
+    transform = t;
+    full_copy_pending = true;
+}
+
+void mrs::Renderer::suspend()
+{
+    // We don't know what happened to the render target while we weren't drawing
+    full_copy_pending = true;
+}
+
+auto mrs::Renderer::output_transform(geom::Size const& target_size) const -> OutputTransform
+{
+    auto const w = viewport.size.width.as_int(), h = viewport.size.height.as_int();
+    auto const m = as_integer_matrix(transform).value_or(std::array<int, 4>{1, 0, 0, 1});
+    auto const a = m[0], b = m[1], c = m[2], d = m[3];
+
+    /* The transform acts (as in the GL renderer) on coordinates centred on the viewport with y
+     * pointing up, so each output axis takes one viewport axis, possibly reversed.
+     */
+    OutputTransform t{};
+    if (a)
+        t = {a > 0 ? 0 : w - 1, a, 0, 0, 0, 0};
+    else
+        t = {c > 0 ? h - 1 : 0, 0, -c, 0, 0, 0};
+
+    if (d)
+        std::tie(t.y0, t.yx, t.yy) = std::make_tuple(d > 0 ? 0 : h - 1, 0, d);
+    else
+        std::tie(t.y0, t.yx, t.yy) = std::make_tuple(b > 0 ? w - 1 : 0, -b, 0);
+
+    // Centre the (transformed) viewport in the target, as the GL renderer does when their aspect ratios differ
+    bool const swaps_axes = a == 0;
+    auto const output_width = swaps_axes ? h : w;
+    auto const output_height = swaps_axes ? w : h;
+    t.x0 += (target_size.width.as_int() - output_width) / 2;
+    t.y0 += (target_size.height.as_int() - output_height) / 2;
+
+    return t;
+}
+
+void mrs::Renderer::render(mg::RenderableList const& renderables) const
+{
+    geom::Rectangle const whole_viewport{{0, 0}, viewport.size};
+    auto const width = viewport.size.width.as_uint32_t();
+
+    std::vector<Drawn> frame;
+    std::vector<Layer> layers;
+    frame.reserve(renderables.size());
+    layers.reserve(renderables.size());
+    for (auto const& renderable : renderables)
+    {
+        auto buffer = renderable->buffer();
+        Drawn drawn{
+            renderable->id(),
+            buffer ? buffer->id() : mg::BufferID{},
+            renderable->screen_position(),
+            renderable->clip_area(),
+            renderable->alpha(),
+            renderable->shaped()};
+
+        layers.push_back(Layer{
+            relative_to(drawn.position, viewport),
+            intersection_of(relative_to(drawn.visible_area(), viewport), whole_viewport),
+            to_alpha8(drawn.alpha),
+            drawn.shaped,
+            std::move(buffer),
+            nullptr});
+        frame.push_back(std::move(drawn));
+    }
+
+    std::vector<geom::Rectangle> damage;
+    if (!shadow_valid)
+    {
+        shadow.assign(width * viewport.size.height.as_uint32_t(), clear_colour);
+        damage.push_back(whole_viewport);
+    }
+    else
+    {
+        for (auto const& area : damage_since_last_frame(frame))
+        {
+            auto const local = intersection_of(relative_to(area, viewport), whole_viewport);
+            if (!is_empty(local))
+                damage.push_back(local);
+        }
+
+        if (damage.size() > max_damage_rectangles)
+            damage = {bounding_box(damage)};
+    }
+
+    // Only map the buffers we need to read
+    for (auto& layer : layers)
+    {
+        if (!layer.buffer || is_empty(layer.visible) ||
+            std::none_of(damage.begin(), damage.end(), [&](auto const& area) { return area.overlaps(layer.visible); }))
+        {
+            continue;
+        }
+
+        try
+        {
+            auto pixels = as_read_mappable_buffer(layer.buffer)->map_readable();
+            if (!can_convert_from(pixels->format()))
+            {
+                mir::log_error("Software renderer does not support buffer format %d", pixels->format());
+                continue;
+            }
+            layer.pixels = std::move(pixels);
+        }
+        catch (std::exception const&)
+        {
+            mir::log(mir::logging::Severity::error, MIR_LOG_COMPONENT, std::current_exception(),
+                     "Buffer does not support software rendering");
+        }
+    }
+
+    for (auto const& area : damage)
+    {
+        draw(layers, area);
+    }
+
+    last_frame = std::move(frame);
+    shadow_valid = true;
+
+    {
+        auto const target = render_target.map_back_buffer();
+        auto const age = render_target.back_buffer_age();
+        bool const invalidated = full_copy_pending || target->size() != last_target_size;
+        bool const full = invalidated || age == 0 || age - 1 > damage_history.size();
+
+        if (full)
+        {
+            copy_to_target(*target, {whole_viewport}, true);
+        }
+        else
+        {
+            auto areas = damage;
+            for (auto i = 0u; i + 1 < age; ++i)
+            {
+                areas.insert(areas.end(), damage_history[i].begin(), damage_history[i].end());
+            }
+            if (areas.size() > max_damage_rectangles)
+                areas = {bounding_box(areas)};
+
+            copy_to_target(*target, areas, false);
+        }
+
+        damage_history.push_front(invalidated ? std::vector<geom::Rectangle>{whole_viewport} : damage);
+        if (damage_history.size() > max_buffer_age)
+            damage_history.pop_back();
+
+        full_copy_pending = false;
+        last_target_size = target->size();
+    }
+
+    render_target.swap_buffers();
+}
+
+auto mrs::Renderer::damage_since_last_frame(std::vector<Drawn> const& frame) const -> std::vector<geom::Rectangle>
+{
+    std::unordered_map<mg::Renderable::ID, size_t> previous;
+    for (auto i = 0u; i != last_frame.size(); ++i)
+    {
+        previous[last_frame[i].id] = i;
+    }
+
+    std::vector<geom::Rectangle> damage;
+    std::vector<bool> still_present(last_frame.size(), false);
+    size_t last_index = 0;
+
+    for (auto const& drawn : frame)
+    {
+        auto const p = previous.find(drawn.id);
+        if (p == previous.end())
+        {
+            damage.push_back(drawn.visible_area());
+            continue;
+        }
+
+        if (p->second < last_index)
+        {
+            // Restacked; simplest to redraw everything
+            return {viewport};
+        }
+        last_index = p->second;
+        still_present[p->second] = true;
+
+        auto const& before = last_frame[p->second];
+        if (!(before == drawn))
+        {
+            damage.push_back(before.visible_area());
+            damage.push_back(drawn.visible_area());
+        }
+    }
+
+    for (auto i = 0u; i != last_frame.size(); ++i)
+    {
+        if (!still_present[i])
+            damage.push_back(last_frame[i].visible_area());
+    }
+
+    return damage;
+}
+
+void mrs::Renderer::draw(std::vector<Layer> const& layers, geom::Rectangle const& area) const
+{
+    auto const width = viewport.size.width.as_int();
+    auto const x = area.left().as_int();
+    auto const n = area.size.width.as_uint32_t();
+
+    for (auto y = area.top().as_int(); y != area.bottom().as_int(); ++y)
+    {
+        std::fill_n(shadow.data() + y * width + x, n, clear_colour);
+    }
+
+    for (auto const& layer : layers)
+    {
+        auto const visible = intersection_of(layer.visible, area);
+        if (!layer.pixels || is_empty(visible))
+            continue;
+
+        auto& pixels = *layer.pixels;
+        auto const format = pixels.format();
+        auto const bytes_per_pixel = MIR_BYTES_PER_PIXEL(format);
+        auto const stride = pixels.stride().as_uint32_t();
+        auto const source_width = pixels.size().width.as_uint32_t();
+        auto const source_height = pixels.size().height.as_uint32_t();
+        auto const position_width = layer.position.size.width.as_uint32_t();
+        auto const position_height = layer.position.size.height.as_uint32_t();
+        bool const scaled = source_width != position_width || source_height != position_height;
+
+        auto const left = visible.left().as_int();
+        auto const count = visible.size.width.as_uint32_t();
+        auto const offset_x = static_cast<size_t>(left - layer.position.left().as_int());
+        row.resize(count);
+
+        // Nearest-neighbour sampling, from pixel centres
+        auto const sample = [](size_t i, size_t from, size_t to)
+            {
+                return std::min((2 * i + 1) * to / (2 * from), to - 1);
+            };
+
+        size_t first_column = offset_x;
+        if (scaled)
+        {
+            column_map.resize(count);
+            for (auto i = 0u; i != count; ++i)
+            {
+                column_map[i] = sample(offset_x + i, position_width, source_width);
+            }
+            first_column = column_map.front();
+            source_row.resize(column_map.back() - first_column + 1);
+        }
+
+        for (auto y = visible.top().as_int(); y != visible.bottom().as_int(); ++y)
+        {
+            auto const offset_y = static_cast<size_t>(y - layer.position.top().as_int());
+            auto const source_y = scaled ? sample(offset_y, position_height, source_height) : offset_y;
+            auto const source = pixels.data() + source_y * stride + first_column * bytes_per_pixel;
+
+            if (scaled)
+            {
+                convert_row(kernels, format, source, source_row.data(), source_row.size(), layer.shaped);
+                for (auto i = 0u; i != count; ++i)
+                {
+                    row[i] = source_row[column_map[i] - first_column];
+                }
+            }
+            else
+            {
+                convert_row(kernels, format, source, row.data(), count, layer.shaped);
+            }
+
+            auto const destination = shadow.data() + y * width + left;
+            if (layer.alpha == 255 && !layer.shaped)
+            {
+                memcpy(destination, row.data(), count * sizeof *destination);
+            }
+            else
+            {
+                kernels.over(destination, row.data(), count, layer.alpha);
+            }
+        }
+    }
+}
+
+void mrs::Renderer::copy_to_target(
+    Mapping<unsigned char>& target,
+    std::vector<geom::Rectangle> const& areas,
+    bool full) const
+{
+    auto const format = target.format();
+    if (!is_supported_target(format))
+    {
+        BOOST_THROW_EXCEPTION(std::logic_error("Software renderer does not support the render target's pixel format"));
+    }
+
+    auto const data = target.data();
+    auto const stride = target.stride().as_uint32_t();
+    auto const target_size = target.size();
+    auto const width = viewport.size.width.as_int();
+    bool const swap = has_red_first(format);
+
+    if (full)
+    {
+        // Clears any letterboxing, as well as the rest of the buffer
+        for (auto y = 0; y != target_size.height.as_int(); ++y)
+        {
+            std::fill_n(reinterpret_cast<uint32_t*>(data + y * stride), target_size.width.as_int(), clear_colour);
+        }
+    }
+
+    auto const t = output_transform(target_size);
+    auto const in_target = t.invert(geom::Rectangle{{0, 0}, target_size});
+    bool const identity = t.xx == 1 && t.yy == 1;
+
+    for (auto const& area : areas)
+    {
+        auto const visible = intersection_of(area, in_target);
+        if (is_empty(visible))
+            continue;
+
+        auto const count = visible.size.width.as_uint32_t();
+
+        for (auto y = visible.top().as_int(); y != visible.bottom().as_int(); ++y)
+        {
+            auto const source = shadow.data() + y * width + visible.left().as_int();
+            auto const start = t.apply(geom::Point{visible.left().as_int(), y});
+            auto const destination = data + start.y.as_int() * stride + start.x.as_int() * sizeof(uint32_t);
+
+            if (identity)
+            {
+                auto const row_start = reinterpret_cast<uint32_t*>(destination);
+                if (swap)
+                    kernels.swap_red_blue(row_start, source, count);
+                else
+                    memcpy(row_start, source, count * sizeof *source);
+            }
+            else
+            {
+                // A row of the viewport is a row or column of the target, in either direction
+                ptrdiff_t const step = t.xx * ptrdiff_t{sizeof(uint32_t)} + t.yx * ptrdiff_t(stride);
+                auto pixel = destination;
+                for (auto i = 0u; i != count; ++i, pixel += step)
+                {
+                    auto const value = source[i];
+                    uint32_t const converted =
+                        swap ? (value & 0xff00ff00) | ((value >> 16) & 0xff) | ((value & 0xff) << 16) : value;
+                    memcpy(pixel, &converted, sizeof converted);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_SW_RENDERER_H_
+#define MIR_RENDERER_SW_RENDERER_H_
+
+#include <mir/renderer/renderer.h>
+#include <mir/geometry/rectangle.h>
+#include <mir/graphics/buffer_id.h>
+#include <mir/graphics/renderable.h>
+#include "mir/renderer/sw/render_target.h"
+
+#include <deque>
+#include <optional>
+#include <vector>
+
+namespace mir
+{
+namespace renderer
+{
+namespace software
+{
+struct PixelKernels;
+
+/**
+ * Composites renderables on the CPU, reading client buffers through ReadMappableBuffer.
+ *
+ * The scene is composited into a shadow buffer in ordinary memory (render targets such as dumb
+ * buffers are usually uncached, and slow to read back for blending), redrawing only what changed
+ * since the last frame. The damaged parts of the shadow buffer are then copied to the render
+ * target, rotated or reflected by the output transform and converted to the target's format.
+ *
+ * Renderables are scaled to their screen_position() by nearest-neighbour sampling;
+ * Renderable::transformation() is not supported and is ignored.
+ */
+class Renderer : public renderer::Renderer
+{
+public:
+    /// render_target is owned externally, and must be kept alive as long as this object.
+    explicit Renderer(RenderTarget& render_target);
+    ~Renderer() override;
+
+    void set_viewport(geometry::Rectangle const& rect) override;
+    void set_output_transform(glm::mat2 const&) override;
+    void render(graphics::RenderableList const&) const override;
+    void suspend() override;
+
+    /// Frames of damage remembered for back_buffer_age(); older back buffers are redrawn in full
+    static size_t const max_buffer_age = 4;
+
+private:
+    /// What we drew of a renderable, to tell whether it needs redrawing
+    struct Drawn
+    {
+        graphics::Renderable::ID id;
+        graphics::BufferID buffer;
+        geometry::Rectangle position;
+        std::optional<geometry::Rectangle> clip;
+        float alpha;
+        bool shaped;
+
+        auto visible_area() const -> geometry::Rectangle;
+        auto operator==(Drawn const& other) const -> bool;
+    };
+
+    /// A renderable as drawn in the current frame
+    struct Layer;
+
+    /// An integer affine map from viewport pixels to render target pixels
+    struct OutputTransform
+    {
+        int x0, xx, xy;
+        int y0, yx, yy;
+
+        auto apply(geometry::Point p) const -> geometry::Point;
+        auto apply(geometry::Rectangle const& r) const -> geometry::Rectangle;
+        auto invert(geometry::Rectangle const& r) const -> geometry::Rectangle;
+    };
+
+    auto damage_since_last_frame(std::vector<Drawn> const& frame) const -> std::vector<geometry::Rectangle>;
+    void draw(std::vector<Layer> const& layers, geometry::Rectangle const& area) const;
+    void copy_to_target(Mapping<unsigned char>& target, std::vector<geometry::Rectangle> const& areas, bool full) const;
+    auto output_transform(geometry::Size const& target_size) const -> OutputTransform;
+
+    RenderTarget& render_target;
+    PixelKernels const& kernels;
+
+    geometry::Rectangle viewport;
+    glm::mat2 transform{1};
+
+    // State carried from frame to frame
+    mutable std::vector<uint32_t> shadow;
+    mutable bool shadow_valid{false};
+    mutable bool full_copy_pending{true};
+    mutable std::vector<Drawn> last_frame;
+    mutable std::deque<std::vector<geometry::Rectangle>> damage_history;
+    mutable geometry::Size last_target_size;
+
+    // Scratch space, kept to avoid reallocating every frame
+    mutable std::vector<uint32_t> row;
+    mutable std::vector<uint32_t> source_row;
+    mutable std::vector<size_t> column_map;
+};
+
+}
+}
+}
+
+#endif // MIR_RENDERER_SW_RENDERER_H_
@@ -21,6 +21,7 @@
 #include "default_display_buffer_compositor_factory.h"
 #include "multi_threaded_compositor.h"
 #include "gl/renderer_factory.h"
+#include "gl/program_binary_cache.h"
 #include "basic_screen_shooter.h"
 #include "null_screen_shooter.h"
 #include "mir/main_loop.h"
@@ -89,9 +90,14 @@ mir::DefaultServerConfiguration::the_compositor()
 std::shared_ptr<mir::renderer::RendererFactory> mir::DefaultServerConfiguration::the_renderer_factory()
 {
     return renderer_factory(
-        []()
+        [this]()
         {
-            return std::make_shared<mir::renderer::gl::RendererFactory>();
+            std::shared_ptr<mrg::ProgramBinaryCache> binary_cache;
+            if (the_options()->get<bool>(options::gl_program_cache_opt))
+            {
+                binary_cache = mrg::ProgramBinaryCache::for_current_user();
+            }
+            return std::make_shared<mrg::RendererFactory>(binary_cache);
         });
 }
 
@@ -19,6 +19,8 @@
 #include "mir/renderer/renderer.h"
 #include "mir/graphics/display_buffer.h"
 #include "mir/renderer/gl/render_target.h"
+#include "mir/renderer/sw/render_target.h"
+#include "sw/renderer.h"
 
 #include "default_display_buffer_compositor.h"
 
@@ -39,12 +41,19 @@ std::unique_ptr<mc::DisplayBufferCompositor>
 mc::DefaultDisplayBufferCompositorFactory::create_compositor_for(
     mg::DisplayBuffer& display_buffer)
 {
-    auto const render_target = dynamic_cast<renderer::gl::RenderTarget*>(display_buffer.native_display_buffer());
-    if (!render_target)
+    std::unique_ptr<renderer::Renderer> renderer;
+    if (auto const render_target = dynamic_cast<renderer::gl::RenderTarget*>(display_buffer.native_display_buffer()))
     {
-        BOOST_THROW_EXCEPTION(std::logic_error("DisplayBuffer does not support GL rendering"));
+        renderer = renderer_factory->create_renderer_for(*render_target);
+    }
+    else if (auto const cpu_target = dynamic_cast<renderer::software::RenderTarget*>(display_buffer.native_display_buffer()))
+    {
+        renderer = std::make_unique<renderer::software::Renderer>(*cpu_target);
+    }
+    else
+    {
+        BOOST_THROW_EXCEPTION(std::logic_error("DisplayBuffer supports neither GL nor software rendering"));
     }
-    auto renderer = renderer_factory->create_renderer_for(*render_target);
     renderer->set_viewport(display_buffer.view_area());
     return std::make_unique<DefaultDisplayBufferCompositor>(
          display_buffer, std::move(renderer), report);
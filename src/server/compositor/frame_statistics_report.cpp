@@ -0,0 +1,206 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "frame_statistics_report.h"
+
+#include <algorithm>
+#include <tuple>
+
+namespace mc = mir::compositor;
+namespace geom = mir::geometry;
+using namespace std::chrono_literals;
+
+namespace
+{
+// A frame that starts this soon after the previous one finished was waiting for it
+auto const busy_threshold = 1ms;
+
+// Below this we're not being throttled by vblank (e.g. a nested or virtual output), so there's no vblank to miss
+auto const min_refresh_period = 2ms;
+
+auto as_duration(mir::time::Duration d) -> mc::DurationHistogram::Duration
+{
+    return std::max(std::chrono::duration_cast<mc::DurationHistogram::Duration>(d), mc::DurationHistogram::Duration{0});
+}
+}
+
+auto mc::DurationHistogram::bucket_limit(size_t i) -> Duration
+{
+    if (i + 1 >= bucket_count)
+        return Duration::max();
+
+    return Duration{125} * (1 << i);
+}
+
+void mc::DurationHistogram::add(Duration sample)
+{
+    size_t i = 0;
+    while (i + 1 < bucket_count && sample > bucket_limit(i))
+        ++i;
+
+    ++counts[i];
+    ++samples;
+    sum += sample;
+    largest = std::max(largest, sample);
+}
+
+mc::FrameStatisticsReport::FrameStatisticsReport(
+    std::shared_ptr<CompositorReport> const& next,
+    std::shared_ptr<time::Clock> const& clock)
+    : next{next},
+      clock{clock}
+{
+}
+
+void mc::FrameStatisticsReport::added_display(int width, int height, int x, int y, SubCompositorId id)
+{
+    {
+        std::lock_guard lock{mutex};
+        auto& output = outputs[id] = Output{};
+        output.statistics.id = id;
+        output.statistics.area = {{x, y}, {width, height}};
+    }
+
+    next->added_display(width, height, x, y, id);
+}
+
+void mc::FrameStatisticsReport::began_frame(SubCompositorId id)
+{
+    {
+        std::lock_guard lock{mutex};
+        auto& output = outputs[id];
+        auto const t = clock->now();
+
+        output.busy = output.finished != TimePoint{} && t - output.finished < busy_threshold;
+
+        // Only the first frame after a scene change shows it
+        if (last_scheduled > output.began)
+            output.statistics.scene_change_to_composite.add(as_duration(t - last_scheduled));
+
+        output.began = t;
+        output.bypassed = true;
+    }
+
+    next->began_frame(id);
+}
+
+void mc::FrameStatisticsReport::renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables)
+{
+    next->renderables_in_frame(id, renderables);
+}
+
+void mc::FrameStatisticsReport::rendered_frame(SubCompositorId id)
+{
+    {
+        std::lock_guard lock{mutex};
+        auto& output = outputs[id];
+        auto const t = clock->now();
+
+        output.statistics.render_time.add(as_duration(t - output.began));
+        output.rendered = t;
+        output.bypassed = false;
+    }
+
+    next->rendered_frame(id);
+}
+
+void mc::FrameStatisticsReport::finished_frame(SubCompositorId id)
+{
+    {
+        std::lock_guard lock{mutex};
+        auto& output = outputs[id];
+        auto& statistics = output.statistics;
+        auto const t = clock->now();
+
+        statistics.post_time.add(as_duration(t - (output.bypassed ? output.began : output.rendered)));
+        ++statistics.frames;
+        if (output.bypassed)
+            ++statistics.bypassed_frames;
+
+        if (output.busy)
+        {
+            auto const interval = as_duration(t - output.finished);
+            statistics.frame_interval.add(interval);
+
+            output.recent_intervals[output.next_interval++ % output.recent_intervals.size()] = interval;
+
+            // The median of recent intervals is our estimate of the refresh period: unlike the
+            // minimum it isn't thrown by the odd early flip, or by a run of missed vblanks.
+            auto recent = output.recent_intervals;
+            auto const end = recent.begin() + std::min(output.next_interval, recent.size());
+            auto const median = recent.begin() + (end - recent.begin()) / 2;
+            std::nth_element(recent.begin(), median, end);
+            auto const period = *median;
+
+            if (period >= min_refresh_period)
+            {
+                auto const periods = (interval + period / 2) / period;
+                if (periods > 1)
+                    statistics.missed_vblanks += periods - 1;
+            }
+        }
+
+        output.finished = t;
+    }
+
+    next->finished_frame(id);
+}
+
+void mc::FrameStatisticsReport::started()
+{
+    next->started();
+}
+
+void mc::FrameStatisticsReport::stopped()
+{
+    {
+        std::lock_guard lock{mutex};
+        outputs.clear();
+    }
+
+    next->stopped();
+}
+
+void mc::FrameStatisticsReport::scheduled()
+{
+    {
+        std::lock_guard lock{mutex};
+        last_scheduled = clock->now();
+    }
+
+    next->scheduled();
+}
+
+auto mc::FrameStatisticsReport::output_statistics() const -> std::vector<OutputFrameStatistics>
+{
+    std::vector<OutputFrameStatistics> result;
+
+    {
+        std::lock_guard lock{mutex};
+        result.reserve(outputs.size());
+        for (auto const& output : outputs)
+            result.push_back(output.second.statistics);
+    }
+
+    std::sort(result.begin(), result.end(), [](auto const& lhs, auto const& rhs)
+        {
+            auto const& l = lhs.area.top_left;
+            auto const& r = rhs.area.top_left;
+            return std::tie(l.y, l.x) < std::tie(r.y, r.x);
+        });
+
+    return result;
+}
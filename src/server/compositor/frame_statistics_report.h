@@ -0,0 +1,80 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_FRAME_STATISTICS_REPORT_H_
+#define MIR_COMPOSITOR_FRAME_STATISTICS_REPORT_H_
+
+#include "mir/compositor/frame_statistics.h"
+#include "mir/time/clock.h"
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace mir
+{
+namespace compositor
+{
+/**
+ * A CompositorReport that keeps FrameStatistics, and passes every event on to another report
+ * (e.g. the one selected by --compositor-report).
+ */
+class FrameStatisticsReport : public CompositorReport, public FrameStatistics
+{
+public:
+    FrameStatisticsReport(std::shared_ptr<CompositorReport> const& next, std::shared_ptr<time::Clock> const& clock);
+
+    void added_display(int width, int height, int x, int y, SubCompositorId id) override;
+    void began_frame(SubCompositorId id) override;
+    void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
+    void rendered_frame(SubCompositorId id) override;
+    void finished_frame(SubCompositorId id) override;
+    void started() override;
+    void stopped() override;
+    void scheduled() override;
+
+    auto output_statistics() const -> std::vector<OutputFrameStatistics> override;
+
+private:
+    using TimePoint = time::Timestamp;
+
+    struct Output
+    {
+        OutputFrameStatistics statistics;
+
+        TimePoint began;
+        TimePoint rendered;
+        TimePoint finished;
+        bool bypassed = true;
+        bool busy = false;  ///< This frame started as soon as the last one finished
+
+        /// The most recent frame intervals, from which we estimate the refresh period
+        std::array<DurationHistogram::Duration, 15> recent_intervals{};
+        size_t next_interval{0};
+    };
+
+    std::shared_ptr<CompositorReport> const next;
+    std::shared_ptr<time::Clock> const clock;
+
+    std::mutex mutable mutex; // Protects the following...
+    std::unordered_map<SubCompositorId, Output> outputs;
+    TimePoint last_scheduled;
+};
+}
+}
+
+#endif // MIR_COMPOSITOR_FRAME_STATISTICS_REPORT_H_
@@ -105,8 +105,13 @@ std::shared_ptr<mir::ConsoleServices> mir::DefaultServerConfiguration::the_conso
                 {
                     try
                     {
-                        auto const vt_services = std::make_shared<mir::LogindConsoleServices>(
-                            std::dynamic_pointer_cast<mir::GLibMainLoop>(the_main_loop()));
+                        auto const glib_main_loop = std::dynamic_pointer_cast<mir::GLibMainLoop>(the_main_loop());
+                        if (!glib_main_loop)
+                        {
+                            throw std::runtime_error{"logind console services require the GLib main loop"};
+                        }
+
+                        auto const vt_services = std::make_shared<mir::LogindConsoleServices>(glib_main_loop);
                         mir::log_debug("Using logind for session management");
                         return vt_services;
                     }
@@ -18,6 +18,8 @@
 #include "mir/fatal.h"
 #include "mir/options/default_configuration.h"
 #include "mir/glib_main_loop.h"
+#include "mir/epoll_main_loop.h"
+#include "mir/abnormal_exit.h"
 #include "mir/default_server_status_listener.h"
 #include "mir/emergency_cleanup.h"
 #include "mir/cookie/authority.h"
@@ -154,7 +156,18 @@ std::shared_ptr<mir::MainLoop> mir::DefaultServerConfiguration::the_main_loop()
     return main_loop(
         [this]() -> std::shared_ptr<mir::MainLoop>
         {
-            return std::make_shared<mir::GLibMainLoop>(the_clock());
+            auto const main_loop_type = the_options()->get<std::string>(options::main_loop_opt);
+
+            if (main_loop_type == "epoll")
+                return std::make_shared<mir::EpollMainLoop>(the_clock());
+            else if (main_loop_type != "glib")
+                throw mir::AbnormalExit{"Unknown --main-loop: " + main_loop_type};
+
+            auto const alarm_strategy = the_options()->get<bool>(options::timer_wheel_alarms_opt) ?
+                GLibMainLoop::AlarmStrategy::timer_wheel :
+                GLibMainLoop::AlarmStrategy::gsource_per_alarm;
+
+            return std::make_shared<mir::GLibMainLoop>(the_clock(), alarm_strategy);
         });
 }
 
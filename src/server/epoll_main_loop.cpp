@@ -0,0 +1,612 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/epoll_main_loop.h"
+#include "mir/time/timer_wheel.h"
+#include "mir/lockable_callback.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <array>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace
+{
+/*
+ * signalfd() only sees signals that are blocked in *every* thread of the
+ * process, which Mir cannot guarantee for threads created by drivers and
+ * libraries. So, as GLibMainLoop does, we install a sigaction() handler that
+ * forwards the signal number down a pipe registered with the epoll set.
+ */
+class SignalPipes
+{
+public:
+    static void add(int write_fd)
+    {
+        for (auto& wfd : write_fds)
+        {
+            int v = -1;
+            if (wfd.compare_exchange_strong(v, write_fd))
+                return;
+        }
+
+        BOOST_THROW_EXCEPTION(
+            std::runtime_error(
+                "Failed to add signal write fd. Have you created too many main loops?"));
+    }
+
+    static void remove(int write_fd)
+    {
+        for (auto& wfd : write_fds)
+        {
+            int v = write_fd;
+            if (wfd.compare_exchange_strong(v, -1))
+                break;
+        }
+    }
+
+    static void notify(int sig)
+    {
+        for (auto const& write_fd : write_fds)
+        {
+            // As with GLibMainLoop, a racing remove() means at worst we
+            // write() to -1, which is harmless.
+            if (write_fd >= 0 && write(write_fd, &sig, sizeof(sig))) {}
+        }
+    }
+
+private:
+    static int const max_write_fds{10};
+    static std::array<std::atomic<int>, max_write_fds> write_fds;
+};
+
+std::array<std::atomic<int>, 10> SignalPipes::write_fds{
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1};
+
+void epoll_add(int epoll_fd, int fd)
+{
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(errno, std::system_category(), "Failed to add fd to epoll set"));
+    }
+}
+
+auto make_epoll_fd() -> mir::Fd
+{
+    mir::Fd fd{epoll_create1(EPOLL_CLOEXEC)};
+    if (fd < 0)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(errno, std::system_category(), "Failed to create epoll fd"));
+    }
+    return fd;
+}
+
+auto make_wake_fd() -> mir::Fd
+{
+    mir::Fd fd{eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)};
+    if (fd < 0)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(errno, std::system_category(), "Failed to create main loop wake fd"));
+    }
+    return fd;
+}
+}
+
+/*
+ * An fd handler is disabled (under its mutex) before it is dropped, so once
+ * unregister_fd_handler() returns the handler is neither running nor will run.
+ * The mutex is recursive to allow unregistering from within the handler.
+ */
+struct mir::EpollMainLoop::FdHandler
+{
+    FdHandler(void const* owner, std::function<void(int)> const& handler)
+        : owner{owner}, handler{handler}
+    {
+    }
+
+    void const* const owner;
+    std::function<void(int)> const handler;
+    std::recursive_mutex mutex;
+    bool enabled{true};
+
+    void call(int fd)
+    {
+        std::lock_guard lock{mutex};
+        if (enabled)
+            handler(fd);
+    }
+
+    void disable()
+    {
+        std::lock_guard lock{mutex};
+        enabled = false;
+    }
+};
+
+mir::EpollMainLoop::EpollMainLoop(std::shared_ptr<time::Clock> const& clock)
+    : epoll_fd{make_epoll_fd()},
+      wake_fd{make_wake_fd()},
+      running_{false},
+      stop_requested{false},
+      timer_wheel{std::make_unique<time::TimerWheel>(clock, [this] { handle_exception(std::current_exception()); })}
+{
+    int pipefd[2];
+
+    if (pipe2(pipefd, O_CLOEXEC) == -1)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(errno, std::system_category(), "Failed to create signal pipe"));
+    }
+
+    signal_read_fd = mir::Fd(pipefd[0]);
+    signal_write_fd = mir::Fd(pipefd[1]);
+    // Make the signal_write_fd non-blocking, to avoid blocking in the signal handler
+    fcntl(signal_write_fd, F_SETFL, O_NONBLOCK);
+
+    SignalPipes::add(signal_write_fd);
+
+    epoll_add(epoll_fd, wake_fd);
+    add_fd_handler(signal_read_fd, this, [this] (int) { dispatch_pending_signals(); });
+    add_fd_handler(timer_wheel->watch_fd(), this,
+        [this] (int) { timer_wheel->dispatch(dispatch::FdEvent::readable); });
+}
+
+mir::EpollMainLoop::~EpollMainLoop()
+{
+    SignalPipes::remove(signal_write_fd);
+
+    std::lock_guard lock{signal_handlers_mutex};
+    for (auto const& handled : handled_signals)
+        sigaction(handled.first, &handled.second, nullptr);
+}
+
+void mir::EpollMainLoop::run()
+{
+    main_loop_exception = nullptr;
+    running_ = true;
+
+    while (running_)
+        iterate();
+
+    if (main_loop_exception)
+        std::rethrow_exception(main_loop_exception);
+}
+
+void mir::EpollMainLoop::stop()
+{
+    stop_requested = true;
+    wake();
+}
+
+bool mir::EpollMainLoop::running() const
+{
+    return running_;
+}
+
+void mir::EpollMainLoop::iterate()
+{
+    int const max_events{32};
+    epoll_event events[max_events];
+
+    auto const n = epoll_wait(epoll_fd, events, max_events, -1);
+    if (n == -1)
+    {
+        if (errno == EINTR)
+            return;
+
+        BOOST_THROW_EXCEPTION(
+            std::system_error(errno, std::system_category(), "Failed to wait on epoll fd"));
+    }
+
+    // Stop requests take priority over any other pending work
+    if (stop_requested.exchange(false))
+    {
+        halt();
+        return;
+    }
+
+    for (auto i = 0; i != n; ++i)
+    {
+        int const fd = events[i].data.fd;
+
+        if (fd == wake_fd)
+        {
+            eventfd_t unused;
+            if (eventfd_read(wake_fd, &unused)) {}
+        }
+        else
+        {
+            dispatch_fd(fd);
+        }
+    }
+
+    dispatch_actions();
+}
+
+void mir::EpollMainLoop::halt()
+{
+    std::unique_lock lock{run_on_halt_mutex};
+    running_ = false;
+
+    auto const actions = std::move(run_on_halt_queue);
+    run_on_halt_queue.clear();
+    // The actions may themselves enqueue_with_guaranteed_execution()
+    lock.unlock();
+
+    for (auto& action : actions)
+    {
+        try { action(); }
+        catch (...) { handle_exception(std::current_exception()); }
+    }
+}
+
+void mir::EpollMainLoop::wake()
+{
+    if (eventfd_write(wake_fd, 1)) {}
+}
+
+void mir::EpollMainLoop::register_signal_handler(
+    std::initializer_list<int> sigs,
+    std::function<void(int)> const& handler)
+{
+    auto const handler_with_exception_handling =
+        [this, handler] (int sig)
+        {
+            try { handler(sig); }
+            catch (...) { handle_exception(std::current_exception()); }
+        };
+
+    add_signal_handler(sigs, handler_with_exception_handling);
+}
+
+void mir::EpollMainLoop::register_signal_handler(
+    std::initializer_list<int> sigs,
+    mir::UniqueModulePtr<std::function<void(int)>> handler)
+{
+    std::shared_ptr<std::function<void(int)>> const shared_handler{std::move(handler)};
+
+    auto const handler_with_exception_handling =
+        [this, shared_handler] (int sig)
+        {
+            try { (*shared_handler)(sig); }
+            catch (...) { handle_exception(std::current_exception()); }
+        };
+
+    add_signal_handler(sigs, handler_with_exception_handling);
+}
+
+void mir::EpollMainLoop::add_signal_handler(
+    std::vector<int> const& sigs, std::function<void(int)> const& handler)
+{
+    {
+        std::lock_guard lock{signal_handlers_mutex};
+        signal_handlers.push_back({sigs, handler});
+    }
+
+    for (auto sig : sigs)
+        ensure_signal_is_handled(sig);
+}
+
+void mir::EpollMainLoop::ensure_signal_is_handled(int sig)
+{
+    std::lock_guard lock{signal_handlers_mutex};
+
+    if (handled_signals.find(sig) != handled_signals.end())
+        return;
+
+    struct sigaction old_action;
+    struct sigaction new_action{};
+
+    new_action.sa_handler = &SignalPipes::notify;
+    sigfillset(&new_action.sa_mask);
+
+    if (sigaction(sig, &new_action, &old_action) == -1)
+    {
+        std::stringstream msg;
+        msg << "Failed to register action for signal " << sig;
+        BOOST_THROW_EXCEPTION(
+            std::system_error(errno, std::system_category(), msg.str()));
+    }
+
+    handled_signals.emplace(sig, old_action);
+}
+
+void mir::EpollMainLoop::dispatch_pending_signals()
+{
+    int sig{-1};
+    size_t total{0};
+
+    do
+    {
+        auto const nread = read(signal_read_fd, reinterpret_cast<char*>(&sig) + total, sizeof(sig) - total);
+
+        if (nread < 0)
+        {
+            if (errno != EINTR)
+                return;
+        }
+        else
+        {
+            total += nread;
+        }
+    }
+    while (total < sizeof(sig));
+
+    std::vector<SignalHandler> handlers;
+    {
+        std::lock_guard lock{signal_handlers_mutex};
+        handlers = signal_handlers;
+    }
+
+    for (auto const& element : handlers)
+    {
+        if (std::find(element.sigs.begin(), element.sigs.end(), sig) != element.sigs.end())
+            element.handler(sig);
+    }
+}
+
+void mir::EpollMainLoop::register_fd_handler(
+    std::initializer_list<int> fds,
+    void const* owner,
+    std::function<void(int)> const& handler)
+{
+    auto const handler_with_exception_handling =
+        [this, handler] (int fd)
+        {
+            try { handler(fd); }
+            catch (...) { handle_exception(std::current_exception()); }
+        };
+
+    for (auto fd : fds)
+        add_fd_handler(fd, owner, handler_with_exception_handling);
+}
+
+void mir::EpollMainLoop::register_fd_handler(
+    std::initializer_list<int> fds,
+    void const* owner,
+    mir::UniqueModulePtr<std::function<void(int)>> handler)
+{
+    std::shared_ptr<std::function<void(int)>> const shared_handler{std::move(handler)};
+
+    auto const handler_with_exception_handling =
+        [this, shared_handler] (int fd)
+        {
+            try { (*shared_handler)(fd); }
+            catch (...) { handle_exception(std::current_exception()); }
+        };
+
+    for (auto fd : fds)
+        add_fd_handler(fd, owner, handler_with_exception_handling);
+}
+
+void mir::EpollMainLoop::unregister_fd_handler(void const* owner)
+{
+    remove_fd_handlers_owned_by(owner);
+}
+
+void mir::EpollMainLoop::add_fd_handler(
+    int fd, void const* owner, std::function<void(int)> const& handler)
+{
+    std::lock_guard lock{fd_handlers_mutex};
+
+    // epoll only accepts each fd once, so all handlers for an fd share a watch
+    auto& handlers = fd_handlers[fd];
+    if (handlers.empty())
+    {
+        try
+        {
+            epoll_add(epoll_fd, fd);
+        }
+        catch (...)
+        {
+            fd_handlers.erase(fd);
+            throw;
+        }
+    }
+
+    handlers.push_back(std::make_shared<FdHandler>(owner, handler));
+}
+
+void mir::EpollMainLoop::remove_fd_handlers_owned_by(void const* owner)
+{
+    std::vector<std::shared_ptr<FdHandler>> removed;
+
+    {
+        std::lock_guard lock{fd_handlers_mutex};
+
+        for (auto i = fd_handlers.begin(); i != fd_handlers.end();)
+        {
+            auto& handlers = i->second;
+            auto const new_end = std::stable_partition(
+                handlers.begin(), handlers.end(),
+                [&] (auto const& handler) { return handler->owner != owner; });
+
+            std::move(new_end, handlers.end(), std::back_inserter(removed));
+            handlers.erase(new_end, handlers.end());
+
+            if (handlers.empty())
+            {
+                // This fails harmlessly if the fd has already been closed
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, i->first, nullptr);
+                i = fd_handlers.erase(i);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+
+    // Disable outside fd_handlers_mutex: we may have to wait for a handler
+    // in progress on the loop thread, which may itself (un)register handlers.
+    for (auto const& handler : removed)
+        handler->disable();
+}
+
+void mir::EpollMainLoop::dispatch_fd(int fd)
+{
+    std::vector<std::shared_ptr<FdHandler>> handlers;
+    {
+        std::lock_guard lock{fd_handlers_mutex};
+        if (auto const i = fd_handlers.find(fd); i != fd_handlers.end())
+            handlers = i->second;
+    }
+
+    for (auto const& handler : handlers)
+        handler->call(fd);
+}
+
+void mir::EpollMainLoop::enqueue(void const* owner, ServerAction const& action)
+{
+    add_action(owner, action, true);
+}
+
+void mir::EpollMainLoop::enqueue_with_guaranteed_execution(ServerAction const& action)
+{
+    std::unique_lock lock{run_on_halt_mutex};
+
+    if (!running_)
+    {
+        // The action may itself enqueue_with_guaranteed_execution()
+        lock.unlock();
+        action();
+        return;
+    }
+
+    run_on_halt_queue.push_back(action);
+    lock.unlock();
+
+    add_action(
+        nullptr,
+        [this]
+        {
+            std::unique_lock lock{run_on_halt_mutex};
+            // The queue may already have been drained by halt()
+            if (run_on_halt_queue.empty())
+                return;
+
+            auto const action = std::move(run_on_halt_queue.front());
+            run_on_halt_queue.pop_front();
+            lock.unlock();
+
+            action();
+        },
+        false);
+}
+
+void mir::EpollMainLoop::pause_processing_for(void const* owner)
+{
+    std::lock_guard lock{do_not_process_mutex};
+
+    auto const iter = std::find(do_not_process.begin(), do_not_process.end(), owner);
+    if (iter == do_not_process.end())
+        do_not_process.push_back(owner);
+}
+
+void mir::EpollMainLoop::resume_processing_for(void const* owner)
+{
+    {
+        std::lock_guard lock{do_not_process_mutex};
+
+        auto const new_end = std::remove(do_not_process.begin(), do_not_process.end(), owner);
+        do_not_process.erase(new_end, do_not_process.end());
+    }
+
+    // Wake up the loop so that any actions for owner are processed
+    wake();
+}
+
+void mir::EpollMainLoop::spawn(std::function<void()>&& work)
+{
+    add_action(nullptr, std::move(work), false);
+}
+
+void mir::EpollMainLoop::add_action(void const* owner, ServerAction const& action, bool pausable)
+{
+    {
+        std::lock_guard lock{actions_mutex};
+        actions.push_back({owner, action, pausable});
+    }
+
+    wake();
+}
+
+bool mir::EpollMainLoop::should_process_actions_for(void const* owner)
+{
+    std::lock_guard lock{do_not_process_mutex};
+
+    auto const iter = std::find(do_not_process.begin(), do_not_process.end(), owner);
+    return iter == do_not_process.end();
+}
+
+void mir::EpollMainLoop::dispatch_actions()
+{
+    // Only dispatch what is queued now; actions enqueued by the actions we run
+    // are picked up on the next iteration (the enqueue will have woken us).
+    std::vector<QueuedAction> ready;
+    {
+        std::lock_guard lock{actions_mutex};
+
+        auto const paused_end = std::stable_partition(
+            actions.begin(), actions.end(),
+            [this] (auto const& queued)
+            {
+                return queued.pausable && !should_process_actions_for(queued.owner);
+            });
+
+        std::move(paused_end, actions.end(), std::back_inserter(ready));
+        actions.erase(paused_end, actions.end());
+    }
+
+    for (auto const& queued : ready)
+    {
+        try { queued.action(); }
+        catch (...) { handle_exception(std::current_exception()); }
+    }
+}
+
+std::unique_ptr<mir::time::Alarm> mir::EpollMainLoop::create_alarm(
+    std::function<void()> const& callback)
+{
+    return timer_wheel->create_alarm(callback);
+}
+
+std::unique_ptr<mir::time::Alarm> mir::EpollMainLoop::create_alarm(
+    std::unique_ptr<LockableCallback> callback)
+{
+    return timer_wheel->create_alarm(std::move(callback));
+}
+
+void mir::EpollMainLoop::handle_exception(std::exception_ptr const& e)
+{
+    main_loop_exception = e;
+    stop();
+}
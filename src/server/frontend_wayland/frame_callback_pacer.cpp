@@ -0,0 +1,141 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "frame_callback_pacer.h"
+
+#include "mir/executor.h"
+#include "mir/scene/surface.h"
+
+namespace mf = mir::frontend;
+
+struct mf::FrameCallbackPacer::State
+{
+    /// Waiting for a buffer to be composited, or for the frame executor
+    std::vector<Callback> pending;
+    /// Committed while the surface couldn't be seen
+    std::vector<Callback> parked;
+
+    static void send(std::vector<Callback>& callbacks)
+    {
+        auto const sending = std::move(callbacks);
+        callbacks.clear();
+        for (auto const& callback : sending)
+        {
+            callback();
+        }
+    }
+};
+
+auto mf::can_be_seen(scene::Surface const* scene_surface, bool has_buffer) -> bool
+{
+    if (!scene_surface || !has_buffer)
+        return true;
+
+    switch (scene_surface->state())
+    {
+    case mir_window_state_minimized:
+    case mir_window_state_hidden:
+        return false;
+
+    default:
+        break;
+    }
+
+    if (!scene_surface->visible())
+        return false;
+
+    // The compositor reports surfaces that are off-screen as occluded too
+    return scene_surface->query(mir_window_attrib_visibility) != mir_window_visibility_occluded;
+}
+
+mf::FrameCallbackPacer::FrameCallbackPacer(
+    std::shared_ptr<Executor> const& wayland_executor,
+    std::shared_ptr<Executor> const& frame_executor,
+    std::shared_ptr<Executor> const& hidden_frame_executor)
+    : wayland_executor{wayland_executor},
+      frame_executor{frame_executor},
+      hidden_frame_executor{hidden_frame_executor},
+      state{std::make_shared<State>()}
+{
+}
+
+mf::FrameCallbackPacer::~FrameCallbackPacer() = default;
+
+void mf::FrameCallbackPacer::commit(std::vector<Callback>&& callbacks, bool new_buffer, bool can_be_seen)
+{
+    // If a client commits multiple times before the first buffer is handled, all the callbacks are sent at once
+    state->pending.insert(
+        state->pending.end(),
+        std::make_move_iterator(callbacks.begin()),
+        std::make_move_iterator(callbacks.end()));
+
+    if (state->pending.empty())
+    {
+        return;
+    }
+
+    if (!can_be_seen)
+    {
+        // Nothing will be composited, so keep the client ticking over slowly (if at all). Only these callbacks are
+        // sent by the hidden frame executor: any committed once the surface can be seen again are paced as usual.
+        state->parked.insert(
+            state->parked.end(),
+            std::make_move_iterator(state->pending.begin()),
+            std::make_move_iterator(state->pending.end()));
+        state->pending.clear();
+
+        if (hidden_frame_executor)
+        {
+            hidden_frame_executor->spawn(
+                on_wayland_thread([](State& state) { State::send(state.parked); }));
+        }
+    }
+    else if (!new_buffer)
+    {
+        frame_executor->spawn(
+            on_wayland_thread([](State& state) { State::send(state.pending); }));
+    }
+}
+
+auto mf::FrameCallbackPacer::buffer_consumed() const -> std::function<void()>
+{
+    return on_wayland_thread([](State& state) { State::send(state.pending); });
+}
+
+void mf::FrameCallbackPacer::send_all()
+{
+    State::send(state->parked);
+    State::send(state->pending);
+}
+
+void mf::FrameCallbackPacer::send_parked()
+{
+    State::send(state->parked);
+}
+
+auto mf::FrameCallbackPacer::on_wayland_thread(void (*action)(State&)) const -> std::function<void()>
+{
+    return [wayland_executor=wayland_executor, weak_state=std::weak_ptr<State>{state}, action]()
+        {
+            wayland_executor->spawn([weak_state, action]()
+                {
+                    if (auto const state = weak_state.lock())
+                    {
+                        action(*state);
+                    }
+                });
+        };
+}
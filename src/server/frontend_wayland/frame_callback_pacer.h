@@ -0,0 +1,95 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_FRAME_CALLBACK_PACER_H
+#define MIR_FRONTEND_FRAME_CALLBACK_PACER_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace mir
+{
+class Executor;
+
+namespace scene
+{
+class Surface;
+}
+
+namespace frontend
+{
+
+/// Whether a surface might be seen, and so should have its frame callbacks paced by the display.
+///
+/// \param scene_surface    The window the surface is part of, if any. Surfaces that aren't part of a window (such as
+///                         cursors) might be seen.
+/// \param has_buffer       Whether the surface has a buffer. A surface without one hasn't been shown yet, so the
+///                         compositor can't have found it to be occluded.
+auto can_be_seen(scene::Surface const* scene_surface, bool has_buffer) -> bool;
+
+/// Decides when the frame callbacks of a surface's commits are sent.
+///
+/// While the surface can be seen, callbacks are sent when a committed buffer is composited or, for commits without a
+/// new buffer, by the frame executor. Callbacks of commits made while the surface can't be seen are parked until the
+/// hidden frame executor runs or the surface can be seen again, whichever comes first. Without a hidden frame executor,
+/// they are parked until the surface can be seen again.
+///
+/// All member functions must be called on the Wayland thread, and the callbacks are sent on it.
+class FrameCallbackPacer
+{
+public:
+    /// Sends the done event of a single wl_callback
+    using Callback = std::function<void()>;
+
+    /// \param hidden_frame_executor  Paces the callbacks of surfaces that can't be seen, or null to hold them until the
+    ///                               surface can be seen
+    FrameCallbackPacer(
+        std::shared_ptr<Executor> const& wayland_executor,
+        std::shared_ptr<Executor> const& frame_executor,
+        std::shared_ptr<Executor> const& hidden_frame_executor);
+    ~FrameCallbackPacer();
+
+    FrameCallbackPacer(FrameCallbackPacer const&) = delete;
+    FrameCallbackPacer& operator=(FrameCallbackPacer const&) = delete;
+
+    /// Schedules the callbacks of a commit, along with any that are still waiting for a buffer to be composited
+    void commit(std::vector<Callback>&& callbacks, bool new_buffer, bool can_be_seen);
+
+    /// For a committed buffer to call (from any thread) once composited
+    auto buffer_consumed() const -> std::function<void()>;
+
+    /// Sends all callbacks now, whether or not they are parked
+    void send_all();
+
+    /// Sends the parked callbacks now, as the surface can be seen again
+    void send_parked();
+
+private:
+    struct State;
+
+    /// A function to run action on the Wayland thread, unless this has been destroyed by then
+    auto on_wayland_thread(void (*action)(State&)) const -> std::function<void()>;
+
+    std::shared_ptr<Executor> const wayland_executor;
+    std::shared_ptr<Executor> const frame_executor;
+    std::shared_ptr<Executor> const hidden_frame_executor;
+    std::shared_ptr<State> const state;
+};
+}
+}
+
+#endif // MIR_FRONTEND_FRAME_CALLBACK_PACER_H
@@ -25,7 +25,7 @@ namespace mf = mir::frontend;
 
 namespace
 {
-auto const delay = std::chrono::milliseconds{16};
+auto const default_interval = std::chrono::milliseconds{16};
 }
 
 struct mf::FrameExecutor::Callbacks
@@ -35,7 +35,13 @@ struct mf::FrameExecutor::Callbacks
 };
 
 mf::FrameExecutor::FrameExecutor(time::AlarmFactory& alarm_factory)
-    : callbacks{std::make_shared<Callbacks>()},
+    : FrameExecutor{alarm_factory, default_interval}
+{
+}
+
+mf::FrameExecutor::FrameExecutor(time::AlarmFactory& alarm_factory, std::chrono::milliseconds interval)
+    : interval{interval},
+      callbacks{std::make_shared<Callbacks>()},
       alarm{alarm_factory.create_alarm([weak_callbacks = std::weak_ptr<Callbacks>{callbacks}]()
           {
               fire_callbacks(weak_callbacks);
@@ -52,7 +58,7 @@ void mf::FrameExecutor::spawn(std::function<void()>&& work)
 
     if (needs_alarm)
     {
-        alarm->reschedule_in(delay);
+        alarm->reschedule_in(interval);
     }
 }
 
@@ -19,6 +19,7 @@
 
 #include <mir/executor.h>
 
+#include <chrono>
 #include <memory>
 
 namespace mir
@@ -37,6 +38,8 @@ class FrameExecutor : public Executor
 {
 public:
     explicit FrameExecutor(time::AlarmFactory& alarm_factory);
+    /// Runs callbacks (at least) interval after the first of them was spawned
+    FrameExecutor(time::AlarmFactory& alarm_factory, std::chrono::milliseconds interval);
 
     // This can be called from any thread. Given callback is run on the main loop thread. The wayland executor is NOT
     // automatically used.
@@ -45,6 +48,7 @@ public:
 private:
     struct Callbacks;
 
+    std::chrono::milliseconds const interval;
     std::shared_ptr<Callbacks> const callbacks; // shared_ptr so it can potentially outlive this object
     std::unique_ptr<time::Alarm> const alarm;
 
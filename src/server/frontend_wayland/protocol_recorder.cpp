@@ -0,0 +1,253 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "protocol_recorder.h"
+#include "shm.h"
+
+#include "mir/renderer/sw/pixel_source.h"
+#include "mir/wayland/client.h"
+#include "mir/log.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <cctype>
+#include <iomanip>
+#include <sstream>
+#include <system_error>
+
+namespace mf = mir::frontend;
+namespace mw = mir::wayland;
+namespace fs = std::filesystem;
+
+namespace
+{
+// FNV-1a is stable across runs, so identical content recorded in different sessions shares a file
+auto content_hash(unsigned char const* data, size_t len) -> std::string
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    for (size_t i = 0; i != len; ++i)
+    {
+        hash ^= data[i];
+        hash *= 0x100000001b3;
+    }
+
+    std::stringstream out;
+    out << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return out.str();
+}
+
+auto quoted(char const* string) -> std::string
+{
+    if (!string)
+        return "null";
+
+    std::stringstream out;
+    out << '"' << std::hex << std::setfill('0');
+    for (auto p = string; *p; ++p)
+    {
+        auto const c = static_cast<unsigned char>(*p);
+        if (c <= ' ' || c >= 0x7f || c == '"' || c == '%')
+            out << '%' << std::setw(2) << unsigned{c};
+        else
+            out << *p;
+    }
+    out << '"';
+    return out.str();
+}
+
+auto hex(wl_array const* array) -> std::string
+{
+    std::stringstream out;
+    out << 'x' << std::hex << std::setfill('0');
+    auto const data = static_cast<unsigned char const*>(array->data);
+    for (size_t i = 0; i != array->size; ++i)
+        out << std::setw(2) << unsigned{data[i]};
+    return out.str();
+}
+
+auto id_of(wl_object* object) -> uint32_t
+{
+    // Server side, object arguments are resources (which start with their wl_object)
+    return object ? wl_resource_get_id(reinterpret_cast<wl_resource*>(object)) : 0;
+}
+}
+
+mf::ProtocolRecorder::ProtocolRecorder(wl_display* display, fs::path directory)
+    : directory{std::move(directory)},
+      epoch{std::chrono::steady_clock::now()}
+{
+    std::error_code ec;
+    fs::create_directories(this->directory / "shm", ec);
+    if (ec)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{
+            ec,
+            "Failed to create Wayland recording directory " + this->directory.string()}));
+    }
+
+    logger = wl_display_add_protocol_logger(display, &log_thunk, this);
+    mir::log_info("Recording Wayland clients in %s", this->directory.c_str());
+}
+
+mf::ProtocolRecorder::~ProtocolRecorder()
+{
+    wl_protocol_logger_destroy(logger);
+    for (auto const& [client, recording] : clients)
+    {
+        mw::Client::from(client).remove_destroy_listener(recording.destroy_listener);
+    }
+}
+
+void mf::ProtocolRecorder::log_thunk(
+    void* self,
+    wl_protocol_logger_type direction,
+    wl_protocol_logger_message const* message)
+{
+    if (direction != WL_PROTOCOL_LOGGER_REQUEST)
+        return;
+
+    try
+    {
+        static_cast<ProtocolRecorder*>(self)->log_request(*message);
+    }
+    catch (...)
+    {
+        log(logging::Severity::warning, MIR_LOG_COMPONENT, std::current_exception(), "Failed to record Wayland request");
+    }
+}
+
+void mf::ProtocolRecorder::log_request(wl_protocol_logger_message const& message)
+{
+    auto& out = recording_for(wl_resource_get_client(message.resource)).out;
+    auto const now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch);
+    auto const interface = wl_resource_get_class(message.resource);
+    auto const id = wl_resource_get_id(message.resource);
+
+    if (std::string{interface} == "wl_surface" &&
+        std::string{message.message->name} == "attach" &&
+        message.arguments[0].o)
+    {
+        auto const buffer = reinterpret_cast<wl_resource*>(message.arguments[0].o);
+        try
+        {
+            if (auto const hash = save_shm_content(buffer); !hash.empty())
+                out << now.count() << " shm " << wl_resource_get_id(buffer) << ' ' << hash << '\n';
+        }
+        catch (...)
+        {
+            // The client may have truncated the pool; the attach itself is still worth recording
+            log(logging::Severity::warning, MIR_LOG_COMPONENT, std::current_exception(), "Failed to record SHM buffer");
+        }
+    }
+
+    std::string signature;
+    for (auto c = message.message->signature; *c; ++c)
+    {
+        if (!isdigit(*c))
+            signature += *c;
+    }
+
+    out << now.count() << ' ' << id << ' ' << interface << ' ' << message.message_opcode << ' '
+        << message.message->name << ' ' << (signature.empty() ? "-" : signature);
+
+    auto argument = message.arguments;
+    for (auto const c : signature)
+    {
+        if (c == '?')
+            continue;
+
+        out << ' ';
+        switch (c)
+        {
+        case 'i':
+            out << argument->i;
+            break;
+        case 'u':
+            out << argument->u;
+            break;
+        case 'f':
+            out << argument->f;
+            break;
+        case 's':
+            out << quoted(argument->s);
+            break;
+        case 'o':
+            out << id_of(argument->o);
+            break;
+        case 'n':
+            out << argument->n;
+            break;
+        case 'a':
+            out << hex(argument->a);
+            break;
+        case 'h':
+            out << "fd";
+            break;
+        }
+        ++argument;
+    }
+    out << '\n';
+}
+
+auto mf::ProtocolRecorder::recording_for(wl_client* client) -> ClientRecording&
+{
+    if (auto const existing = clients.find(client); existing != clients.end())
+        return existing->second;
+
+    auto const path = directory / ("client-" + std::to_string(next_client++) + ".wlrec");
+    auto& recording = clients[client];
+    recording.out.open(path);
+    if (!recording.out)
+    {
+        clients.erase(client);
+        BOOST_THROW_EXCEPTION((std::runtime_error{"Failed to create Wayland recording " + path.string()}));
+    }
+
+    pid_t pid;
+    wl_client_get_credentials(client, &pid, nullptr, nullptr);
+    recording.out << "# Wayland requests of pid " << pid << '\n';
+
+    recording.destroy_listener = mw::Client::from(client).add_destroy_listener([this, client]
+        {
+            clients.erase(client);
+        });
+
+    return recording;
+}
+
+auto mf::ProtocolRecorder::save_shm_content(wl_resource* buffer) -> std::string
+{
+    auto const shm_buffer = ShmBuffer::from(buffer);
+    if (!shm_buffer)
+        return {};
+
+    auto const mapping = shm_buffer->data()->map_readable();
+    auto const hash = content_hash(mapping->data(), mapping->len());
+
+    if (saved_content.insert(hash).second)
+    {
+        auto const path = directory / "shm" / hash;
+        if (!fs::exists(path))
+        {
+            std::ofstream content{path, std::ios::binary};
+            content.write(reinterpret_cast<char const*>(mapping->data()), mapping->len());
+            if (!content)
+                mir::log_warning("Failed to save SHM buffer content to %s", path.c_str());
+        }
+    }
+
+    return hash;
+}
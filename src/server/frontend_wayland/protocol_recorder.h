@@ -0,0 +1,87 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_PROTOCOL_RECORDER_H_
+#define MIR_FRONTEND_PROTOCOL_RECORDER_H_
+
+#include "mir/wayland/lifetime_tracker.h"
+
+#include <wayland-server-core.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace mir
+{
+namespace frontend
+{
+/**
+ * Records the requests of every Wayland client, so that a session can be replayed against a
+ * server later (see tests/benchmarks/protocol_replay.h).
+ *
+ * Each client's requests are written to "client-<n>.wlrec" in the recording directory, one per line:
+ *
+ *     <ns> <object> <interface> <opcode> <message> <signature> <arguments...>
+ *
+ * <ns> is the time since recording started, which is shared by all clients. Strings are quoted
+ * with non-printing characters, spaces, quotes and '%' percent-encoded, "null" is a null string,
+ * arrays are hex prefixed with 'x' and file descriptors are recorded only as "fd".
+ *
+ * Before a wl_surface.attach of an SHM buffer the buffer's content is recorded as:
+ *
+ *     <ns> shm <buffer> <content hash>
+ *
+ * and the content is saved, once per distinct content, in "shm/<content hash>". dmabuf metadata
+ * (size, format, planes and modifiers) is already in the zwp_linux_buffer_params_v1 requests.
+ */
+class ProtocolRecorder
+{
+public:
+    ProtocolRecorder(wl_display* display, std::filesystem::path directory);
+    ~ProtocolRecorder();
+
+    ProtocolRecorder(ProtocolRecorder const&) = delete;
+    ProtocolRecorder& operator=(ProtocolRecorder const&) = delete;
+
+private:
+    struct ClientRecording
+    {
+        std::ofstream out;
+        wayland::DestroyListenerId destroy_listener;
+    };
+
+    static void log_thunk(void* self, wl_protocol_logger_type direction, wl_protocol_logger_message const* message);
+    void log_request(wl_protocol_logger_message const& message);
+    auto recording_for(wl_client* client) -> ClientRecording&;
+    /// Save the content of buffer if it's an SHM buffer, returning its hash (or an empty string)
+    auto save_shm_content(wl_resource* buffer) -> std::string;
+
+    std::filesystem::path const directory;
+    std::chrono::steady_clock::time_point const epoch;
+    std::unordered_map<wl_client*, ClientRecording> clients;
+    std::unordered_set<std::string> saved_content;
+    int next_client{0};
+    wl_protocol_logger* logger{nullptr};
+};
+}
+}
+
+#endif // MIR_FRONTEND_PROTOCOL_RECORDER_H_
@@ -26,6 +26,7 @@
 #include "frame_executor.h"
 #include "output_manager.h"
 #include "wayland_executor.h"
+#include "protocol_recorder.h"
 
 #include "mir/main_loop.h"
 #include "mir/thread_name.h"
@@ -65,11 +66,13 @@ public:
         struct wl_display* display,
         std::shared_ptr<mir::Executor> const& wayland_executor,
         std::shared_ptr<mir::Executor> const& frame_callback_executor,
+        std::shared_ptr<mir::Executor> const& hidden_frame_callback_executor,
         std::shared_ptr<mg::GraphicBufferAllocator> const& allocator)
         : Global(display, Version<4>()),
           allocator{allocator},
           wayland_executor{wayland_executor},
-          frame_callback_executor{frame_callback_executor}
+          frame_callback_executor{frame_callback_executor},
+          hidden_frame_callback_executor{hidden_frame_callback_executor}
     {
     }
 
@@ -79,6 +82,7 @@ private:
     std::shared_ptr<mg::GraphicBufferAllocator> const allocator;
     std::shared_ptr<mir::Executor> const wayland_executor;
     std::shared_ptr<mir::Executor> const frame_callback_executor;
+    std::shared_ptr<mir::Executor> const hidden_frame_callback_executor;
     std::map<std::pair<wl_client*, uint32_t>, std::vector<std::function<void(WlSurface*)>>> surface_callbacks;
 
     class Instance : wayland::Compositor
@@ -122,6 +126,7 @@ void WlCompositor::Instance::create_surface(wl_resource* new_surface)
         new_surface,
         compositor->wayland_executor,
         compositor->frame_callback_executor,
+        compositor->hidden_frame_callback_executor,
         compositor->allocator};
     auto const key = std::make_pair(wl_resource_get_client(new_surface), wl_resource_get_id(new_surface));
     auto const callbacks = compositor->surface_callbacks.find(key);
@@ -235,7 +240,9 @@ mf::WaylandConnector::WaylandConnector(
     bool arw_socket,
     std::unique_ptr<WaylandExtensions> extensions_,
     WaylandProtocolExtensionFilter const& extension_filter,
-    bool enable_key_repeat)
+    bool enable_key_repeat,
+    std::optional<std::string> const& protocol_recording_dir,
+    std::chrono::milliseconds hidden_frame_interval)
     : extension_filter{extension_filter},
       display{wl_display_create(), &cleanup_display},
       pause_signal{eventfd(0, EFD_CLOEXEC | EFD_SEMAPHORE)},
@@ -277,6 +284,9 @@ mf::WaylandConnector::WaylandConnector(
         display.get(),
         executor,
         std::make_shared<FrameExecutor>(*main_loop),
+        // A zero interval parks the callbacks of surfaces that can't be seen until they can
+        hidden_frame_interval.count() ?
+            std::make_shared<FrameExecutor>(*main_loop, hidden_frame_interval) : nullptr,
         this->allocator);
     subcompositor_global = std::make_unique<mf::WlSubcompositor>(display.get());
     seat_global = std::make_unique<mf::WlSeat>(
@@ -312,6 +322,11 @@ mf::WaylandConnector::WaylandConnector(
 
     shm_global = std::make_unique<WlShm>(display.get(), executor);
 
+    if (protocol_recording_dir)
+    {
+        protocol_recorder = std::make_unique<ProtocolRecorder>(display.get(), *protocol_recording_dir);
+    }
+
     char const* wayland_display = nullptr;
 
     if (auto const display_name = getenv("WAYLAND_DISPLAY"))
@@ -23,6 +23,9 @@
 #include "mir/optional_value.h"
 
 #include <wayland-server-core.h>
+#include <chrono>
+#include <optional>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <thread>
@@ -72,6 +75,7 @@ class WlDataDeviceManager;
 class WlSurface;
 class SurfaceStack;
 class WlShm;
+class ProtocolRecorder;
 
 class WaylandExtensions
 {
@@ -141,7 +145,9 @@ public:
         bool arw_socket,
         std::unique_ptr<WaylandExtensions> extensions,
         WaylandProtocolExtensionFilter const& extension_filter,
-        bool enable_key_repeat);
+        bool enable_key_repeat,
+        std::optional<std::string> const& protocol_recording_dir,
+        std::chrono::milliseconds hidden_frame_interval);
 
     ~WaylandConnector() override;
 
@@ -186,6 +192,7 @@ private:
     std::unique_ptr<OutputManager> output_manager;
     std::unique_ptr<WlDataDeviceManager> data_device_manager_global;
     std::unique_ptr<WlShm> shm_global;
+    std::unique_ptr<ProtocolRecorder> protocol_recorder;
     std::shared_ptr<Executor> const executor;
     std::shared_ptr<graphics::GraphicBufferAllocator> const allocator;
     std::shared_ptr<shell::Shell> const shell;
@@ -38,6 +38,7 @@
 #include "wlr_screencopy_v1.h"
 #include "primary_selection_v1.h"
 
+#include "mir/abnormal_exit.h"
 #include "mir/graphics/platform.h"
 #include "mir/options/default_configuration.h"
 #include "mir/scene/session.h"
@@ -298,6 +299,24 @@ std::shared_ptr<mf::Connector>
 
             auto const enable_repeat = options->get<bool>(options::enable_key_repeat_opt);
 
+            int const hidden_frame_interval_ms = options->get<int>(options::hidden_frame_interval_opt);
+            if (hidden_frame_interval_ms < 0)
+            {
+                throw mir::AbnormalExit(
+                    "Invalid " +
+                    std::string{options::hidden_frame_interval_opt} +
+                    " value " +
+                    std::to_string(hidden_frame_interval_ms) +
+                    ", must be >= 0");
+            }
+            std::chrono::milliseconds const hidden_frame_interval{hidden_frame_interval_ms};
+
+            std::optional<std::string> protocol_recording_dir;
+            if (options->is_set(options::wayland_record_opt))
+            {
+                protocol_recording_dir = options->get<std::string>(options::wayland_record_opt);
+            }
+
             return std::make_shared<mf::WaylandConnector>(
                 the_shell(),
                 the_clock(),
@@ -322,7 +341,9 @@ std::shared_ptr<mf::Connector>
                     options->is_set(mo::x11_display_opt),
                     wayland_extension_hooks),
                 wayland_extension_filter,
-                enable_repeat);
+                enable_repeat,
+                protocol_recording_dir,
+                hidden_frame_interval);
         });
 }
 
@@ -36,6 +36,7 @@
 #include "mir/executor.h"
 #include "mir/graphics/graphic_buffer_allocator.h"
 #include "mir/scene/surface.h"
+#include "mir/scene/null_surface_observer.h"
 #include "mir/shell/surface_specification.h"
 #include "mir/log.h"
 
@@ -82,22 +83,73 @@ bool mf::WlSurfaceState::surface_data_needs_refresh() const
            surface_data_invalidated;
 }
 
+class mf::WlSurface::VisibilityObserver : public mir::scene::NullSurfaceObserver
+{
+public:
+    VisibilityObserver(mw::Weak<WlSurface> surface, std::shared_ptr<Executor> const& wayland_executor)
+        : surface{std::move(surface)},
+          wayland_executor{wayland_executor}
+    {
+    }
+
+    void attrib_changed(scene::Surface const*, MirWindowAttrib attrib, int) override
+    {
+        if (attrib == mir_window_attrib_visibility || attrib == mir_window_attrib_state)
+        {
+            might_be_seen();
+        }
+    }
+
+    void hidden_set_to(scene::Surface const*, bool hide) override
+    {
+        if (!hide)
+        {
+            might_be_seen();
+        }
+    }
+
+private:
+    void might_be_seen()
+    {
+        wayland_executor->spawn([surface=surface]()
+            {
+                if (surface && surface.value().can_be_seen())
+                {
+                    surface.value().frame_callbacks.send_parked();
+                }
+            });
+    }
+
+    mw::Weak<WlSurface> const surface;
+    std::shared_ptr<Executor> const wayland_executor;
+};
+
 mf::WlSurface::WlSurface(
     wl_resource* new_resource,
     std::shared_ptr<Executor> const& wayland_executor,
     std::shared_ptr<Executor> const& frame_callback_executor,
+    std::shared_ptr<Executor> const& hidden_frame_callback_executor,
     std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator)
     : Surface(new_resource, Version<4>()),
         session{client->client_session()},
         stream{session->create_buffer_stream({{}, mir_pixel_format_invalid, graphics::BufferUsage::undefined})},
         allocator{allocator},
         wayland_executor{wayland_executor},
-        frame_callback_executor{frame_callback_executor},
         null_role{this},
-        role{&null_role}
+        role{&null_role},
+        frame_callbacks{wayland_executor, frame_callback_executor, hidden_frame_callback_executor},
+        visibility_observer{std::make_shared<VisibilityObserver>(mw::make_weak(this), wayland_executor)}
 {
     // wl_surface is specified to act in mailbox mode
     stream->allow_framedropping(true);
+
+    on_scene_surface_created([this](std::shared_ptr<scene::Surface> scene_surface)
+        {
+            // Use immediate_executor so uninteresting observations are processed quickly, the observer punts
+            // interesting ones to the Wayland executor itself
+            scene_surface->register_interest(visibility_observer, mir::immediate_executor);
+            observed_scene_surface = scene_surface;
+        });
 }
 
 mf::WlSurface::~WlSurface()
@@ -105,6 +157,11 @@ mf::WlSurface::~WlSurface()
     // We can't use a function try block as we want to access `client`:
     // "Before any catch clauses of a function-try-block on a destructor are entered,
     // all bases and non-variant members have already been destroyed."
+    if (auto const scene_surface = observed_scene_surface.lock())
+    {
+        scene_surface->unregister_interest(*visibility_observer);
+    }
+
     try
     {
         // Destroy the buffer stream first, as surface_destroyed() may throw
@@ -248,19 +305,10 @@ mf::WlSurface* mf::WlSurface::from(wl_resource* resource)
     return static_cast<WlSurface*>(static_cast<wayland::Surface*>(raw_surface));
 }
 
-void mf::WlSurface::send_frame_callbacks()
+auto mf::WlSurface::can_be_seen() const -> bool
 {
-    for (auto const& frame : frame_callbacks)
-    {
-        if (frame)
-        {
-            auto const timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                std::chrono::steady_clock::now().time_since_epoch());
-            frame.value().send_done_event(timestamp_ms.count());
-            frame.value().destroy_and_delete();
-        }
-    }
-    frame_callbacks.clear();
+    auto const surface = scene_surface();
+    return mf::can_be_seen(surface ? surface.value().get() : nullptr, buffer_size_.has_value());
 }
 
 void mf::WlSurface::attach(std::optional<wl_resource*> const& buffer, int32_t x, int32_t y)
@@ -320,10 +368,21 @@ void mf::WlSurface::set_input_region(std::optional<wl_resource*> const& region)
 
 void mf::WlSurface::commit(WlSurfaceState const& state)
 {
-    // We're going to lose the value of state, so copy the frame_callbacks first. We have to maintain a list of
-    // callbacks in wl_surface because if a client commits multiple times before the first buffer is handled, all the
-    // callbacks should be sent at once.
-    frame_callbacks.insert(end(frame_callbacks), begin(state.frame_callbacks), end(state.frame_callbacks));
+    // We're going to lose the value of state, so copy the frame_callbacks first
+    std::vector<FrameCallbackPacer::Callback> callbacks;
+    for (auto const& frame : state.frame_callbacks)
+    {
+        callbacks.push_back([frame]()
+            {
+                if (frame)
+                {
+                    auto const timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch());
+                    frame.value().send_done_event(timestamp_ms.count());
+                    frame.value().destroy_and_delete();
+                }
+            });
+    }
 
     if (state.offset)
         offset_ = state.offset.value();
@@ -334,16 +393,7 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
     if (state.scale)
         stream->set_scale(state.scale.value());
 
-    auto const executor_send_frame_callbacks = [executor = wayland_executor, weak_self = mw::make_weak(this)]()
-        {
-            executor->spawn([weak_self]()
-                {
-                    if (weak_self)
-                    {
-                        weak_self.value().send_frame_callbacks();
-                    }
-                });
-        };
+    bool const new_buffer = state.buffer && *state.buffer;
 
     if (state.buffer)
     {
@@ -353,7 +403,6 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
         {
             // TODO: unmap surface, and unmap all subsurfaces
             buffer_size_ = std::nullopt;
-            send_frame_callbacks();
         }
         else
         {
@@ -370,7 +419,7 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
             {
                 mir_buffer = allocator->buffer_from_shm(
                     shm_buffer->data(),
-                    std::move(executor_send_frame_callbacks),
+                    frame_callbacks.buffer_consumed(),
                     std::move(release_buffer));
                 tracepoint(
                     mir_server_wayland,
@@ -382,7 +431,7 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
             {
                 mir_buffer = allocator->buffer_from_resource(
                     buffer,
-                    std::move(executor_send_frame_callbacks),
+                    frame_callbacks.buffer_consumed(),
                     std::move(release_buffer));
                 tracepoint(
                     mir_server_wayland,
@@ -392,6 +441,7 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
             }
 
             stream->submit_buffer(mir_buffer);
+
             auto const new_buffer_size = stream->stream_size();
 
             if (!input_shape && std::make_optional(new_buffer_size) != buffer_size_)
@@ -402,9 +452,12 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
             buffer_size_ = new_buffer_size;
         }
     }
-    else
+
+    frame_callbacks.commit(std::move(callbacks), new_buffer, can_be_seen());
+    if (state.buffer && !new_buffer)
     {
-        frame_callback_executor->spawn(std::move(executor_send_frame_callbacks));
+        // There's nothing left to composite
+        frame_callbacks.send_all();
     }
 
     for (WlSubsurface* child: children)
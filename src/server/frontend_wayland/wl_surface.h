@@ -21,6 +21,7 @@
 #include "mir/wayland/weak.h"
 
 #include "wl_surface_role.h"
+#include "frame_callback_pacer.h"
 
 #include "mir/geometry/displacement.h"
 #include "mir/geometry/size.h"
@@ -107,6 +108,7 @@ public:
     WlSurface(wl_resource* new_resource,
               std::shared_ptr<mir::Executor> const& wayland_executor,
               std::shared_ptr<mir::Executor> const& frame_callback_executor,
+              std::shared_ptr<mir::Executor> const& hidden_frame_callback_executor,
               std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator);
 
     ~WlSurface();
@@ -145,7 +147,6 @@ public:
 private:
     std::shared_ptr<mir::graphics::GraphicBufferAllocator> const allocator;
     std::shared_ptr<mir::Executor> const wayland_executor;
-    std::shared_ptr<mir::Executor> const frame_callback_executor;
 
     NullWlSurfaceRole null_role;
     WlSurfaceRole* role;
@@ -154,11 +155,16 @@ private:
     WlSurfaceState pending;
     geometry::Displacement offset_;
     std::optional<geometry::Size> buffer_size_;
-    std::vector<wayland::Weak<WlSurfaceState::Callback>> frame_callbacks;
+    FrameCallbackPacer frame_callbacks;
     std::optional<std::vector<mir::geometry::Rectangle>> input_shape;
     std::vector<SceneSurfaceCreatedCallback> scene_surface_created_callbacks;
 
-    void send_frame_callbacks();
+    /// Sends parked frame callbacks as soon as the window can be seen again
+    class VisibilityObserver;
+    std::shared_ptr<VisibilityObserver> const visibility_observer;
+    std::weak_ptr<scene::Surface> observed_scene_surface;
+
+    auto can_be_seen() const -> bool;
 
     void attach(std::optional<wl_resource*> const& buffer, int32_t x, int32_t y) override;
     void damage(int32_t x, int32_t y, int32_t width, int32_t height) override;
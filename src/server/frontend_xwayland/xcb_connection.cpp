@@ -30,6 +30,8 @@ namespace geom = mir::geometry;
 
 namespace
 {
+thread_local unsigned int last_property_request{0};
+
 template<typename T, typename U = T>
 auto data_buffer_to_debug_string(
     T* data,
@@ -160,6 +162,7 @@ mf::XCBConnection::Atom::Atom(std::string const& name, XCBConnection* connection
       name_{name},
       cookie{xcb_intern_atom(*connection, 0, name_.size(), name_.c_str())}
 {
+    connection->atoms.push_back(this);
 }
 
 mf::XCBConnection::Atom::operator xcb_atom_t() const
@@ -190,6 +193,12 @@ mf::XCBConnection::XCBConnection(Fd const& fd)
       xcb_screen{xcb_setup_roots_iterator(xcb_get_setup(xcb_connection)).data},
       atom_name_cache{{XCB_ATOM_NONE, "None/Any"}}
 {
+    // All the atoms were requested as they were constructed, so this waits for a single round trip rather than one
+    // per atom, and later uses never need to block on the X server
+    for (auto const atom : atoms)
+    {
+        static_cast<void>(static_cast<xcb_atom_t>(*atom));
+    }
 }
 
 mf::XCBConnection::~XCBConnection()
@@ -207,7 +216,7 @@ void mf::XCBConnection::verify_not_in_error_state() const
 
 auto mf::XCBConnection::query_name(xcb_atom_t atom) const -> std::string
 {
-    std::lock_guard{atom_name_cache_mutex};
+    std::lock_guard lock{atom_name_cache_mutex};
     auto const iter = atom_name_cache.find(atom);
 
     if (iter == atom_name_cache.end())
@@ -267,6 +276,16 @@ bool mf::XCBConnection::is_ours(uint32_t id) const
     return (id & ~setup->resource_id_mask) == setup->resource_id_base;
 }
 
+auto mf::XCBConnection::last_read_property_sequence() const -> unsigned int
+{
+    return last_property_request;
+}
+
+void mf::XCBConnection::discard_reply(unsigned int sequence) const
+{
+    xcb_discard_reply(xcb_connection, sequence);
+}
+
 auto mf::XCBConnection::read_property(
     xcb_window_t window,
     xcb_atom_t prop,
@@ -282,6 +301,7 @@ auto mf::XCBConnection::read_property(
         XCB_ATOM_ANY,
         0, // no offset
         max_length);
+    last_property_request = cookie.sequence;
 
     return [this, cookie, handler=std::move(handler), window, prop]()
         {
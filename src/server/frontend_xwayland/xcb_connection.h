@@ -156,6 +156,12 @@ public:
     /// If the window was created by us
     auto is_ours(xcb_window_t window) const -> bool;
 
+    /// The sequence number of the last read_property() request sent by the calling thread
+    auto last_read_property_sequence() const -> unsigned int;
+
+    /// Drops the reply to a request that will never be waited for, so XCB can free it
+    void discard_reply(unsigned int sequence) const;
+
     /// Read a single property of various types from the window
     /// Returns a function that will wait on the reply before calling action()
     /// @{
@@ -265,6 +271,11 @@ public:
     auto error_debug_string(xcb_generic_error_t* error) const -> std::string;
     /// @}
 
+private:
+    /// Every atom declared below, so they can all be looked up at once
+    std::vector<Atom const*> atoms;
+
+public:
 #define DECLARE_ATOM(name) Atom const name{#name, this}
 
     DECLARE_ATOM(WM_PROTOCOLS);
@@ -401,6 +401,12 @@ mf::XWaylandSurface::XWaylandSurface(
 mf::XWaylandSurface::~XWaylandSurface()
 {
     close();
+
+    // Drop any replies that were never needed, without waiting for them or running their handlers
+    for (auto const& [property, reply] : prefetched_replies)
+    {
+        connection->discard_reply(reply.sequence);
+    }
 }
 
 void mf::XWaylandSurface::map()
@@ -425,7 +431,10 @@ void mf::XWaylandSurface::map()
             }
         });
 
-    // If we had more properties to read we would queue them all up before completing the first one
+    // Request everything attach_wl_surface() will need in the same flush, so it doesn't wait on a round trip of
+    // its own once the client associates a wl_surface
+    prefetch_properties();
+
     cookie();
 
     uint32_t const workspace = 1;
@@ -630,6 +639,12 @@ void mf::XWaylandSurface::wm_change_state_client_message(uint32_t const (&data)[
 
 void mf::XWaylandSurface::property_notify(xcb_atom_t property)
 {
+    // A reply to a request sent before the change must be processed first, so it can't overwrite the new value
+    if (auto const stale_reply = take_prefetched_reply(property))
+    {
+        stale_reply.value()();
+    }
+
     auto const handler = property_handlers.find(property);
     if (handler != property_handlers.end())
     {
@@ -680,28 +695,15 @@ void mf::XWaylandSurface::attach_wl_surface(WlSurface* wl_surface)
 
     std::vector<std::function<void()>> reply_functions;
 
-    // Read all properties
+    // Read all properties, reusing any requests already sent by map()
     for (auto const& handler : property_handlers)
     {
-        reply_functions.push_back(handler.second());
+        auto prefetched = take_prefetched_reply(handler.first);
+        reply_functions.push_back(prefetched ? std::move(prefetched.value()) : handler.second());
     }
 
-    std::shared_ptr<XWaylandClientManager::Session> local_client_session;
-    std::shared_ptr<ms::Session> session;
-    reply_functions.push_back(connection->read_property(
-        window, connection->_NET_WM_PID,
-        XCBConnection::Handler<uint32_t>{
-            [&](uint32_t pid)
-            {
-                local_client_session = client_manager->session_for_client(pid);
-                session = local_client_session->session();
-            },
-            [&](std::string const&)
-            {
-                log_warning("X11 app did not set _NET_WM_PID, grouping it under the default XWayland application");
-                session = get_session(wl_surface->resource);
-            }
-        }));
+    auto prefetched_pid = take_prefetched_reply(connection->_NET_WM_PID);
+    reply_functions.push_back(prefetched_pid ? std::move(prefetched_pid.value()) : read_net_wm_pid());
 
     // Wait for and process all the XCB replies
     for (auto const& reply_function : reply_functions)
@@ -709,6 +711,25 @@ void mf::XWaylandSurface::attach_wl_surface(WlSurface* wl_surface)
         reply_function();
     }
 
+    std::optional<uint32_t> net_wm_pid;
+    {
+        std::lock_guard lock{mutex};
+        net_wm_pid = cached.net_wm_pid;
+    }
+
+    std::shared_ptr<XWaylandClientManager::Session> local_client_session;
+    std::shared_ptr<ms::Session> session;
+    if (net_wm_pid)
+    {
+        local_client_session = client_manager->session_for_client(net_wm_pid.value());
+        session = local_client_session->session();
+    }
+    else
+    {
+        log_warning("X11 app did not set _NET_WM_PID, grouping it under the default XWayland application");
+        session = get_session(wl_surface->resource);
+    }
+
     if (!session)
     {
         fatal_error("Property handlers did not set a valid session");
@@ -1426,3 +1447,62 @@ auto mf::XWaylandSurface::XWaylandSurfaceObserverManager::try_get_resize_event()
         return std::shared_ptr<MirInputEvent const>{};
     }
 }
+
+void mf::XWaylandSurface::prefetch_properties()
+{
+    std::lock_guard lock{prefetched_replies_mutex};
+
+    // A request still outstanding from an earlier map() is as good as a new one: had the property changed since,
+    // property_notify() would have consumed it
+    for (auto const& handler : property_handlers)
+    {
+        if (!prefetched_replies.contains(handler.first))
+        {
+            auto complete = handler.second();
+            prefetched_replies.emplace(
+                handler.first,
+                PrefetchedReply{std::move(complete), connection->last_read_property_sequence()});
+        }
+    }
+
+    if (!prefetched_replies.contains(connection->_NET_WM_PID))
+    {
+        auto complete = read_net_wm_pid();
+        prefetched_replies.emplace(
+            connection->_NET_WM_PID,
+            PrefetchedReply{std::move(complete), connection->last_read_property_sequence()});
+    }
+}
+
+auto mf::XWaylandSurface::take_prefetched_reply(xcb_atom_t property) -> std::optional<std::function<void()>>
+{
+    std::lock_guard lock{prefetched_replies_mutex};
+
+    auto const iter = prefetched_replies.find(property);
+    if (iter == prefetched_replies.end())
+    {
+        return std::nullopt;
+    }
+
+    auto reply = std::move(iter->second.complete);
+    prefetched_replies.erase(iter);
+    return reply;
+}
+
+auto mf::XWaylandSurface::read_net_wm_pid() -> std::function<void()>
+{
+    return connection->read_property(
+        window, connection->_NET_WM_PID,
+        XCBConnection::Handler<uint32_t>{
+            [this](uint32_t pid)
+            {
+                std::lock_guard lock{mutex};
+                cached.net_wm_pid = pid;
+            },
+            [this](std::string const&)
+            {
+                std::lock_guard lock{mutex};
+                cached.net_wm_pid = std::nullopt;
+            }
+        });
+}
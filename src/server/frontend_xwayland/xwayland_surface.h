@@ -184,6 +184,16 @@ private:
     /// Appplies any mods in nullable_pending_spec to the scene_surface (if any)
     void apply_any_mods_to_scene_surface();
 
+    /// Sends the requests for everything attach_wl_surface() reads, so the replies are in flight while the client
+    /// associates a wl_surface
+    void prefetch_properties();
+
+    /// Removes and returns the reply function for a prefetched property, if there is one
+    auto take_prefetched_reply(xcb_atom_t property) -> std::optional<std::function<void()>>;
+
+    /// Reads _NET_WM_PID into cached.net_wm_pid
+    auto read_net_wm_pid() -> std::function<void()>;
+
     /// Unlike with scaled Wayland surfaces, all the data going to and from the client is in raw pixels. Mir internally
     /// deals with scaled coordinates. This means before modifying the Mir surface we need to scale the values in our
     /// surface spec. We also need to convert from global to local coordinates if the surface has a parent. This
@@ -243,8 +253,21 @@ private:
 
         xcb_window_t transient_for{XCB_WINDOW_NONE};
         std::vector<xcb_atom_t> wm_types;
+
+        /// The _NET_WM_PID set by the client, or nullopt if it didn't set one
+        std::optional<uint32_t> net_wm_pid;
     } cached;
 
+    /// A request sent by prefetch_properties() that has not been processed yet
+    struct PrefetchedReply
+    {
+        std::function<void()> complete;
+        /// So the reply can be discarded if it is never needed
+        unsigned int sequence;
+    };
+    std::mutex prefetched_replies_mutex;
+    std::map<xcb_atom_t, PrefetchedReply> prefetched_replies;
+
     /// When we send a configure we push it to the back, when we get notified of a configure we pop it and all the ones
     /// before it
     std::deque<geometry::Rectangle> inflight_configures;
@@ -123,12 +123,27 @@ mir::detail::GMainContextHandle::operator GMainContext*() const
 
 mir::GLibMainLoop::GLibMainLoop(
     std::shared_ptr<time::Clock> const& clock)
+    : GLibMainLoop(clock, AlarmStrategy::gsource_per_alarm)
+{
+}
+
+mir::GLibMainLoop::GLibMainLoop(
+    std::shared_ptr<time::Clock> const& clock,
+    AlarmStrategy alarm_strategy)
     : clock{clock},
       running_{false},
+      timer_wheel{alarm_strategy == AlarmStrategy::timer_wheel ?
+          std::make_unique<time::TimerWheel>(clock, [this] { handle_exception(std::current_exception()); }) :
+          nullptr},
       fd_sources{main_context},
       signal_sources{fd_sources},
       before_iteration_hook{[]{}}
 {
+    if (timer_wheel)
+    {
+        fd_sources.add(timer_wheel->watch_fd(), timer_wheel.get(),
+            [this] (int) { timer_wheel->dispatch(dispatch::FdEvent::readable); });
+    }
 }
 
 void mir::GLibMainLoop::run()
@@ -340,6 +355,9 @@ std::unique_ptr<mir::time::Alarm> mir::GLibMainLoop::create_alarm(
 std::unique_ptr<mir::time::Alarm> mir::GLibMainLoop::create_alarm(
     std::unique_ptr<LockableCallback> callback)
 {
+    if (timer_wheel)
+        return timer_wheel->create_alarm(std::move(callback));
+
     auto const exception_hander =
         [this]
         {
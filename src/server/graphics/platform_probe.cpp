@@ -15,21 +15,44 @@
  */
 
 #include "mir/log.h"
+#include "mir/console_services.h"
 #include "mir/graphics/platform.h"
 #include "platform_probe.h"
+#include "mir/raii.h"
 
 #include <boost/throw_exception.hpp>
 
+#include <condition_variable>
+#include <future>
+#include <mutex>
+
 namespace mg = mir::graphics;
 
 namespace
 {
+enum class ModuleType
+{
+    Rendering,
+    Display
+};
+
 auto probe_module(
-    mir::graphics::PlatformProbe const& probe,
+    ModuleType type,
     mir::SharedLibrary& module,
-    char const* platform_type_name,
     mir::options::ProgramOption const& options,
     std::shared_ptr<mir::ConsoleServices> const& console) -> std::vector<mg::SupportedDevice>
+{
+    auto const probe = module.load_function<mir::graphics::PlatformProbe>(
+        type == ModuleType::Display ? "probe_display_platform" : "probe_rendering_platform",
+        MIR_SERVER_GRAPHICS_PLATFORM_VERSION);
+
+    return probe(console, std::make_shared<mir::udev::Context>(), options);
+}
+
+void log_probe_result(
+    ModuleType type,
+    mir::SharedLibrary& module,
+    std::vector<mg::SupportedDevice> const& supported_devices)
 {
     auto describe = module.load_function<mir::graphics::DescribeModule>(
         "describe_graphics_module",
@@ -37,13 +60,12 @@ auto probe_module(
 
     auto desc = describe();
     mir::log_info("Found %s driver: %s (version %d.%d.%d)",
-                  platform_type_name,
+                  type == ModuleType::Display ? "display" : "rendering",
                   desc->name,
                   desc->major_version,
                   desc->minor_version,
                   desc->micro_version);
 
-    auto supported_devices = probe(console, std::make_shared<mir::udev::Context>(), options);
     if (supported_devices.empty())
     {
         mir::log_info("(Unsupported by system environment)");
@@ -70,7 +92,6 @@ auto probe_module(
             mir::log_info("\t%s (priority %i)", device_name.c_str(), device.support_level);
         }
     }
-    return supported_devices;
 }
 }
 
@@ -79,14 +100,9 @@ auto mir::graphics::probe_display_module(
     options::ProgramOption const& options,
     std::shared_ptr<ConsoleServices> const& console) -> std::vector<SupportedDevice>
 {
-    return probe_module(
-        module.load_function<mir::graphics::PlatformProbe>(
-            "probe_display_platform",
-            MIR_SERVER_GRAPHICS_PLATFORM_VERSION),
-        module,
-        "display",
-        options,
-        console);
+    auto supported_devices = probe_module(ModuleType::Display, module, options, console);
+    log_probe_result(ModuleType::Display, module, supported_devices);
+    return supported_devices;
 }
 
 auto mir::graphics::probe_rendering_module(
@@ -94,14 +110,9 @@ auto mir::graphics::probe_rendering_module(
     options::ProgramOption const& options,
     std::shared_ptr<ConsoleServices> const& console) -> std::vector<SupportedDevice>
 {
-    return probe_module(
-        module.load_function<mir::graphics::PlatformProbe>(
-            "probe_rendering_platform",
-            MIR_SERVER_GRAPHICS_PLATFORM_VERSION),
-        module,
-        "rendering",
-        options,
-        console);
+    auto supported_devices = probe_module(ModuleType::Rendering, module, options, console);
+    log_probe_result(ModuleType::Rendering, module, supported_devices);
+    return supported_devices;
 }
 
 namespace
@@ -121,10 +132,97 @@ bool is_same_device(
     return *a == *b;
 }
 
-enum class ModuleType
+/**
+ * Exclusive right to use the console while probing.
+ *
+ * Probes acquire devices through the console and hold them until they return; the console
+ * services only allow each device to be acquired once, and several modules probe the same
+ * DRM nodes. The right is released by whichever thread finished the probe, so this can't
+ * simply be a std::mutex.
+ */
+class ConsoleToken
 {
-    Rendering,
-    Display
+public:
+    void claim()
+    {
+        std::unique_lock lock{mutex};
+        available.wait(lock, [this]() { return !claimed; });
+        claimed = true;
+    }
+
+    void release()
+    {
+        {
+            std::lock_guard lock{mutex};
+            claimed = false;
+        }
+        available.notify_one();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable available;
+    bool claimed{false};
+};
+
+/**
+ * The console as seen by a single probe.
+ *
+ * The first device acquisition claims the ConsoleToken, so probes that use the console run one
+ * after another while those that don't still run concurrently.
+ */
+class ProbeConsole : public mir::ConsoleServices
+{
+public:
+    ProbeConsole(std::shared_ptr<mir::ConsoleServices> console, ConsoleToken& token)
+        : console{std::move(console)},
+          token{token}
+    {
+    }
+
+    /// Lets the next probe use the console; the devices this probe acquired have been released.
+    void probe_finished()
+    {
+        if (claimed)
+        {
+            claimed = false;
+            token.release();
+        }
+    }
+
+    void register_switch_handlers(
+        mir::graphics::EventHandlerRegister& handlers,
+        std::function<bool()> const& switch_away,
+        std::function<bool()> const& switch_back) override
+    {
+        console->register_switch_handlers(handlers, switch_away, switch_back);
+    }
+
+    void restore() override
+    {
+        console->restore();
+    }
+
+    auto create_vt_switcher() -> std::unique_ptr<mir::VTSwitcher> override
+    {
+        return console->create_vt_switcher();
+    }
+
+    auto acquire_device(int major, int minor, std::unique_ptr<mir::Device::Observer> observer)
+        -> std::future<std::unique_ptr<mir::Device>> override
+    {
+        if (!claimed)
+        {
+            token.claim();
+            claimed = true;
+        }
+        return console->acquire_device(major, minor, std::move(observer));
+    }
+
+private:
+    std::shared_ptr<mir::ConsoleServices> const console;
+    ConsoleToken& token;
+    bool claimed{false};
 };
 
 auto modules_for_device(
@@ -134,21 +232,43 @@ auto modules_for_device(
     std::shared_ptr<mir::ConsoleServices> const& console)
 -> std::vector<std::pair<mg::SupportedDevice, std::shared_ptr<mir::SharedLibrary>>>
 {
+    /* Probing a module can involve opening devices and initialising EGL, which can take a
+     * significant part of startup, and the modules don't depend on each other. So probe them
+     * all concurrently, then consider the results in order, exactly as if probed one by one.
+     *
+     * The exception is the console: the devices a probe acquires are held until it returns,
+     * and can't be acquired by another probe meanwhile, so probes using it take turns.
+     */
+    ConsoleToken console_token;
+    std::vector<std::future<std::vector<mg::SupportedDevice>>> probes;
+    for (auto const& module : modules)
+    {
+        probes.push_back(
+            std::async(
+                std::launch::async,
+                [type, module, &options, &console, &console_token]()
+                {
+                    if (!console)
+                    {
+                        return probe_module(type, *module, options, console);
+                    }
+
+                    auto const probe_console = std::make_shared<ProbeConsole>(console, console_token);
+                    auto const finished = mir::raii::paired_calls(
+                        []() {},
+                        [&probe_console]() { probe_console->probe_finished(); });
+                    return probe_module(type, *module, options, probe_console);
+                }));
+    }
+
     std::vector<std::pair<mg::SupportedDevice, std::shared_ptr<mir::SharedLibrary>>> best_modules_so_far;
-    for (auto& module : modules)
+    for (size_t i = 0; i != modules.size(); ++i)
     {
+        auto const& module = modules[i];
         try
         {
-            std::vector<mg::SupportedDevice> supported_devices;
-            switch (type)
-            {
-            case ModuleType::Rendering:
-                supported_devices = mg::probe_rendering_module(*module, options, console);
-                break;
-            case ModuleType::Display:
-                supported_devices = mg::probe_display_module(*module, options, console);
-                break;
-            }
+            auto supported_devices = probes[i].get();
+            log_probe_result(type, *module, supported_devices);
             for (auto& device : supported_devices)
             {
                 if (device.device)
@@ -21,6 +21,7 @@
 #include "lttng_report_factory.h"
 #include "logging_report_factory.h"
 #include "null_report_factory.h"
+#include "../compositor/frame_statistics_report.h"
 
 #include "mir/abnormal_exit.h"
 
@@ -64,7 +65,10 @@ auto mir::DefaultServerConfiguration::the_compositor_report() -> std::shared_ptr
     return compositor_report(
         [this]()->std::shared_ptr<mc::CompositorReport>
         {
-            return report_factory(options::compositor_report_opt)->create_compositor_report();
+            // Frame statistics are always collected, whichever report is selected
+            return std::make_shared<mc::FrameStatisticsReport>(
+                report_factory(options::compositor_report_opt)->create_compositor_report(),
+                the_clock());
         });
 }
 
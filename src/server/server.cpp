@@ -32,6 +32,7 @@
 #include "mir/report_exception.h"
 #include "mir/run_mir.h"
 #include "mir/cookie/authority.h"
+#include "mir/compositor/frame_statistics.h"
 
 // TODO these are used to frig a stub renderer when running headless
 #include "mir/renderer/renderer.h"
@@ -562,6 +563,12 @@ FOREACH_WRAPPER(MIR_SERVER_WRAP)
 
 #undef MIR_SERVER_WRAP
 
+auto mir::Server::the_frame_statistics() const -> std::shared_ptr<compositor::FrameStatistics>
+{
+    verify_accessing_allowed(self->server_config);
+    return std::dynamic_pointer_cast<compositor::FrameStatistics>(self->server_config->the_compositor_report());
+}
+
 auto mir::Server::the_composite_event_filter() const -> decltype(self->server_config->the_composite_event_filter())
 {
     if (self->server_config)
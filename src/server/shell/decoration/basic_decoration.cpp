@@ -115,7 +115,9 @@ public:
 
     auto create_buffer_stream() -> std::shared_ptr<mc::BufferStream>;
 
-    std::shared_ptr<mc::BufferStream> const titlebar;
+    std::shared_ptr<mc::BufferStream> const titlebar;       ///< Background only, stretched over the titlebar
+    std::shared_ptr<mc::BufferStream> const title;
+    std::shared_ptr<mc::BufferStream> const buttons;
     std::shared_ptr<mc::BufferStream> const left_border;
     std::shared_ptr<mc::BufferStream> const right_border;
     std::shared_ptr<mc::BufferStream> const bottom_border;
@@ -129,6 +131,8 @@ private:
 msd::BasicDecoration::BufferStreams::BufferStreams(std::shared_ptr<scene::Session> const& session)
     : session{session},
       titlebar{create_buffer_stream()},
+      title{create_buffer_stream()},
+      buttons{create_buffer_stream()},
       left_border{create_buffer_stream()},
       right_border{create_buffer_stream()},
       bottom_border{create_buffer_stream()}
@@ -138,6 +142,8 @@ msd::BasicDecoration::BufferStreams::BufferStreams(std::shared_ptr<scene::Sessio
 msd::BasicDecoration::BufferStreams::~BufferStreams()
 {
     session->destroy_buffer_stream(titlebar);
+    session->destroy_buffer_stream(title);
+    session->destroy_buffer_stream(buttons);
     session->destroy_buffer_stream(left_border);
     session->destroy_buffer_stream(right_border);
     session->destroy_buffer_stream(bottom_border);
@@ -261,8 +267,7 @@ void msd::BasicDecoration::request_close()
 void msd::BasicDecoration::set_cursor(std::string const& cursor_image_name)
 {
     msh::SurfaceSpecification spec;
-    // size is hard-coded because current implementation ignores it
-    spec.cursor_image = cursor_images->image(cursor_image_name, {16, 16});
+    spec.cursor_image = cursor_images->image(cursor_image_name, mir::input::default_cursor_size);
     shell->modify_surface(session, decoration_surface, spec);
 }
 
@@ -313,6 +318,19 @@ void msd::BasicDecoration::update(
             as_delta(window_state->side_border_width()));
     }
 
+    auto const previous_title_rect = renderer->title_rect();
+    auto const previous_buttons_rect = renderer->buttons_rect();
+
+    if (window_updated({
+            &WindowState::focused_state,
+            &WindowState::window_name,
+            &WindowState::titlebar_rect}) ||
+        input_updated({
+            &InputState::buttons}))
+    {
+        renderer->update_state(*window_state, *input_state);
+    }
+
     msh::SurfaceSpecification spec;
 
     if (window_updated({
@@ -333,7 +351,9 @@ void msd::BasicDecoration::update(
             &WindowState::titlebar_rect,
             &WindowState::left_border_rect,
             &WindowState::right_border_rect,
-            &WindowState::bottom_border_rect}))
+            &WindowState::bottom_border_rect}) ||
+        renderer->title_rect() != previous_title_rect ||
+        renderer->buttons_rect() != previous_buttons_rect)
     {
         spec.streams = std::vector<StreamSpecification>{};
         auto const emplace = [&](std::shared_ptr<mc::BufferStream> stream, geom::Rectangle rect)
@@ -341,17 +361,23 @@ void msd::BasicDecoration::update(
                 if (rect.size.width > geom::Width{} && rect.size.height > geom::Height{})
                     spec.streams.value().emplace_back(StreamSpecification{stream, as_displacement(rect.top_left), rect.size});
             };
+        auto const emplace_titlebar = [&]()
+            {
+                emplace(buffer_streams->titlebar, window_state->titlebar_rect());
+                emplace(buffer_streams->title, renderer->title_rect());
+                emplace(buffer_streams->buttons, renderer->buttons_rect());
+            };
 
         switch (window_state->border_type())
         {
         case BorderType::Full:
-            emplace(buffer_streams->titlebar, window_state->titlebar_rect());
+            emplace_titlebar();
             emplace(buffer_streams->left_border, window_state->left_border_rect());
             emplace(buffer_streams->right_border, window_state->right_border_rect());
             emplace(buffer_streams->bottom_border, window_state->bottom_border_rect());
             break;
         case BorderType::Titlebar:
-            emplace(buffer_streams->titlebar, window_state->titlebar_rect());
+            emplace_titlebar();
             break;
         case BorderType::None:
             break;
@@ -363,57 +389,27 @@ void msd::BasicDecoration::update(
         shell->modify_surface(session, decoration_surface, spec);
     }
 
-    if (window_updated({
-            &WindowState::focused_state,
-            &WindowState::window_name,
-            &WindowState::titlebar_rect,
-            &WindowState::left_border_rect,
-            &WindowState::right_border_rect,
-            &WindowState::bottom_border_rect}) ||
-        input_updated({
-            &InputState::buttons}))
-    {
-        renderer->update_state(*window_state, *input_state);
-    }
-
     std::vector<std::pair<
         std::shared_ptr<mc::BufferStream>,
         std::optional<std::shared_ptr<mg::Buffer>>>> new_buffers;
 
+    // The solid color buffers are stretched to size by the compositor, so only need replacing when the color changes
     if (window_updated({
-            &WindowState::focused_state,
-            &WindowState::side_border_width,
-            &WindowState::side_border_height}))
-    {
-        new_buffers.emplace_back(
-            buffer_streams->left_border,
-            renderer->render_left_border());
-        new_buffers.emplace_back(
-            buffer_streams->right_border,
-            renderer->render_right_border());
-    }
-
-    if (window_updated({
-            &WindowState::focused_state,
-            &WindowState::bottom_border_width,
-            &WindowState::bottom_border_height}))
+            &WindowState::focused_state}))
     {
-        new_buffers.emplace_back(
-            buffer_streams->bottom_border,
-            renderer->render_bottom_border());
+        for (auto const& stream : {
+                buffer_streams->titlebar,
+                buffer_streams->left_border,
+                buffer_streams->right_border,
+                buffer_streams->bottom_border})
+        {
+            new_buffers.emplace_back(stream, renderer->render_solid_color());
+        }
     }
 
-    if (window_updated({
-            &WindowState::focused_state,
-            &WindowState::window_name,
-            &WindowState::titlebar_rect}) ||
-        input_updated({
-            &InputState::buttons}))
-    {
-        new_buffers.emplace_back(
-            buffer_streams->titlebar,
-            renderer->render_titlebar());
-    }
+    // These are nullopt unless the content has changed
+    new_buffers.emplace_back(buffer_streams->title, renderer->render_title());
+    new_buffers.emplace_back(buffer_streams->buttons, renderer->render_buttons());
 
     for (auto const& pair : new_buffers)
     {
@@ -29,8 +29,11 @@
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
+#include <algorithm>
+#include <atomic>
 #include <locale>
 #include <codecvt>
+#include <shared_mutex>
 
 namespace ms = mir::scene;
 namespace mg = mir::graphics;
@@ -59,6 +62,9 @@ uint32_t const default_close_normal_button  = color(0xA0, 0x20, 0x20);
 uint32_t const default_close_active_button  = color(0xC0, 0x60, 0x60);
 uint32_t const default_button_icon          = color(0xFF, 0xFF, 0xFF);
 
+/// Enough for the characters of many titles at a couple of sizes, at a few hundred bytes each
+size_t const default_glyph_cache_capacity{512};
+
 /// Font search logic should be kept in sync with examples/example-server-lib/wallpaper_config.cpp
 auto default_font() -> std::string
 {
@@ -201,7 +207,7 @@ class msd::Renderer::Text::Impl
     : public Text
 {
 public:
-    Impl();
+    explicit Impl(size_t glyph_cache_capacity);
     ~Impl();
 
     void render(
@@ -212,17 +218,56 @@ public:
         geom::Height height_pixels,
         Pixel color) override;
 
+    auto width(std::string const& text, geom::Height height_pixels) -> geom::Width override;
+
 private:
-    std::mutex mutex;
+    /// A rasterized glyph, ready to be blended into a buffer
+    struct Glyph
+    {
+        std::vector<unsigned char> coverage;    ///< rows * width alpha values
+        int width;
+        int rows;
+        geom::Displacement offset;              ///< From the top left of the text to the top left of the bitmap
+        geom::Displacement advance;             ///< From this glyph to the next one
+    };
+
+    using GlyphKey = std::pair<char32_t, int>;  ///< (character, pixel height)
+
+    struct CachedGlyph
+    {
+        CachedGlyph(std::shared_ptr<Glyph const> glyph, uint64_t last_used)
+            : glyph{std::move(glyph)},
+              last_used{last_used}
+        {
+        }
+
+        std::shared_ptr<Glyph const> const glyph;   ///< nullptr if the glyph can not be rendered
+        std::atomic<uint64_t> last_used;
+    };
+
+    /// Guards library and face, as FreeType objects can only be used by one thread at a time
+    std::mutex freetype_mutex;
     FT_Library library;
     FT_Face face;
 
+    /// Glyphs are shared with the titles being drawn, so evicting one doesn't disturb a concurrent render
+    size_t const glyph_cache_capacity;
+    std::shared_mutex glyphs_mutex;
+    std::map<GlyphKey, CachedGlyph> glyphs;
+    std::atomic<uint64_t> glyph_use_count{0};
+
+    /// Returns nullptr if the glyph can not be rendered
+    auto glyph(char32_t character, geom::Height height) -> std::shared_ptr<Glyph const>;
+    auto cached_glyph(GlyphKey const& key) -> std::optional<std::shared_ptr<Glyph const>>;
+    void cache_glyph_locked(GlyphKey const& key, std::shared_ptr<Glyph const> const& glyph);
+    auto rasterize_glyph_locked(char32_t character, geom::Height height) -> std::shared_ptr<Glyph const>;
+
     void set_char_size(geom::Height height);
     void rasterize_glyph(char32_t glyph);
     void render_glyph(
         Pixel* buf,
         geom::Size buf_size,
-        FT_Bitmap const* glyph,
+        Glyph const& glyph,
         geom::Point top_left,
         Pixel color);
 
@@ -244,6 +289,11 @@ public:
     {
     }
 
+    auto width(std::string const&, geom::Height) -> geom::Width override
+    {
+        return {};
+    }
+
 private:
 };
 
@@ -256,21 +306,27 @@ auto msd::Renderer::Text::instance() -> std::shared_ptr<Text>
     auto shared = singleton.lock();
     if (!shared)
     {
-        try
-        {
-            shared = std::make_shared<Impl>();
-        }
-        catch (std::runtime_error const& error)
-        {
-            log_warning("%s", error.what());
-            shared = std::make_shared<Null>();
-        }
+        shared = create(default_glyph_cache_capacity);
         singleton = shared;
     }
     return shared;
 }
 
-msd::Renderer::Text::Impl::Impl()
+auto msd::Renderer::Text::create(size_t glyph_cache_capacity) -> std::shared_ptr<Text>
+{
+    try
+    {
+        return std::make_shared<Impl>(glyph_cache_capacity);
+    }
+    catch (std::runtime_error const& error)
+    {
+        log_warning("%s", error.what());
+        return std::make_shared<Null>();
+    }
+}
+
+msd::Renderer::Text::Impl::Impl(size_t glyph_cache_capacity)
+    : glyph_cache_capacity{glyph_cache_capacity}
 {
     if (auto const error = FT_Init_FreeType(&library))
         BOOST_THROW_EXCEPTION(std::runtime_error(
@@ -310,48 +366,116 @@ void msd::Renderer::Text::Impl::render(
     if (!area(buf_size) || height_pixels <= geom::Height{})
         return;
 
-    std::lock_guard lock{mutex};
+    auto const utf32 = utf8_to_utf32(text);
 
-    if (!library || !face)
+    for (char32_t const character : utf32)
     {
-        log_warning("FreeType not initialized");
-        return;
+        if (auto const glyph = this->glyph(character, height_pixels))
+        {
+            render_glyph(buf, buf_size, *glyph, top_left + glyph->offset, color);
+            top_left += glyph->advance;
+        }
     }
+}
 
+auto msd::Renderer::Text::Impl::width(std::string const& text, geom::Height height_pixels) -> geom::Width
+{
+    if (height_pixels <= geom::Height{})
+        return {};
+
+    geom::DeltaX width{};
+    for (char32_t const character : utf8_to_utf32(text))
+    {
+        if (auto const glyph = this->glyph(character, height_pixels))
+            width += glyph->advance.dx;
+    }
+    return as_width(width);
+}
+
+auto msd::Renderer::Text::Impl::glyph(char32_t character, geom::Height height) -> std::shared_ptr<Glyph const>
+{
+    GlyphKey const key{character, height.as_int()};
+
+    if (auto const cached = cached_glyph(key))
+        return *cached;
+
+    std::lock_guard freetype_lock{freetype_mutex};
+
+    // Another thread may have rasterized it while we waited
+    if (auto const cached = cached_glyph(key))
+        return *cached;
+
+    std::shared_ptr<Glyph const> glyph;
     try
     {
-        set_char_size(height_pixels);
+        glyph = rasterize_glyph_locked(character, height);
     }
     catch (std::runtime_error const& error)
     {
         log_warning("%s", error.what());
+    }
+
+    cache_glyph_locked(key, glyph);
+    return glyph;
+}
+
+auto msd::Renderer::Text::Impl::cached_glyph(GlyphKey const& key) -> std::optional<std::shared_ptr<Glyph const>>
+{
+    std::shared_lock lock{glyphs_mutex};
+    if (auto const i = glyphs.find(key); i != glyphs.end())
+    {
+        i->second.last_used = ++glyph_use_count;
+        return i->second.glyph;
+    }
+    return std::nullopt;
+}
+
+void msd::Renderer::Text::Impl::cache_glyph_locked(GlyphKey const& key, std::shared_ptr<Glyph const> const& glyph)
+{
+    if (glyph_cache_capacity == 0)
         return;
+
+    std::lock_guard lock{glyphs_mutex};
+
+    if (glyphs.size() >= glyph_cache_capacity)
+    {
+        // Only done on a miss with a full cache, so a linear search for the least recently used is fine
+        auto const lru = std::min_element(
+            glyphs.begin(),
+            glyphs.end(),
+            [](auto const& a, auto const& b) { return a.second.last_used < b.second.last_used; });
+        glyphs.erase(lru);
     }
 
-    auto const utf32 = utf8_to_utf32(text);
+    glyphs.try_emplace(key, glyph, ++glyph_use_count);
+}
+
+auto msd::Renderer::Text::Impl::rasterize_glyph_locked(char32_t character, geom::Height height)
+    -> std::shared_ptr<Glyph const>
+{
+    if (!library || !face)
+        BOOST_THROW_EXCEPTION(std::runtime_error("FreeType not initialized"));
 
-    for (char32_t const glyph : utf32)
+    set_char_size(height);
+    rasterize_glyph(character);
+
+    FT_GlyphSlot const slot = face->glyph;
+    FT_Bitmap const& bitmap = slot->bitmap;
+    int const width = bitmap.width;
+    int const rows = bitmap.rows;
+
+    std::vector<unsigned char> coverage(width * rows);
+    for (int y = 0; y < rows; y++)
     {
-        try
-        {
-            rasterize_glyph(glyph);
-
-            geom::Point glyph_top_left =
-                top_left +
-                geom::Displacement{
-                    face->glyph->bitmap_left,
-                    height_pixels.as_int() - face->glyph->bitmap_top};
-            render_glyph(buf, buf_size, &face->glyph->bitmap, glyph_top_left, color);
-
-            top_left += geom::Displacement{
-                face->glyph->advance.x / 64,
-                face->glyph->advance.y / 64};
-        }
-        catch (std::runtime_error const& error)
-        {
-            log_warning("%s", error.what());
-        }
+        std::copy_n(bitmap.buffer + y * bitmap.pitch, width, coverage.data() + y * width);
     }
+
+    return std::make_shared<Glyph const>(Glyph{
+        std::move(coverage),
+        width,
+        rows,
+        geom::Displacement{slot->bitmap_left, height.as_int() - slot->bitmap_top},
+        geom::Displacement{slot->advance.x / 64, slot->advance.y / 64}});
 }
 
 void msd::Renderer::Text::Impl::set_char_size(geom::Height height)
@@ -377,15 +501,15 @@ void msd::Renderer::Text::Impl::rasterize_glyph(char32_t glyph)
 void msd::Renderer::Text::Impl::render_glyph(
     Pixel* buf,
     geom::Size buf_size,
-    FT_Bitmap const* glyph,
+    Glyph const& glyph,
     geom::Point top_left,
     Pixel color)
 {
     geom::X const buffer_left = std::max(top_left.x, geom::X{});
-    geom::X const buffer_right = std::min(top_left.x + geom::DeltaX{glyph->width}, as_x(buf_size.width));
+    geom::X const buffer_right = std::min(top_left.x + geom::DeltaX{glyph.width}, as_x(buf_size.width));
 
     geom::Y const buffer_top = std::max(top_left.y, geom::Y{});
-    geom::Y const buffer_bottom = std::min(top_left.y + geom::DeltaY{glyph->rows}, as_y(buf_size.height));
+    geom::Y const buffer_bottom = std::min(top_left.y + geom::DeltaY{glyph.rows}, as_y(buf_size.height));
 
     geom::Displacement const glyph_offset = as_displacement(top_left);
 
@@ -395,7 +519,7 @@ void msd::Renderer::Text::Impl::render_glyph(
     for (geom::Y buffer_y = buffer_top; buffer_y < buffer_bottom; buffer_y += geom::DeltaY{1})
     {
         geom::Y const glyph_y = buffer_y - glyph_offset.dy;
-        unsigned char* const glyph_row = glyph->buffer + glyph_y.as_int() * glyph->pitch;
+        unsigned char const* const glyph_row = glyph.coverage.data() + glyph_y.as_int() * glyph.width;
         Pixel* const buffer_row = buf + buffer_y.as_int() * buf_size.width.as_int();
 
         for (geom::X buffer_x = buffer_left; buffer_x < buffer_right; buffer_x += geom::DeltaX{1})
@@ -479,27 +603,6 @@ msd::Renderer::Renderer(
 
 void msd::Renderer::update_state(WindowState const& window_state, InputState const& input_state)
 {
-    left_border_size = window_state.left_border_rect().size;
-    right_border_size = window_state.right_border_rect().size;
-    bottom_border_size = window_state.bottom_border_rect().size;
-
-    size_t length{0};
-    length = std::max(length, area(left_border_size));
-    length = std::max(length, area(right_border_size));
-    length = std::max(length, area(bottom_border_size));
-
-    if (length != solid_color_pixels_length)
-    {
-        solid_color_pixels_length = length;
-        solid_color_pixels.reset(); // force a reallocation next time it's needed
-    }
-
-    if (window_state.titlebar_rect().size != titlebar_size)
-    {
-        titlebar_size = window_state.titlebar_rect().size;
-        titlebar_pixels.reset(); // force a reallocation next time it's needed
-    }
-
     Theme const* const new_theme = (window_state.focused_state() != mir_window_focus_state_unfocused) ?
         &focused_theme :
         &unfocused_theme;
@@ -507,151 +610,158 @@ void msd::Renderer::update_state(WindowState const& window_state, InputState con
     if (new_theme != current_theme)
     {
         current_theme = new_theme;
-        needs_titlebar_redraw = true;
-        needs_solid_color_redraw = true;
+        needs_title_redraw = true;
+        needs_buttons_redraw = true;
     }
 
     if (window_state.window_name() != name)
     {
         name = window_state.window_name();
-        needs_titlebar_redraw = true;
+        name_width = text->width(name, static_geometry->title_font_height);
+        needs_title_redraw = true;
     }
 
-    if (input_state.buttons() != buttons)
+    // The buttons are drawn into a single buffer covering all of them, so moving them together
+    // (as happens when the window is resized) only moves the buffer
+    geom::Rectangle new_buttons_rect{};
+    if (!input_state.buttons().empty())
     {
-        // If the number of buttons or their location changed, redraw the whole titlebar
-        // Otherwise if the buttons are in the same place, just redraw them
-        if (input_state.buttons().size() != buttons.size())
+        geom::Point top_left = input_state.buttons().front().rect.top_left;
+        geom::Point bottom_right = input_state.buttons().front().rect.bottom_right();
+        for (auto const& button : input_state.buttons())
         {
-            needs_titlebar_redraw = true;
+            top_left = {std::min(top_left.x, button.rect.left()), std::min(top_left.y, button.rect.top())};
+            bottom_right = {std::max(bottom_right.x, button.rect.right()), std::max(bottom_right.y, button.rect.bottom())};
         }
-        else
-        {
-            for (unsigned i = 0; i < buttons.size(); i++)
-            {
-                if (input_state.buttons()[i].rect != buttons[i].rect)
-                    needs_titlebar_redraw = true;
-            }
-        }
-        buttons = input_state.buttons();
-        needs_titlebar_buttons_redraw = true;
+        new_buttons_rect = {top_left, as_size(bottom_right - top_left)};
     }
-}
 
-auto msd::Renderer::render_titlebar() -> std::optional<std::shared_ptr<mg::Buffer>>
-{
-    if (!area(titlebar_size))
-        return std::nullopt;
-
-    if (!titlebar_pixels)
+    std::vector<ButtonInfo> new_buttons;
+    for (auto button : input_state.buttons())
     {
-        titlebar_pixels = alloc_pixels(titlebar_size);
-        needs_titlebar_redraw = true;
+        button.rect.top_left = button.rect.top_left - as_displacement(new_buttons_rect.top_left);
+        new_buttons.push_back(button);
     }
 
-    if (needs_titlebar_redraw)
+    if (new_buttons != buttons)
     {
-        for (geom::Y y{0}; y < as_y(titlebar_size.height); y += geom::DeltaY{1})
-        {
-            render_row(
-                titlebar_pixels.get(), titlebar_size,
-                {0, y}, titlebar_size.width,
-                current_theme->background_color);
-        }
-
-        text->render(
-            titlebar_pixels.get(),
-            titlebar_size,
-            name,
-            static_geometry->title_font_top_left,
-            static_geometry->title_font_height,
-            current_theme->text_color);
+        buttons = std::move(new_buttons);
+        needs_buttons_redraw = true;
     }
-
-    if (needs_titlebar_redraw || needs_titlebar_buttons_redraw)
-    {
-        for (auto const& button : buttons)
-        {
-            auto const icon = button_icons.find(button.function);
-            if (icon != button_icons.end())
-            {
-                Pixel button_color = icon->second.normal_color;
-                if (button.state == ButtonState::Hovered)
-                    button_color = icon->second.active_color;
-                for (geom::Y y{button.rect.top()}; y < button.rect.bottom(); y += geom::DeltaY{1})
-                {
-                    render_row(
-                        titlebar_pixels.get(),
-                        titlebar_size,
-                        {button.rect.left(), y},
-                        button.rect.size.width,
-                        button_color);
-                }
-                geom::Rectangle const icon_rect = {
-                button.rect.top_left + static_geometry->icon_padding, {
-                    button.rect.size.width - static_geometry->icon_padding.dx * 2,
-                    button.rect.size.height - static_geometry->icon_padding.dy * 2}};
-                icon->second.render_icon(
-                    titlebar_pixels.get(),
-                    titlebar_size,
-                    icon_rect,
-                    static_geometry->icon_line_width,
-                    icon->second.icon_color);
-            }
-            else
-            {
-                log_warning("Could not render decoration button with unknown function %d\n", static_cast<int>(button.function));
-            }
-        }
-    }
-
-    needs_titlebar_redraw = false;
-    needs_titlebar_buttons_redraw = false;
-
-    return make_buffer(titlebar_pixels.get(), titlebar_size);
+    buttons_rect_ = new_buttons_rect;
+
+    // The title is only as wide as the text, but must not extend under the buttons
+    auto const titlebar = window_state.titlebar_rect();
+    auto const title_right = buttons.empty() ? titlebar.right() : buttons_rect_.left();
+    auto const title_width = std::min(
+        static_geometry->title_font_top_left.x + as_delta(name_width),
+        title_right - as_delta(titlebar.left()));
+    geom::Rectangle const new_title_rect{
+        titlebar.top_left,
+        {std::max(as_width(title_width), geom::Width{}), titlebar.size.height}};
+
+    if (new_title_rect.size != title_rect_.size)
+        needs_title_redraw = true;
+    title_rect_ = new_title_rect;
 }
 
-auto msd::Renderer::render_left_border() -> std::optional<std::shared_ptr<mg::Buffer>>
+auto msd::Renderer::title_rect() const -> geom::Rectangle
 {
-    if (!area(left_border_size))
-        return std::nullopt;
-    update_solid_color_pixels();
-    return make_buffer(solid_color_pixels.get(), left_border_size);
+    return title_rect_;
 }
 
-auto msd::Renderer::render_right_border() -> std::optional<std::shared_ptr<mg::Buffer>>
+auto msd::Renderer::buttons_rect() const -> geom::Rectangle
 {
-    if (!area(right_border_size))
-        return std::nullopt;
-    update_solid_color_pixels();
-    return make_buffer(solid_color_pixels.get(), right_border_size);
+    return buttons_rect_;
 }
 
-auto msd::Renderer::render_bottom_border() -> std::optional<std::shared_ptr<mg::Buffer>>
+auto msd::Renderer::render_solid_color() -> std::optional<std::shared_ptr<mg::Buffer>>
 {
-    if (!area(bottom_border_size))
-        return std::nullopt;
-    update_solid_color_pixels();
-    return make_buffer(solid_color_pixels.get(), bottom_border_size);
+    Pixel const pixel = current_theme->background_color;
+    return make_buffer(&pixel, geom::Size{1, 1});
 }
 
-void msd::Renderer::update_solid_color_pixels()
+auto msd::Renderer::render_title() -> std::optional<std::shared_ptr<mg::Buffer>>
 {
-    if (!solid_color_pixels)
+    if (!needs_title_redraw || !area(title_rect_.size))
+        return std::nullopt;
+
+    auto const pixels = alloc_pixels(title_rect_.size);
+    for (geom::Y y{0}; y < as_y(title_rect_.size.height); y += geom::DeltaY{1})
     {
-        solid_color_pixels = alloc_pixels(geom::Size{solid_color_pixels_length, 1});
-        needs_solid_color_redraw = true;
+        render_row(
+            pixels.get(), title_rect_.size,
+            {0, y}, title_rect_.size.width,
+            current_theme->background_color);
     }
 
-    if (needs_solid_color_redraw)
+    text->render(
+        pixels.get(),
+        title_rect_.size,
+        name,
+        static_geometry->title_font_top_left,
+        static_geometry->title_font_height,
+        current_theme->text_color);
+
+    needs_title_redraw = false;
+
+    return make_buffer(pixels.get(), title_rect_.size);
+}
+
+auto msd::Renderer::render_buttons() -> std::optional<std::shared_ptr<mg::Buffer>>
+{
+    if (!needs_buttons_redraw || !area(buttons_rect_.size))
+        return std::nullopt;
+
+    auto const buf_size = buttons_rect_.size;
+    auto const pixels = alloc_pixels(buf_size);
+
+    // Fill in the gaps between buttons
+    for (geom::Y y{0}; y < as_y(buf_size.height); y += geom::DeltaY{1})
     {
         render_row(
-            solid_color_pixels.get(), geom::Size{solid_color_pixels_length, 1},
-            geom::Point{}, geom::Width{solid_color_pixels_length},
+            pixels.get(), buf_size,
+            {0, y}, buf_size.width,
             current_theme->background_color);
     }
 
-    needs_solid_color_redraw = false;
+    for (auto const& button : buttons)
+    {
+        auto const icon = button_icons.find(button.function);
+        if (icon != button_icons.end())
+        {
+            Pixel button_color = icon->second.normal_color;
+            if (button.state == ButtonState::Hovered)
+                button_color = icon->second.active_color;
+            for (geom::Y y{button.rect.top()}; y < button.rect.bottom(); y += geom::DeltaY{1})
+            {
+                render_row(
+                    pixels.get(),
+                    buf_size,
+                    {button.rect.left(), y},
+                    button.rect.size.width,
+                    button_color);
+            }
+            geom::Rectangle const icon_rect = {
+            button.rect.top_left + static_geometry->icon_padding, {
+                button.rect.size.width - static_geometry->icon_padding.dx * 2,
+                button.rect.size.height - static_geometry->icon_padding.dy * 2}};
+            icon->second.render_icon(
+                pixels.get(),
+                buf_size,
+                icon_rect,
+                static_geometry->icon_line_width,
+                icon->second.icon_color);
+        }
+        else
+        {
+            log_warning("Could not render decoration button with unknown function %d\n", static_cast<int>(button.function));
+        }
+    }
+
+    needs_buttons_redraw = false;
+
+    return make_buffer(pixels.get(), buf_size);
 }
 
 auto msd::Renderer::make_buffer(
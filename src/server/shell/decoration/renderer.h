@@ -23,6 +23,8 @@
 
 #include <memory>
 #include <map>
+#include <optional>
+#include <vector>
 
 namespace mir
 {
@@ -42,6 +44,12 @@ struct StaticGeometry;
 auto const buffer_format = mir_pixel_format_argb_8888;
 auto const bytes_per_pixel = 4;
 
+/// Draws the contents of the decoration streams
+///
+/// The titlebar background and the borders are plain 1x1 buffers of the background color that the
+/// compositor stretches to size, so resizing a window doesn't need any new buffers for them. Only the
+/// window title and the buttons are rasterized, into buffers that depend on their content rather than
+/// the size of the window.
 class Renderer
 {
 public:
@@ -50,19 +58,30 @@ public:
         std::shared_ptr<StaticGeometry const> const& static_geometry);
 
     void update_state(WindowState const& window_state, InputState const& input_state);
-    auto render_titlebar() -> std::optional<std::shared_ptr<graphics::Buffer>>;
-    auto render_left_border() -> std::optional<std::shared_ptr<graphics::Buffer>>;
-    auto render_right_border() -> std::optional<std::shared_ptr<graphics::Buffer>>;
-    auto render_bottom_border() -> std::optional<std::shared_ptr<graphics::Buffer>>;
 
-private:
+    /// Where the title and buttons buffers should be placed (relative to the decoration surface)
+    /// These are updated by update_state() and may be empty
+    auto title_rect() const -> geometry::Rectangle;
+    auto buttons_rect() const -> geometry::Rectangle;
+
+    /// A 1x1 buffer of the current background color
+    auto render_solid_color() -> std::optional<std::shared_ptr<graphics::Buffer>>;
+
+    /// Returns std::nullopt if the content is unchanged since the last call, or could not be drawn
+    auto render_title() -> std::optional<std::shared_ptr<graphics::Buffer>>;
+    auto render_buttons() -> std::optional<std::shared_ptr<graphics::Buffer>>;
+
     using Pixel = uint32_t;
 
     class Text
     {
     public:
+        /// The Text shared by all decorations
         static auto instance() -> std::shared_ptr<Text>;
 
+        /// A Text with its own cache of up to glyph_cache_capacity rasterized glyphs (0 disables caching)
+        static auto create(size_t glyph_cache_capacity) -> std::shared_ptr<Text>;
+
         virtual ~Text() = default;
 
         virtual void render(
@@ -73,6 +92,9 @@ private:
             geometry::Height height_pixels,
             Pixel color) = 0;
 
+        /// The horizontal distance covered by render()ing the text
+        virtual auto width(std::string const& text, geometry::Height height_pixels) -> geometry::Width = 0;
+
     private:
         class Impl;
         class Null;
@@ -81,6 +103,7 @@ private:
         static std::weak_ptr<Text> singleton;
     };
 
+private:
     /// A visual theme for a decoration
     /// Focused and unfocused windows use a different theme
     struct Theme
@@ -110,24 +133,17 @@ private:
     std::map<ButtonFunction, Icon const> button_icons;
     std::shared_ptr<StaticGeometry const> const static_geometry;
 
-    bool needs_solid_color_redraw{true};
-    geometry::Size left_border_size;
-    geometry::Size right_border_size;
-    geometry::Size bottom_border_size;
-    size_t solid_color_pixels_length{0};
-    std::unique_ptr<Pixel[]> solid_color_pixels; // can be nullptr
-
-    geometry::Size titlebar_size{};
-    std::unique_ptr<Pixel[]> titlebar_pixels; // can be nullptr
-
-    bool needs_titlebar_redraw{true};
-    bool needs_titlebar_buttons_redraw{true};
     std::string name;
-    std::vector<ButtonInfo> buttons;
+    geometry::Width name_width{};   ///< Width of the rendered name, measured when the name changes
+    geometry::Rectangle title_rect_{};
+    std::vector<ButtonInfo> buttons; ///< Relative to buttons_rect_
+    geometry::Rectangle buttons_rect_{};
+
+    bool needs_title_redraw{true};
+    bool needs_buttons_redraw{true};
 
     std::shared_ptr<Text> const text;
 
-    void update_solid_color_pixels();
     auto make_buffer(
         Pixel const* pixels,
         geometry::Size size) -> std::optional<std::shared_ptr<graphics::Buffer>>;
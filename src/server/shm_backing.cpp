@@ -21,10 +21,13 @@
 #include <sys/mman.h>
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #include <signal.h>
 #include <system_error>
 #include <memory>
 #include <atomic>
+#include <array>
+#include <thread>
 #include <boost/throw_exception.hpp>
 
 namespace
@@ -60,6 +63,33 @@ public:
         }
     }
 
+private:
+    /* One entry in the registry of protected ranges.
+     *
+     * The SIGBUS handler can run on any thread, concurrently with other threads
+     * claiming and releasing entries, so it only ever touches atomics: it pins an
+     * entry with `readers` before reading the range, and release_range() waits
+     * for any pinning handler to finish before the entry can be reused.
+     */
+    struct ProtectedRange
+    {
+        enum : int { unused, claimed, active, releasing };
+
+        std::atomic<int> state{unused};
+        std::atomic<int> readers{0};
+        std::atomic<uintptr_t> start{0};
+        std::atomic<size_t> len{0};
+        std::atomic<bool> fallback_mapped{false};
+    };
+
+    /// Entries are allocated in blocks that are never freed, so the handler can walk them without locking
+    struct RangeBlock
+    {
+        std::array<ProtectedRange, 64> ranges;
+        RangeBlock* next{nullptr};
+    };
+
+public:
     class AccessProtector
     {
         friend class ShmBufferSIGBUSHandler;
@@ -71,37 +101,12 @@ public:
 
         auto invalid_access_prevented() -> bool
         {
-            return used;
-        }
-
-        auto within_protected_region(void* access) -> bool
-        {
-            auto fault_addr = reinterpret_cast<uintptr_t>(access);
-            auto protected_addr = reinterpret_cast<uintptr_t>(addr);
-            return fault_addr > protected_addr &&
-                fault_addr < protected_addr + len;
-        }
-
-        auto provide_fallback_mapping() -> bool
-        {
-            // Replace the existing mapping with a fallback
-            if (mmap(
-                addr, len,
-                PROT_READ | PROT_WRITE,
-                MAP_PRIVATE | MAP_FIXED | MAP_ANONYMOUS,
-                -1, 0) == addr)
-            {
-                // We've successfully replaced any existing mapping with a new,
-                // all-0, mapping that will not SIGBUS on access.
-                used = true;
-                return true;
-            }
-            return false;
+            return range->fallback_mapped;
         }
 
         ~AccessProtector()
         {
-            if (used)
+            if (release_range(range))
             {
                 munmap(addr, len);
             }
@@ -109,13 +114,14 @@ public:
     private:
         AccessProtector(void* addr, size_t len)
             : addr{addr},
-              len{len}
+              len{len},
+              range{claim_range(addr, len)}
         {
         }
 
-        void* addr;
-        size_t len;
-        std::atomic<bool> used{false};    // Atomic only to ensure signal-safety
+        void* const addr;
+        size_t const len;
+        ProtectedRange* const range;
     };
 
     /**
@@ -124,16 +130,15 @@ public:
      * Ensure that accesses within the memory range [addr, addr+len) can be accessed
      * without crashing with SIGBUS.
      *
+     * This does not take any locks, so mappings can be made concurrently from any thread.
+     *
      * \returns A handle representing this memory access guard. As long as the guard is
      *          live, accesses within the protected range are safe.
      */
     auto static protect_access_to(void* addr, size_t len) -> std::shared_ptr<AccessProtector>
     {
-        auto protector = std::shared_ptr<AccessProtector>{new AccessProtector{addr, len}};
-        auto locked_list = current_access.lock();
         install_sigbus_handler();
-        locked_list->push_back(protector);
-        return protector;
+        return std::shared_ptr<AccessProtector>{new AccessProtector{addr, len}};
     }
 
 private:
@@ -141,8 +146,117 @@ private:
 
     friend class AccessProtector;
 
+    static auto claim_range(void* addr, size_t len) -> ProtectedRange*
+    {
+        // Threads tend to map and unmap repeatedly, so first try the entry this thread used last
+        thread_local ProtectedRange* last_claimed{nullptr};
+
+        auto const try_claim = [addr, len](ProtectedRange* range)
+            {
+                int expected{ProtectedRange::unused};
+                if (!range->state.compare_exchange_strong(expected, ProtectedRange::claimed))
+                {
+                    return false;
+                }
+                range->start.store(reinterpret_cast<uintptr_t>(addr), std::memory_order_relaxed);
+                range->len.store(len, std::memory_order_relaxed);
+                range->fallback_mapped.store(false, std::memory_order_relaxed);
+                range->state.store(ProtectedRange::active, std::memory_order_release);
+                last_claimed = range;
+                return true;
+            };
+
+        if (last_claimed && try_claim(last_claimed))
+        {
+            return last_claimed;
+        }
+
+        for (auto block = range_blocks.load(std::memory_order_acquire); block; block = block->next)
+        {
+            for (auto& range : block->ranges)
+            {
+                if (try_claim(&range))
+                {
+                    return &range;
+                }
+            }
+        }
+
+        // Every entry is in use: add another block. It isn't visible to anyone else yet, so the claim succeeds.
+        auto const block = new RangeBlock;
+        try_claim(&block->ranges[0]);
+        block->next = range_blocks.load();
+        while (!range_blocks.compare_exchange_weak(block->next, block))
+        {
+        }
+        return &block->ranges[0];
+    }
+
+    /// \returns whether the SIGBUS handler replaced the range with a fallback mapping
+    static auto release_range(ProtectedRange* range) -> bool
+    {
+        range->state.store(ProtectedRange::releasing);
+
+        // A handler that pinned the range while it was active may still be replacing the mapping
+        while (range->readers.load() > 0)
+        {
+            std::this_thread::yield();
+        }
+
+        auto const fallback_mapped = range->fallback_mapped.load();
+        range->state.store(ProtectedRange::unused, std::memory_order_release);
+        return fallback_mapped;
+    }
+
+    /// Called from the SIGBUS handler, so must be async-signal-safe
+    static auto provide_fallback_mapping(ProtectedRange& range, void* access) -> bool
+    {
+        bool provided{false};
+
+        range.readers.fetch_add(1);
+        if (range.state.load() == ProtectedRange::active)
+        {
+            auto const fault_addr = reinterpret_cast<uintptr_t>(access);
+            auto const start = range.start.load(std::memory_order_relaxed);
+            auto const len = range.len.load(std::memory_order_relaxed);
+
+            if (fault_addr >= start && fault_addr - start < len)
+            {
+                // Replace the existing mapping with a fallback
+                auto const addr = reinterpret_cast<void*>(start);
+                if (mmap(
+                    addr, len,
+                    PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_FIXED | MAP_ANONYMOUS,
+                    -1, 0) == addr)
+                {
+                    // We've successfully replaced any existing mapping with a new,
+                    // all-0, mapping that will not SIGBUS on access.
+                    range.fallback_mapped = true;
+                    provided = true;
+                }
+            }
+        }
+        range.readers.fetch_sub(1);
+
+        return provided;
+    }
+
     static void install_sigbus_handler()
     {
+        /* This is called for every access to a client buffer, so avoid allocating and
+         * replacing the handler when ours is already installed. We still need to check:
+         * another component may have installed its own handler since, and ours puts back
+         * the previous handler when it can't handle a SIGBUS.
+         */
+        struct sigaction current_handler;
+        if (sigaction(SIGBUS, nullptr, &current_handler) == 0 &&
+            (current_handler.sa_flags & SA_SIGINFO) &&
+            current_handler.sa_sigaction == &sigbus_handler)
+        {
+            return;
+        }
+
         struct sigaction sig_handler_desc;
         sigfillset(&sig_handler_desc.sa_mask);
         sig_handler_desc.sa_flags = SA_SIGINFO;
@@ -169,11 +283,15 @@ private:
         }
         if (old_handler->sa_sigaction != &sigbus_handler)
         {
-            // Because we install the handler every time, we only want
-            // to save the old handler when it's not ours!
+            // Another thread may have raced us to install the handler, so we only
+            // want to save the old handler when it's not ours!
             auto to_delete = previous_handler.exchange(old_handler);
             delete to_delete;
         }
+        else
+        {
+            delete old_handler;
+        }
     }
 
     static void sigbus_handler(int sig, siginfo_t* info, void* ucontext)
@@ -193,20 +311,15 @@ private:
              * not doing something absolutely bonkers, like trying to store
              * pthread mutexes in a file-backed mmap()ed region).
              *
-             * *That* means that we have access to sensible concurrency primitives!
-             * *And* the memory allocator!
-             * What bliss!
-             *
-             * So, even though this is a signal handler, we can use normal
-             * code.
+             * Even so, the handler only touches atomics and never blocks, so
+             * that mapping and unmapping protected ranges on other threads
+             * never has to serialise against it (or against each other).
              */
-            auto locked_list = current_access.lock();
-            for (auto& weak_protector : *locked_list)
+            for (auto block = range_blocks.load(std::memory_order_acquire); block; block = block->next)
             {
-                if (auto protector = weak_protector.lock())
+                for (auto& range : block->ranges)
                 {
-                    if (protector->within_protected_region(info->si_addr) &&
-                        protector->provide_fallback_mapping())
+                    if (provide_fallback_mapping(range, info->si_addr))
                     {
                         // We've replaced the client-provided mapping with one that will
                         // not fault; it is now safe to continue.
@@ -232,15 +345,19 @@ private:
             (previous_handler.load()->sa_handler)(sig);
         }
     }
-    static mir::Synchronised<std::vector<std::weak_ptr<AccessProtector>>> current_access;
+    static std::atomic<RangeBlock*> range_blocks;
     static std::atomic<struct sigaction*> previous_handler;
     static std::weak_ptr<ShmBufferSIGBUSHandler> installed_handler;
 };
 std::weak_ptr<ShmBufferSIGBUSHandler> ShmBufferSIGBUSHandler::installed_handler;
 std::atomic<struct sigaction*> ShmBufferSIGBUSHandler::previous_handler;
-mir::Synchronised<std::vector<std::weak_ptr<ShmBufferSIGBUSHandler::AccessProtector>>>
-    ShmBufferSIGBUSHandler::current_access;
+std::atomic<ShmBufferSIGBUSHandler::RangeBlock*> ShmBufferSIGBUSHandler::range_blocks;
 
+auto round_to_pages(size_t size) -> size_t
+{
+    static size_t const page_size = sysconf(_SC_PAGE_SIZE);
+    return (size + page_size - 1) / page_size * page_size;
+}
 
 class ShmBacking
 {
@@ -260,18 +377,50 @@ public:
 private:
     std::shared_ptr<ShmBufferSIGBUSHandler> const sigbus_handler;
 
+    /* The client's pool, mapped at the start of a larger reservation of address space.
+     *
+     * Clients typically grow their pools a little at a time, so resize() maps the growth
+     * into the reservation rather than remapping the whole pool. Every CurrentMapping
+     * grown from the same reservation shares its address, and holds only the root mapping
+     * (which owns the reservation): a client sending many small resizes must not build a
+     * chain of mappings, each keeping its predecessor alive.
+     */
     class CurrentMapping
     {
     public:
-        CurrentMapping(void* addr, size_t size, bool size_is_trustworthy)
+        CurrentMapping(void* addr, size_t size, size_t reserved, bool size_is_trustworthy)
             : mapped_address{addr},
               size{size},
+              reserved{reserved},
               size_is_trustworthy{size_is_trustworthy}
         {
         }
+
+        /**
+         * \param grown_from   The mapping this one extends. The root mapping it was grown from owns
+         *                     the reservation, and is kept alive as long as this is.
+         */
+        CurrentMapping(std::shared_ptr<CurrentMapping const> const& grown_from, size_t size, bool size_is_trustworthy)
+            : mapped_address{grown_from->mapped_address},
+              size{size},
+              reserved{grown_from->reserved},
+              size_is_trustworthy{size_is_trustworthy},
+              root{grown_from->root ? grown_from->root : grown_from}
+        {
+        }
+
         ~CurrentMapping()
         {
-            ::munmap(mapped_address, size);
+            if (!root)
+            {
+                // The pool as first mapped, then the rest of the reservation (including any growth)
+                ::munmap(mapped_address, size);
+                auto const pool_end = round_to_pages(size);
+                if (reserved > pool_end)
+                {
+                    ::munmap(static_cast<char*>(mapped_address) + pool_end, reserved - pool_end);
+                }
+            }
         }
 
         CurrentMapping(CurrentMapping const&) = delete;
@@ -282,9 +431,13 @@ private:
 
         void* const mapped_address;
         size_t size;
+        size_t const reserved;
         bool size_is_trustworthy;
+
+    private:
+        std::shared_ptr<CurrentMapping const> const root;
     };
-    
+
     template<typename T>
     class Mapping : public mir::shm::Mapping<T>
     {
@@ -397,18 +550,50 @@ auto ShmBacking::lock_range(size_t start, size_t len)
 
 void ShmBacking::resize(size_t new_size)
 {
-    void* mapped_address = mmap(nullptr, new_size, prot, MAP_SHARED, backing_store, 0);
-    if (mapped_address == MAP_FAILED)
+    auto const current = *current_mapping.lock();
+    if (current && new_size > current->size && new_size <= current->reserved)
     {
+        auto const mapped_end = round_to_pages(current->size);
+        if (new_size > mapped_end)
+        {
+            auto const tail = static_cast<char*>(current->mapped_address) + mapped_end;
+            if (mmap(tail, new_size - mapped_end, prot, MAP_SHARED | MAP_FIXED, backing_store, mapped_end) == MAP_FAILED)
+            {
+                BOOST_THROW_EXCEPTION((std::system_error{
+                    errno,
+                    std::system_category(),
+                    "Failed to extend mapping of client-provided SHM pool"}));
+            }
+        }
+
+        *current_mapping.lock() = std::make_shared<CurrentMapping>(
+            current,
+            new_size,
+            backing_size_is_guaranteed_at_least(this->backing_store, new_size));
+        return;
+    }
+
+    // Leave room for the pool to double before it needs a new reservation
+    auto const reserved = round_to_pages(new_size) * 2;
+    void* mapped_address = mmap(nullptr, reserved, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mapped_address == MAP_FAILED ||
+        mmap(mapped_address, new_size, prot, MAP_SHARED | MAP_FIXED, backing_store, 0) == MAP_FAILED)
+    {
+        auto const error = errno;
+        if (mapped_address != MAP_FAILED)
+        {
+            munmap(mapped_address, reserved);
+        }
         BOOST_THROW_EXCEPTION((std::system_error{
-            errno,
+            error,
             std::system_category(),
             "Failed to map client-provided SHM pool"}));
     }
-    
+
     *current_mapping.lock() = std::make_shared<CurrentMapping>(
         mapped_address,
         new_size,
+        reserved,
         backing_size_is_guaranteed_at_least(this->backing_store, new_size));
 }
 
@@ -0,0 +1,441 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/time/timer_wheel.h"
+#include "mir/lockable_callback_wrapper.h"
+#include "mir/basic_callback.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <limits>
+#include <mutex>
+#include <system_error>
+#include <vector>
+
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace mt = mir::time;
+
+namespace
+{
+/* Each level of the wheel has 64 slots, so that the occupied slots of a level
+ * fit in a single uint64_t and the next occupied slot can be found with a
+ * single bit scan. Four levels of 1ms ticks cover a little over four hours;
+ * alarms further in the future are parked in the outermost level and
+ * re-examined when it cascades.
+ */
+int const bits_per_level{6};
+uint64_t const slots_per_level{uint64_t{1} << bits_per_level};
+uint64_t const slot_mask{slots_per_level - 1};
+int const levels{4};
+uint64_t const wheel_span{uint64_t{1} << (bits_per_level * levels)};
+uint64_t const no_tick{std::numeric_limits<uint64_t>::max()};
+
+auto create_timer_fd() -> mir::Fd
+{
+    auto const fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create timerfd"}));
+    }
+    return mir::Fd{fd};
+}
+}
+
+class mt::TimerWheel::Wheel
+{
+public:
+    struct Entry : std::enable_shared_from_this<Entry>
+    {
+        std::unique_ptr<LockableCallback> callback;
+        std::atomic<Alarm::State> state{Alarm::cancelled};
+
+        // Held while the callback runs, so that cancel() and destruction can wait
+        // for an in-progress dispatch to complete.
+        std::recursive_mutex dispatch_mutex;
+
+        // The following are guarded by Wheel::mutex
+        Entry* prev{nullptr};
+        Entry* next{nullptr};
+        uint64_t expiry{0};
+        int level{-1};          ///< -1 when not linked into the wheel
+        uint64_t slot{0};
+        uint64_t generation{0};
+    };
+
+    Wheel(std::shared_ptr<Clock> const& clock, std::function<void()> const& exception_handler)
+        : clock{clock},
+          exception_handler{exception_handler},
+          timer_fd{create_timer_fd()},
+          base{clock->now()}
+    {
+    }
+
+    auto schedule(Entry& entry, Timestamp t) -> bool
+    {
+        std::lock_guard lock{mutex};
+
+        if (entry.level >= 0)
+            remove(lock, entry);
+
+        ++entry.generation;
+        entry.expiry = std::max(tick_for(t), current_tick + 1);
+        insert(lock, entry, current_tick);
+        rearm(lock);
+
+        return entry.state.exchange(Alarm::pending) == Alarm::pending;
+    }
+
+    auto cancel(Entry& entry) -> bool
+    {
+        std::lock_guard dispatch_lock{entry.dispatch_mutex};
+        std::lock_guard lock{mutex};
+
+        unschedule(lock, entry);
+
+        auto expected = Alarm::pending;
+        entry.state.compare_exchange_strong(expected, Alarm::cancelled);
+        return entry.state == Alarm::cancelled;
+    }
+
+    void destroy(Entry& entry)
+    {
+        std::lock_guard dispatch_lock{entry.dispatch_mutex};
+        std::lock_guard lock{mutex};
+
+        unschedule(lock, entry);
+    }
+
+    void dispatch()
+    {
+        uint64_t expirations;
+        if (read(timer_fd, &expirations, sizeof expirations) < 0 && errno != EAGAIN)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to read timerfd"}));
+        }
+
+        std::vector<std::pair<std::shared_ptr<Entry>, uint64_t>> expired;
+        {
+            std::lock_guard lock{mutex};
+
+            armed_tick = no_tick;
+            auto const target = elapsed_ticks(clock->now());
+
+            for (auto tick = next_event_tick(lock); tick <= target; tick = next_event_tick(lock))
+                process_tick(lock, tick, expired);
+
+            current_tick = std::max(current_tick, target);
+            rearm(lock);
+        }
+
+        for (auto const& [entry, generation] : expired)
+            fire(*entry, generation);
+    }
+
+    std::shared_ptr<Clock> const clock;
+    std::function<void()> const exception_handler;
+    Fd const timer_fd;
+
+private:
+    using Lock = std::lock_guard<std::mutex>;
+
+    struct Level
+    {
+        std::array<Entry*, slots_per_level> slots{};
+        uint64_t occupied{0};
+    };
+
+    /// The first tick at or after t: alarms must never fire early
+    auto tick_for(Timestamp t) const -> uint64_t
+    {
+        if (t <= base)
+            return 0;
+        return std::chrono::ceil<Tick>(t - base).count();
+    }
+
+    /// The last tick that has fully elapsed at t
+    auto elapsed_ticks(Timestamp t) const -> uint64_t
+    {
+        if (t <= base)
+            return 0;
+        return std::chrono::floor<Tick>(t - base).count();
+    }
+
+    void unschedule(Lock const& lock, Entry& entry)
+    {
+        if (entry.level >= 0)
+            remove(lock, entry);
+        ++entry.generation;
+    }
+
+    /* Entries live in the lowest level whose span covers their expiry, at the
+     * slot indexed by the corresponding bits of the (absolute) expiry tick. An
+     * entry in level L is examined when the wheel reaches the start of its
+     * slot, at which point it is moved ("cascaded") into a lower level.
+     */
+    void insert(Lock const&, Entry& entry, uint64_t now)
+    {
+        auto const delta = entry.expiry - now;
+        auto const placement = delta < wheel_span ? entry.expiry : now + wheel_span - 1;
+
+        int level = 0;
+        while (level < levels - 1 &&
+               (placement - now) >= (uint64_t{1} << (bits_per_level * (level + 1))))
+        {
+            ++level;
+        }
+
+        auto const slot = (placement >> (bits_per_level * level)) & slot_mask;
+        auto& head = wheel[level].slots[slot];
+
+        entry.level = level;
+        entry.slot = slot;
+        entry.prev = nullptr;
+        entry.next = head;
+        if (head)
+            head->prev = &entry;
+        head = &entry;
+
+        wheel[level].occupied |= uint64_t{1} << slot;
+    }
+
+    void remove(Lock const&, Entry& entry)
+    {
+        auto& level = wheel[entry.level];
+
+        if (entry.prev)
+            entry.prev->next = entry.next;
+        else
+            level.slots[entry.slot] = entry.next;
+
+        if (entry.next)
+            entry.next->prev = entry.prev;
+
+        if (!level.slots[entry.slot])
+            level.occupied &= ~(uint64_t{1} << entry.slot);
+
+        entry.prev = entry.next = nullptr;
+        entry.level = -1;
+    }
+
+    /// Detach and return the entries in a slot
+    auto take_slot(Lock const&, int level, uint64_t slot) -> Entry*
+    {
+        auto const head = wheel[level].slots[slot];
+        wheel[level].slots[slot] = nullptr;
+        wheel[level].occupied &= ~(uint64_t{1} << slot);
+        return head;
+    }
+
+    void process_tick(
+        Lock const& lock,
+        uint64_t tick,
+        std::vector<std::pair<std::shared_ptr<Entry>, uint64_t>>& expired)
+    {
+        current_tick = tick;
+
+        // Cascade the outer levels first; entries they release may land in
+        // lower levels that are also cascading on this tick.
+        for (auto level = levels - 1; level > 0; --level)
+        {
+            auto const shift = bits_per_level * level;
+            if (tick & ((uint64_t{1} << shift) - 1))
+                continue;
+
+            for (auto entry = take_slot(lock, level, (tick >> shift) & slot_mask); entry;)
+            {
+                auto const next = entry->next;
+                insert(lock, *entry, tick);
+                entry = next;
+            }
+        }
+
+        for (auto entry = take_slot(lock, 0, tick & slot_mask); entry;)
+        {
+            auto const next = entry->next;
+            entry->prev = entry->next = nullptr;
+            entry->level = -1;
+            expired.emplace_back(entry->shared_from_this(), entry->generation);
+            entry = next;
+        }
+    }
+
+    /// The next tick on which there is something to do (firing or cascading)
+    auto next_event_tick(Lock const&) const -> uint64_t
+    {
+        auto result = no_tick;
+
+        for (auto level = 0; level != levels; ++level)
+        {
+            auto const occupied = wheel[level].occupied;
+            if (!occupied)
+                continue;
+
+            auto const shift = bits_per_level * level;
+            auto const position = current_tick >> shift;
+            auto const rotated = std::rotr(occupied, static_cast<int>((position + 1) & slot_mask));
+            auto const distance = static_cast<uint64_t>(std::countr_zero(rotated)) + 1;
+
+            result = std::min(result, (position + distance) << shift);
+        }
+
+        return result;
+    }
+
+    void rearm(Lock const& lock)
+    {
+        auto const tick = next_event_tick(lock);
+        if (tick == armed_tick)
+            return;
+
+        itimerspec spec{{0, 0}, {0, 0}};
+        if (tick != no_tick)
+        {
+            auto const wait = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                clock->min_wait_until(base + Tick{tick}));
+
+            // A zero it_value disarms the timer; we want an immediate wakeup
+            auto const ns = std::max(wait.count(), decltype(wait.count()){1});
+            spec.it_value.tv_sec = ns / 1000000000;
+            spec.it_value.tv_nsec = ns % 1000000000;
+        }
+
+        if (timerfd_settime(timer_fd, 0, &spec, nullptr) < 0)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to arm timerfd"}));
+        }
+
+        armed_tick = tick;
+    }
+
+    void fire(Entry& entry, uint64_t generation)
+    {
+        try
+        {
+            // Attempt to preserve locking order during callback dispatching
+            // so we acquire the caller's lock before our own.
+            auto& handler = *entry.callback;
+            std::lock_guard handler_lock{handler};
+            std::lock_guard dispatch_lock{entry.dispatch_mutex};
+
+            bool still_due;
+            {
+                std::lock_guard lock{mutex};
+                still_due = entry.generation == generation;
+            }
+
+            if (still_due)
+                handler();
+        }
+        catch (...)
+        {
+            exception_handler();
+        }
+    }
+
+    Timestamp const base;
+
+    std::mutex mutex;
+    std::array<Level, levels> wheel;
+    uint64_t current_tick{0};
+    uint64_t armed_tick{no_tick};
+};
+
+class mt::TimerWheel::AlarmImpl : public Alarm
+{
+public:
+    AlarmImpl(std::shared_ptr<Wheel> const& wheel, std::unique_ptr<LockableCallback> callback)
+        : wheel{wheel},
+          entry{std::make_shared<Wheel::Entry>()}
+    {
+        entry->callback = std::make_unique<LockableCallbackWrapper>(
+            std::move(callback),
+            [entry = entry.get()] { entry->state = triggered; });
+    }
+
+    ~AlarmImpl() override
+    {
+        wheel->destroy(*entry);
+    }
+
+    bool cancel() override
+    {
+        return wheel->cancel(*entry);
+    }
+
+    State state() const override
+    {
+        return entry->state;
+    }
+
+    bool reschedule_in(std::chrono::milliseconds delay) override
+    {
+        return reschedule_for(wheel->clock->now() + delay);
+    }
+
+    bool reschedule_for(Timestamp time_point) override
+    {
+        return wheel->schedule(*entry, time_point);
+    }
+
+private:
+    std::shared_ptr<Wheel> const wheel;
+    std::shared_ptr<Wheel::Entry> const entry;
+};
+
+mt::TimerWheel::TimerWheel(
+    std::shared_ptr<Clock> const& clock,
+    std::function<void()> const& exception_handler)
+    : wheel{std::make_shared<Wheel>(clock, exception_handler)}
+{
+}
+
+mt::TimerWheel::~TimerWheel() = default;
+
+auto mt::TimerWheel::create_alarm(std::function<void()> const& callback) -> std::unique_ptr<Alarm>
+{
+    return create_alarm(std::make_unique<BasicCallback>(callback));
+}
+
+auto mt::TimerWheel::create_alarm(std::unique_ptr<LockableCallback> callback) -> std::unique_ptr<Alarm>
+{
+    return std::make_unique<AlarmImpl>(wheel, std::move(callback));
+}
+
+auto mt::TimerWheel::watch_fd() const -> Fd
+{
+    return wheel->timer_fd;
+}
+
+auto mt::TimerWheel::dispatch(dispatch::FdEvents events) -> bool
+{
+    if (events & dispatch::FdEvent::error)
+        return false;
+
+    if (events & dispatch::FdEvent::readable)
+        wheel->dispatch();
+
+    return true;
+}
+
+auto mt::TimerWheel::relevant_events() const -> dispatch::FdEvents
+{
+    return dispatch::FdEvent::readable;
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_BENCHMARKS_ALLOCATION_COUNTER_H_
+#define MIR_BENCHMARKS_ALLOCATION_COUNTER_H_
+
+#include <cstdint>
+
+namespace mir
+{
+namespace benchmarks
+{
+/// The number of times global operator new has been called by any thread in the process.
+///
+/// Linking allocation_counter.cpp into a benchmark replaces the global allocation functions, so
+/// this includes allocations made by the shared libraries the benchmark loads.
+auto allocation_count() -> uint64_t;
+}
+}
+
+#endif // MIR_BENCHMARKS_ALLOCATION_COUNTER_H_
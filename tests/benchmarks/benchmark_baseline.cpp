@@ -0,0 +1,104 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "benchmark_baseline.h"
+
+#include <boost/throw_exception.hpp>
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace mb = mir::benchmarks;
+
+namespace
+{
+auto env(char const* name) -> std::optional<std::string>
+{
+    if (auto const value = getenv(name))
+        return std::string{value};
+    return std::nullopt;
+}
+
+auto load(std::string const& path) -> std::map<std::string, double>
+{
+    std::ifstream file{path};
+    if (!file)
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error{"Failed to open benchmark baseline: " + path});
+    }
+
+    std::map<std::string, double> result;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        line = line.substr(0, line.find('#'));
+
+        std::istringstream fields{line};
+        std::string metric;
+        double value;
+        if (fields >> metric >> value)
+        {
+            result[metric] = value;
+        }
+    }
+    return result;
+}
+}
+
+auto mb::Baseline::instance() -> Baseline&
+{
+    static Baseline instance;
+    return instance;
+}
+
+mb::Baseline::Baseline() :
+    baseline{env("MIR_BENCHMARK_BASELINE") ? load(*env("MIR_BENCHMARK_BASELINE")) : decltype(baseline){}},
+    tolerance{env("MIR_BENCHMARK_TOLERANCE") ? std::stod(*env("MIR_BENCHMARK_TOLERANCE")) : 0.25},
+    record_path{env("MIR_BENCHMARK_RECORD_BASELINE")}
+{
+}
+
+void mb::Baseline::check(std::string const& metric, double value)
+{
+    std::lock_guard lock{mutex};
+
+    if (auto const expected = baseline.find(metric); expected != baseline.end())
+    {
+        EXPECT_LE(value, expected->second * (1 + tolerance))
+            << metric << " regressed: baseline is " << expected->second;
+    }
+
+    record(metric, value);
+}
+
+void mb::Baseline::record(std::string const& metric, double value)
+{
+    if (!record_path)
+        return;
+
+    recorded[metric] = value;
+
+    // Rewrite the whole file each time, so that an aborted run still leaves a usable baseline
+    std::ofstream file{*record_path, std::ios::trunc};
+    file << "# Benchmark baseline: metric value\n";
+    for (auto const& [name, recorded_value] : recorded)
+    {
+        file << name << ' ' << recorded_value << '\n';
+    }
+}
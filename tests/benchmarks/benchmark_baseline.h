@@ -0,0 +1,63 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_BENCHMARKS_BENCHMARK_BASELINE_H_
+#define MIR_BENCHMARKS_BENCHMARK_BASELINE_H_
+
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace mir
+{
+namespace benchmarks
+{
+/**
+ * Previously recorded benchmark results, for catching regressions.
+ *
+ * A baseline is a text file with a "metric value" pair on each line ('#' starts a comment). It is
+ * read from $MIR_BENCHMARK_BASELINE. If $MIR_BENCHMARK_RECORD_BASELINE names a file, the results
+ * of this run are written there for use as a future baseline.
+ *
+ * Baselines are only meaningful on the machine that recorded them. Those for reference machines
+ * are kept in tests/benchmarks/baselines/, and the MIR_BENCHMARK_BASELINE CMake option selects
+ * one for the benchmarks run by ctest.
+ */
+class Baseline
+{
+public:
+    static auto instance() -> Baseline&;
+
+    /// Check a metric for which lower values are better. The current test fails if the value
+    /// is more than $MIR_BENCHMARK_TOLERANCE (default 0.25, i.e. 25%) worse than the baseline.
+    void check(std::string const& metric, double value);
+
+private:
+    Baseline();
+
+    void record(std::string const& metric, double value);
+
+    std::mutex mutex;
+    std::map<std::string, double> baseline;
+    double const tolerance;
+    std::optional<std::string> const record_path;
+    std::map<std::string, double> recorded;
+};
+}
+}
+
+#endif // MIR_BENCHMARKS_BENCHMARK_BASELINE_H_
@@ -0,0 +1,106 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_BENCHMARKS_BENCHMARK_SAMPLES_H_
+#define MIR_BENCHMARKS_BENCHMARK_SAMPLES_H_
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace mir
+{
+namespace benchmarks
+{
+/// Collects duration samples and reports summary statistics for a benchmark
+class Samples
+{
+public:
+    using Duration = std::chrono::nanoseconds;
+
+    explicit Samples(std::string name) : name{std::move(name)} {}
+
+    void add(Duration sample) { samples.push_back(sample); }
+
+    auto count() const -> size_t { return samples.size(); }
+
+    auto percentile(double p) -> Duration
+    {
+        if (samples.empty())
+            return Duration{0};
+
+        auto const index = std::min(samples.size() - 1, static_cast<size_t>(p / 100.0 * samples.size()));
+        std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+        return samples[index];
+    }
+
+    auto mean() const -> Duration
+    {
+        if (samples.empty())
+            return Duration{0};
+
+        Duration total{0};
+        for (auto const& s : samples)
+            total += s;
+        return total / samples.size();
+    }
+
+    /// Print the summary and record it in the gtest XML output
+    void report()
+    {
+        auto const us = [](Duration d) { return std::chrono::duration<double, std::micro>(d).count(); };
+
+        auto const p50 = percentile(50);
+        auto const p90 = percentile(90);
+        auto const p99 = percentile(99);
+        auto const max = percentile(100);
+
+        printf("%-48s n=%-8zu mean=%9.2fus p50=%9.2fus p90=%9.2fus p99=%9.2fus max=%9.2fus\n",
+            name.c_str(), samples.size(), us(mean()), us(p50), us(p90), us(p99), us(max));
+
+        ::testing::Test::RecordProperty(name + ".mean_ns", std::to_string(mean().count()));
+        ::testing::Test::RecordProperty(name + ".p50_ns", std::to_string(p50.count()));
+        ::testing::Test::RecordProperty(name + ".p99_ns", std::to_string(p99.count()));
+    }
+
+private:
+    std::string const name;
+    std::vector<Duration> samples;
+};
+
+/// Report a single measured value for a benchmark
+inline void report_value(std::string const& name, double value, char const* unit)
+{
+    printf("%-48s %12.2f %s\n", name.c_str(), value, unit);
+    ::testing::Test::RecordProperty(name, std::to_string(value));
+}
+
+/// Report a throughput figure (operations per second) for a benchmark
+inline void report_rate(std::string const& name, size_t operations, std::chrono::nanoseconds elapsed)
+{
+    auto const rate = operations / std::chrono::duration<double>(elapsed).count();
+    printf("%-48s %12.0f ops/s (%zu ops in %.3fs)\n",
+        name.c_str(), rate, operations, std::chrono::duration<double>(elapsed).count());
+    ::testing::Test::RecordProperty(name + ".ops_per_second", std::to_string(static_cast<long long>(rate)));
+}
+}
+}
+
+#endif // MIR_BENCHMARKS_BENCHMARK_SAMPLES_H_
@@ -0,0 +1,62 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "benchmark_server.h"
+
+#include <miral/application_info.h>
+#include <miral/window_manager_tools.h>
+
+#include <mir/server.h>
+
+namespace mb = mir::benchmarks;
+
+mb::BenchmarkServer::BenchmarkServer()
+{
+    add_server_init([this](mir::Server& server) { running_server = &server; });
+}
+
+mb::BenchmarkServer::~BenchmarkServer() = default;
+
+void mb::BenchmarkServer::TearDown()
+{
+    // Disconnect before the server goes away
+    clients.clear();
+    miral::TestServer::TearDown();
+}
+
+auto mb::BenchmarkServer::connect_client() -> SyntheticClient&
+{
+    clients.push_back(std::make_unique<SyntheticClient>(server().open_wayland_client_socket()));
+    return *clients.back();
+}
+
+auto mb::BenchmarkServer::windows() -> std::vector<miral::Window>
+{
+    std::vector<miral::Window> result;
+    invoke_tools([&](miral::WindowManagerTools& tools)
+        {
+            tools.for_each_application([&](miral::ApplicationInfo& info)
+                {
+                    result.insert(result.end(), info.windows().begin(), info.windows().end());
+                });
+        });
+    return result;
+}
+
+auto mb::BenchmarkServer::server() const -> mir::Server&
+{
+    return *running_server;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_BENCHMARKS_BENCHMARK_SERVER_H_
+#define MIR_BENCHMARKS_BENCHMARK_SERVER_H_
+
+#include "synthetic_client.h"
+
+#include <miral/test_server.h>
+#include <miral/window.h>
+
+#include <memory>
+#include <vector>
+
+namespace mir
+{
+class Server;
+
+namespace benchmarks
+{
+/// A test server for benchmarks driven by in-process synthetic clients
+class BenchmarkServer : public miral::TestServer
+{
+public:
+    BenchmarkServer();
+    ~BenchmarkServer();
+
+    void TearDown() override;
+
+    /// A new client. It is disconnected before the server stops.
+    auto connect_client() -> SyntheticClient&;
+
+    /// All the windows known to the window manager
+    auto windows() -> std::vector<miral::Window>;
+
+protected:
+    /// The running server (only valid after SetUp())
+    auto server() const -> mir::Server&;
+
+    std::vector<std::unique_ptr<SyntheticClient>> clients;
+
+private:
+    mir::Server* running_server{nullptr};
+};
+}
+}
+
+#endif // MIR_BENCHMARKS_BENCHMARK_SERVER_H_
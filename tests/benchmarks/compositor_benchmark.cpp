@@ -0,0 +1,261 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "compositor_benchmark.h"
+#include "allocation_counter.h"
+#include "benchmark_baseline.h"
+#include "benchmark_samples.h"
+
+#include <miral/wayland_extensions.h>
+
+#include <mir/compositor/display_buffer_compositor.h>
+#include <mir/compositor/display_buffer_compositor_factory.h>
+#include <mir/server.h>
+
+#include <time.h>
+
+#include <mutex>
+#include <thread>
+
+namespace mb = mir::benchmarks;
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+using namespace std::chrono_literals;
+
+std::chrono::seconds const mb::CompositorBenchmark::warm_up_period{1};
+std::chrono::seconds const mb::CompositorBenchmark::measurement_period{3};
+
+namespace
+{
+auto process_cpu_time() -> std::chrono::nanoseconds
+{
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return std::chrono::seconds{ts.tv_sec} + std::chrono::nanoseconds{ts.tv_nsec};
+}
+
+auto as_us(std::chrono::nanoseconds d) -> double
+{
+    return std::chrono::duration<double, std::micro>(d).count();
+}
+
+/// Report latency samples, and check their median and tail against the baseline
+void report_latencies(std::string const& name, std::vector<std::chrono::nanoseconds> const& latencies)
+{
+    mb::Samples samples{name};
+    for (auto const& latency : latencies)
+    {
+        samples.add(latency);
+    }
+    samples.report();
+
+    mb::Baseline::instance().check(name + ".p50_us", as_us(samples.percentile(50)));
+    mb::Baseline::instance().check(name + ".p99_us", as_us(samples.percentile(99)));
+}
+}
+
+/// How long each call to DisplayBufferCompositor::composite() takes
+class mb::CompositorBenchmark::FrameTimes
+{
+public:
+    void add(std::chrono::nanoseconds frame_time)
+    {
+        std::lock_guard lock{mutex};
+        if (measuring)
+            samples.push_back(frame_time);
+    }
+
+    void start()
+    {
+        std::lock_guard lock{mutex};
+        samples.clear();
+        measuring = true;
+    }
+
+    auto stop() -> std::vector<std::chrono::nanoseconds>
+    {
+        std::lock_guard lock{mutex};
+        measuring = false;
+        return std::move(samples);
+    }
+
+private:
+    std::mutex mutex;
+    bool measuring{false};
+    std::vector<std::chrono::nanoseconds> samples;
+};
+
+class mb::CompositorBenchmark::TimedCompositorFactory : public mc::DisplayBufferCompositorFactory
+{
+public:
+    TimedCompositorFactory(
+        std::shared_ptr<mc::DisplayBufferCompositorFactory> const& wrapped,
+        std::shared_ptr<FrameTimes> const& frame_times) :
+        wrapped{wrapped},
+        frame_times{frame_times}
+    {
+    }
+
+    auto create_compositor_for(mg::DisplayBuffer& display_buffer) -> std::unique_ptr<mc::DisplayBufferCompositor> override
+    {
+        struct TimedCompositor : mc::DisplayBufferCompositor
+        {
+            TimedCompositor(
+                std::unique_ptr<mc::DisplayBufferCompositor> wrapped,
+                std::shared_ptr<FrameTimes> const& frame_times) :
+                wrapped{std::move(wrapped)},
+                frame_times{frame_times}
+            {
+            }
+
+            void composite(mc::SceneElementSequence&& scene_sequence) override
+            {
+                auto const start = std::chrono::steady_clock::now();
+                wrapped->composite(std::move(scene_sequence));
+                frame_times->add(std::chrono::steady_clock::now() - start);
+            }
+
+            std::unique_ptr<mc::DisplayBufferCompositor> const wrapped;
+            std::shared_ptr<FrameTimes> const frame_times;
+        };
+
+        return std::make_unique<TimedCompositor>(wrapped->create_compositor_for(display_buffer), frame_times);
+    }
+
+private:
+    std::shared_ptr<mc::DisplayBufferCompositorFactory> const wrapped;
+    std::shared_ptr<FrameTimes> const frame_times;
+};
+
+mb::CompositorBenchmark::CompositorBenchmark() :
+    frame_times{std::make_shared<FrameTimes>()}
+{
+    add_to_environment("MIR_SERVER_PLATFORM_DISPLAY_LIBS", "mir:virtual");
+    add_to_environment("MIR_SERVER_PLATFORM_RENDERING_LIBS", "mir:egl-generic");
+    add_to_environment("MIR_SERVER_VIRTUAL_OUTPUT", "1920x1080");
+    add_to_environment("MIR_SERVER_VIRTUAL_UNTHROTTLED", "true");
+
+    add_server_init(miral::WaylandExtensions{}.enable(miral::WaylandExtensions::zwlr_screencopy_manager_v1));
+
+    add_server_init([this](mir::Server& server)
+        {
+            // The test server composites "headlessly" without rendering, which is no use here.
+            // Building nothing falls back to the default compositor.
+            server.override_the_display_buffer_compositor_factory(
+                [] { return std::shared_ptr<mc::DisplayBufferCompositorFactory>{}; });
+
+            server.wrap_display_buffer_compositor_factory(
+                [this](std::shared_ptr<mc::DisplayBufferCompositorFactory> const& wrapped)
+                {
+                    return std::make_shared<TimedCompositorFactory>(wrapped, frame_times);
+                });
+        });
+}
+
+mb::CompositorBenchmark::~CompositorBenchmark() = default;
+
+void mb::CompositorBenchmark::default_load()
+{
+    std::this_thread::sleep_for(10ms);
+}
+
+void mb::CompositorBenchmark::measure(std::string const& scenario, std::function<void()> const& load)
+{
+    auto const run_for = [&](std::chrono::nanoseconds period)
+        {
+            auto const end = std::chrono::steady_clock::now() + period;
+            while (std::chrono::steady_clock::now() < end)
+            {
+                load();
+            }
+        };
+
+    for (auto const& client : clients)
+    {
+        client->start();
+    }
+
+    run_for(warm_up_period);
+
+    frame_times->start();
+    for (auto const& client : clients)
+    {
+        client->set_measuring(true);
+    }
+    auto const start_cpu = process_cpu_time();
+    auto const start_allocations = allocation_count();
+    auto const start = std::chrono::steady_clock::now();
+
+    run_for(measurement_period);
+
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+    auto const allocations = allocation_count() - start_allocations;
+    auto const cpu = process_cpu_time() - start_cpu;
+    for (auto const& client : clients)
+    {
+        client->set_measuring(false);
+    }
+    auto const frames = frame_times->stop();
+
+    std::vector<std::chrono::nanoseconds> frame_latencies;
+    std::vector<std::chrono::nanoseconds> screencopy_latencies;
+    unsigned screencopy_failures{0};
+    for (auto const& client : clients)
+    {
+        client->stop();
+        frame_latencies.insert(
+            frame_latencies.end(),
+            client->frame_callback_latencies().begin(),
+            client->frame_callback_latencies().end());
+        screencopy_latencies.insert(
+            screencopy_latencies.end(),
+            client->screencopy_latencies().begin(),
+            client->screencopy_latencies().end());
+        screencopy_failures += client->screencopy_failures();
+    }
+
+    ASSERT_FALSE(frames.empty()) << "Nothing was composited";
+
+    Samples frame_time{scenario + ".frame_time"};
+    for (auto const& f : frames)
+    {
+        frame_time.add(f);
+    }
+    frame_time.report();
+    report_rate(scenario + ".frames", frames.size(), elapsed);
+
+    auto const cpu_per_frame = as_us(cpu) / frames.size();
+    auto const allocations_per_frame = static_cast<double>(allocations) / frames.size();
+    report_value(scenario + ".cpu_per_frame", cpu_per_frame, "us");
+    report_value(scenario + ".allocations_per_frame", allocations_per_frame, "allocations");
+
+    auto& baseline = Baseline::instance();
+    baseline.check(scenario + ".frame_time.p50_us", as_us(frame_time.percentile(50)));
+    baseline.check(scenario + ".frame_time.p99_us", as_us(frame_time.percentile(99)));
+    baseline.check(scenario + ".cpu_per_frame_us", cpu_per_frame);
+    baseline.check(scenario + ".allocations_per_frame", allocations_per_frame);
+
+    if (!frame_latencies.empty())
+    {
+        report_latencies(scenario + ".frame_callback_latency", frame_latencies);
+    }
+
+    if (!screencopy_latencies.empty())
+    {
+        report_latencies(scenario + ".screencopy_latency", screencopy_latencies);
+    }
+    EXPECT_EQ(screencopy_failures, 0u);
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_BENCHMARKS_COMPOSITOR_BENCHMARK_H_
+#define MIR_BENCHMARKS_COMPOSITOR_BENCHMARK_H_
+
+#include "benchmark_server.h"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace mir
+{
+namespace benchmarks
+{
+/**
+ * A server compositing with the real GL renderer onto a headless 1920x1080 virtual output, for
+ * benchmarking with in-process synthetic clients.
+ *
+ * The output is unthrottled, so the compositor draws as fast as the clients can keep it busy and
+ * the measurements reflect the cost of compositing rather than a refresh rate. CPU time and
+ * allocations are those of the whole process, clients included.
+ */
+class CompositorBenchmark : public BenchmarkServer
+{
+public:
+    CompositorBenchmark();
+    ~CompositorBenchmark();
+
+    /// Start the clients, and run for a warm-up period and then a measurement period, calling
+    /// load() repeatedly throughout. The results are reported as "<scenario>.<metric>" and
+    /// checked against the baseline.
+    void measure(std::string const& scenario, std::function<void()> const& load = default_load);
+
+    static std::chrono::seconds const warm_up_period;
+    static std::chrono::seconds const measurement_period;
+
+private:
+    class FrameTimes;
+    class TimedCompositorFactory;
+
+    static void default_load();
+
+    std::shared_ptr<FrameTimes> const frame_times;
+};
+}
+}
+
+#endif // MIR_BENCHMARKS_COMPOSITOR_BENCHMARK_H_
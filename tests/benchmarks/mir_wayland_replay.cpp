@@ -0,0 +1,102 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "protocol_replay.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <string>
+
+namespace mb = mir::benchmarks;
+
+namespace
+{
+auto ms(std::chrono::nanoseconds d) -> double
+{
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+void usage(char const* program)
+{
+    printf("Usage: %s [--max-speed] <recording directory>\n"
+        "Replays a session recorded with mir's --wayland-record to the server at $WAYLAND_DISPLAY\n",
+        program);
+}
+}
+
+int main(int argc, char const* argv[])
+try
+{
+    auto speed = mb::ProtocolReplay::Speed::original;
+    char const* recording{nullptr};
+
+    for (auto i = 1; i != argc; ++i)
+    {
+        if (strcmp(argv[i], "--max-speed") == 0)
+        {
+            speed = mb::ProtocolReplay::Speed::maximum;
+        }
+        else if (strcmp(argv[i], "--help") == 0 || recording)
+        {
+            usage(argv[0]);
+            return argc == 2 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        else
+        {
+            recording = argv[i];
+        }
+    }
+
+    if (!recording)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    mb::ProtocolReplay const replay{recording};
+    printf("Replaying %zu requests from %zu clients\n", replay.request_count(), replay.client_count());
+
+    auto result = replay.replay(&mb::ProtocolReplay::connect_to_wayland_display, speed);
+
+    printf("Sent %zu requests in %.2fms (recorded over %.2fms)\n",
+        result.requests, ms(result.elapsed), ms(result.recorded_duration));
+
+    if (!result.lateness.empty())
+    {
+        std::sort(result.lateness.begin(), result.lateness.end());
+        auto const percentile = [&](double p)
+            {
+                return result.lateness[std::min(result.lateness.size() - 1, static_cast<size_t>(p / 100 * result.lateness.size()))];
+            };
+        printf("Lateness: p50=%.3fms p99=%.3fms max=%.3fms\n",
+            ms(percentile(50)), ms(percentile(99)), ms(result.lateness.back()));
+    }
+
+    for (auto const& error : result.errors)
+    {
+        fprintf(stderr, "Error: %s\n", error.c_str());
+    }
+
+    return result.errors.empty() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+catch (std::exception const& error)
+{
+    fprintf(stderr, "%s\n", error.what());
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,693 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "protocol_replay.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <fcntl.h>
+#include <linux/udmabuf.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+namespace mb = mir::benchmarks;
+namespace fs = std::filesystem;
+using namespace std::chrono_literals;
+
+namespace
+{
+// Object ids from here up are allocated by the server
+uint32_t const first_server_id{0xff000000};
+// libwayland doesn't accept more than this in one message
+size_t const max_fds_per_message{28};
+// How long to wait for the server to catch up with the last request
+auto const finish_timeout{60s};
+
+auto now() -> std::chrono::steady_clock::time_point
+{
+    return std::chrono::steady_clock::now();
+}
+
+void append(std::vector<uint32_t>& words, void const* data, size_t size)
+{
+    auto const offset = words.size();
+    words.resize(offset + (size + 3) / 4, 0);
+    memcpy(words.data() + offset, data, size);
+}
+
+/// A string argument as recorded: quoted, with some characters percent-encoded
+auto unquoted(std::string const& token) -> std::string
+{
+    if (token.size() < 2 || token.front() != '"' || token.back() != '"')
+        BOOST_THROW_EXCEPTION((std::runtime_error{"Malformed string argument: " + token}));
+
+    std::string result;
+    for (size_t i = 1; i + 1 < token.size(); ++i)
+    {
+        if (token[i] == '%' && i + 3 < token.size())
+        {
+            result += static_cast<char>(std::stoi(token.substr(i + 1, 2), nullptr, 16));
+            i += 2;
+        }
+        else
+        {
+            result += token[i];
+        }
+    }
+    return result;
+}
+
+/// An array argument as recorded: hex, prefixed with 'x'
+auto unhexed(std::string const& token) -> std::vector<unsigned char>
+{
+    if (token.empty() || token.front() != 'x' || token.size() % 2 != 1)
+        BOOST_THROW_EXCEPTION((std::runtime_error{"Malformed array argument: " + token}));
+
+    std::vector<unsigned char> result;
+    for (size_t i = 1; i != token.size(); i += 2)
+        result.push_back(static_cast<unsigned char>(std::stoi(token.substr(i, 2), nullptr, 16)));
+    return result;
+}
+
+auto shared_memory(size_t size, unsigned flags) -> mir::Fd
+{
+    mir::Fd fd{memfd_create("mir-protocol-replay", MFD_CLOEXEC | flags)};
+    if (fd == mir::Fd::invalid || ftruncate(fd, size) == -1)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create replay memory"}));
+    }
+    return fd;
+}
+
+/// The memory behind a replayed wl_shm_pool
+class Pool
+{
+public:
+    explicit Pool(size_t size)
+        : fd{shared_memory(size, 0)},
+          size{size},
+          data{map(size)}
+    {
+    }
+
+    ~Pool()
+    {
+        munmap(data, size);
+    }
+
+    void resize(size_t new_size)
+    {
+        if (new_size <= size)
+            return;
+
+        if (ftruncate(fd, new_size) == -1)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to resize replay pool"}));
+        }
+        auto const remapped = mremap(data, size, new_size, MREMAP_MAYMOVE);
+        if (remapped == MAP_FAILED)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to remap replay pool"}));
+        }
+        data = static_cast<unsigned char*>(remapped);
+        size = new_size;
+    }
+
+    mir::Fd const fd;
+    size_t size;
+    unsigned char* data;
+
+private:
+    auto map(size_t size) const -> unsigned char*
+    {
+        auto const result = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (result == MAP_FAILED)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to map replay pool"}));
+        }
+        return static_cast<unsigned char*>(result);
+    }
+};
+}
+
+class mb::ProtocolReplay::ClientReplay
+{
+public:
+    ClientReplay(ProtocolReplay const& replay, Client const& client, Fd socket)
+        : replay{replay},
+          client{client},
+          socket{std::move(socket)},
+          udmabuf{open("/dev/udmabuf", O_RDWR | O_CLOEXEC)},
+          finished_future{finished.get_future()}
+    {
+        reader = std::thread{[this] { read_events(); }};
+    }
+
+    ~ClientReplay()
+    {
+        shutdown(socket, SHUT_RDWR);
+        reader.join();
+    }
+
+    void run(Speed speed, std::chrono::steady_clock::time_point replay_start)
+    {
+        std::this_thread::sleep_until(replay_start);
+
+        try
+        {
+            for (auto const& request : client.requests)
+            {
+                if (speed == Speed::original)
+                {
+                    auto const due = replay_start + (request.time - replay.start);
+                    std::this_thread::sleep_until(due);
+                    lateness.push_back(now() - due);
+                }
+
+                if (finished_future.wait_for(0s) == std::future_status::ready)
+                    break;
+
+                perform(request);
+            }
+
+            uint32_t const sync[]{1, 12 << 16 | 0, client.next_id};
+            send(std::vector<uint32_t>{std::begin(sync), std::end(sync)}, {});
+        }
+        catch (std::exception const& error)
+        {
+            errors.push_back(error.what());
+        }
+
+        if (finished_future.wait_for(finish_timeout) == std::future_status::ready)
+        {
+            if (auto const error = finished_future.get(); !error.empty())
+                errors.push_back(error);
+        }
+        else
+        {
+            errors.push_back("Timed out waiting for the server");
+        }
+        finish_time = now();
+    }
+
+    size_t requests{0};
+    std::vector<std::chrono::nanoseconds> lateness;
+    std::vector<std::string> errors;
+    std::chrono::steady_clock::time_point finish_time;
+
+private:
+    struct ShmBuffer
+    {
+        std::shared_ptr<Pool> pool;
+        size_t offset;
+    };
+
+    void perform(Request const& request)
+    {
+        switch (request.action)
+        {
+        case Action::send:
+        {
+            std::vector<Fd> fds;
+            for (auto i = 0; i != request.fds; ++i)
+                fds.push_back(shared_memory(0, 0));
+            send(request, {fds.begin(), fds.end()});
+            break;
+        }
+
+        case Action::shm_content:
+            if (auto const buffer = shm_buffers.find(request.object); buffer != shm_buffers.end())
+            {
+                auto const& content = replay.contents.at(request.content);
+                auto const& [pool, offset] = buffer->second;
+                if (offset < pool->size)
+                    memcpy(pool->data + offset, content.data(), std::min(content.size(), pool->size - offset));
+            }
+            return;
+
+        case Action::create_pool:
+        {
+            auto const pool = std::make_shared<Pool>(request.numbers.at(1));
+            pools[request.numbers.at(0)] = pool;
+            send(request, {pool->fd});
+            break;
+        }
+
+        case Action::resize_pool:
+            if (auto const pool = pools.find(request.object); pool != pools.end())
+                pool->second->resize(request.numbers.at(0));
+            send(request, {});
+            break;
+
+        case Action::destroy_pool:
+            send(request, {});
+            pools.erase(request.object);
+            break;
+
+        case Action::create_shm_buffer:
+            if (auto const pool = pools.find(request.object); pool != pools.end())
+                shm_buffers[request.numbers.at(0)] = ShmBuffer{pool->second, static_cast<size_t>(request.numbers.at(1))};
+            send(request, {});
+            break;
+
+        case Action::destroy_buffer:
+            send(request, {});
+            shm_buffers.erase(request.object);
+            break;
+
+        case Action::add_dmabuf_plane:
+            // Sent with the create request, when the size of the memory is known
+            dmabuf_planes[request.object].push_back(&request);
+            return;
+
+        case Action::create_dmabuf:
+            create_dmabuf(request);
+            break;
+        }
+
+        ++requests;
+    }
+
+    void create_dmabuf(Request const& request)
+    {
+        auto const& planes = dmabuf_planes[request.object];
+
+        // create is (width, height, format, flags); create_immed has the new buffer first
+        auto const height = request.numbers.at(request.numbers.size() - 3);
+        size_t size{0};
+        for (auto const plane : planes)
+        {
+            // (plane_idx, offset, stride, modifier_hi, modifier_lo)
+            size = std::max<size_t>(size, plane->numbers.at(1) + plane->numbers.at(2) * height);
+        }
+
+        auto const memory = dmabuf_memory(std::max<size_t>(size, 1));
+        for (auto const plane : planes)
+        {
+            send(*plane, {memory});
+            ++requests;
+        }
+        send(request, {});
+
+        dmabuf_planes.erase(request.object);
+    }
+
+    /// udmabufs need whole, sealed pages
+    auto dmabuf_memory(size_t size) const -> Fd
+    {
+        auto const page_size = sysconf(_SC_PAGESIZE);
+        auto const bytes = (size + page_size - 1) / page_size * page_size;
+        auto memory = shared_memory(bytes, MFD_ALLOW_SEALING);
+
+        if (udmabuf == Fd::invalid || fcntl(memory, F_ADD_SEALS, F_SEAL_SHRINK) == -1)
+            return memory;
+
+        udmabuf_create create{};
+        create.memfd = static_cast<uint32_t>(static_cast<int>(memory));
+        create.flags = UDMABUF_FLAGS_CLOEXEC;
+        create.offset = 0;
+        create.size = bytes;
+        Fd dmabuf{ioctl(udmabuf, UDMABUF_CREATE, &create)};
+        return dmabuf != Fd::invalid ? dmabuf : memory;
+    }
+
+    void send(Request const& request, std::vector<int> const& fds)
+    {
+        send(request.words, fds);
+    }
+
+    void send(std::vector<uint32_t> const& words, std::vector<int> const& fds)
+    {
+        if (fds.size() > max_fds_per_message)
+            BOOST_THROW_EXCEPTION((std::runtime_error{"Too many file descriptors in one request"}));
+
+        auto const bytes = reinterpret_cast<char const*>(words.data());
+        auto const size = words.size() * sizeof(uint32_t);
+
+        for (size_t sent = 0; sent != size;)
+        {
+            iovec iov{const_cast<char*>(bytes + sent), size - sent};
+            msghdr message{};
+            message.msg_iov = &iov;
+            message.msg_iovlen = 1;
+
+            alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * max_fds_per_message)];
+            if (sent == 0 && !fds.empty())
+            {
+                message.msg_control = control;
+                message.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+                auto const header = CMSG_FIRSTHDR(&message);
+                header->cmsg_level = SOL_SOCKET;
+                header->cmsg_type = SCM_RIGHTS;
+                header->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+                memcpy(CMSG_DATA(header), fds.data(), sizeof(int) * fds.size());
+            }
+
+            auto const result = sendmsg(socket, &message, MSG_NOSIGNAL);
+            if (result < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to send request"}));
+            }
+            sent += result;
+        }
+    }
+
+    /// Discards events until the final wl_display.sync is done, or the server reports an error
+    void read_events()
+    {
+        std::vector<unsigned char> pending;
+        unsigned char buffer[4096];
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * max_fds_per_message)];
+
+        for (;;)
+        {
+            iovec iov{buffer, sizeof buffer};
+            msghdr message{};
+            message.msg_iov = &iov;
+            message.msg_iovlen = 1;
+            message.msg_control = control;
+            message.msg_controllen = sizeof control;
+
+            auto const received = recvmsg(socket, &message, MSG_CMSG_CLOEXEC);
+            if (received < 0 && errno == EINTR)
+                continue;
+            if (received <= 0)
+                return finish("The server disconnected");
+
+            // Keymaps and the like are of no interest
+            for (auto header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header))
+            {
+                if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS)
+                {
+                    auto const count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                    for (size_t i = 0; i != count; ++i)
+                    {
+                        int fd;
+                        memcpy(&fd, CMSG_DATA(header) + i * sizeof(int), sizeof fd);
+                        close(fd);
+                    }
+                }
+            }
+
+            pending.insert(pending.end(), buffer, buffer + received);
+
+            while (pending.size() >= 8)
+            {
+                uint32_t header[2];
+                memcpy(header, pending.data(), sizeof header);
+                auto const size = header[1] >> 16;
+                auto const opcode = header[1] & 0xffff;
+
+                if (size < sizeof header)
+                    return finish("Malformed event from the server");
+                if (pending.size() < size)
+                    break;
+
+                if (header[0] == 1 && opcode == 0 && size >= 20)
+                {
+                    // wl_display.error(object, code, message)
+                    uint32_t error[3];
+                    memcpy(error, pending.data() + 8, sizeof error);
+                    std::string const text{
+                        reinterpret_cast<char const*>(pending.data() + 20),
+                        strnlen(reinterpret_cast<char const*>(pending.data() + 20), size - 20)};
+                    return finish(
+                        "Protocol error " + std::to_string(error[1]) + " on object " + std::to_string(error[0]) +
+                        ": " + text);
+                }
+
+                if (header[0] == client.next_id && opcode == 0)
+                    return finish({});
+
+                pending.erase(pending.begin(), pending.begin() + size);
+            }
+        }
+    }
+
+    void finish(std::string const& error)
+    {
+        finished.set_value(error);
+    }
+
+    ProtocolReplay const& replay;
+    Client const& client;
+    Fd const socket;
+    Fd const udmabuf;
+
+    std::map<uint32_t, std::shared_ptr<Pool>> pools;
+    std::map<uint32_t, ShmBuffer> shm_buffers;
+    std::map<uint32_t, std::vector<Request const*>> dmabuf_planes;
+
+    std::promise<std::string> finished;
+    std::future<std::string> finished_future;
+    std::thread reader;
+};
+
+mb::ProtocolReplay::ProtocolReplay(fs::path const& recording)
+{
+    std::vector<std::pair<int, fs::path>> files;
+    for (auto const& entry : fs::directory_iterator{recording})
+    {
+        auto const name = entry.path().filename().string();
+        if (name.rfind("client-", 0) == 0 && entry.path().extension() == ".wlrec")
+            files.emplace_back(std::stoi(name.substr(7)), entry.path());
+    }
+    std::sort(files.begin(), files.end());
+
+    if (files.empty())
+        BOOST_THROW_EXCEPTION((std::runtime_error{"No Wayland client recordings in " + recording.string()}));
+
+    std::optional<std::chrono::nanoseconds> first;
+
+    for (auto const& [_, path] : files)
+    {
+        std::ifstream in{path};
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(in, line);)
+        {
+            if (!line.empty() && line.front() != '#')
+                lines.push_back(line);
+        }
+
+        Client client;
+        for (size_t i = 0; i != lines.size(); ++i)
+        {
+            try
+            {
+                std::istringstream line{lines[i]};
+                Request request;
+                int64_t time;
+                std::string object;
+                line >> time >> object;
+                request.time = std::chrono::nanoseconds{time};
+
+                if (object == "shm")
+                {
+                    request.action = Action::shm_content;
+                    line >> request.object >> request.content;
+                    if (!line)
+                        BOOST_THROW_EXCEPTION((std::runtime_error{"Truncated line"}));
+
+                    if (!contents.count(request.content))
+                    {
+                        std::ifstream content{recording / "shm" / request.content, std::ios::binary};
+                        if (!content)
+                            BOOST_THROW_EXCEPTION((std::runtime_error{"Missing SHM content " + request.content}));
+                        contents[request.content].assign(std::istreambuf_iterator<char>{content}, {});
+                    }
+                    client.requests.push_back(std::move(request));
+                    continue;
+                }
+
+                std::string interface, message, signature;
+                uint32_t opcode;
+                line >> interface >> opcode >> message >> signature;
+                if (!line)
+                    BOOST_THROW_EXCEPTION((std::runtime_error{"Truncated line"}));
+                request.object = std::stoul(object);
+
+                if (interface == "wl_shm" && message == "create_pool")
+                    request.action = Action::create_pool;
+                else if (interface == "wl_shm_pool" && message == "resize")
+                    request.action = Action::resize_pool;
+                else if (interface == "wl_shm_pool" && message == "destroy")
+                    request.action = Action::destroy_pool;
+                else if (interface == "wl_shm_pool" && message == "create_buffer")
+                    request.action = Action::create_shm_buffer;
+                else if (interface == "wl_buffer" && message == "destroy")
+                    request.action = Action::destroy_buffer;
+                else if (interface == "zwp_linux_buffer_params_v1" && message == "add")
+                    request.action = Action::add_dmabuf_plane;
+                else if (interface == "zwp_linux_buffer_params_v1" && (message == "create" || message == "create_immed"))
+                    request.action = Action::create_dmabuf;
+                else
+                    request.action = Action::send;
+
+                request.words = {request.object, 0};
+                for (auto const c : signature == "-" ? std::string{} : signature)
+                {
+                    if (c == '?')
+                        continue;
+
+                    std::string token;
+                    if (!(line >> token))
+                        BOOST_THROW_EXCEPTION((std::runtime_error{"Truncated line"}));
+
+                    switch (c)
+                    {
+                    case 's':
+                        if (token == "null")
+                        {
+                            request.words.push_back(0);
+                        }
+                        else
+                        {
+                            auto const string = unquoted(token);
+                            request.words.push_back(string.size() + 1);
+                            append(request.words, string.c_str(), string.size() + 1);
+                        }
+                        break;
+
+                    case 'a':
+                    {
+                        auto const array = unhexed(token);
+                        request.words.push_back(array.size());
+                        append(request.words, array.data(), array.size());
+                        break;
+                    }
+
+                    case 'h':
+                        ++request.fds;
+                        break;
+
+                    default:
+                    {
+                        auto const value = std::stoll(token);
+                        request.numbers.push_back(value);
+                        request.words.push_back(static_cast<uint32_t>(value));
+                        if (c == 'n' && value < first_server_id)
+                            client.next_id = std::max(client.next_id, static_cast<uint32_t>(value + 1));
+                        break;
+                    }
+                    }
+                }
+                request.words[1] = static_cast<uint32_t>(request.words.size() * sizeof(uint32_t)) << 16 | opcode;
+
+                client.requests.push_back(std::move(request));
+            }
+            catch (std::exception const& error)
+            {
+                // A session that crashed the server may have been cut off mid-line
+                if (i + 1 == lines.size())
+                    break;
+
+                BOOST_THROW_EXCEPTION((std::runtime_error{
+                    path.string() + ": " + error.what() + " in line: " + lines[i]}));
+            }
+        }
+
+        if (!client.requests.empty())
+        {
+            first = std::min(first.value_or(client.requests.front().time), client.requests.front().time);
+            end = std::max(end, client.requests.back().time);
+            clients.push_back(std::move(client));
+        }
+    }
+
+    start = first.value_or(end);
+}
+
+auto mb::ProtocolReplay::request_count() const -> size_t
+{
+    size_t result{0};
+    for (auto const& client : clients)
+    {
+        result += std::count_if(client.requests.begin(), client.requests.end(),
+            [](Request const& request) { return request.action != Action::shm_content; });
+    }
+    return result;
+}
+
+auto mb::ProtocolReplay::replay(std::function<Fd()> const& connect, Speed speed) const -> Result
+{
+    std::vector<std::unique_ptr<ClientReplay>> replays;
+    for (auto const& client : clients)
+        replays.push_back(std::make_unique<ClientReplay>(*this, client, connect()));
+
+    // Give every thread time to start, so that they all begin together
+    auto const replay_start = now() + 10ms;
+
+    std::vector<std::thread> threads;
+    for (auto const& client : replays)
+        threads.emplace_back([&client, speed, replay_start] { client->run(speed, replay_start); });
+    for (auto& thread : threads)
+        thread.join();
+
+    Result result;
+    result.recorded_duration = end - start;
+    for (size_t i = 0; i != replays.size(); ++i)
+    {
+        auto const& client = *replays[i];
+        result.requests += client.requests;
+        result.elapsed = std::max<std::chrono::nanoseconds>(result.elapsed, client.finish_time - replay_start);
+        result.lateness.insert(result.lateness.end(), client.lateness.begin(), client.lateness.end());
+        for (auto const& error : client.errors)
+            result.errors.push_back("client " + std::to_string(i) + ": " + error);
+    }
+    return result;
+}
+
+auto mb::ProtocolReplay::connect_to_wayland_display() -> Fd
+{
+    std::string display{getenv("WAYLAND_DISPLAY") ? getenv("WAYLAND_DISPLAY") : "wayland-0"};
+    if (display.front() != '/')
+    {
+        auto const runtime_dir = getenv("XDG_RUNTIME_DIR");
+        if (!runtime_dir)
+            BOOST_THROW_EXCEPTION((std::runtime_error{"XDG_RUNTIME_DIR is not set"}));
+        display = std::string{runtime_dir} + "/" + display;
+    }
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (display.size() >= sizeof address.sun_path)
+        BOOST_THROW_EXCEPTION((std::runtime_error{"Wayland socket path too long: " + display}));
+    strncpy(address.sun_path, display.c_str(), sizeof address.sun_path - 1);
+
+    Fd socket{::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)};
+    if (socket == Fd::invalid ||
+        ::connect(socket, reinterpret_cast<sockaddr const*>(&address), sizeof address) == -1)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to connect to " + display}));
+    }
+    return socket;
+}
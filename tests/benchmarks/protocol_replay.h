@@ -0,0 +1,126 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_BENCHMARKS_PROTOCOL_REPLAY_H_
+#define MIR_BENCHMARKS_PROTOCOL_REPLAY_H_
+
+#include <mir/fd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace mir
+{
+namespace benchmarks
+{
+/**
+ * Replays a session recorded with --wayland-record against a server.
+ *
+ * Each recorded client is replayed on its own connection and thread. Requests are written straight
+ * onto the socket with their recorded object ids, so the server sees the traffic it saw when
+ * recording. Events from the server are read and discarded, except that a protocol error fails
+ * the replay.
+ *
+ * File descriptors can't be recorded, so they are recreated: wl_shm pools get fresh memory, into
+ * which the recorded content is written before each attach; dmabufs get udmabuf memory (or plain
+ * memfd memory, which the server may refuse, when /dev/udmabuf isn't available) of the recorded
+ * size; any other file descriptor is an empty memfd. Serials are replayed as recorded.
+ */
+class ProtocolReplay
+{
+public:
+    enum class Speed
+    {
+        original,   ///< Each request is sent at its recorded time
+        maximum     ///< Each request is sent as soon as the last one has been
+    };
+
+    struct Result
+    {
+        size_t requests{0};
+        /// From the first request to the last, as recorded
+        std::chrono::nanoseconds recorded_duration{0};
+        /// From the first request to the server having handled the last, for the slowest client
+        std::chrono::nanoseconds elapsed{0};
+        /// How late each request was sent relative to its recorded time (at original speed)
+        std::vector<std::chrono::nanoseconds> lateness;
+        /// Protocol errors, disconnections and the like
+        std::vector<std::string> errors;
+    };
+
+    /// Load the recording in a directory written by --wayland-record
+    explicit ProtocolReplay(std::filesystem::path const& recording);
+
+    auto client_count() const -> size_t { return clients.size(); }
+    auto request_count() const -> size_t;
+
+    /// Replay every client, each on a connection made by connect(), and wait for them to finish
+    auto replay(std::function<Fd()> const& connect, Speed speed) const -> Result;
+
+    /// A connection to the server named by $WAYLAND_DISPLAY
+    static auto connect_to_wayland_display() -> Fd;
+
+private:
+    enum class Action
+    {
+        send,
+        shm_content,
+        create_pool,
+        resize_pool,
+        destroy_pool,
+        create_shm_buffer,
+        destroy_buffer,
+        add_dmabuf_plane,
+        create_dmabuf
+    };
+
+    struct Request
+    {
+        std::chrono::nanoseconds time;
+        Action action;
+        uint32_t object;
+        /// The message on the wire, except for the file descriptors
+        std::vector<uint32_t> words;
+        int fds{0};
+        /// The integer arguments (i, u, f, o and n) in order
+        std::vector<int64_t> numbers;
+        /// The hash of recorded SHM content
+        std::string content;
+    };
+
+    struct Client
+    {
+        std::vector<Request> requests;
+        /// The first id not used by the client, for the final wl_display.sync
+        uint32_t next_id{2};
+    };
+
+    class ClientReplay;
+
+    std::vector<Client> clients;
+    std::map<std::string, std::vector<unsigned char>> contents;
+    std::chrono::nanoseconds start{0};
+    std::chrono::nanoseconds end{0};
+};
+}
+}
+
+#endif // MIR_BENCHMARKS_PROTOCOL_REPLAY_H_
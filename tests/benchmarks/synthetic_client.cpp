@@ -0,0 +1,845 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "synthetic_client.h"
+
+#include "xdg-shell-client.h"
+#include "linux-dmabuf-unstable-v1-client.h"
+#include "protocol/wlr-screencopy-unstable-v1-client.h"
+
+#include <wayland-client.h>
+#include <drm_fourcc.h>
+#include <linux/udmabuf.h>
+
+#include <boost/throw_exception.hpp>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <system_error>
+
+namespace mb = mir::benchmarks;
+namespace geom = mir::geometry;
+using namespace std::chrono_literals;
+
+namespace
+{
+int const small_damage_side{32};
+// Enough that one is almost always free when a frame callback arrives
+int const dmabuf_count{3};
+
+auto now() -> std::chrono::steady_clock::time_point
+{
+    return std::chrono::steady_clock::now();
+}
+
+auto shared_memory(size_t size, unsigned flags) -> mir::Fd
+{
+    mir::Fd fd{memfd_create("mir-synthetic-client", MFD_CLOEXEC | flags)};
+    if (fd == mir::Fd::invalid || ftruncate(fd, size) == -1)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create buffer memory"}));
+    }
+    return fd;
+}
+
+void fill(uint32_t* pixels, geom::Stride stride, geom::Rectangle const& area, uint32_t colour)
+{
+    for (auto y = area.top().as_int(); y != area.bottom().as_int(); ++y)
+    {
+        auto const row = pixels + y * stride.as_int() / 4;
+        std::fill(row + area.left().as_int(), row + area.right().as_int(), colour);
+    }
+}
+}
+
+class mb::SyntheticClient::Buffer
+{
+public:
+    static auto shm(wl_shm* shm, geom::Size size) -> std::unique_ptr<Buffer>
+    {
+        geom::Stride const stride{size.width.as_int() * 4};
+        auto const bytes = stride.as_int() * size.height.as_int();
+        auto const fd = shared_memory(bytes, 0);
+
+        auto const pool = wl_shm_create_pool(shm, fd, bytes);
+        auto const buffer = wl_shm_pool_create_buffer(
+            pool, 0, size.width.as_int(), size.height.as_int(), stride.as_int(), WL_SHM_FORMAT_XRGB8888);
+        wl_shm_pool_destroy(pool);
+
+        return std::unique_ptr<Buffer>{new Buffer{buffer, fd, size, stride}};
+    }
+
+    /// The memory is a memfd, shared with the compositor as a dmabuf by /dev/udmabuf
+    static auto dmabuf(
+        wl_display* display,
+        zwp_linux_dmabuf_v1* linux_dmabuf,
+        int udmabuf,
+        uint64_t modifier,
+        geom::Size size) -> std::unique_ptr<Buffer>
+    {
+        geom::Stride const stride{size.width.as_int() * 4};
+        // udmabuf needs whole, sealed, pages
+        auto const page_size = sysconf(_SC_PAGESIZE);
+        auto const bytes = (stride.as_int() * size.height.as_int() + page_size - 1) / page_size * page_size;
+        auto const fd = shared_memory(bytes, MFD_ALLOW_SEALING);
+
+        if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK) == -1)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to seal buffer memory"}));
+        }
+
+        udmabuf_create create{};
+        create.memfd = static_cast<uint32_t>(static_cast<int>(fd));
+        create.flags = UDMABUF_FLAGS_CLOEXEC;
+        create.offset = 0;
+        create.size = bytes;
+        mir::Fd const dmabuf{ioctl(udmabuf, UDMABUF_CREATE, &create)};
+        if (dmabuf == mir::Fd::invalid)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create udmabuf"}));
+        }
+
+        struct Result
+        {
+            wl_buffer* buffer{nullptr};
+            bool done{false};
+        } result;
+
+        static zwp_linux_buffer_params_v1_listener const params_listener{
+            [](void* data, zwp_linux_buffer_params_v1*, wl_buffer* buffer)
+                {
+                    auto const result = static_cast<Result*>(data);
+                    result->buffer = buffer;
+                    result->done = true;
+                },
+            [](void* data, zwp_linux_buffer_params_v1*)
+                {
+                    static_cast<Result*>(data)->done = true;
+                },
+        };
+
+        auto const params = zwp_linux_dmabuf_v1_create_params(linux_dmabuf);
+        zwp_linux_buffer_params_v1_add_listener(params, &params_listener, &result);
+        zwp_linux_buffer_params_v1_add(
+            params, dmabuf, 0, 0, stride.as_int(), modifier >> 32, modifier & 0xffffffff);
+        zwp_linux_buffer_params_v1_create(params, size.width.as_int(), size.height.as_int(), DRM_FORMAT_XRGB8888, 0);
+
+        while (!result.done)
+        {
+            if (wl_display_roundtrip(display) == -1)
+                BOOST_THROW_EXCEPTION(std::runtime_error{"Lost connection to the compositor"});
+        }
+        zwp_linux_buffer_params_v1_destroy(params);
+
+        if (!result.buffer)
+        {
+            BOOST_THROW_EXCEPTION(std::runtime_error{"The compositor failed to import a udmabuf"});
+        }
+
+        return std::unique_ptr<Buffer>{new Buffer{result.buffer, fd, size, stride}};
+    }
+
+    ~Buffer()
+    {
+        wl_buffer_destroy(buffer);
+        munmap(mapping, bytes);
+    }
+
+    wl_buffer* const buffer;
+    geom::Size const size;
+    geom::Stride const stride;
+    uint32_t* const pixels;
+    bool busy{false};
+
+private:
+    Buffer(wl_buffer* buffer, int fd, geom::Size size, geom::Stride stride) :
+        buffer{buffer},
+        size{size},
+        stride{stride},
+        pixels{static_cast<uint32_t*>(map(fd, stride.as_int() * size.height.as_int()))},
+        bytes{static_cast<size_t>(stride.as_int() * size.height.as_int())},
+        mapping{pixels}
+    {
+        static wl_buffer_listener const buffer_listener{
+            [](void* data, wl_buffer*) { static_cast<Buffer*>(data)->busy = false; },
+        };
+        wl_buffer_add_listener(buffer, &buffer_listener, this);
+    }
+
+    static auto map(int fd, size_t bytes) -> void*
+    {
+        auto const result = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (result == MAP_FAILED)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to map buffer"}));
+        }
+        return result;
+    }
+
+    size_t const bytes;
+    void* const mapping;
+};
+
+/// A surface that redraws whenever it gets a frame callback
+class mb::SyntheticClient::Surface
+{
+public:
+    Surface(SyntheticClient& client, geom::Size size, Damage damage, BufferType buffer_type) :
+        client{client},
+        surface{wl_compositor_create_surface(client.compositor)},
+        shell_surface{xdg_wm_base_get_xdg_surface(client.shell, surface)},
+        damage{damage},
+        buffer_type{buffer_type},
+        size{size}
+    {
+        static xdg_surface_listener const shell_surface_listener{
+            [](void* data, xdg_surface*, uint32_t serial) { static_cast<Surface*>(data)->configure(serial); },
+        };
+        xdg_surface_add_listener(shell_surface, &shell_surface_listener, this);
+
+        if (buffer_type == BufferType::dmabuf)
+        {
+            if (!client.supports_dmabuf())
+            {
+                BOOST_THROW_EXCEPTION(std::runtime_error{"The compositor does not accept linear XRGB8888 udmabufs"});
+            }
+
+            for (auto i = 0; i != dmabuf_count; ++i)
+            {
+                buffers.push_back(Buffer::dmabuf(
+                    client.display, client.linux_dmabuf, client.udmabuf, *client.dmabuf_modifier(), size));
+            }
+        }
+    }
+
+    virtual ~Surface()
+    {
+        if (frame_callback)
+            wl_callback_destroy(frame_callback);
+        buffers.clear();
+        xdg_surface_destroy(shell_surface);
+        wl_surface_destroy(surface);
+    }
+
+    /// Commit the role's initial state and wait until the first frame has been committed
+    void map()
+    {
+        wl_surface_commit(surface);
+        while (!configured)
+        {
+            client.roundtrip();
+        }
+    }
+
+    xdg_surface* shell() const { return shell_surface; }
+
+protected:
+    void set_pending_size(int32_t width, int32_t height)
+    {
+        // Buffers imported as dmabufs keep the size they were created with
+        if (width > 0 && height > 0 && buffer_type == BufferType::shm)
+        {
+            size = geom::Size{width, height};
+        }
+    }
+
+    void stop_drawing()
+    {
+        dismissed = true;
+    }
+
+private:
+    void configure(uint32_t serial)
+    {
+        xdg_surface_ack_configure(shell_surface, serial);
+
+        if (!configured)
+        {
+            configured = true;
+            draw();
+        }
+    }
+
+    auto next_buffer() -> Buffer&
+    {
+        // Buffers of an old size are not reused
+        buffers.erase(
+            std::remove_if(buffers.begin(), buffers.end(), [this](auto const& b) { return b->size != size; }),
+            buffers.end());
+
+        for (auto const& buffer : buffers)
+        {
+            if (!buffer->busy)
+                return *buffer;
+        }
+
+        switch (buffer_type)
+        {
+        case BufferType::shm:
+            buffers.push_back(Buffer::shm(client.shm, size));
+            break;
+
+        case BufferType::dmabuf:
+            // Importing needs a roundtrip, so all the dmabufs were allocated up front. Drawing over
+            // one the compositor holds risks tearing, which doesn't matter here
+            return *buffers[frame % buffers.size()];
+        }
+        return *buffers.back();
+    }
+
+    void draw()
+    {
+        if (dismissed)
+            return;
+
+        auto& buffer = next_buffer();
+        auto const colour = 0xff000000 | (frame * 0x010203);
+        geom::Rectangle const whole{{0, 0}, buffer.size};
+
+        switch (damage)
+        {
+        case Damage::small:
+        {
+            // A square moving along the diagonal: the area it left, and the area it entered, change
+            auto const travel = std::max(1, std::min(buffer.size.width.as_int(), buffer.size.height.as_int()) - small_damage_side);
+            auto const offset = static_cast<int>(frame * 4 % static_cast<uint32_t>(travel));
+            geom::Rectangle const square{{offset, offset}, {small_damage_side, small_damage_side}};
+            auto const changed = intersection_of(
+                geom::Rectangle{{offset - 4, offset - 4}, {small_damage_side + 4, small_damage_side + 4}},
+                whole);
+
+            fill(buffer.pixels, buffer.stride, changed, 0xff202020);
+            fill(buffer.pixels, buffer.stride, intersection_of(square, whole), colour);
+            wl_surface_damage_buffer(
+                surface,
+                changed.left().as_int(), changed.top().as_int(),
+                changed.size.width.as_int(), changed.size.height.as_int());
+            break;
+        }
+
+        case Damage::full:
+        case Damage::none:
+            fill(buffer.pixels, buffer.stride, whole, colour);
+            wl_surface_damage_buffer(surface, 0, 0, buffer.size.width.as_int(), buffer.size.height.as_int());
+            break;
+        }
+
+        if (damage != Damage::none)
+        {
+            static wl_callback_listener const frame_listener{
+                [](void* data, wl_callback*, uint32_t) { static_cast<Surface*>(data)->frame_done(); },
+            };
+            frame_callback = wl_surface_frame(surface);
+            wl_callback_add_listener(frame_callback, &frame_listener, this);
+        }
+
+        wl_surface_attach(surface, buffer.buffer, 0, 0);
+        buffer.busy = true;
+        wl_surface_commit(surface);
+        committed = now();
+        ++frame;
+    }
+
+    void frame_done()
+    {
+        wl_callback_destroy(frame_callback);
+        frame_callback = nullptr;
+        client.add_latency(now() - committed);
+        draw();
+    }
+
+    SyntheticClient& client;
+    wl_surface* const surface;
+    xdg_surface* const shell_surface;
+    Damage const damage;
+    BufferType const buffer_type;
+    geom::Size size;
+    std::vector<std::unique_ptr<Buffer>> buffers;
+    bool configured{false};
+    bool dismissed{false};
+    wl_callback* frame_callback{nullptr};
+    std::chrono::steady_clock::time_point committed;
+    uint32_t frame{0};
+};
+
+class mb::SyntheticClient::Toplevel : public Surface
+{
+public:
+    Toplevel(SyntheticClient& client, geom::Size size, Damage damage, BufferType buffer_type) :
+        Surface{client, size, damage, buffer_type},
+        toplevel{xdg_surface_get_toplevel(shell())}
+    {
+        static xdg_toplevel_listener const toplevel_listener{
+            [](void* data, xdg_toplevel*, int32_t width, int32_t height, wl_array*)
+                { static_cast<Toplevel*>(data)->set_pending_size(width, height); },
+            [](void*, xdg_toplevel*) {},
+        };
+        xdg_toplevel_add_listener(toplevel, &toplevel_listener, this);
+        xdg_toplevel_set_title(toplevel, "synthetic client");
+        map();
+    }
+
+    ~Toplevel()
+    {
+        xdg_toplevel_destroy(toplevel);
+    }
+
+private:
+    xdg_toplevel* const toplevel;
+};
+
+class mb::SyntheticClient::Popup : public Surface
+{
+public:
+    Popup(SyntheticClient& client, Surface& parent, geom::Rectangle placement, Damage damage) :
+        Surface{client, placement.size, damage, BufferType::shm},
+        popup{make_popup(client, parent, placement)}
+    {
+        static xdg_popup_listener const popup_listener{
+            [](void*, xdg_popup*, int32_t, int32_t, int32_t, int32_t) {},
+            [](void* data, xdg_popup*) { static_cast<Popup*>(data)->stop_drawing(); },
+        };
+        xdg_popup_add_listener(popup, &popup_listener, this);
+        map();
+    }
+
+    ~Popup()
+    {
+        xdg_popup_destroy(popup);
+    }
+
+private:
+    auto make_popup(SyntheticClient& client, Surface& parent, geom::Rectangle placement) -> xdg_popup*
+    {
+        auto const positioner = xdg_wm_base_create_positioner(client.shell);
+        xdg_positioner_set_size(positioner, placement.size.width.as_int(), placement.size.height.as_int());
+        xdg_positioner_set_anchor_rect(positioner, placement.left().as_int(), placement.top().as_int(), 1, 1);
+        xdg_positioner_set_anchor(positioner, XDG_POSITIONER_ANCHOR_TOP_LEFT);
+        xdg_positioner_set_gravity(positioner, XDG_POSITIONER_GRAVITY_BOTTOM_RIGHT);
+        auto const result = xdg_surface_get_popup(shell(), parent.shell(), positioner);
+        xdg_positioner_destroy(positioner);
+        return result;
+    }
+
+    xdg_popup* const popup;
+};
+
+/// Captures the output over and over, like a screen recorder that can keep up
+class mb::SyntheticClient::ScreenCopier
+{
+public:
+    explicit ScreenCopier(SyntheticClient& client) :
+        client{client}
+    {
+        capture();
+    }
+
+    ~ScreenCopier()
+    {
+        if (frame)
+            zwlr_screencopy_frame_v1_destroy(frame);
+    }
+
+    std::vector<std::chrono::nanoseconds> latencies;
+    unsigned failures{0};
+
+private:
+    void capture()
+    {
+        static zwlr_screencopy_frame_v1_listener const frame_listener{
+            [](void* data, zwlr_screencopy_frame_v1*, uint32_t format, uint32_t width, uint32_t height, uint32_t stride)
+                { static_cast<ScreenCopier*>(data)->copy(format, geom::Size{width, height}, geom::Stride{stride}); },
+            [](void*, zwlr_screencopy_frame_v1*, uint32_t) {},
+            [](void* data, zwlr_screencopy_frame_v1*, uint32_t, uint32_t, uint32_t)
+                { static_cast<ScreenCopier*>(data)->ready(); },
+            [](void* data, zwlr_screencopy_frame_v1*)
+                { static_cast<ScreenCopier*>(data)->failed(); },
+            [](void*, zwlr_screencopy_frame_v1*, uint32_t, uint32_t, uint32_t, uint32_t) {},
+            [](void*, zwlr_screencopy_frame_v1*, uint32_t, uint32_t, uint32_t) {},
+            [](void*, zwlr_screencopy_frame_v1*) {},
+        };
+
+        frame = zwlr_screencopy_manager_v1_capture_output(client.screencopy_manager, 0, client.output);
+        zwlr_screencopy_frame_v1_add_listener(frame, &frame_listener, this);
+        requested = now();
+    }
+
+    void copy(uint32_t format, geom::Size size, geom::Stride stride)
+    {
+        if (format != WL_SHM_FORMAT_XRGB8888 && format != WL_SHM_FORMAT_ARGB8888)
+        {
+            BOOST_THROW_EXCEPTION(std::runtime_error{"Unexpected screencopy format"});
+        }
+
+        if (!buffer || buffer->size != size || buffer->stride != stride)
+        {
+            buffer = Buffer::shm(client.shm, size);
+        }
+        zwlr_screencopy_frame_v1_copy(frame, buffer->buffer);
+    }
+
+    void ready()
+    {
+        if (client.measuring)
+            latencies.push_back(now() - requested);
+        recapture();
+    }
+
+    void failed()
+    {
+        if (client.measuring)
+            ++failures;
+        recapture();
+    }
+
+    void recapture()
+    {
+        zwlr_screencopy_frame_v1_destroy(frame);
+        frame = nullptr;
+        capture();
+    }
+
+    SyntheticClient& client;
+    zwlr_screencopy_frame_v1* frame{nullptr};
+    std::unique_ptr<Buffer> buffer;
+    std::chrono::steady_clock::time_point requested;
+};
+
+mb::SyntheticClient::SyntheticClient(Fd connection) :
+    // libwayland takes ownership of the fd it is given
+    display{wl_display_connect_to_fd(fcntl(connection, F_DUPFD_CLOEXEC, 3))}
+{
+    if (!display)
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error{"Failed to connect to the compositor"});
+    }
+
+    static wl_registry_listener const registry_listener{
+        new_global,
+        [](void*, wl_registry*, uint32_t) {},
+    };
+    registry = wl_display_get_registry(display);
+    wl_registry_add_listener(registry, &registry_listener, this);
+
+    // One roundtrip for the globals, and one for the events sent when they are bound
+    roundtrip();
+    roundtrip();
+
+    if (!compositor || !shm || !shell)
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error{"The compositor lacks wl_compositor, wl_shm or xdg_wm_base"});
+    }
+
+    udmabuf = Fd{open("/dev/udmabuf", O_RDWR | O_CLOEXEC)};
+}
+
+mb::SyntheticClient::~SyntheticClient()
+{
+    running = false;
+    if (event_thread.joinable())
+        event_thread.join();
+
+    screen_copier.reset();
+    surfaces.clear();
+
+    if (pointer)
+        wl_pointer_destroy(pointer);
+    if (keyboard)
+        wl_keyboard_destroy(keyboard);
+    if (touch)
+        wl_touch_destroy(touch);
+    if (seat)
+        wl_seat_destroy(seat);
+    if (screencopy_manager)
+        zwlr_screencopy_manager_v1_destroy(screencopy_manager);
+    if (linux_dmabuf)
+        zwp_linux_dmabuf_v1_destroy(linux_dmabuf);
+    if (output)
+        wl_output_destroy(output);
+    xdg_wm_base_destroy(shell);
+    wl_shm_destroy(shm);
+    wl_compositor_destroy(compositor);
+    wl_registry_destroy(registry);
+    wl_display_disconnect(display);
+}
+
+void mb::SyntheticClient::new_global(
+    void* data, wl_registry* registry, uint32_t id, char const* interface, uint32_t version)
+{
+    auto const self = static_cast<SyntheticClient*>(data);
+
+    if (strcmp(interface, wl_compositor_interface.name) == 0)
+    {
+        self->compositor = static_cast<wl_compositor*>(
+            wl_registry_bind(registry, id, &wl_compositor_interface, std::min(version, 4u)));
+    }
+    else if (strcmp(interface, wl_shm_interface.name) == 0)
+    {
+        self->shm = static_cast<wl_shm*>(wl_registry_bind(registry, id, &wl_shm_interface, 1));
+    }
+    else if (strcmp(interface, wl_output_interface.name) == 0 && !self->output)
+    {
+        self->output = static_cast<wl_output*>(wl_registry_bind(registry, id, &wl_output_interface, 1));
+    }
+    else if (strcmp(interface, wl_seat_interface.name) == 0 && !self->seat)
+    {
+        static wl_seat_listener const seat_listener{
+            [](void* data, wl_seat*, uint32_t capabilities)
+                { static_cast<SyntheticClient*>(data)->seat_capabilities(capabilities); },
+            [](void*, wl_seat*, char const*) {},
+        };
+        // Version 5 has pointer frames
+        self->seat = static_cast<wl_seat*>(wl_registry_bind(registry, id, &wl_seat_interface, std::min(version, 5u)));
+        wl_seat_add_listener(self->seat, &seat_listener, self);
+    }
+    else if (strcmp(interface, xdg_wm_base_interface.name) == 0)
+    {
+        static xdg_wm_base_listener const shell_listener{
+            [](void*, xdg_wm_base* shell, uint32_t serial) { xdg_wm_base_pong(shell, serial); },
+        };
+        self->shell = static_cast<xdg_wm_base*>(wl_registry_bind(registry, id, &xdg_wm_base_interface, 1));
+        xdg_wm_base_add_listener(self->shell, &shell_listener, self);
+    }
+    else if (strcmp(interface, zwp_linux_dmabuf_v1_interface.name) == 0 && version >= 3)
+    {
+        static zwp_linux_dmabuf_v1_listener const dmabuf_listener{
+            [](void*, zwp_linux_dmabuf_v1*, uint32_t) {},
+            [](void* data, zwp_linux_dmabuf_v1*, uint32_t format, uint32_t modifier_hi, uint32_t modifier_lo)
+                {
+                    static_cast<SyntheticClient*>(data)->dmabuf_formats.emplace(
+                        format, (uint64_t{modifier_hi} << 32) | modifier_lo);
+                },
+        };
+        self->linux_dmabuf = static_cast<zwp_linux_dmabuf_v1*>(
+            wl_registry_bind(registry, id, &zwp_linux_dmabuf_v1_interface, 3));
+        zwp_linux_dmabuf_v1_add_listener(self->linux_dmabuf, &dmabuf_listener, self);
+    }
+    else if (strcmp(interface, zwlr_screencopy_manager_v1_interface.name) == 0)
+    {
+        self->screencopy_manager = static_cast<zwlr_screencopy_manager_v1*>(
+            wl_registry_bind(registry, id, &zwlr_screencopy_manager_v1_interface, 1));
+    }
+}
+
+void mb::SyntheticClient::seat_capabilities(uint32_t capabilities)
+{
+// If building against newer Wayland protocol definitions we may miss trailing fields
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmissing-field-initializers"
+    if (capabilities & WL_SEAT_CAPABILITY_POINTER && !pointer)
+    {
+        static wl_pointer_listener const pointer_listener{
+            [](void*, auto...) {},
+            [](void*, auto...) {},
+            [](void* data, auto...) { static_cast<SyntheticClient*>(data)->pointer_moved = true; },
+            [](void*, auto...) {},
+            [](void*, auto...) {},
+            [](void* data, auto...)
+                {
+                    auto const self = static_cast<SyntheticClient*>(data);
+                    if (std::exchange(self->pointer_moved, false))
+                        self->input_event(InputType::pointer_motion);
+                },
+            [](void*, auto...) {},
+            [](void*, auto...) {},
+            [](void*, auto...) {},
+        };
+        pointer = wl_seat_get_pointer(seat);
+        wl_pointer_add_listener(pointer, &pointer_listener, this);
+    }
+
+    if (capabilities & WL_SEAT_CAPABILITY_KEYBOARD && !keyboard)
+    {
+        static wl_keyboard_listener const keyboard_listener{
+            [](void*, wl_keyboard*, uint32_t, int32_t fd, uint32_t) { close(fd); },
+            [](void*, auto...) {},
+            [](void*, auto...) {},
+            [](void* data, auto...) { static_cast<SyntheticClient*>(data)->input_event(InputType::key); },
+            [](void*, auto...) {},
+            [](void*, auto...) {},
+        };
+        keyboard = wl_seat_get_keyboard(seat);
+        wl_keyboard_add_listener(keyboard, &keyboard_listener, this);
+    }
+
+    if (capabilities & WL_SEAT_CAPABILITY_TOUCH && !touch)
+    {
+        static wl_touch_listener const touch_listener{
+            [](void*, auto...) {},
+            [](void*, auto...) {},
+            [](void*, auto...) {},
+            [](void* data, auto...) { static_cast<SyntheticClient*>(data)->input_event(InputType::touch); },
+            [](void*, auto...) {},
+        };
+        touch = wl_seat_get_touch(seat);
+        wl_touch_add_listener(touch, &touch_listener, this);
+    }
+#pragma GCC diagnostic pop
+}
+
+void mb::SyntheticClient::input_event(InputType type)
+{
+    auto const index = static_cast<size_t>(type);
+    if (measuring)
+        input_times[index].push_back(now());
+    ++input_counts[index];
+}
+
+auto mb::SyntheticClient::input_received(InputType type) const -> size_t
+{
+    return input_counts[static_cast<size_t>(type)];
+}
+
+auto mb::SyntheticClient::input_receipts(InputType type) const
+-> std::vector<std::chrono::steady_clock::time_point> const&
+{
+    return input_times[static_cast<size_t>(type)];
+}
+
+auto mb::SyntheticClient::dmabuf_modifier() const -> std::optional<uint64_t>
+{
+    // A udmabuf is linear; "invalid" lets the compositor assume the layout, which is then linear too
+    for (uint64_t const modifier : {uint64_t{DRM_FORMAT_MOD_LINEAR}, uint64_t{DRM_FORMAT_MOD_INVALID}})
+    {
+        if (dmabuf_formats.count(std::make_pair(uint32_t{DRM_FORMAT_XRGB8888}, modifier)))
+            return modifier;
+    }
+    return std::nullopt;
+}
+
+auto mb::SyntheticClient::supports_dmabuf() const -> bool
+{
+    return linux_dmabuf && udmabuf != Fd::invalid && dmabuf_modifier();
+}
+
+auto mb::SyntheticClient::supports_screencopy() const -> bool
+{
+    return screencopy_manager && output;
+}
+
+auto mb::SyntheticClient::add_toplevel(geom::Size size, Damage damage, BufferType buffer_type) -> Surface&
+{
+    surfaces.push_back(std::make_unique<Toplevel>(*this, size, damage, buffer_type));
+    return *surfaces.back();
+}
+
+auto mb::SyntheticClient::add_popup(Surface& parent, geom::Rectangle placement, Damage damage) -> Surface&
+{
+    surfaces.push_back(std::make_unique<Popup>(*this, parent, placement, damage));
+    return *surfaces.back();
+}
+
+void mb::SyntheticClient::add_screencopy()
+{
+    screen_copier = std::make_unique<ScreenCopier>(*this);
+}
+
+void mb::SyntheticClient::start()
+{
+    running = true;
+    event_thread = std::thread{[this]
+        {
+            try
+            {
+                run();
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+        }};
+}
+
+void mb::SyntheticClient::stop()
+{
+    running = false;
+    if (event_thread.joinable())
+        event_thread.join();
+
+    if (auto const e = std::exchange(error, nullptr))
+        std::rethrow_exception(e);
+}
+
+void mb::SyntheticClient::set_measuring(bool measuring)
+{
+    this->measuring = measuring;
+}
+
+auto mb::SyntheticClient::frame_callback_latencies() const -> std::vector<std::chrono::nanoseconds> const&
+{
+    return frame_latencies;
+}
+
+auto mb::SyntheticClient::screencopy_latencies() const -> std::vector<std::chrono::nanoseconds> const&
+{
+    static std::vector<std::chrono::nanoseconds> const none;
+    return screen_copier ? screen_copier->latencies : none;
+}
+
+auto mb::SyntheticClient::screencopy_failures() const -> unsigned
+{
+    return screen_copier ? screen_copier->failures : 0;
+}
+
+void mb::SyntheticClient::run()
+{
+    pollfd fds{wl_display_get_fd(display), POLLIN, 0};
+
+    while (running)
+    {
+        while (wl_display_prepare_read(display) != 0)
+        {
+            wl_display_dispatch_pending(display);
+        }
+        wl_display_flush(display);
+
+        // Wake up now and then to notice stop()
+        if (poll(&fds, 1, 100) > 0)
+        {
+            if (wl_display_read_events(display) == -1)
+                BOOST_THROW_EXCEPTION(std::runtime_error{"Lost connection to the compositor"});
+        }
+        else
+        {
+            wl_display_cancel_read(display);
+        }
+
+        if (wl_display_dispatch_pending(display) == -1)
+            BOOST_THROW_EXCEPTION(std::runtime_error{"Lost connection to the compositor"});
+    }
+}
+
+void mb::SyntheticClient::roundtrip()
+{
+    if (wl_display_roundtrip(display) == -1)
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error{"Lost connection to the compositor"});
+    }
+}
+
+void mb::SyntheticClient::add_latency(std::chrono::nanoseconds latency)
+{
+    if (measuring)
+        frame_latencies.push_back(latency);
+}
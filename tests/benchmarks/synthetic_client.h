@@ -0,0 +1,162 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_BENCHMARKS_SYNTHETIC_CLIENT_H_
+#define MIR_BENCHMARKS_SYNTHETIC_CLIENT_H_
+
+#include <mir/fd.h>
+#include <mir/geometry/rectangle.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+struct wl_compositor;
+struct wl_display;
+struct wl_output;
+struct wl_keyboard;
+struct wl_pointer;
+struct wl_registry;
+struct wl_seat;
+struct wl_shm;
+struct wl_touch;
+struct xdg_wm_base;
+struct zwp_linux_dmabuf_v1;
+struct zwlr_screencopy_manager_v1;
+
+namespace mir
+{
+namespace benchmarks
+{
+/**
+ * A Wayland client that keeps the compositor busy.
+ *
+ * Surfaces are added (and mapped) on the calling thread; start() then hands the connection to a
+ * thread of its own, on which every animated surface redraws as soon as it gets its frame
+ * callback, and input events are timestamped as they arrive.
+ */
+class SyntheticClient
+{
+public:
+    enum class BufferType
+    {
+        shm,
+        dmabuf      ///< Allocated from /dev/udmabuf, so no GPU is needed
+    };
+
+    enum class Damage
+    {
+        small,      ///< A small square moving across the surface
+        full,       ///< The whole surface changes each frame
+        none        ///< Drawn once, and never changed
+    };
+
+    enum class InputType
+    {
+        pointer_motion,
+        key,
+        touch
+    };
+
+    class Surface;
+
+    explicit SyntheticClient(Fd connection);
+    ~SyntheticClient();
+
+    /// Whether dmabuf surfaces can be added: the compositor accepts linear XRGB8888 dmabufs
+    /// and /dev/udmabuf is usable
+    auto supports_dmabuf() const -> bool;
+    /// Whether add_screencopy() can be used
+    auto supports_screencopy() const -> bool;
+
+    auto add_toplevel(geometry::Size size, Damage damage, BufferType buffer_type = BufferType::shm) -> Surface&;
+    auto add_popup(Surface& parent, geometry::Rectangle placement, Damage damage) -> Surface&;
+    /// Repeatedly capture the first output, starting each capture as the previous one completes
+    void add_screencopy();
+
+    void start();
+    /// Stop the client's thread, rethrowing anything that went wrong on it
+    void stop();
+
+    /// Latencies are only sampled while measuring
+    void set_measuring(bool measuring);
+
+    /// From committing a frame until its frame callback is done (only valid after stop())
+    auto frame_callback_latencies() const -> std::vector<std::chrono::nanoseconds> const&;
+    /// From requesting a screencopy until it is ready (only valid after stop())
+    auto screencopy_latencies() const -> std::vector<std::chrono::nanoseconds> const&;
+    auto screencopy_failures() const -> unsigned;
+
+    /// The number of input events of a type received so far, measuring or not: motion
+    /// (counted by pointer frame), key presses and releases, and touch frames
+    auto input_received(InputType type) const -> size_t;
+    /// When each input event of a type was received while measuring (only valid after stop())
+    auto input_receipts(InputType type) const -> std::vector<std::chrono::steady_clock::time_point> const&;
+
+private:
+    class Buffer;
+    class Toplevel;
+    class Popup;
+    class ScreenCopier;
+
+    static void new_global(void* data, wl_registry* registry, uint32_t id, char const* interface, uint32_t version);
+    void seat_capabilities(uint32_t capabilities);
+    void input_event(InputType type);
+    auto dmabuf_modifier() const -> std::optional<uint64_t>;
+    void run();
+    void roundtrip();
+    void add_latency(std::chrono::nanoseconds latency);
+
+    wl_display* const display;
+    wl_registry* registry{nullptr};
+    wl_compositor* compositor{nullptr};
+    wl_shm* shm{nullptr};
+    xdg_wm_base* shell{nullptr};
+    wl_output* output{nullptr};
+    zwp_linux_dmabuf_v1* linux_dmabuf{nullptr};
+    zwlr_screencopy_manager_v1* screencopy_manager{nullptr};
+    wl_seat* seat{nullptr};
+    wl_pointer* pointer{nullptr};
+    wl_keyboard* keyboard{nullptr};
+    wl_touch* touch{nullptr};
+    /// (format, modifier) pairs advertised by linux_dmabuf
+    std::set<std::pair<uint32_t, uint64_t>> dmabuf_formats;
+    Fd udmabuf;
+
+    std::vector<std::unique_ptr<Surface>> surfaces;
+    std::unique_ptr<ScreenCopier> screen_copier;
+
+    std::atomic<bool> measuring{false};
+    std::atomic<bool> running{false};
+    std::thread event_thread;
+    std::exception_ptr error;
+
+    std::vector<std::chrono::nanoseconds> frame_latencies;
+    bool pointer_moved{false};
+    std::array<std::atomic<size_t>, 3> input_counts{};
+    std::array<std::vector<std::chrono::steady_clock::time_point>, 3> input_times;
+};
+}
+}
+
+#endif // MIR_BENCHMARKS_SYNTHETIC_CLIENT_H_
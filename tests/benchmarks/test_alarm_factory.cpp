@@ -0,0 +1,185 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "benchmark_samples.h"
+
+#include "mir/glib_main_loop.h"
+#include "mir/time/steady_clock.h"
+
+#include "mir/test/auto_unblock_thread.h"
+#include "mir/test/signal.h"
+
+#include <gtest/gtest.h>
+
+#include <sys/resource.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mb = mir::benchmarks;
+namespace mt = mir::test;
+using namespace std::chrono_literals;
+using AlarmStrategy = mir::GLibMainLoop::AlarmStrategy;
+
+namespace
+{
+auto thread_cpu_time() -> std::chrono::microseconds
+{
+    rusage usage;
+    getrusage(RUSAGE_THREAD, &usage);
+    return std::chrono::seconds{usage.ru_utime.tv_sec + usage.ru_stime.tv_sec} +
+           std::chrono::microseconds{usage.ru_utime.tv_usec + usage.ru_stime.tv_usec};
+}
+
+auto name_of(AlarmStrategy strategy) -> std::string
+{
+    switch (strategy)
+    {
+    case AlarmStrategy::gsource_per_alarm:
+        return "gsource";
+    case AlarmStrategy::timer_wheel:
+        return "timer_wheel";
+    }
+    return "unknown";
+}
+
+struct AlarmFactoryBenchmark : testing::TestWithParam<AlarmStrategy>
+{
+    std::shared_ptr<mir::time::SteadyClock> const clock = std::make_shared<mir::time::SteadyClock>();
+    mir::GLibMainLoop ml{clock, GetParam()};
+    std::atomic<std::chrono::microseconds> loop_cpu_time{0us};
+    mt::AutoUnblockThread loop_thread{
+        [this] { ml.stop(); },
+        [this]
+        {
+            auto const start = thread_cpu_time();
+            ml.run();
+            loop_cpu_time = thread_cpu_time() - start;
+        }};
+
+    auto label(char const* what) const -> std::string
+    {
+        return std::string{what} + "/" + name_of(GetParam());
+    }
+};
+}
+
+// Many alarms repeatedly pushed back before they expire: the pattern of
+// idle and "application not responding" timeouts, which are reset on activity.
+TEST_P(AlarmFactoryBenchmark, reschedule_pending_alarms)
+{
+    int const alarm_count{2000};
+    int const reschedules_per_alarm{50};
+
+    std::vector<std::unique_ptr<mir::time::Alarm>> alarms;
+    for (auto i = 0; i != alarm_count; ++i)
+        alarms.push_back(ml.create_alarm([]{}));
+
+    auto const start = std::chrono::steady_clock::now();
+    for (auto round = 0; round != reschedules_per_alarm; ++round)
+    {
+        for (auto const& alarm : alarms)
+            alarm->reschedule_in(10s + std::chrono::milliseconds{round});
+    }
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+
+    mb::report_rate(label("reschedule"), alarm_count * reschedules_per_alarm, elapsed);
+
+    alarms.clear();
+    ml.stop();
+    loop_thread.stop();
+    mb::report_value(label("reschedule.loop_cpu"), loop_cpu_time.load().count() / 1000.0, "ms");
+}
+
+// Many alarms rearming themselves from their own callback: the pattern of
+// KeyRepeatDispatcher while keys are held on several devices.
+TEST_P(AlarmFactoryBenchmark, self_rearming_alarms)
+{
+    int const alarm_count{500};
+    auto const period = 5ms;
+    auto const duration = 2s;
+
+    struct Repeater
+    {
+        std::unique_ptr<mir::time::Alarm> alarm;
+        mir::time::Timestamp due;
+    };
+
+    mb::Samples lateness{label("repeat.lateness")};
+    std::mutex lateness_mutex;
+    std::atomic<bool> stopping{false};
+    std::vector<std::unique_ptr<Repeater>> repeaters;
+
+    for (auto i = 0; i != alarm_count; ++i)
+    {
+        auto repeater = std::make_unique<Repeater>();
+        repeater->alarm = ml.create_alarm(
+            [&, r = repeater.get()]
+            {
+                auto const now = clock->now();
+                {
+                    std::lock_guard lock{lateness_mutex};
+                    lateness.add(now - r->due);
+                }
+                if (!stopping)
+                {
+                    r->due = now + period;
+                    r->alarm->reschedule_for(r->due);
+                }
+            });
+        repeaters.push_back(std::move(repeater));
+    }
+
+    for (auto const& r : repeaters)
+    {
+        r->due = clock->now() + period;
+        r->alarm->reschedule_for(r->due);
+    }
+
+    std::this_thread::sleep_for(duration);
+    stopping = true;
+    ml.stop();
+    loop_thread.stop();
+    repeaters.clear();
+
+    lateness.report();
+    mb::report_rate(label("repeat.fired"), lateness.count(), duration);
+    mb::report_value(label("repeat.loop_cpu"), loop_cpu_time.load().count() / 1000.0, "ms");
+}
+
+// Short-lived alarms created, scheduled and destroyed without firing
+TEST_P(AlarmFactoryBenchmark, create_schedule_destroy)
+{
+    int const iterations{100000};
+
+    auto const start = std::chrono::steady_clock::now();
+    for (auto i = 0; i != iterations; ++i)
+    {
+        auto const alarm = ml.create_alarm([]{});
+        alarm->reschedule_in(1s);
+    }
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+
+    mb::report_rate(label("create_schedule_destroy"), iterations, elapsed);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    AlarmFactory,
+    AlarmFactoryBenchmark,
+    testing::Values(AlarmStrategy::gsource_per_alarm, AlarmStrategy::timer_wheel));
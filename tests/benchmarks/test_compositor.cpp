@@ -0,0 +1,159 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "compositor_benchmark.h"
+
+#include <miral/window_manager_tools.h>
+#include <miral/window_specification.h>
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+namespace mb = mir::benchmarks;
+namespace geom = mir::geometry;
+using namespace std::chrono_literals;
+using namespace testing;
+
+using Damage = mb::SyntheticClient::Damage;
+using BufferType = mb::SyntheticClient::BufferType;
+
+namespace
+{
+geom::Size const window_size{640, 480};
+
+struct CompositorBenchmark : mb::CompositorBenchmark
+{
+};
+
+/// The parameter is the number of animated windows, each from a separate client
+struct Animators : mb::CompositorBenchmark, WithParamInterface<int>
+{
+    auto label(char const* what) const -> std::string
+    {
+        return std::string{"compositor."} + what + "/" + std::to_string(GetParam());
+    }
+
+    void add_animators(Damage damage, BufferType buffer_type = BufferType::shm)
+    {
+        for (auto i = 0; i != GetParam(); ++i)
+        {
+            connect_client().add_toplevel(window_size, damage, buffer_type);
+        }
+    }
+};
+}
+
+TEST_P(Animators, shm_small_damage)
+{
+    add_animators(Damage::small);
+    measure(label("shm_small_damage"));
+}
+
+TEST_P(Animators, shm_full_damage)
+{
+    add_animators(Damage::full);
+    measure(label("shm_full_damage"));
+}
+
+TEST_P(Animators, dmabuf_small_damage)
+{
+    if (!connect_client().supports_dmabuf())
+    {
+        GTEST_SKIP() << "linear XRGB8888 udmabufs are not supported here";
+    }
+
+    add_animators(Damage::small, BufferType::dmabuf);
+    measure(label("dmabuf_small_damage"));
+}
+
+TEST_P(Animators, dmabuf_full_damage)
+{
+    if (!connect_client().supports_dmabuf())
+    {
+        GTEST_SKIP() << "linear XRGB8888 udmabufs are not supported here";
+    }
+
+    add_animators(Damage::full, BufferType::dmabuf);
+    measure(label("dmabuf_full_damage"));
+}
+
+INSTANTIATE_TEST_SUITE_P(CompositorBenchmark, Animators, Values(1, 4, 16));
+
+TEST_F(CompositorBenchmark, many_tiny_popups)
+{
+    auto& client = connect_client();
+    auto& parent = client.add_toplevel({800, 600}, Damage::small);
+
+    for (auto i = 0; i != 64; ++i)
+    {
+        client.add_popup(parent, {{16 + i % 8 * 96, 16 + i / 8 * 72}, {16, 16}}, Damage::full);
+    }
+
+    measure("compositor.many_tiny_popups");
+}
+
+// Resizing a window each frame, as the window manager does for an interactive drag-resize
+TEST_F(CompositorBenchmark, drag_resize)
+{
+    connect_client().add_toplevel(window_size, Damage::full);
+    auto const window = windows().front();
+
+    int step{0};
+    measure("compositor.drag_resize", [&]
+        {
+            auto const offset = step++ % 200;
+            miral::WindowSpecification spec;
+            spec.size() = geom::Size{600 + offset * 4, 400 + offset * 3};
+            invoke_tools([&](miral::WindowManagerTools& tools) { tools.modify_window(window, spec); });
+            std::this_thread::sleep_for(4ms);
+        });
+}
+
+// Raising a different window every millisecond, as a stress test of restacking
+TEST_F(CompositorBenchmark, rapid_restack)
+{
+    for (auto i = 0; i != 8; ++i)
+    {
+        connect_client().add_toplevel(window_size, Damage::small);
+    }
+    auto const windows = this->windows();
+
+    size_t next{0};
+    measure("compositor.rapid_restack", [&]
+        {
+            auto const& window = windows[next++ % windows.size()];
+            invoke_tools([&](miral::WindowManagerTools& tools) { tools.raise_tree(window); });
+            std::this_thread::sleep_for(1ms);
+        });
+}
+
+TEST_F(CompositorBenchmark, screencopy_under_load)
+{
+    auto& recorder = connect_client();
+    if (!recorder.supports_screencopy())
+    {
+        GTEST_SKIP() << "wlr-screencopy is not available";
+    }
+
+    for (auto i = 0; i != 4; ++i)
+    {
+        connect_client().add_toplevel(window_size, Damage::full);
+    }
+    recorder.add_screencopy();
+
+    measure("compositor.screencopy_under_load");
+}
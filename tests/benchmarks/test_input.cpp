@@ -0,0 +1,261 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "allocation_counter.h"
+#include "benchmark_baseline.h"
+#include "benchmark_samples.h"
+#include "benchmark_server.h"
+
+#include <mir_test_framework/fake_input_device.h>
+#include <mir_test_framework/input_device_faker.h>
+#include <mir/input/input_device_info.h>
+#include <mir/test/event_factory.h>
+
+#include <miral/window_manager_tools.h>
+#include <miral/window_specification.h>
+
+#include <gtest/gtest.h>
+
+#include <linux/input-event-codes.h>
+
+#include <chrono>
+#include <functional>
+#include <thread>
+
+namespace mb = mir::benchmarks;
+namespace mi = mir::input;
+namespace mis = mir::input::synthesis;
+namespace mtf = mir_test_framework;
+namespace geom = mir::geometry;
+using namespace std::chrono_literals;
+using namespace testing;
+
+using InputType = mb::SyntheticClient::InputType;
+using Damage = mb::SyntheticClient::Damage;
+
+namespace
+{
+// The test server's display is 1600x1600. All the events are aimed here.
+geom::Point const focus_point{800, 800};
+geom::Rectangle const target_area{{600, 650}, {400, 300}};
+geom::Size const other_size{64, 64};
+
+size_t const warm_up_events{500};
+/// Sent as fast as possible, for throughput
+size_t const flood_events{20000};
+/// Sent at a high but sustainable rate (like an 8kHz gaming mouse), for latency
+size_t const paced_events{4000};
+std::chrono::microseconds const paced_interval{125};
+
+auto now() -> std::chrono::steady_clock::time_point
+{
+    return std::chrono::steady_clock::now();
+}
+
+/**
+ * Drives events from fake input devices through the server's real input stack to a Wayland
+ * client: the input manager, seat, dispatchers, surface input dispatcher and the wl_seat
+ * frontend.
+ *
+ * The parameter is the number of surfaces. All but the target surface are stacked above it
+ * (but away from the events) so that finding the target means looking past them.
+ */
+struct InputBenchmark : mb::BenchmarkServer, WithParamInterface<int>
+{
+    void SetUp() override
+    {
+        pointer = faker.add_fake_input_device(mi::InputDeviceInfo{"mouse", "mouse-uid", mi::DeviceCapability::pointer});
+        keyboard = faker.add_fake_input_device(
+            mi::InputDeviceInfo{"keyboard", "keyboard-uid", mi::DeviceCapability::keyboard | mi::DeviceCapability::alpha_numeric});
+        touchscreen = faker.add_fake_input_device(
+            mi::InputDeviceInfo{"touchscreen", "touchscreen-uid", mi::DeviceCapability::touchscreen | mi::DeviceCapability::multitouch});
+
+        mb::BenchmarkServer::SetUp();
+        faker.wait_for_input_devices_added_to(server());
+
+        target = &connect_client();
+        target->add_toplevel(target_area.size, Damage::none);
+        for (auto i = 1; i < GetParam(); ++i)
+        {
+            connect_client().add_toplevel(other_size, Damage::none);
+        }
+        arrange_windows();
+
+        for (auto const& client : clients)
+        {
+            client->start();
+        }
+    }
+
+    void TearDown() override
+    {
+        mb::BenchmarkServer::TearDown();
+        pointer.reset();
+        keyboard.reset();
+        touchscreen.reset();
+    }
+
+    void arrange_windows()
+    {
+        auto const all = windows();
+        invoke_tools([&](miral::WindowManagerTools& tools)
+            {
+                std::vector<miral::Window> others;
+                int next{0};
+                for (auto const& window : all)
+                {
+                    miral::WindowSpecification spec;
+                    if (window.size() == target_area.size)
+                    {
+                        spec.top_left() = target_area.top_left;
+                        tools.modify_window(window, spec);
+                        tools.select_active_window(window);
+                    }
+                    else
+                    {
+                        // Rows across the top of the display, well clear of the target
+                        spec.top_left() = geom::Point{next % 20 * 80, next / 20 * 80};
+                        tools.modify_window(window, spec);
+                        others.push_back(window);
+                        ++next;
+                    }
+                }
+
+                // Activating the target raised it, but it should be at the bottom
+                for (auto const& window : others)
+                {
+                    tools.raise_tree(window);
+                }
+            });
+    }
+
+    void wait_for(InputType type, size_t count)
+    {
+        auto const timeout = now() + 20s;
+        while (target->input_received(type) < count)
+        {
+            ASSERT_LT(now(), timeout) << "Only " << target->input_received(type) << " of " << count << " events arrived";
+            std::this_thread::sleep_for(100us);
+        }
+    }
+
+    /// Deliver warm-up, flood and paced runs of events and report on them as "input.<stream>/<surfaces>"
+    void measure(char const* stream, InputType type, std::function<void(size_t)> const& emit)
+    {
+        auto const label = std::string{"input."} + stream + "/" + std::to_string(GetParam());
+        size_t sent{0};
+
+        for (size_t i = 0; i != warm_up_events; ++i)
+        {
+            emit(sent++);
+        }
+        wait_for(type, warm_up_events);
+        // Anything sent before the warm-up (such as entering the surface) must arrive too
+        std::this_thread::sleep_for(100ms);
+        auto received = target->input_received(type);
+        target->set_measuring(true);
+
+        auto const flood_allocations = mb::allocation_count();
+        auto const flood_start = now();
+        for (size_t i = 0; i != flood_events; ++i)
+        {
+            emit(sent++);
+        }
+        wait_for(type, received += flood_events);
+        auto const allocations = mb::allocation_count() - flood_allocations;
+
+        std::vector<std::chrono::steady_clock::time_point> paced_sends;
+        paced_sends.reserve(paced_events);
+        auto const paced_start = now();
+        for (size_t i = 0; i != paced_events; ++i)
+        {
+            std::this_thread::sleep_until(paced_start + i * paced_interval);
+            paced_sends.push_back(now());
+            emit(sent++);
+        }
+        wait_for(type, received += paced_events);
+
+        target->set_measuring(false);
+        target->stop();
+
+        // Every event was sent to the target, in order, so the receipts pair with the sends
+        auto const& receipts = target->input_receipts(type);
+        ASSERT_EQ(receipts.size(), flood_events + paced_events) << "Events were lost or merged";
+
+        auto const flood_time = receipts[flood_events - 1] - flood_start;
+        mb::report_rate(label + ".events", flood_events, flood_time);
+        mb::report_value(label + ".allocations_per_event", static_cast<double>(allocations) / flood_events, "allocations");
+
+        mb::Samples latency{label + ".latency"};
+        for (size_t i = 0; i != paced_events; ++i)
+        {
+            latency.add(receipts[flood_events + i] - paced_sends[i]);
+        }
+        latency.report();
+
+        auto const us = [](std::chrono::nanoseconds d) { return std::chrono::duration<double, std::micro>(d).count(); };
+        auto& baseline = mb::Baseline::instance();
+        baseline.check(label + ".ns_per_event", std::chrono::duration<double, std::nano>(flood_time).count() / flood_events);
+        baseline.check(label + ".allocations_per_event", static_cast<double>(allocations) / flood_events);
+        baseline.check(label + ".latency.p50_us", us(latency.percentile(50)));
+        baseline.check(label + ".latency.p99_us", us(latency.percentile(99)));
+    }
+
+    mtf::InputDeviceFaker faker;
+    mir::UniqueModulePtr<mtf::FakeInputDevice> pointer;
+    mir::UniqueModulePtr<mtf::FakeInputDevice> keyboard;
+    mir::UniqueModulePtr<mtf::FakeInputDevice> touchscreen;
+    mb::SyntheticClient* target{nullptr};
+};
+}
+
+TEST_P(InputBenchmark, pointer_motion)
+{
+    // Push the cursor into the corner, and then to the focus point
+    pointer->emit_event(mis::a_pointer_event().with_movement(-10000, -10000));
+    pointer->emit_event(mis::a_pointer_event().with_movement(focus_point.x.as_int(), focus_point.y.as_int()));
+
+    measure("pointer_motion", InputType::pointer_motion, [this](size_t i)
+        {
+            // Jitter, so the cursor stays over the target
+            pointer->emit_event(mis::a_pointer_event().with_movement(i % 2 ? -1 : 1, 0));
+        });
+}
+
+TEST_P(InputBenchmark, keyboard)
+{
+    measure("keyboard", InputType::key, [this](size_t i)
+        {
+            keyboard->emit_event(i % 2 ? mis::a_key_up_event().of_scancode(KEY_A) : mis::a_key_down_event().of_scancode(KEY_A));
+        });
+}
+
+TEST_P(InputBenchmark, touch)
+{
+    touchscreen->emit_event(mis::a_touch_event().with_action(mis::TouchParameters::Action::Tap).at_position(focus_point));
+
+    measure("touch", InputType::touch, [this](size_t i)
+        {
+            touchscreen->emit_event(
+                mis::a_touch_event()
+                    .with_action(mis::TouchParameters::Action::Move)
+                    .at_position(focus_point + geom::DeltaX{i % 2 ? 0 : 1}));
+        });
+
+    touchscreen->emit_event(mis::a_touch_event().with_action(mis::TouchParameters::Action::Release).at_position(focus_point));
+}
+
+INSTANTIATE_TEST_SUITE_P(InputBenchmark, InputBenchmark, Values(1, 16, 64));
@@ -0,0 +1,151 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "benchmark_baseline.h"
+#include "benchmark_samples.h"
+#include "benchmark_server.h"
+#include "protocol_replay.h"
+
+#include <mir/server.h>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <boost/throw_exception.hpp>
+
+#include <stdlib.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <system_error>
+#include <thread>
+
+namespace mb = mir::benchmarks;
+namespace fs = std::filesystem;
+using namespace std::chrono_literals;
+using namespace testing;
+
+using Damage = mb::SyntheticClient::Damage;
+using Speed = mb::ProtocolReplay::Speed;
+
+namespace
+{
+auto ms(std::chrono::nanoseconds d) -> double
+{
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+struct ProtocolReplayBenchmark : mb::BenchmarkServer
+{
+    ProtocolReplayBenchmark()
+    {
+        char directory[] = "/tmp/mir-wayland-recording-XXXXXX";
+        if (!mkdtemp(directory))
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create recording directory"}));
+        }
+        recording = directory;
+
+        add_to_environment("MIR_SERVER_WAYLAND_RECORD", directory);
+    }
+
+    ~ProtocolReplayBenchmark()
+    {
+        std::error_code ignored;
+        fs::remove_all(recording, ignored);
+    }
+
+    /// Disconnect the synthetic clients, and wait for the server to finish their recordings
+    void disconnect_clients()
+    {
+        clients.clear();
+
+        auto const deadline = std::chrono::steady_clock::now() + 10s;
+        while (!windows().empty() && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(10ms);
+        }
+    }
+
+    auto replay(mb::ProtocolReplay const& recorded, Speed speed) -> mb::ProtocolReplay::Result
+    {
+        return recorded.replay([this] { return server().open_wayland_client_socket(); }, speed);
+    }
+
+    void report(std::string const& name, mb::ProtocolReplay::Result const& result)
+    {
+        printf("%-48s requests=%-8zu recorded=%9.2fms elapsed=%9.2fms\n",
+            name.c_str(), result.requests, ms(result.recorded_duration), ms(result.elapsed));
+        RecordProperty(name + ".elapsed_ns", std::to_string(result.elapsed.count()));
+
+        if (!result.lateness.empty())
+        {
+            mb::Samples lateness{name + ".lateness"};
+            for (auto const sample : result.lateness)
+                lateness.add(sample);
+            lateness.report();
+        }
+    }
+
+    fs::path recording;
+};
+}
+
+TEST_F(ProtocolReplayBenchmark, replays_a_recorded_session_without_errors)
+{
+    auto& client = connect_client();
+    client.add_toplevel({320, 240}, Damage::small);
+    client.add_toplevel({160, 120}, Damage::full);
+    client.start();
+    std::this_thread::sleep_for(500ms);
+    client.stop();
+    disconnect_clients();
+
+    mb::ProtocolReplay const recorded{recording};
+    ASSERT_THAT(recorded.client_count(), Eq(1u));
+    ASSERT_THAT(recorded.request_count(), Gt(0u));
+
+    for (auto const speed : {Speed::maximum, Speed::original})
+    {
+        auto const result = replay(recorded, speed);
+
+        EXPECT_THAT(result.errors, IsEmpty());
+        EXPECT_THAT(result.requests, Eq(recorded.request_count()));
+    }
+}
+
+// A session recorded elsewhere (e.g. on a misbehaving production system) with --wayland-record
+TEST_F(ProtocolReplayBenchmark, recorded_session)
+{
+    auto const session = getenv("MIR_BENCHMARK_WAYLAND_RECORDING");
+    if (!session)
+    {
+        GTEST_SKIP() << "Set MIR_BENCHMARK_WAYLAND_RECORDING to replay a recorded session";
+    }
+
+    mb::ProtocolReplay const recorded{session};
+
+    auto const original = replay(recorded, Speed::original);
+    EXPECT_THAT(original.errors, IsEmpty());
+    report("replay.original_speed", original);
+
+    auto const maximum = replay(recorded, Speed::maximum);
+    EXPECT_THAT(maximum.errors, IsEmpty());
+    report("replay.maximum_speed", maximum);
+
+    mb::Baseline::instance().check("replay.maximum_speed.elapsed_ms", ms(maximum.elapsed));
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "benchmark_samples.h"
+
+#include "src/server/shm_backing.h"
+
+#include <boost/throw_exception.hpp>
+#include <gtest/gtest.h>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <system_error>
+
+namespace mb = mir::benchmarks;
+
+namespace
+{
+size_t const width{640};
+size_t const height{480};
+size_t const stride{width * 4};
+size_t const buffer_size{stride * height};
+
+// Like most toolkits, don't seal the pool: every access is then protected against SIGBUS
+auto make_pool_fd(size_t size) -> mir::Fd
+{
+    mir::Fd fd{memfd_create("mir-shm-benchmark", MFD_CLOEXEC)};
+    if (fd == mir::Fd::invalid || ftruncate(fd, size) == -1)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create SHM pool"}));
+    }
+    return fd;
+}
+
+// What the compositor does with a committed buffer: map it and read every row
+auto consume(mir::shm::RWMappableRange& buffer) -> unsigned
+{
+    auto const mapping = buffer.map_ro();
+    unsigned sum{0};
+    for (size_t row = 0; row < height; ++row)
+    {
+        sum += static_cast<unsigned>((*mapping)[row * stride]);
+    }
+    return sum;
+}
+}
+
+// A long-lived pool with buffers created from it, attached, committed and destroyed:
+// the pattern of GTK and Qt clients, which create a fresh wl_buffer for most frames.
+TEST(ShmPoolBenchmark, buffer_create_commit_destroy)
+{
+    int const buffers_in_pool{4};
+    int const iterations{100000};
+
+    auto const pool = mir::shm::rw_pool_from_fd(make_pool_fd(buffers_in_pool * buffer_size), buffers_in_pool * buffer_size);
+
+    unsigned sum{0};
+    auto const start = std::chrono::steady_clock::now();
+    for (auto i = 0; i != iterations; ++i)
+    {
+        auto const buffer = pool->get_rw_range((i % buffers_in_pool) * buffer_size, buffer_size);
+        sum += consume(*buffer);
+    }
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(sum, 0u);
+    mb::report_rate("shm_pool.create_commit_destroy", iterations, elapsed);
+}
+
+// A pool grown one buffer at a time while earlier buffers remain in use,
+// as clients do while the user resizes a window.
+TEST(ShmPoolBenchmark, grow_pool)
+{
+    int const growths{200};
+    size_t const growth{stride * 16};
+
+    mb::Samples resize{"shm_pool.resize"};
+
+    size_t size{buffer_size};
+    auto const fd = make_pool_fd(size + growths * growth);
+    auto const pool = mir::shm::rw_pool_from_fd(fd, size);
+    auto const first_buffer = pool->get_rw_range(0, buffer_size);
+
+    for (auto i = 0; i != growths; ++i)
+    {
+        size += growth;
+        auto const start = std::chrono::steady_clock::now();
+        pool->resize(size);
+        resize.add(std::chrono::steady_clock::now() - start);
+
+        auto const buffer = pool->get_rw_range(size - buffer_size, buffer_size);
+        consume(*buffer);
+        consume(*first_buffer);
+    }
+
+    resize.report();
+}
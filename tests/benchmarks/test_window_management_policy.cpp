@@ -0,0 +1,346 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "benchmark_baseline.h"
+#include "benchmark_samples.h"
+#include "test_window_manager_tools.h"
+#include "window_management_trace_replay.h"
+
+#include <miral/canonical_window_manager.h>
+#include <miral/minimal_window_manager.h>
+
+#include <mir/shell/surface_specification.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace mb = mir::benchmarks;
+namespace mt = mir::test;
+using namespace testing;
+
+namespace
+{
+miral::Rectangle const display_area{{0, 0}, {1920, 1080}};
+
+/// CanonicalWindowManagerPolicy leaves input and move/resize requests to the shell
+struct CanonicalPolicy : miral::CanonicalWindowManagerPolicy
+{
+    using miral::CanonicalWindowManagerPolicy::CanonicalWindowManagerPolicy;
+
+    bool handle_keyboard_event(MirKeyboardEvent const*) override { return false; }
+    bool handle_touch_event(MirTouchEvent const*) override { return false; }
+    bool handle_pointer_event(MirPointerEvent const*) override { return false; }
+    void handle_request_move(miral::WindowInfo&, MirInputEvent const*) override {}
+    void handle_request_resize(miral::WindowInfo&, MirInputEvent const*, MirResizeEdge) override {}
+};
+
+struct Policy
+{
+    std::string name;
+    miral::WindowManagementPolicyBuilder build;
+};
+
+// To compare a policy of your own under the same workloads, add it here
+std::vector<Policy> const policies{
+    {"minimal", [](miral::WindowManagerTools const& tools) -> std::unique_ptr<miral::WindowManagementPolicy>
+        { return std::make_unique<miral::MinimalWindowManager>(tools); }},
+    {"canonical", [](miral::WindowManagerTools const& tools) -> std::unique_ptr<miral::WindowManagementPolicy>
+        { return std::make_unique<CanonicalPolicy>(tools); }},
+};
+
+/// Drives a real policy through BasicWindowManager, timing each window management operation
+struct WindowManagementPolicyBenchmark : mt::TestWindowManagerTools, WithParamInterface<Policy>
+{
+    WindowManagementPolicyBenchmark()
+        : mt::TestWindowManagerTools{GetParam().build}
+    {
+    }
+
+    std::map<std::string, mb::Samples> operations;
+    std::mt19937 random{42};
+
+    void SetUp() override
+    {
+        notify_configuration_applied(create_fake_display_configuration({display_area}));
+        basic_window_manager.add_session(session);
+    }
+
+    /// The latencies of an operation, reported as "policy.<policy>.<workload>.<operation>"
+    auto samples_for(std::string const& operation) -> mb::Samples&
+    {
+        std::string const workload{UnitTest::GetInstance()->current_test_info()->name()};
+        auto const name = "policy." + GetParam().name + "." + workload.substr(0, workload.find('/')) + "." + operation;
+        return operations.try_emplace(name, name).first->second;
+    }
+
+    void report()
+    {
+        auto const us = [](mb::Samples::Duration d) { return std::chrono::duration<double, std::micro>(d).count(); };
+
+        for (auto& [name, samples] : operations)
+        {
+            samples.report();
+            mb::Baseline::instance().check(name + ".p50_us", us(samples.percentile(50)));
+            mb::Baseline::instance().check(name + ".p99_us", us(samples.percentile(99)));
+        }
+    }
+
+    template<typename Operation>
+    static auto time(Operation const& operation) -> mb::Samples::Duration
+    {
+        auto const start = std::chrono::steady_clock::now();
+        operation();
+        return std::chrono::steady_clock::now() - start;
+    }
+
+    auto create_window(
+        std::shared_ptr<mir::scene::Session> const& application,
+        mir::shell::SurfaceSpecification const& params,
+        std::string const& operation) -> miral::Window
+    {
+        std::shared_ptr<mir::scene::Surface> surface;
+        samples_for(operation).add(time([&]
+            {
+                surface = basic_window_manager.add_surface(application, params, &create_surface);
+                basic_window_manager.surface_ready(surface);
+            }));
+        return basic_window_manager.info_for(surface).window();
+    }
+
+    auto toplevel(int i) -> mir::shell::SurfaceSpecification
+    {
+        mir::shell::SurfaceSpecification params;
+        params.name = "toplevel-" + std::to_string(i);
+        params.set_size({200 + i % 300, 150 + i % 200});
+        params.top_left = mir::geometry::Point{i % 1700, i % 900};
+        return params;
+    }
+
+    /// Sessions each with windows_per_application toplevels
+    auto create_applications(int applications, int windows_per_application) -> std::vector<miral::Window>
+    {
+        std::vector<miral::Window> windows;
+        for (auto a = 0; a != applications; ++a)
+        {
+            auto const application = a ? create_session() : session;
+            if (a)
+                basic_window_manager.add_session(application);
+
+            for (auto w = 0; w != windows_per_application; ++w)
+                windows.push_back(create_window(application, toplevel(a * windows_per_application + w), "create"));
+        }
+        return windows;
+    }
+
+    void modify(miral::Window const& window, miral::WindowSpecification const& modifications, std::string const& operation)
+    {
+        samples_for(operation).add(time([&]
+            {
+                basic_window_manager.modify_window(basic_window_manager.info_for(window), modifications);
+            }));
+    }
+};
+}
+
+// A desktop with thousands of windows open: the cost of everyday operations as the window count grows
+TEST_P(WindowManagementPolicyBenchmark, thousands_of_windows)
+{
+    auto windows = create_applications(20, 100);
+
+    for (auto const& window : windows)
+    {
+        samples_for("focus").add(time([&] { basic_window_manager.select_active_window(window); }));
+    }
+
+    std::shuffle(windows.begin(), windows.end(), random);
+    for (auto const& window : windows)
+    {
+        miral::WindowSpecification move;
+        move.top_left() = window.top_left() + mir::geometry::Displacement{7, 5};
+        modify(window, move, "move");
+
+        miral::WindowSpecification resize;
+        resize.size() = mir::geometry::Size{window.size().width.as_int() + 3, window.size().height.as_int() + 2};
+        modify(window, resize, "resize");
+    }
+
+    std::shuffle(windows.begin(), windows.end(), random);
+    for (auto const& window : windows)
+    {
+        miral::WindowSpecification maximize;
+        maximize.state() = mir_window_state_maximized;
+        modify(window, maximize, "maximize");
+
+        miral::WindowSpecification restore;
+        restore.state() = mir_window_state_restored;
+        modify(window, restore, "restore");
+    }
+
+    std::shuffle(windows.begin(), windows.end(), random);
+    for (auto const& window : windows)
+    {
+        auto const application = window.application();
+        samples_for("destroy").add(time([&] { basic_window_manager.remove_surface(application, window); }));
+    }
+
+    report();
+}
+
+// Menus opened from menus: creation, focus and raise all walk the parent chain
+TEST_P(WindowManagementPolicyBenchmark, deep_popup_trees)
+{
+    int const trees{16};
+    int const depth{64};
+
+    std::vector<std::vector<miral::Window>> chains;
+    for (auto t = 0; t != trees; ++t)
+    {
+        std::vector<miral::Window> chain{create_window(session, toplevel(t), "create")};
+        for (auto d = 0; d != depth; ++d)
+        {
+            mir::shell::SurfaceSpecification params;
+            params.name = "popup-" + std::to_string(t) + "-" + std::to_string(d);
+            params.type = mir_window_type_menu;
+            params.parent = chain.back();
+            params.set_size({160, 120});
+            params.aux_rect = mir::geometry::Rectangle{{150, 10 + d % 8 * 10}, {10, 10}};
+            chain.push_back(create_window(session, params, "create_popup"));
+        }
+        chains.push_back(std::move(chain));
+    }
+
+    for (auto round = 0; round != 4; ++round)
+    {
+        for (auto const& chain : chains)
+        {
+            samples_for("focus_deepest").add(time([&] { basic_window_manager.select_active_window(chain.back()); }));
+            samples_for("raise_root").add(time([&] { basic_window_manager.raise_tree(chain.front()); }));
+        }
+    }
+
+    for (auto& chain : chains)
+    {
+        miral::WindowSpecification move;
+        move.top_left() = chain.front().top_left() + mir::geometry::Displacement{20, 20};
+        modify(chain.front(), move, "move_tree");
+
+        while (!chain.empty())
+        {
+            auto const window = chain.back();
+            chain.pop_back();
+            samples_for(chain.empty() ? "destroy" : "destroy_popup").add(time([&]
+                {
+                    basic_window_manager.remove_surface(session, window);
+                }));
+        }
+    }
+
+    report();
+}
+
+// Alt+Tab and Alt+` held down across many applications
+TEST_P(WindowManagementPolicyBenchmark, rapid_focus_cycling)
+{
+    create_applications(32, 16);
+
+    for (auto i = 0; i != 2000; ++i)
+    {
+        samples_for("focus_next_application").add(time([&] { basic_window_manager.focus_next_application(); }));
+        samples_for("focus_next_within_application").add(time([&]
+            {
+                basic_window_manager.focus_next_within_application();
+            }));
+        samples_for("focus_prev_application").add(time([&] { basic_window_manager.focus_prev_application(); }));
+    }
+
+    report();
+}
+
+// Switching between workspaces by moving their content, as the example shells do
+TEST_P(WindowManagementPolicyBenchmark, workspace_moves)
+{
+    auto const windows = create_applications(16, 64);
+
+    std::vector<std::shared_ptr<miral::Workspace>> workspaces;
+    for (auto i = 0; i != 8; ++i)
+        workspaces.push_back(basic_window_manager.create_workspace());
+
+    for (size_t i = 0; i != windows.size(); ++i)
+    {
+        samples_for("add_to_workspace").add(time([&]
+            {
+                basic_window_manager.add_tree_to_workspace(windows[i], workspaces[i % workspaces.size()]);
+            }));
+    }
+
+    // A spare workspace holds the content of the one being shown while the shell switches
+    auto const spare = basic_window_manager.create_workspace();
+    for (auto round = 0; round != 8; ++round)
+    {
+        for (auto const& workspace : workspaces)
+        {
+            samples_for("switch_workspace").add(time([&]
+                {
+                    basic_window_manager.move_workspace_content_to_workspace(spare, workspace);
+                    basic_window_manager.move_workspace_content_to_workspace(workspace, spare);
+                }));
+        }
+    }
+
+    for (size_t i = 0; i != windows.size(); ++i)
+    {
+        samples_for("remove_from_workspace").add(time([&]
+            {
+                basic_window_manager.remove_tree_from_workspace(windows[i], workspaces[i % workspaces.size()]);
+            }));
+    }
+
+    report();
+}
+
+// Replays a log captured with --window-management-trace, named by $MIR_BENCHMARK_WINDOW_MANAGEMENT_TRACE
+TEST_P(WindowManagementPolicyBenchmark, trace_replay)
+{
+    auto const path = getenv("MIR_BENCHMARK_WINDOW_MANAGEMENT_TRACE");
+    if (!path)
+        GTEST_SKIP() << "Set MIR_BENCHMARK_WINDOW_MANAGEMENT_TRACE to replay a window management trace";
+
+    std::ifstream log{path};
+    ASSERT_TRUE(log) << "Cannot open window management trace " << path;
+
+    mb::TraceReplay const trace{log};
+    ASSERT_GT(trace.size(), 0u) << "No replayable calls in " << path;
+
+    auto const skipped = trace.replay(*this, [this](std::string const& advice, mb::Samples::Duration elapsed)
+        {
+            samples_for(advice).add(elapsed);
+        });
+
+    mb::report_value("policy." + GetParam().name + ".trace_replay.skipped", skipped, "calls");
+    report();
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    WindowManagementPolicy,
+    WindowManagementPolicyBenchmark,
+    ValuesIn(policies),
+    [](TestParamInfo<Policy> const& info) { return info.param.name; });
@@ -0,0 +1,282 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_window_manager_tools.h"
+#include "window_management_trace.h"
+#include "window_management_trace_replay.h"
+
+#include <miral/minimal_window_manager.h>
+
+#include <mir/logging/dumb_console_logger.h>
+#include <mir/logging/logger.h>
+#include <mir/shell/surface_specification.h>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <map>
+#include <sstream>
+
+namespace mb = mir::benchmarks;
+namespace ml = mir::logging;
+namespace mt = mir::test;
+using namespace testing;
+
+namespace
+{
+miral::Rectangle const display_area{{0, 0}, {1920, 1080}};
+
+// An excerpt of a --window-management-trace log, including lines that aren't replayable
+char const* const recorded_trace =
+    "[2026-03-02 10:15:01.000001] <information> miral::Window Management: ====\n"
+    "[2026-03-02 10:15:01.000002] <information> miral::Window Management: advise_begin\n"
+    "[2026-03-02 10:15:01.000003] <information> miral::Window Management: advise_new_window window_info="
+        "{name=editor, type=normal, state=restored, top_left=10, 20, size=(640, 480), children={}, "
+        "preferred_orientation=0xf, confine_pointer=0}\n"
+    "[2026-03-02 10:15:01.000004] <information> miral::Window Management: advise_end\n"
+    "[2026-03-02 10:15:01.000005] <information> miral::Window Management: handle_window_ready window_info="
+        "{name=editor, type=normal, state=restored, top_left=10, 20, size=(640, 480), children={}, "
+        "preferred_orientation=0xf, confine_pointer=0}\n"
+    "[2026-03-02 10:15:01.000006] <information> miral::Window Management: advise_focus_gained window_info="
+        "{name=editor, type=normal, state=restored, top_left=10, 20, size=(640, 480), children={}, "
+        "preferred_orientation=0xf, confine_pointer=0}\n"
+    "[2026-03-02 10:15:01.000007] <information> miral::Window Management: advise_new_window window_info="
+        "{name=open file, type=dialog, state=restored, top_left=100, 120, size=(320, 240), parent=editor, "
+        "children={}, preferred_orientation=0xf, confine_pointer=0}\n"
+    "[2026-03-02 10:15:01.000008] <information> miral::Window Management: advise_raise window_info="
+        "{open file, editor}\n"
+    "[2026-03-02 10:15:01.000009] <information> miral::Window Management: handle_modify_window window_info="
+        "{name=editor, type=normal, state=restored, top_left=10, 20, size=(640, 480), "
+        "children={open file}, preferred_orientation=0xf, confine_pointer=0}, modifications={top_left=30, 40}\n"
+    "[2026-03-02 10:15:01.000010] <information> miral::Window Management: advise_move_to window_info="
+        "{name=editor, type=normal, state=restored, top_left=10, 20, size=(640, 480), "
+        "children={open file}, preferred_orientation=0xf, confine_pointer=0}, top_left=30, 40\n"
+    "[2026-03-02 10:15:01.000011] <information> miral::Window Management: advise_resize window_info="
+        "{name=editor, type=normal, state=restored, top_left=30, 40, size=(640, 480), "
+        "children={open file}, preferred_orientation=0xf, confine_pointer=0}, new_size=(800, 600)\n"
+    "[2026-03-02 10:15:01.000012] <information> miral::Window Management: advise_delete_window window_info="
+        "{name=open file, type=dialog, state=restored, top_left=100, 120, size=(320, 240), parent=editor, "
+        "children={}, preferred_orientation=0xf, confine_pointer=0}\n"
+    "[2026-03-02 10:15:01.000013] <information> miral::Window Management: advise_state_change window_info="
+        "{name=editor, type=normal, state=restored, top_left=30, 40, size=(800, 600), children={}, "
+        "preferred_orientation=0xf, confine_pointer=0}, state=maximized\n"
+    "[2026-03-02 10:15:01.000014] <information> miral::Window Management: advise_move_to window_info="
+        "{name=unknown, type=normal, state=restored, top_left=0, 0, size=(10, 10), children={}, "
+        "preferred_orientation=0xf, confine_pointer=0}, top_left=5, 5\n";
+
+/// Collects log lines as the default logger would write them
+struct CapturingLogger : ml::Logger
+{
+    void log(ml::Severity severity, std::string const& message, std::string const& component) override
+    {
+        ml::format_message(lines, severity, message, component);
+    }
+
+    std::stringstream lines;
+};
+
+auto count_advice(std::string const& log) -> std::map<std::string, int>
+{
+    std::map<std::string, int> counts;
+    std::istringstream in{log};
+    for (std::string line; std::getline(in, line);)
+    {
+        for (auto const advice : {
+            "advise_new_window", "handle_window_ready", "advise_focus_gained", "advise_raise",
+            "advise_move_to", "advise_resize", "advise_state_change", "advise_delete_window"})
+        {
+            if (line.find(std::string{": "} + advice + " window_info=") != std::string::npos)
+                ++counts[advice];
+        }
+    }
+    return counts;
+}
+
+/// A window manager that traces a real policy, as --window-management-trace does
+struct TracedWindowManager : mt::TestWindowManagerTools
+{
+    TracedWindowManager()
+        : mt::TestWindowManagerTools{[](miral::WindowManagerTools const& tools)
+            {
+                return std::make_unique<miral::WindowManagementTrace>(
+                    tools,
+                    [](miral::WindowManagerTools const& tools) -> std::unique_ptr<miral::WindowManagementPolicy>
+                        { return std::make_unique<miral::MinimalWindowManager>(tools); });
+            }}
+    {
+        notify_configuration_applied(create_fake_display_configuration({display_area}));
+        basic_window_manager.add_session(session);
+    }
+
+    void TestBody() override {}
+
+    auto create_window(mir::shell::SurfaceSpecification const& params) -> miral::Window
+    {
+        auto const surface = basic_window_manager.add_surface(session, params, &create_surface);
+        basic_window_manager.surface_ready(surface);
+        return basic_window_manager.info_for(surface).window();
+    }
+
+    void modify(miral::Window const& window, miral::WindowSpecification const& modifications)
+    {
+        basic_window_manager.modify_window(basic_window_manager.info_for(window), modifications);
+    }
+};
+
+struct WindowManagementTraceReplay : mt::TestWindowManagerTools
+{
+    void SetUp() override
+    {
+        notify_configuration_applied(create_fake_display_configuration({display_area}));
+        basic_window_manager.add_session(session);
+    }
+
+    void TearDown() override
+    {
+        ml::set_logger(std::make_shared<ml::DumbConsoleLogger>());
+    }
+
+    auto replay(mb::TraceReplay const& trace) -> std::map<std::string, int>
+    {
+        std::map<std::string, int> replayed;
+        skipped = trace.replay(*this, [&](std::string const& advice, mb::TraceReplay::Duration)
+            {
+                ++replayed[advice];
+            });
+        return replayed;
+    }
+
+    size_t skipped{0};
+};
+
+MATCHER_P(Named, name, "")
+{
+    return arg.name() == name;
+}
+
+MATCHER_P2(NamedWithParent, name, parent, "")
+{
+    std::shared_ptr<mir::scene::Surface> const parent_surface = arg.parent();
+    return arg.name() == name && parent_surface && parent_surface->name() == parent;
+}
+}
+
+TEST_F(WindowManagementTraceReplay, parses_each_replayable_advice_in_a_trace)
+{
+    std::istringstream log{recorded_trace};
+    mb::TraceReplay const trace{log};
+
+    EXPECT_THAT(trace.size(), Eq(10u));
+}
+
+TEST_F(WindowManagementTraceReplay, replays_windows_with_the_recorded_names_types_and_parents)
+{
+    std::istringstream log{recorded_trace};
+    mb::TraceReplay const trace{log};
+
+    EXPECT_CALL(*window_manager_policy, advise_new_window(
+        AllOf(Named("editor"), Property(&miral::WindowInfo::type, mir_window_type_normal))));
+    EXPECT_CALL(*window_manager_policy, advise_new_window(
+        AllOf(NamedWithParent("open file", "editor"), Property(&miral::WindowInfo::type, mir_window_type_dialog))));
+
+    replay(trace);
+}
+
+TEST_F(WindowManagementTraceReplay, replays_moves_and_resizes_with_the_recorded_geometry)
+{
+    std::istringstream log{recorded_trace};
+    mb::TraceReplay const trace{log};
+
+    EXPECT_CALL(*window_manager_policy, advise_move_to(_, _)).Times(AnyNumber());
+    EXPECT_CALL(*window_manager_policy, advise_resize(_, _)).Times(AnyNumber());
+    EXPECT_CALL(*window_manager_policy, advise_move_to(Named("editor"), mir::geometry::Point{30, 40}));
+    EXPECT_CALL(*window_manager_policy, advise_resize(Named("editor"), mir::geometry::Size{800, 600}));
+
+    replay(trace);
+}
+
+TEST_F(WindowManagementTraceReplay, skips_calls_for_windows_it_has_not_seen)
+{
+    std::istringstream log{recorded_trace};
+    mb::TraceReplay const trace{log};
+
+    auto const replayed = replay(trace);
+
+    EXPECT_THAT(skipped, Eq(1u));
+    EXPECT_THAT(replayed, ElementsAre(
+        Pair("advise_delete_window", 1),
+        Pair("advise_focus_gained", 1),
+        Pair("advise_move_to", 1),
+        Pair("advise_new_window", 2),
+        Pair("advise_raise", 1),
+        Pair("advise_resize", 1),
+        Pair("advise_state_change", 1),
+        Pair("handle_window_ready", 1)));
+}
+
+TEST_F(WindowManagementTraceReplay, replays_every_advice_written_by_window_management_trace)
+{
+    auto const logger = std::make_shared<CapturingLogger>();
+    ml::set_logger(logger);
+    {
+        TracedWindowManager traced;
+
+        mir::shell::SurfaceSpecification editor_params;
+        editor_params.name = "editor";
+        editor_params.set_size({640, 480});
+        editor_params.top_left = mir::geometry::Point{10, 20};
+        auto const editor = traced.create_window(editor_params);
+
+        mir::shell::SurfaceSpecification dialog_params;
+        dialog_params.name = "open file";
+        dialog_params.type = mir_window_type_dialog;
+        dialog_params.set_size({320, 240});
+        dialog_params.parent = editor;
+        auto const dialog = traced.create_window(dialog_params);
+
+        traced.basic_window_manager.select_active_window(editor);
+
+        miral::WindowSpecification move;
+        move.top_left() = mir::geometry::Point{30, 40};
+        traced.modify(editor, move);
+
+        miral::WindowSpecification resize;
+        resize.size() = mir::geometry::Size{800, 600};
+        traced.modify(editor, resize);
+
+        traced.basic_window_manager.remove_surface(traced.session, dialog);
+
+        miral::WindowSpecification maximize;
+        maximize.state() = mir_window_state_maximized;
+        traced.modify(editor, maximize);
+    }
+    ml::set_logger(std::make_shared<ml::DumbConsoleLogger>());
+
+    auto const log_text = logger->lines.str();
+    auto const written = count_advice(log_text);
+    ASSERT_THAT(written, Contains(Key("advise_new_window")));
+    ASSERT_THAT(written, Contains(Key("advise_move_to")));
+    ASSERT_THAT(written, Contains(Key("advise_resize")));
+    ASSERT_THAT(written, Contains(Key("advise_state_change")));
+    ASSERT_THAT(written, Contains(Key("advise_delete_window")));
+
+    std::istringstream log{log_text};
+    mb::TraceReplay const trace{log};
+    auto const replayed = replay(trace);
+
+    EXPECT_THAT(skipped, Eq(0u));
+    EXPECT_THAT(replayed, Eq(written));
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "benchmark_samples.h"
+#include "test_window_manager_tools.h"
+
+#include <mir/shell/surface_specification.h>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace mb = mir::benchmarks;
+namespace mt = mir::test;
+using namespace testing;
+
+namespace
+{
+miral::Rectangle const display_area{{0, 0}, {1920, 1080}};
+
+struct WindowManagerBenchmark : mt::TestWindowManagerTools, WithParamInterface<int>
+{
+    struct TestWindow
+    {
+        std::shared_ptr<mir::scene::Surface> surface;
+        miral::Window window;
+    };
+
+    std::vector<TestWindow> windows;
+    std::mt19937 random{42};
+
+    void SetUp() override
+    {
+        notify_configuration_applied(create_fake_display_configuration({display_area}));
+        basic_window_manager.add_session(session);
+    }
+
+    auto label(char const* what) const -> std::string
+    {
+        return std::string{"window_manager."} + what + "/" + std::to_string(GetParam());
+    }
+
+    template<typename Operation>
+    static auto time(Operation const& operation) -> mb::Samples::Duration
+    {
+        auto const start = std::chrono::steady_clock::now();
+        operation();
+        return std::chrono::steady_clock::now() - start;
+    }
+
+    void create_windows(mb::Samples& samples)
+    {
+        for (auto i = 0; i != GetParam(); ++i)
+        {
+            mir::shell::SurfaceSpecification params;
+            params.set_size({200 + i % 300, 150 + i % 200});
+            params.top_left = mir::geometry::Point{i % 1700, i % 900};
+
+            std::shared_ptr<mir::scene::Surface> surface;
+            samples.add(time([&]
+                {
+                    surface = basic_window_manager.add_surface(session, params, &create_surface);
+                }));
+            windows.push_back({surface, basic_window_manager.info_for(surface).window()});
+        }
+    }
+
+    auto shuffled_windows() -> std::vector<TestWindow>
+    {
+        auto result = windows;
+        std::shuffle(result.begin(), result.end(), random);
+        return result;
+    }
+};
+}
+
+// Creates, focuses, raises and destroys many windows, as a test farm session running hundreds of
+// clients does. The interesting figure is how the per-operation cost scales with the window count.
+TEST_P(WindowManagerBenchmark, create_focus_raise_destroy)
+{
+    mb::Samples create{label("create")};
+    mb::Samples focus{label("focus")};
+    mb::Samples raise{label("raise")};
+    mb::Samples destroy{label("destroy")};
+
+    create_windows(create);
+
+    for (auto const& w : shuffled_windows())
+        focus.add(time([&] { basic_window_manager.select_active_window(w.window); }));
+
+    for (auto const& w : shuffled_windows())
+        raise.add(time([&] { basic_window_manager.raise_tree(w.window); }));
+
+    for (auto const& w : shuffled_windows())
+        destroy.add(time([&] { basic_window_manager.remove_surface(session, w.surface); }));
+    windows.clear();
+
+    create.report();
+    focus.report();
+    raise.report();
+    destroy.report();
+}
+
+// Lookups done by the policy on most callbacks
+TEST_P(WindowManagerBenchmark, info_for_lookup)
+{
+    mb::Samples ignored{label("lookup.create")};
+    create_windows(ignored);
+
+    auto const lookups = shuffled_windows();
+    int const rounds{20};
+
+    size_t found{0};
+    auto const elapsed = time([&]
+        {
+            for (auto round = 0; round != rounds; ++round)
+            {
+                for (auto const& w : lookups)
+                    found += bool(basic_window_manager.info_for(w.window).window());
+            }
+        });
+
+    EXPECT_THAT(found, Eq(rounds * lookups.size()));
+    mb::report_rate(label("info_for"), found, elapsed);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    WindowManager,
+    WindowManagerBenchmark,
+    Values(100, 1000, 4000));
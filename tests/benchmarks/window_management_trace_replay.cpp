@@ -0,0 +1,260 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "window_management_trace_replay.h"
+#include "test_window_manager_tools.h"
+
+#include <miral/window_specification.h>
+
+#include <mir/event_printer.h>
+#include <mir/shell/surface_specification.h>
+
+#include <istream>
+#include <map>
+#include <optional>
+#include <regex>
+#include <sstream>
+
+namespace mb = mir::benchmarks;
+namespace geom = mir::geometry;
+
+namespace
+{
+std::string const log_component{"miral::Window Management: "};
+
+/// The braced group that starts at text[begin], braces included
+auto braced_group(std::string const& text, size_t begin) -> std::string
+{
+    int depth{0};
+    for (auto i = begin; i != text.size(); ++i)
+    {
+        if (text[i] == '{')
+        {
+            ++depth;
+        }
+        else if (text[i] == '}' && --depth == 0)
+        {
+            return text.substr(begin, i + 1 - begin);
+        }
+    }
+    return text.substr(begin);
+}
+
+auto capture(std::string const& text, std::regex const& pattern) -> std::optional<std::smatch>
+{
+    std::smatch match;
+    if (std::regex_search(text, match, pattern))
+        return match;
+    return std::nullopt;
+}
+
+/// The value of an enum as printed by WindowManagementTrace, from its name
+template<typename Enum>
+auto enum_named(std::string const& name, Enum count, Enum fallback) -> Enum
+{
+    using mir::operator<<;
+    for (auto i = 0; i != count; ++i)
+    {
+        std::ostringstream out;
+        out << static_cast<Enum>(i);
+        if (out.str() == name)
+            return static_cast<Enum>(i);
+    }
+    return fallback;
+}
+}
+
+mb::TraceReplay::TraceReplay(std::istream& log)
+{
+    static std::regex const advice_pattern{R"(^(advise_\w+|handle_window_ready) window_info=)"};
+    static std::regex const name_pattern{R"(^\{name=([^,}]*))"};
+    static std::regex const first_item_pattern{R"(^\{([^,}]*))"};
+    static std::regex const type_pattern{R"(\btype=(\w+))"};
+    static std::regex const state_pattern{R"(\bstate=(\w+))"};
+    static std::regex const parent_pattern{R"(\bparent=([^,}]*))"};
+    static std::regex const top_left_pattern{R"(\btop_left=(-?\d+), (-?\d+))"};
+    static std::regex const size_pattern{R"(\bsize=\((\d+), (\d+)\))"};
+    static std::regex const new_size_pattern{R"(\bnew_size=\((\d+), (\d+)\))"};
+
+    for (std::string line; std::getline(log, line);)
+    {
+        if (auto const component = line.find(log_component); component != std::string::npos)
+            line.erase(0, component + log_component.size());
+
+        auto const advice = capture(line, advice_pattern);
+        if (!advice)
+            continue;
+
+        Call call;
+        call.advice = (*advice)[1];
+
+        auto const info = braced_group(line, advice->length());
+        auto const rest = line.substr(advice->length() + info.size());
+
+        if (call.advice == "advise_raise")
+        {
+            if (auto const first = capture(info, first_item_pattern))
+                call.name = (*first)[1];
+        }
+        else if (auto const name = capture(info, name_pattern))
+        {
+            call.name = (*name)[1];
+        }
+
+        if (call.advice == "advise_new_window")
+        {
+            if (auto const type = capture(info, type_pattern))
+                call.type = enum_named((*type)[1].str(), mir_window_types, mir_window_type_normal);
+            if (auto const state = capture(info, state_pattern))
+                call.state = enum_named((*state)[1].str(), mir_window_states, mir_window_state_restored);
+            if (auto const parent = capture(info, parent_pattern))
+                call.parent = (*parent)[1];
+            if (auto const top_left = capture(info, top_left_pattern))
+                call.top_left = geom::Point{std::stoi((*top_left)[1]), std::stoi((*top_left)[2])};
+            if (auto const size = capture(info, size_pattern))
+                call.size = geom::Size{std::stoi((*size)[1]), std::stoi((*size)[2])};
+        }
+        else if (call.advice == "advise_move_to")
+        {
+            auto const top_left = capture(rest, top_left_pattern);
+            if (!top_left)
+                continue;
+            call.top_left = geom::Point{std::stoi((*top_left)[1]), std::stoi((*top_left)[2])};
+        }
+        else if (call.advice == "advise_resize")
+        {
+            auto const size = capture(rest, new_size_pattern);
+            if (!size)
+                continue;
+            call.size = geom::Size{std::stoi((*size)[1]), std::stoi((*size)[2])};
+        }
+        else if (call.advice == "advise_state_change")
+        {
+            auto const state = capture(rest, state_pattern);
+            if (!state)
+                continue;
+            call.state = enum_named((*state)[1].str(), mir_window_states, mir_window_state_restored);
+        }
+        else if (call.advice != "advise_delete_window" &&
+                 call.advice != "advise_focus_gained" &&
+                 call.advice != "advise_raise" &&
+                 call.advice != "handle_window_ready")
+        {
+            continue;
+        }
+
+        calls.push_back(std::move(call));
+    }
+}
+
+auto mb::TraceReplay::replay(
+    test::TestWindowManagerTools& target,
+    std::function<void(std::string const& advice, Duration elapsed)> const& record) const -> size_t
+{
+    auto& window_manager = target.basic_window_manager;
+    std::map<std::string, std::vector<miral::Window>> windows;
+    size_t skipped{0};
+
+    auto const find = [&](std::string const& name) -> std::optional<miral::Window>
+        {
+            auto const i = windows.find(name);
+            if (i == windows.end() || i->second.empty())
+                return std::nullopt;
+            return i->second.back();
+        };
+
+    auto const time = [&](std::string const& advice, auto const& operation)
+        {
+            auto const start = std::chrono::steady_clock::now();
+            operation();
+            record(advice, std::chrono::steady_clock::now() - start);
+        };
+
+    for (auto const& call : calls)
+    {
+        if (call.advice == "advise_new_window")
+        {
+            mir::shell::SurfaceSpecification params;
+            params.name = call.name;
+            params.type = call.type;
+            params.top_left = call.top_left;
+            params.set_size(call.size);
+            if (call.state != mir_window_state_restored)
+                params.state = call.state;
+
+            if (!call.parent.empty())
+            {
+                auto const parent = find(call.parent);
+                if (!parent)
+                {
+                    ++skipped;
+                    continue;
+                }
+                params.parent = *parent;
+            }
+
+            std::shared_ptr<mir::scene::Surface> surface;
+            time(call.advice, [&]
+                {
+                    surface = window_manager.add_surface(target.session, params, &target.create_surface);
+                });
+            windows[call.name].push_back(window_manager.info_for(surface).window());
+            continue;
+        }
+
+        auto const window = find(call.name);
+        if (!window)
+        {
+            ++skipped;
+            continue;
+        }
+
+        if (call.advice == "handle_window_ready")
+        {
+            time(call.advice, [&] { window_manager.surface_ready(*window); });
+        }
+        else if (call.advice == "advise_focus_gained")
+        {
+            time(call.advice, [&] { window_manager.select_active_window(*window); });
+        }
+        else if (call.advice == "advise_raise")
+        {
+            time(call.advice, [&] { window_manager.raise_tree(*window); });
+        }
+        else if (call.advice == "advise_delete_window")
+        {
+            time(call.advice, [&] { window_manager.remove_surface(target.session, *window); });
+            windows[call.name].pop_back();
+        }
+        else
+        {
+            miral::WindowSpecification modifications;
+            if (call.advice == "advise_move_to")
+                modifications.top_left() = call.top_left;
+            else if (call.advice == "advise_resize")
+                modifications.size() = call.size;
+            else
+                modifications.state() = call.state;
+
+            time(call.advice, [&]
+                {
+                    window_manager.modify_window(window_manager.info_for(*window), modifications);
+                });
+        }
+    }
+
+    return skipped;
+}
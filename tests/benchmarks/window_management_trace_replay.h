@@ -0,0 +1,81 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_BENCHMARKS_WINDOW_MANAGEMENT_TRACE_REPLAY_H_
+#define MIR_BENCHMARKS_WINDOW_MANAGEMENT_TRACE_REPLAY_H_
+
+#include <mir/geometry/point.h>
+#include <mir/geometry/size.h>
+#include <mir_toolkit/common.h>
+
+#include <chrono>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace mir
+{
+namespace test
+{
+class TestWindowManagerTools;
+}
+
+namespace benchmarks
+{
+/**
+ * Replays a log written with --window-management-trace against a window manager.
+ *
+ * The trace records what the policy was told, not what the clients asked for, so each advice is
+ * replayed as the request most likely to have caused it: advise_new_window creates the window,
+ * advise_focus_gained selects it, advise_move_to moves it and so on. Windows are identified by
+ * name (the most recent window of that name if there are several) and all are created in one
+ * session. Lines that aren't replayable advice are ignored.
+ */
+class TraceReplay
+{
+public:
+    using Duration = std::chrono::nanoseconds;
+
+    explicit TraceReplay(std::istream& log);
+
+    /// The number of calls that will be replayed
+    auto size() const -> size_t { return calls.size(); }
+
+    /// Replay the trace, reporting the time taken by each call against the advice it replays.
+    /// Returns the number of calls skipped because they referred to an unknown window.
+    auto replay(
+        test::TestWindowManagerTools& target,
+        std::function<void(std::string const& advice, Duration elapsed)> const& record) const -> size_t;
+
+private:
+    struct Call
+    {
+        std::string advice;
+        std::string name;
+        std::string parent;
+        MirWindowType type{mir_window_type_normal};
+        MirWindowState state{mir_window_state_restored};
+        geometry::Point top_left;
+        geometry::Size size;
+    };
+
+    std::vector<Call> calls;
+};
+}
+}
+
+#endif // MIR_BENCHMARKS_WINDOW_MANAGEMENT_TRACE_REPLAY_H_
@@ -0,0 +1,152 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "info_map.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace testing;
+
+namespace
+{
+struct Object
+{
+    int value;
+};
+
+struct InfoMap : testing::Test
+{
+    miral::InfoMap<Object, std::string> map;
+
+    std::shared_ptr<Object> const object_a{std::make_shared<Object>(Object{1})};
+    std::shared_ptr<Object> const object_b{std::make_shared<Object>(Object{2})};
+    std::shared_ptr<Object> const object_c{std::make_shared<Object>(Object{3})};
+
+    auto keys() const -> std::vector<std::shared_ptr<Object>>
+    {
+        std::vector<std::shared_ptr<Object>> result;
+        for (auto const& entry : map)
+            result.push_back(entry.first.lock());
+        return result;
+    }
+};
+}
+
+TEST_F(InfoMap, when_created_is_empty)
+{
+    EXPECT_THAT(map.size(), Eq(0u));
+    EXPECT_THAT(map.find(object_a), Eq(map.end()));
+}
+
+TEST_F(InfoMap, emplaced_info_can_be_found)
+{
+    map.emplace(object_a, "a");
+    map.emplace(object_b, "b");
+
+    EXPECT_THAT(map.at(object_a), Eq("a"));
+    EXPECT_THAT(map.at(object_b), Eq("b"));
+    EXPECT_THAT(map.find(object_c), Eq(map.end()));
+}
+
+TEST_F(InfoMap, emplacing_an_existing_key_keeps_the_existing_info)
+{
+    map.emplace(object_a, "a");
+    auto const result = map.emplace(object_a, "another a");
+
+    EXPECT_FALSE(result.second);
+    EXPECT_THAT(map.at(object_a), Eq("a"));
+    EXPECT_THAT(map.size(), Eq(1u));
+}
+
+TEST_F(InfoMap, at_throws_for_unknown_key)
+{
+    EXPECT_THROW(map.at(object_a), std::out_of_range);
+}
+
+TEST_F(InfoMap, references_survive_other_insertions_and_erasures)
+{
+    auto& info_b = map[object_b];
+    info_b = "b";
+
+    map.emplace(object_a, "a");
+    map.emplace(object_c, "c");
+    map.erase(object_a);
+
+    EXPECT_THAT(&map.at(object_b), Eq(&info_b));
+}
+
+TEST_F(InfoMap, iterates_in_the_same_order_as_an_owner_less_map)
+{
+    std::vector<std::shared_ptr<Object>> objects;
+    for (auto i = 0; i != 20; ++i)
+        objects.push_back(std::make_shared<Object>(Object{i}));
+
+    std::map<std::weak_ptr<Object>, std::string, std::owner_less<std::weak_ptr<Object>>> reference;
+    for (auto i = objects.rbegin(); i != objects.rend(); ++i)
+    {
+        map.emplace(*i, std::to_string((*i)->value));
+        reference.emplace(*i, std::to_string((*i)->value));
+    }
+    map.erase(objects[7]);
+    reference.erase(objects[7]);
+
+    std::vector<std::shared_ptr<Object>> expected;
+    for (auto const& entry : reference)
+        expected.push_back(entry.first.lock());
+
+    EXPECT_THAT(keys(), ContainerEq(expected));
+}
+
+TEST_F(InfoMap, expired_key_can_be_found_and_erased)
+{
+    auto object = std::make_shared<Object>(Object{4});
+    std::weak_ptr<Object> const key{object};
+    map.emplace(object_a, "a");
+    map.emplace(key, "expiring");
+    object.reset();
+
+    ASSERT_THAT(map.find(key), Ne(map.end()));
+    EXPECT_THAT(map.find(key)->second, Eq("expiring"));
+
+    EXPECT_THAT(map.erase(key), Eq(1u));
+    EXPECT_THAT(map.find(key), Eq(map.end()));
+    EXPECT_THAT(map.at(object_a), Eq("a"));
+}
+
+TEST_F(InfoMap, a_new_object_is_not_confused_with_an_expired_one)
+{
+    std::weak_ptr<Object> expired_key;
+    {
+        auto const object = std::make_shared<Object>(Object{4});
+        expired_key = object;
+        map.emplace(object, "expired");
+    }
+
+    // The allocator will often reuse the address of the destroyed object
+    auto const new_object = std::make_shared<Object>(Object{5});
+
+    EXPECT_THAT(map.find(new_object), Eq(map.end()));
+    map.emplace(new_object, "new");
+
+    EXPECT_THAT(map.at(new_object), Eq("new"));
+    EXPECT_THAT(map.at(expired_key), Eq("expired"));
+}
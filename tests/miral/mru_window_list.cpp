@@ -187,3 +187,33 @@ TEST_F(MRUWindowList, hiding_then_showing_windows_retains_order)
     EXPECT_THAT(as_enumerated, ElementsAre(window_c, window_b, window_a));
 }
 
+
+TEST_F(MRUWindowList, erasing_a_window_from_the_middle_retains_order_of_others)
+{
+    mru_list.push(window_a);
+    mru_list.push(window_b);
+    mru_list.push(window_c);
+    mru_list.erase(window_b);
+
+    std::vector<miral::Window> as_enumerated;
+
+    mru_list.enumerate([&](miral::Window& window)
+       { as_enumerated.push_back(window); return true; });
+
+    EXPECT_THAT(as_enumerated, ElementsAre(window_c, window_a));
+}
+
+TEST_F(MRUWindowList, an_erased_window_can_be_pushed_again)
+{
+    mru_list.push(window_a);
+    mru_list.push(window_b);
+    mru_list.erase(window_a);
+    mru_list.push(window_a);
+
+    std::vector<miral::Window> as_enumerated;
+
+    mru_list.enumerate([&](miral::Window& window)
+       { as_enumerated.push_back(window); return true; });
+
+    EXPECT_THAT(as_enumerated, ElementsAre(window_a, window_b));
+}
@@ -286,8 +286,19 @@ struct mt::TestWindowManagerTools::Self
 };
 
 mt::TestWindowManagerTools::TestWindowManagerTools()
+    : TestWindowManagerTools{
+        [this](miral::WindowManagerTools const& tools) -> std::unique_ptr<miral::WindowManagementPolicy>
+            {
+                auto policy = std::make_unique<testing::NiceMock<MockWindowManagerPolicy>>(tools);
+                window_manager_policy = policy.get();
+                return policy;
+            }}
+{
+}
+
+mt::TestWindowManagerTools::TestWindowManagerTools(miral::WindowManagementPolicyBuilder const& build_policy)
     : self{std::make_unique<Self>()},
-      session{std::make_shared<StubStubSession>()},
+      session{create_session()},
       window_manager_policy{nullptr},
       window_manager_tools{nullptr},
       basic_window_manager{
@@ -295,12 +306,10 @@ mt::TestWindowManagerTools::TestWindowManagerTools()
         mir::test::fake_shared(self->display_layout),
         mir::test::fake_shared(self->persistent_surface_store),
         self->display_configuration_observer,
-        [this](miral::WindowManagerTools const& tools) -> std::unique_ptr<miral::WindowManagementPolicy>
+        [this, build_policy](miral::WindowManagerTools const& tools)
             {
-                auto policy = std::make_unique<testing::NiceMock<MockWindowManagerPolicy>>(tools);
-                window_manager_policy = policy.get();
                 window_manager_tools = tools;
-                return policy;
+                return build_policy(tools);
             }
     }
 {
@@ -308,6 +317,11 @@ mt::TestWindowManagerTools::TestWindowManagerTools()
 
 mt::TestWindowManagerTools::~TestWindowManagerTools() = default;
 
+auto mt::TestWindowManagerTools::create_session() -> std::shared_ptr<mir::scene::Session>
+{
+    return std::make_shared<StubStubSession>();
+}
+
 auto mt::TestWindowManagerTools::create_surface(
     std::shared_ptr<mir::scene::Session> const& session,
     mir::shell::SurfaceSpecification const& params) -> std::shared_ptr<mir::scene::Surface>
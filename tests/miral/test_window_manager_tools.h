@@ -74,6 +74,8 @@ private:
 
 public:
     TestWindowManagerTools();
+    /// Manage windows with the policy built by build_policy (window_manager_policy is then null)
+    explicit TestWindowManagerTools(miral::WindowManagementPolicyBuilder const& build_policy);
     ~TestWindowManagerTools();
 
     std::shared_ptr<mir::scene::Session> session;
@@ -81,6 +83,9 @@ public:
     miral::WindowManagerTools window_manager_tools;
     miral::BasicWindowManager basic_window_manager;
 
+    /// Another client session, which must also be added to basic_window_manager
+    static auto create_session() -> std::shared_ptr<mir::scene::Session>;
+
     static auto create_surface(
         std::shared_ptr<mir::scene::Session> const& session,
         mir::shell::SurfaceSpecification const& params) -> std::shared_ptr<mir::scene::Surface>;
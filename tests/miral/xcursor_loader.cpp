@@ -0,0 +1,194 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "xcursor_loader.h"
+
+#include <mir/graphics/cursor_image.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+using namespace testing;
+namespace geom = mir::geometry;
+
+namespace
+{
+uint32_t const xcursor_image_type = 0xfffd0002;
+
+// Each nominal size is filled with its own color, so the tests can tell which was loaded
+auto color_for(uint32_t nominal_size) -> uint32_t
+{
+    return 0xff000000 | nominal_size;
+}
+
+/// Writes an XCursor file with a square image for each of the given nominal sizes
+void write_cursor(std::filesystem::path const& file, std::vector<uint32_t> const& nominal_sizes)
+{
+    std::vector<uint32_t> data{0x72756358 /* "Xcur" */, 16, 0x10000, static_cast<uint32_t>(nominal_sizes.size())};
+
+    auto position = 16 + 12 * nominal_sizes.size();
+    for (auto const size : nominal_sizes)
+    {
+        data.insert(data.end(), {xcursor_image_type, size, static_cast<uint32_t>(position)});
+        position += 36 + 4 * size * size;
+    }
+
+    for (auto const size : nominal_sizes)
+    {
+        data.insert(data.end(), {36, xcursor_image_type, size, 1, size, size, size / 2, size / 2, 0});
+        data.insert(data.end(), size * size, color_for(size));
+    }
+
+    std::filesystem::create_directories(file.parent_path());
+    std::ofstream{file, std::ios::binary}.write(
+        reinterpret_cast<char const*>(data.data()), data.size() * sizeof(data.front()));
+}
+
+auto first_pixel(mir::graphics::CursorImage const& image) -> uint32_t
+{
+    return *static_cast<uint32_t const*>(image.as_argb_8888());
+}
+
+struct XCursorLoader : Test
+{
+    XCursorLoader()
+    {
+        // XCursor reads XCURSOR_PATH once per process, so every test uses the same directory
+        static auto const path = []
+            {
+                auto const dir = std::filesystem::temp_directory_path() /
+                    ("miral-xcursor-test-" + std::to_string(getpid()));
+                setenv("XCURSOR_PATH", dir.c_str(), true);
+                return dir;
+            }();
+
+        // ...and a theme of its own
+        theme = UnitTest::GetInstance()->current_test_info()->name();
+        theme_dir = path / theme;
+    }
+
+    ~XCursorLoader()
+    {
+        std::filesystem::remove_all(theme_dir);
+    }
+
+    auto cursor_file(std::string const& name) const -> std::filesystem::path
+    {
+        return theme_dir / "cursors" / name;
+    }
+
+    std::string theme;
+    std::filesystem::path theme_dir;
+};
+}
+
+TEST_F(XCursorLoader, loads_the_requested_nominal_size)
+{
+    write_cursor(cursor_file("arrow"), {24, 48});
+    miral::XCursorLoader loader{theme};
+
+    auto const small = loader.image("arrow", {24, 24});
+    auto const large = loader.image("arrow", {48, 48});
+
+    ASSERT_THAT(small, NotNull());
+    ASSERT_THAT(large, NotNull());
+    EXPECT_THAT(small->size(), Eq(geom::Size{24, 24}));
+    EXPECT_THAT(first_pixel(*small), Eq(color_for(24)));
+    EXPECT_THAT(large->size(), Eq(geom::Size{48, 48}));
+    EXPECT_THAT(first_pixel(*large), Eq(color_for(48)));
+}
+
+TEST_F(XCursorLoader, repeated_request_is_served_from_cache)
+{
+    write_cursor(cursor_file("arrow"), {24});
+    miral::XCursorLoader loader{theme};
+
+    auto const first = loader.image("arrow", {24, 24});
+    std::filesystem::remove(cursor_file("arrow"));
+    auto const second = loader.image("arrow", {24, 24});
+
+    ASSERT_THAT(first, NotNull());
+    EXPECT_THAT(second, Eq(first));
+}
+
+TEST_F(XCursorLoader, cache_is_shared_between_loaders)
+{
+    write_cursor(cursor_file("arrow"), {24});
+    miral::XCursorLoader loader{theme};
+    miral::XCursorLoader other_loader{theme};
+
+    auto const image = loader.image("arrow", {24, 24});
+
+    ASSERT_THAT(image, NotNull());
+    EXPECT_THAT(other_loader.image("arrow", {24, 24}), Eq(image));
+}
+
+TEST_F(XCursorLoader, size_change_loads_new_size_and_keeps_the_old_one)
+{
+    write_cursor(cursor_file("arrow"), {24, 32});
+    miral::XCursorLoader loader{theme};
+
+    auto const before = loader.image("arrow", {24, 24});
+    auto const resized = loader.image("arrow", {32, 32});
+    std::filesystem::remove(cursor_file("arrow"));
+    auto const restored = loader.image("arrow", {24, 24});
+
+    ASSERT_THAT(before, NotNull());
+    ASSERT_THAT(resized, NotNull());
+    EXPECT_THAT(resized, Ne(before));
+    EXPECT_THAT(resized->size(), Eq(geom::Size{32, 32}));
+    EXPECT_THAT(restored, Eq(before));
+}
+
+TEST_F(XCursorLoader, missing_cursor_falls_back_to_arrow)
+{
+    write_cursor(cursor_file("arrow"), {24});
+    miral::XCursorLoader loader{theme};
+
+    auto const arrow = loader.image("arrow", {24, 24});
+
+    EXPECT_THAT(loader.image("no-such-cursor", {24, 24}), Eq(arrow));
+}
+
+TEST_F(XCursorLoader, misses_are_cached)
+{
+    miral::XCursorLoader loader{theme};
+
+    EXPECT_THAT(loader.image("arrow", {24, 24}), IsNull());
+
+    write_cursor(cursor_file("arrow"), {24});
+
+    EXPECT_THAT(loader.image("arrow", {24, 24}), IsNull());
+}
+
+TEST_F(XCursorLoader, cache_is_dropped_with_the_last_loader)
+{
+    {
+        miral::XCursorLoader loader{theme};
+        EXPECT_THAT(loader.image("arrow", {24, 24}), IsNull());
+    }
+
+    write_cursor(cursor_file("arrow"), {24});
+    miral::XCursorLoader loader{theme};
+
+    EXPECT_THAT(loader.image("arrow", {24, 24}), NotNull());
+}
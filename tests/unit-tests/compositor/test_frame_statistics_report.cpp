@@ -0,0 +1,204 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/compositor/frame_statistics_report.h"
+
+#include "mir/test/doubles/advanceable_clock.h"
+#include "mir/test/doubles/mock_compositor_report.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mc = mir::compositor;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+struct FrameStatisticsReport : Test
+{
+    void composite_frame(std::chrono::microseconds render, std::chrono::microseconds post)
+    {
+        report.began_frame(id);
+        clock->advance_by(render);
+        report.rendered_frame(id);
+        clock->advance_by(post);
+        report.finished_frame(id);
+    }
+
+    void bypass_frame(std::chrono::microseconds post)
+    {
+        report.began_frame(id);
+        clock->advance_by(post);
+        report.finished_frame(id);
+    }
+
+    auto statistics() const -> mc::OutputFrameStatistics
+    {
+        auto const all = report.output_statistics();
+        EXPECT_THAT(all.size(), Eq(1u));
+        return all.empty() ? mc::OutputFrameStatistics{} : all.front();
+    }
+
+    std::shared_ptr<NiceMock<mtd::MockCompositorReport>> const next{
+        std::make_shared<NiceMock<mtd::MockCompositorReport>>()};
+    std::shared_ptr<mtd::AdvanceableClock> const clock{std::make_shared<mtd::AdvanceableClock>()};
+    mc::FrameStatisticsReport report{next, clock};
+
+    int const output_id_storage{0};
+    mc::CompositorReport::SubCompositorId const id{&output_id_storage};
+};
+}
+
+TEST(DurationHistogram, samples_go_in_the_smallest_bucket_that_holds_them)
+{
+    mc::DurationHistogram histogram;
+
+    histogram.add(mc::DurationHistogram::bucket_limit(0));
+    histogram.add(mc::DurationHistogram::bucket_limit(0) + 1us);
+    histogram.add(1h);
+
+    auto const& buckets = histogram.buckets();
+    EXPECT_THAT(buckets[0], Eq(1u));
+    EXPECT_THAT(buckets[1], Eq(1u));
+    EXPECT_THAT(buckets[mc::DurationHistogram::bucket_count - 1], Eq(1u));
+    EXPECT_THAT(histogram.count(), Eq(3u));
+    EXPECT_THAT(histogram.max(), Eq(mc::DurationHistogram::Duration{1h}));
+}
+
+TEST_F(FrameStatisticsReport, forwards_events_to_next_report)
+{
+    InSequence seq;
+    EXPECT_CALL(*next, added_display(640, 480, 0, 0, id));
+    EXPECT_CALL(*next, began_frame(id));
+    EXPECT_CALL(*next, rendered_frame(id));
+    EXPECT_CALL(*next, finished_frame(id));
+
+    report.added_display(640, 480, 0, 0, id);
+    composite_frame(1ms, 1ms);
+}
+
+TEST_F(FrameStatisticsReport, records_display_area)
+{
+    report.added_display(640, 480, 10, 20, id);
+
+    EXPECT_THAT(statistics().area, Eq(geom::Rectangle{{10, 20}, {640, 480}}));
+}
+
+TEST_F(FrameStatisticsReport, records_render_and_post_times)
+{
+    report.added_display(640, 480, 0, 0, id);
+
+    composite_frame(3ms, 5ms);
+
+    auto const stats = statistics();
+    EXPECT_THAT(stats.frames, Eq(1u));
+    EXPECT_THAT(stats.bypassed_frames, Eq(0u));
+    EXPECT_THAT(stats.render_time.total(), Eq(mc::DurationHistogram::Duration{3ms}));
+    EXPECT_THAT(stats.post_time.total(), Eq(mc::DurationHistogram::Duration{5ms}));
+}
+
+TEST_F(FrameStatisticsReport, counts_bypassed_frames)
+{
+    report.added_display(640, 480, 0, 0, id);
+
+    composite_frame(1ms, 1ms);
+    bypass_frame(2ms);
+
+    auto const stats = statistics();
+    EXPECT_THAT(stats.frames, Eq(2u));
+    EXPECT_THAT(stats.bypassed_frames, Eq(1u));
+    EXPECT_THAT(stats.render_time.count(), Eq(1u));
+    EXPECT_THAT(stats.post_time.count(), Eq(2u));
+}
+
+TEST_F(FrameStatisticsReport, records_scene_change_to_composite_once_per_change)
+{
+    report.added_display(640, 480, 0, 0, id);
+    clock->advance_by(1s);
+
+    report.scheduled();
+    clock->advance_by(2ms);
+    composite_frame(1ms, 1ms);
+    composite_frame(1ms, 1ms);
+
+    auto const stats = statistics();
+    EXPECT_THAT(stats.scene_change_to_composite.count(), Eq(1u));
+    EXPECT_THAT(stats.scene_change_to_composite.total(), Eq(mc::DurationHistogram::Duration{2ms}));
+}
+
+TEST_F(FrameStatisticsReport, frame_interval_ignores_idle_gaps)
+{
+    report.added_display(640, 480, 0, 0, id);
+
+    bypass_frame(16ms);
+    bypass_frame(16ms);
+    clock->advance_by(1s);
+    bypass_frame(16ms);
+
+    EXPECT_THAT(statistics().frame_interval.count(), Eq(1u));
+}
+
+TEST_F(FrameStatisticsReport, estimates_missed_vblanks_from_frame_intervals)
+{
+    report.added_display(640, 480, 0, 0, id);
+
+    for (auto i = 0; i != 10; ++i)
+        bypass_frame(16ms);
+
+    EXPECT_THAT(statistics().missed_vblanks, Eq(0u));
+
+    bypass_frame(48ms);
+
+    EXPECT_THAT(statistics().missed_vblanks, Eq(2u));
+}
+
+TEST_F(FrameStatisticsReport, does_not_count_missed_vblanks_on_unthrottled_outputs)
+{
+    report.added_display(640, 480, 0, 0, id);
+
+    for (auto i = 0; i != 10; ++i)
+        bypass_frame(100us);
+    bypass_frame(1ms);
+
+    EXPECT_THAT(statistics().missed_vblanks, Eq(0u));
+}
+
+TEST_F(FrameStatisticsReport, stopping_clears_statistics)
+{
+    report.added_display(640, 480, 0, 0, id);
+    composite_frame(1ms, 1ms);
+
+    report.stopped();
+
+    EXPECT_THAT(report.output_statistics(), IsEmpty());
+}
+
+TEST_F(FrameStatisticsReport, outputs_are_ordered_by_position)
+{
+    int const other_id_storage{0};
+    mc::CompositorReport::SubCompositorId const other_id{&other_id_storage};
+
+    report.added_display(640, 480, 640, 0, id);
+    report.added_display(640, 480, 0, 0, other_id);
+
+    auto const all = report.output_statistics();
+    ASSERT_THAT(all.size(), Eq(2u));
+    EXPECT_THAT(all[0].id, Eq(other_id));
+    EXPECT_THAT(all[1].id, Eq(id));
+}
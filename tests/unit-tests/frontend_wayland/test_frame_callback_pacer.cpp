@@ -0,0 +1,268 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/frame_callback_pacer.h"
+#include "src/server/frontend_wayland/frame_executor.h"
+#include "mir/test/doubles/fake_alarm_factory.h"
+#include "mir/test/doubles/explicit_executor.h"
+#include "mir/test/doubles/stub_surface.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mf = mir::frontend;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+struct WindowSurface : mtd::StubSurface
+{
+    bool visible() const override { return !hidden; }
+    MirWindowState state() const override { return window_state; }
+
+    int query(MirWindowAttrib attrib) const override
+    {
+        return attrib == mir_window_attrib_visibility ? visibility : 0;
+    }
+
+    bool hidden{false};
+    MirWindowState window_state{mir_window_state_restored};
+    MirWindowVisibility visibility{mir_window_visibility_exposed};
+};
+
+auto const frame_interval = 16ms;
+auto const hidden_frame_interval = 1000ms;
+
+struct FrameCallbackPacer : Test
+{
+    mtd::FakeAlarmFactory alarm_factory;
+    std::shared_ptr<mtd::ExplicitExecutor> const wayland_executor{std::make_shared<mtd::ExplicitExecutor>()};
+    mf::FrameCallbackPacer pacer{
+        wayland_executor,
+        std::make_shared<mf::FrameExecutor>(alarm_factory, frame_interval),
+        std::make_shared<mf::FrameExecutor>(alarm_factory, hidden_frame_interval)};
+
+    std::vector<int> sent;
+
+    auto callbacks(std::initializer_list<int> ids) -> std::vector<mf::FrameCallbackPacer::Callback>
+    {
+        std::vector<mf::FrameCallbackPacer::Callback> result;
+        for (auto const id : ids)
+        {
+            result.push_back([this, id]() { sent.push_back(id); });
+        }
+        return result;
+    }
+
+    void advance_by(std::chrono::milliseconds step)
+    {
+        alarm_factory.advance_by(step);
+        wayland_executor->execute();
+    }
+
+    ~FrameCallbackPacer()
+    {
+        wayland_executor->execute();
+    }
+};
+}
+
+TEST(CanBeSeen, surface_that_is_not_a_window_can_be_seen)
+{
+    EXPECT_TRUE(mf::can_be_seen(nullptr, true));
+}
+
+TEST(CanBeSeen, exposed_window_can_be_seen)
+{
+    WindowSurface window;
+
+    EXPECT_TRUE(mf::can_be_seen(&window, true));
+}
+
+TEST(CanBeSeen, minimized_window_cannot_be_seen)
+{
+    WindowSurface window;
+    window.window_state = mir_window_state_minimized;
+
+    EXPECT_FALSE(mf::can_be_seen(&window, true));
+}
+
+TEST(CanBeSeen, window_in_hidden_state_cannot_be_seen)
+{
+    WindowSurface window;
+    window.window_state = mir_window_state_hidden;
+
+    EXPECT_FALSE(mf::can_be_seen(&window, true));
+}
+
+TEST(CanBeSeen, hidden_window_cannot_be_seen)
+{
+    WindowSurface window;
+    window.hidden = true;
+
+    EXPECT_FALSE(mf::can_be_seen(&window, true));
+}
+
+TEST(CanBeSeen, occluded_window_cannot_be_seen)
+{
+    WindowSurface window;
+    window.visibility = mir_window_visibility_occluded;
+
+    EXPECT_FALSE(mf::can_be_seen(&window, true));
+}
+
+TEST(CanBeSeen, window_without_a_buffer_can_be_seen)
+{
+    // It starts out occluded, but only because it hasn't been composited yet
+    WindowSurface window;
+    window.visibility = mir_window_visibility_occluded;
+
+    EXPECT_TRUE(mf::can_be_seen(&window, false));
+}
+
+TEST_F(FrameCallbackPacer, commit_without_buffer_is_paced_by_frame_executor)
+{
+    pacer.commit(callbacks({1}), false, true);
+
+    advance_by(frame_interval - 1ms);
+    EXPECT_THAT(sent, IsEmpty());
+
+    advance_by(2ms);
+    EXPECT_THAT(sent, ElementsAre(1));
+}
+
+TEST_F(FrameCallbackPacer, commit_with_buffer_waits_for_the_buffer_to_be_consumed)
+{
+    pacer.commit(callbacks({1}), true, true);
+
+    advance_by(hidden_frame_interval + 1ms);
+    EXPECT_THAT(sent, IsEmpty());
+
+    pacer.buffer_consumed()();
+    wayland_executor->execute();
+    EXPECT_THAT(sent, ElementsAre(1));
+}
+
+TEST_F(FrameCallbackPacer, commit_without_buffer_that_cannot_be_seen_is_paced_by_hidden_frame_executor)
+{
+    pacer.commit(callbacks({1}), false, false);
+
+    advance_by(hidden_frame_interval - 1ms);
+    EXPECT_THAT(sent, IsEmpty());
+
+    advance_by(2ms);
+    EXPECT_THAT(sent, ElementsAre(1));
+}
+
+TEST_F(FrameCallbackPacer, commit_with_buffer_that_cannot_be_seen_is_paced_by_hidden_frame_executor)
+{
+    pacer.commit(callbacks({1}), true, false);
+
+    advance_by(hidden_frame_interval - 1ms);
+    EXPECT_THAT(sent, IsEmpty());
+
+    advance_by(2ms);
+    EXPECT_THAT(sent, ElementsAre(1));
+}
+
+TEST_F(FrameCallbackPacer, earlier_callbacks_waiting_for_a_buffer_are_parked_when_surface_cannot_be_seen)
+{
+    pacer.commit(callbacks({1}), true, true);
+    pacer.commit(callbacks({2}), false, false);
+
+    advance_by(hidden_frame_interval + 1ms);
+    EXPECT_THAT(sent, ElementsAre(1, 2));
+}
+
+TEST_F(FrameCallbackPacer, parked_callbacks_are_sent_as_soon_as_surface_can_be_seen)
+{
+    pacer.commit(callbacks({1, 2}), false, false);
+
+    pacer.send_parked();
+    EXPECT_THAT(sent, ElementsAre(1, 2));
+}
+
+TEST_F(FrameCallbackPacer, hidden_frame_executor_does_not_send_callbacks_committed_once_surface_can_be_seen)
+{
+    pacer.commit(callbacks({1}), false, false);
+    pacer.send_parked();
+    pacer.commit(callbacks({2}), true, true);
+
+    advance_by(hidden_frame_interval + 1ms);
+    EXPECT_THAT(sent, ElementsAre(1));
+
+    pacer.buffer_consumed()();
+    wayland_executor->execute();
+    EXPECT_THAT(sent, ElementsAre(1, 2));
+}
+
+TEST_F(FrameCallbackPacer, send_all_sends_parked_and_pending_callbacks)
+{
+    pacer.commit(callbacks({1}), false, false);
+    pacer.commit(callbacks({2}), true, true);
+
+    pacer.send_all();
+    EXPECT_THAT(sent, UnorderedElementsAre(1, 2));
+}
+
+TEST_F(FrameCallbackPacer, callbacks_are_not_sent_after_pacer_is_destroyed)
+{
+    auto short_lived = std::make_unique<mf::FrameCallbackPacer>(
+        wayland_executor,
+        std::make_shared<mf::FrameExecutor>(alarm_factory, frame_interval),
+        std::make_shared<mf::FrameExecutor>(alarm_factory, hidden_frame_interval));
+    auto const consumed = short_lived->buffer_consumed();
+
+    short_lived->commit(callbacks({1}), true, true);
+    short_lived.reset();
+
+    consumed();
+    wayland_executor->execute();
+    EXPECT_THAT(sent, IsEmpty());
+}
+
+TEST_F(FrameCallbackPacer, without_hidden_frame_executor_callbacks_that_cannot_be_seen_wait_until_they_can)
+{
+    mf::FrameCallbackPacer parking_pacer{
+        wayland_executor,
+        std::make_shared<mf::FrameExecutor>(alarm_factory, frame_interval),
+        nullptr};
+
+    parking_pacer.commit(callbacks({1}), true, false);
+    parking_pacer.commit(callbacks({2}), false, false);
+
+    advance_by(10 * hidden_frame_interval);
+    EXPECT_THAT(sent, IsEmpty());
+
+    parking_pacer.send_parked();
+    EXPECT_THAT(sent, ElementsAre(1, 2));
+}
+
+TEST_F(FrameCallbackPacer, without_hidden_frame_executor_callbacks_that_can_be_seen_are_paced_as_usual)
+{
+    mf::FrameCallbackPacer parking_pacer{
+        wayland_executor,
+        std::make_shared<mf::FrameExecutor>(alarm_factory, frame_interval),
+        nullptr};
+
+    parking_pacer.commit(callbacks({1}), false, true);
+
+    advance_by(frame_interval + 1ms);
+    EXPECT_THAT(sent, ElementsAre(1));
+}
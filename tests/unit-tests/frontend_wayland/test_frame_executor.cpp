@@ -0,0 +1,94 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/frame_executor.h"
+#include "mir/test/doubles/fake_alarm_factory.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mf = mir::frontend;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+struct FrameExecutorTest : Test
+{
+    mtd::FakeAlarmFactory alarm_factory;
+    int runs{0};
+
+    auto count_run()
+    {
+        return [this]() { ++runs; };
+    }
+};
+}
+
+TEST_F(FrameExecutorTest, runs_work_after_default_interval)
+{
+    mf::FrameExecutor executor{alarm_factory};
+
+    executor.spawn(count_run());
+
+    alarm_factory.advance_by(15ms);
+    EXPECT_THAT(runs, Eq(0));
+
+    alarm_factory.advance_by(2ms);
+    EXPECT_THAT(runs, Eq(1));
+}
+
+TEST_F(FrameExecutorTest, runs_work_after_given_interval)
+{
+    mf::FrameExecutor executor{alarm_factory, 1000ms};
+
+    executor.spawn(count_run());
+
+    alarm_factory.advance_by(999ms);
+    EXPECT_THAT(runs, Eq(0));
+
+    alarm_factory.advance_by(2ms);
+    EXPECT_THAT(runs, Eq(1));
+}
+
+TEST_F(FrameExecutorTest, work_spawned_before_alarm_fires_runs_with_the_first)
+{
+    mf::FrameExecutor executor{alarm_factory, 100ms};
+
+    executor.spawn(count_run());
+    alarm_factory.advance_by(90ms);
+    executor.spawn(count_run());
+
+    alarm_factory.advance_by(11ms);
+    EXPECT_THAT(runs, Eq(2));
+}
+
+TEST_F(FrameExecutorTest, work_spawned_after_alarm_fires_waits_a_full_interval)
+{
+    mf::FrameExecutor executor{alarm_factory, 100ms};
+
+    executor.spawn(count_run());
+    alarm_factory.advance_by(101ms);
+    executor.spawn(count_run());
+
+    alarm_factory.advance_by(99ms);
+    EXPECT_THAT(runs, Eq(1));
+
+    alarm_factory.advance_by(2ms);
+    EXPECT_THAT(runs, Eq(2));
+}
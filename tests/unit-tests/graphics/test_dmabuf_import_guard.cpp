@@ -0,0 +1,99 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/platform/graphics/dmabuf_import_guard.h"
+#include "mir/logging/logger.h"
+#include "mir/logging/dumb_console_logger.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <stdexcept>
+
+namespace mg = mir::graphics;
+namespace ml = mir::logging;
+using namespace testing;
+
+namespace
+{
+struct MockLogger : ml::Logger
+{
+    MOCK_METHOD3(log, void (ml::Severity severity, std::string const& message, std::string const& component));
+};
+
+struct DmaBufImportGuard : Test
+{
+    std::shared_ptr<MockLogger> const logger{std::make_shared<NiceMock<MockLogger>>()};
+    mg::DmaBufImportGuard guard;
+
+    void SetUp() override
+    {
+        ml::set_logger(logger);
+    }
+
+    void TearDown() override
+    {
+        ml::set_logger(std::make_shared<ml::DumbConsoleLogger>());
+    }
+};
+}
+
+TEST_F(DmaBufImportGuard, returns_the_imported_texture)
+{
+    EXPECT_THAT(guard.import([]() -> GLuint { return 42; }), Eq(42u));
+    EXPECT_FALSE(guard.failed());
+}
+
+TEST_F(DmaBufImportGuard, imports_again_after_a_successful_import)
+{
+    int imports{0};
+    auto const import = [&]() -> GLuint { return ++imports; };
+
+    guard.import(import);
+    guard.import(import);
+
+    EXPECT_THAT(imports, Eq(2));
+}
+
+TEST_F(DmaBufImportGuard, failed_import_returns_no_texture)
+{
+    EXPECT_THAT(guard.import([]() -> GLuint { throw std::runtime_error{"EGL_BAD_MATCH"}; }), Eq(0u));
+    EXPECT_TRUE(guard.failed());
+}
+
+TEST_F(DmaBufImportGuard, does_not_retry_after_a_failed_import)
+{
+    int imports{0};
+    auto const import = [&]() -> GLuint { ++imports; throw std::runtime_error{"EGL_BAD_MATCH"}; };
+
+    for (auto frame = 0; frame != 10; ++frame)
+    {
+        EXPECT_THAT(guard.import(import), Eq(0u));
+    }
+
+    EXPECT_THAT(imports, Eq(1));
+}
+
+TEST_F(DmaBufImportGuard, logs_a_failed_import_only_once)
+{
+    EXPECT_CALL(*logger, log(ml::Severity::error, HasSubstr("EGL_BAD_MATCH"), _)).Times(1);
+
+    for (auto frame = 0; frame != 10; ++frame)
+    {
+        guard.import([]() -> GLuint { throw std::runtime_error{"EGL_BAD_MATCH"}; });
+    }
+}
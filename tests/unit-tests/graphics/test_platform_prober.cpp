@@ -16,8 +16,15 @@
 
 #include <gtest/gtest.h>
 #include <fcntl.h>
+#include <sys/sysmacros.h>
 #include <boost/throw_exception.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+
 #include "mir/graphics/platform.h"
 #include "src/server/graphics/platform_probe.h"
 #include "mir/options/program_option.h"
@@ -154,6 +161,64 @@ public:
     }
 };
 
+/**
+ * Console services that, like logind, refuse to hand out a device that is already acquired
+ */
+class ExclusiveConsoleServices : public StubConsoleServices
+{
+public:
+    std::future<std::unique_ptr<mir::Device>> acquire_device(
+        int major, int minor,
+        std::unique_ptr<mir::Device::Observer> observer) override
+    {
+        {
+            std::lock_guard lock{mutex};
+            if (!held_devices.insert(makedev(major, minor)).second)
+            {
+                acquired_twice = true;
+                BOOST_THROW_EXCEPTION((std::runtime_error{"Attempted to acquire a device multiple times"}));
+            }
+        }
+
+        std::stringstream filename;
+        filename << "/dev/dri/" << major << ":" << minor;
+        observer->activated(mir::Fd{::open(filename.str().c_str(), O_RDWR | O_CLOEXEC)});
+
+        // Hold the device long enough that any concurrent probe would try to acquire it too
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+
+        std::promise<std::unique_ptr<mir::Device>> promise;
+        promise.set_value(std::make_unique<HeldDevice>(*this, makedev(major, minor)));
+        return promise.get_future();
+    }
+
+    std::atomic<bool> acquired_twice{false};
+
+private:
+    class HeldDevice : public mir::Device
+    {
+    public:
+        HeldDevice(ExclusiveConsoleServices& console, dev_t devnum)
+            : console{console},
+              devnum{devnum}
+        {
+        }
+
+        ~HeldDevice()
+        {
+            std::lock_guard lock{console.mutex};
+            console.held_devices.erase(devnum);
+        }
+
+    private:
+        ExclusiveConsoleServices& console;
+        dev_t const devnum;
+    };
+
+    std::mutex mutex;
+    std::set<dev_t> held_devices;
+};
+
 class ServerPlatformProbeMockDRM : public ::testing::Test
 {
 #if defined(MIR_BUILD_PLATFORM_GBM_KMS)
@@ -198,6 +263,27 @@ TEST_F(ServerPlatformProbeMockDRM, LoadsMesaPlatformWhenDrmMasterCanBeAcquired)
     EXPECT_THAT(found_platforms, Contains(HasSubstr("gbm-kms")));
 }
 
+TEST_F(ServerPlatformProbeMockDRM, ModulesProbingTheSameDeviceDoNotAcquireItConcurrently)
+{
+    using namespace testing;
+    mir::options::ProgramOption options;
+    auto fake_mesa = ensure_mesa_probing_succeeds();
+
+    auto modules = available_platforms();
+    auto const more_modules = available_platforms();
+    modules.insert(modules.end(), more_modules.begin(), more_modules.end());
+    auto const console = std::make_shared<ExclusiveConsoleServices>();
+
+    auto selection_result = mir::graphics::display_modules_for_device(modules, options, console);
+
+    EXPECT_FALSE(console->acquired_twice);
+    EXPECT_THAT(selection_result, Not(IsEmpty()));
+    for (auto& [device, module] : selection_result)
+    {
+        EXPECT_THAT(device.support_level, Gt(mir::graphics::PlatformPriority::unsupported));
+    }
+}
+
 TEST_F(ServerPlatformProbeMockDRM, DoesNotLoadDummyPlatformWhenBetterPlatformExists)
 {
     using namespace testing;
@@ -87,6 +87,10 @@ struct StubKMSOutputContainer : public mgg::KMSOutputContainer
     {
     }
 
+    void mark_changed(dev_t, std::optional<uint32_t>)
+    {
+    }
+
     std::vector<std::shared_ptr<testing::NiceMock<MockKMSOutput>>> outputs;
 };
 
@@ -122,6 +122,7 @@ public:
                *std::make_shared<mtd::StubConsoleServices>(),
                *std::make_shared<mtd::NullEmergencyCleanup>(),
                mgg::BypassOption::allowed,
+               mgg::CompositingOption::gl,
                std::make_unique<mgg::Quirks>(mir::options::ProgramOption{}));
     }
 
@@ -132,6 +133,7 @@ public:
             platform->drm,
             platform->gbm,
             platform->bypass_option(),
+            mgg::CompositingOption::gl,
             std::make_shared<mg::CloneDisplayConfigurationPolicy>(),
             std::make_shared<mtd::StubGLConfig>(),
             null_report);
@@ -634,6 +636,7 @@ TEST_F(MesaDisplayTest, successful_creation_of_display_reports_successful_setup_
                         platform->drm,
                         platform->gbm,
                         platform->bypass_option(),
+                        mgg::CompositingOption::gl,
                         std::make_shared<mg::CloneDisplayConfigurationPolicy>(),
                         std::make_shared<mtd::StubGLConfig>(),
                         mock_report);
@@ -854,6 +857,7 @@ TEST_F(MesaDisplayTest, respects_gl_config)
         platform->drm,
         platform->gbm,
         platform->bypass_option(),
+        mgg::CompositingOption::gl,
         std::make_shared<mg::CloneDisplayConfigurationPolicy>(),
         mir::test::fake_shared(mock_gl_config),
         null_report};
@@ -881,6 +885,7 @@ TEST_F(MesaDisplayTest, uses_xrgb8888_framebuffer_when_argb8888_is_not_supported
         platform->drm,
         platform->gbm,
         platform->bypass_option(),
+        mgg::CompositingOption::gl,
         std::make_shared<mg::CloneDisplayConfigurationPolicy>(),
         std::make_shared<NiceMock<mtd::MockGLConfig>>(),
         null_report};
@@ -908,6 +913,7 @@ TEST_F(MesaDisplayTest, uses_argb8888_framebuffer_when_xrgb8888_is_not_supported
         platform->drm,
         platform->gbm,
         platform->bypass_option(),
+        mgg::CompositingOption::gl,
         std::make_shared<mg::CloneDisplayConfigurationPolicy>(),
         std::make_shared<NiceMock<mtd::MockGLConfig>>(),
         null_report};
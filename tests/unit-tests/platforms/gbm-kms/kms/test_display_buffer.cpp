@@ -17,12 +17,14 @@
 #include "src/server/report/null_report_factory.h"
 #include "src/platforms/gbm-kms/server/kms/platform.h"
 #include "src/platforms/gbm-kms/server/kms/display_buffer.h"
+#include "src/platforms/gbm-kms/server/kms/fb_handle.h"
 #include "mir/graphics/dmabuf_buffer.h"
 #include "mir/test/doubles/mock_egl.h"
 #include "mir/test/doubles/mock_gl.h"
 #include "mir/test/doubles/mock_drm.h"
 #include "mir/test/doubles/mock_buffer.h"
 #include "mir/test/doubles/mock_gbm.h"
+#include "mir/test/doubles/stub_buffer.h"
 #include "mir/test/doubles/stub_gl_config.h"
 #include "mir_test_framework/udev_environment.h"
 #include "mir/test/doubles/fake_renderable.h"
@@ -32,6 +34,9 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include <gbm.h>
+#include <xf86drm.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 using namespace testing;
 using namespace mir;
@@ -340,8 +345,10 @@ TEST_F(MesaDisplayBufferTest, rotated_cannot_bypass)
     EXPECT_FALSE(db.overlay(bypassable_list));
 }
 
-TEST_F(MesaDisplayBufferTest, fullscreen_software_buffer_cannot_bypass)
+TEST_F(MesaDisplayBufferTest, fullscreen_software_buffer_that_cannot_be_mapped_is_not_overlaid)
 {
+    // A fullscreen SHM buffer is scanned out by copying it into a dumb buffer, but that needs to map
+    // the buffer; this one is neither a dmabuf nor mappable, so there's nothing it can be scanned out from.
     graphics::RenderableList const list{fake_software_renderable};
 
     // Passes the bypass candidate test:
@@ -481,3 +488,85 @@ TEST_F(MesaDisplayBufferTest, skips_bypass_because_of_incompatible_list)
 
     EXPECT_FALSE(db.overlay(list));
 }
+
+TEST_F(MesaDisplayBufferTest, fullscreen_shm_buffer_is_copied_into_a_dumb_buffer_for_scanout)
+{
+    // Dumb buffers are mapped through the DRM fd, so give them some real memory to live in
+    off_t const dumb_buffer_spacing = 64 * 1024;
+    mir::Fd const drm_fd{memfd_create("fake-drm", 0)};
+    ASSERT_THAT(ftruncate(drm_fd, 2 * dumb_buffer_spacing), Eq(0));
+    ON_CALL(*mock_kms_output, drm_fd()).WillByDefault(Return(drm_fd));
+    uint32_t handles_created{0};
+
+    ON_CALL(mock_drm, drmIoctl(_, _, _))
+        .WillByDefault(Invoke(
+            [&](int, unsigned long request, void* arg)
+            {
+                switch (request)
+                {
+                case DRM_IOCTL_MODE_CREATE_DUMB:
+                {
+                    auto const params = static_cast<drm_mode_create_dumb*>(arg);
+                    params->handle = ++handles_created;
+                    params->pitch = params->width * params->bpp / 8;
+                    params->size = params->pitch * params->height;
+                    return 0;
+                }
+                case DRM_IOCTL_MODE_MAP_DUMB:
+                {
+                    auto const params = static_cast<drm_mode_map_dumb*>(arg);
+                    params->offset = (params->handle - 1) * dumb_buffer_spacing;
+                    return 0;
+                }
+                default:
+                    return 0;
+                }
+            }));
+    ON_CALL(mock_drm, drmModeAddFB2(_, _, _, _, _, _, _, _, _))
+        .WillByDefault(Invoke(
+            [](int, uint32_t, uint32_t, uint32_t, uint32_t const handles[4], uint32_t const*, uint32_t const*,
+               uint32_t* fb_id, uint32_t)
+            {
+                *fb_id = 100 + handles[0];
+                return 0;
+            }));
+
+    auto const shm_renderable = std::make_shared<FakeRenderable>(display_area);
+    shm_renderable->set_buffer(std::make_shared<StubBuffer>(
+        BufferProperties{display_area.size, mir_pixel_format_xrgb_8888, BufferUsage::software}));
+
+    graphics::gbm::DisplayBuffer db(
+        graphics::gbm::BypassOption::prohibited,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(Truly(
+        [](FBHandle const* fb) { return fb->get_drm_fb_id() == 101; })))
+        .WillOnce(Return(true));
+
+    EXPECT_TRUE(db.overlay({shm_renderable}));
+    db.post();
+}
+
+TEST_F(MesaDisplayBufferTest, fullscreen_shm_buffer_is_composited_without_dumb_buffers)
+{
+    ON_CALL(mock_drm, drmIoctl(_, DRM_IOCTL_MODE_CREATE_DUMB, _))
+        .WillByDefault(Return(-1));
+
+    auto const shm_renderable = std::make_shared<FakeRenderable>(display_area);
+    shm_renderable->set_buffer(std::make_shared<StubBuffer>(
+        BufferProperties{display_area.size, mir_pixel_format_xrgb_8888, BufferUsage::software}));
+
+    graphics::gbm::DisplayBuffer db(
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    EXPECT_FALSE(db.overlay({shm_renderable}));
+}
@@ -24,6 +24,8 @@
 #include "src/server/report/null_report_factory.h"
 #include "mir/options/program_option.h"
 #include "src/platforms/gbm-kms/server/kms/quirks.h"
+#include "src/platforms/gbm-kms/server/kms/real_kms_output_container.h"
+#include "src/platforms/gbm-kms/server/kms/page_flipper.h"
 
 #include "mir/test/signal.h"
 #include "mir/test/auto_unblock_thread.h"
@@ -43,6 +45,7 @@
 
 #include <stdexcept>
 #include <fcntl.h>
+#include <sys/stat.h>
 
 namespace mg = mir::graphics;
 namespace mgg = mir::graphics::gbm;
@@ -129,6 +132,7 @@ public:
                *std::make_shared<mtd::StubConsoleServices>(),
                *std::make_shared<mtd::NullEmergencyCleanup>(),
                mgg::BypassOption::allowed,
+               mgg::CompositingOption::gl,
                std::make_unique<mgg::Quirks>(mir::options::ProgramOption{}));
     }
 
@@ -987,3 +991,59 @@ TEST_F(MesaDisplayConfigurationTest, does_not_query_drm_unnecesarily)
     EXPECT_CALL(mock_drm, drmModeGetConnector(_,_)).Times(AtLeast(1));
     display->configuration();
 }
+
+TEST_F(MesaDisplayConfigurationTest, connector_hotplug_only_reprobes_that_connector)
+{
+    using namespace ::testing;
+
+    uint32_t const invalid_id{0};
+    uint32_t const crtc_id{10};
+    uint32_t const encoder_id{20};
+    std::vector<uint32_t> const connector_ids{30, 31};
+    std::vector<uint32_t> possible_encoder_ids_empty;
+    uint32_t const possible_crtcs_mask_empty{0};
+
+    mock_drm.reset(drm_device);
+    mock_drm.add_crtc(drm_device, crtc_id, modes0[1]);
+    mock_drm.add_encoder(drm_device, encoder_id, crtc_id, possible_crtcs_mask_empty);
+    mock_drm.add_connector(
+        drm_device,
+        connector_ids[0],
+        DRM_MODE_CONNECTOR_HDMIA,
+        DRM_MODE_CONNECTED,
+        encoder_id,
+        modes0,
+        possible_encoder_ids_empty,
+        geom::Size{480, 270});
+    mock_drm.add_connector(
+        drm_device,
+        connector_ids[1],
+        DRM_MODE_CONNECTOR_DisplayPort,
+        DRM_MODE_DISCONNECTED,
+        invalid_id,
+        modes_empty,
+        possible_encoder_ids_empty,
+        geom::Size{});
+    mock_drm.prepare(drm_device);
+
+    mgg::RealKMSOutputContainer outputs{
+        {drm_fd},
+        [](int) { return std::shared_ptr<mgg::PageFlipper>{}; }};
+    outputs.update_from_hardware_state();
+
+    struct stat drm_device_info;
+    ASSERT_THAT(fstat(drm_fd, &drm_device_info), Eq(0));
+    outputs.mark_changed(drm_device_info.st_rdev, connector_ids[1]);
+
+    EXPECT_CALL(mock_drm, drmModeGetConnector(_, connector_ids[0])).Times(0);
+    EXPECT_CALL(mock_drm, drmModeGetConnector(_, connector_ids[1])).Times(AtLeast(1));
+    outputs.update_from_hardware_state();
+    Mock::VerifyAndClearExpectations(&mock_drm);
+
+    // Without a connector every connector on the device is re-probed
+    outputs.mark_changed(drm_device_info.st_rdev, std::nullopt);
+
+    EXPECT_CALL(mock_drm, drmModeGetConnector(_, connector_ids[0])).Times(AtLeast(1));
+    EXPECT_CALL(mock_drm, drmModeGetConnector(_, connector_ids[1])).Times(AtLeast(1));
+    outputs.update_from_hardware_state();
+}
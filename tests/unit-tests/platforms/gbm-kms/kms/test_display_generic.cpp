@@ -88,6 +88,7 @@ public:
                 *std::make_shared<mtd::StubConsoleServices>(),
                 *std::make_shared<mtd::NullEmergencyCleanup>(),
                 mgg::BypassOption::allowed,
+                mgg::CompositingOption::gl,
                 std::make_unique<mgg::Quirks>(mir::options::ProgramOption{}));
         return platform->create_display(
             std::make_shared<mg::CloneDisplayConfigurationPolicy>(),
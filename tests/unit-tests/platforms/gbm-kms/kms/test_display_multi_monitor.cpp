@@ -28,6 +28,7 @@
 #include "mir/test/doubles/stub_console_services.h"
 #include "mir/test/doubles/mock_egl.h"
 #include "mir/test/doubles/mock_gl.h"
+#include "mir/test/doubles/mock_display_report.h"
 #include "mir/graphics/display_configuration_policy.h"
 #include "mir/test/doubles/stub_gl_config.h"
 
@@ -145,13 +146,15 @@ public:
         mock_drm.reset("/dev/dri/card2");
     }
 
-    std::shared_ptr<mgg::Platform> create_platform()
+    std::shared_ptr<mgg::Platform> create_platform(
+        std::shared_ptr<mg::DisplayReport> const& report = mir::report::null_display_report())
     {
         return std::make_shared<mgg::Platform>(
-               mir::report::null_display_report(),
+               report,
                *std::make_shared<mtd::StubConsoleServices>(),
                *std::make_shared<mtd::NullEmergencyCleanup>(),
                mgg::BypassOption::allowed,
+               mgg::CompositingOption::gl,
                std::make_unique<mgg::Quirks>(mir::options::ProgramOption{}));
     }
 
@@ -483,6 +486,46 @@ TEST_F(MesaDisplayMultiMonitorTest, create_display_uses_different_drm_fbs_for_si
     auto display = create_display_side_by_side(create_platform());
 }
 
+TEST_F(MesaDisplayMultiMonitorTest, side_by_side_crtcs_are_each_set_once_after_all_display_buffers_are_built)
+{
+    using namespace testing;
+
+    int const num_connected_outputs{3};
+    int const num_disconnected_outputs{2};
+    uint32_t const base_fb_id{66};
+    FBIDContainer fb_id_container{base_fb_id};
+    auto const report = std::make_shared<NiceMock<mtd::MockDisplayReport>>();
+
+    setup_outputs(num_connected_outputs, num_disconnected_outputs);
+
+    EXPECT_CALL(mock_drm, drmModeAddFB2(mtd::IsFdOfDevice(drm_device),
+                                        _, _, _, _, _, _, _, _))
+        .WillRepeatedly(Invoke(&fb_id_container, &FBIDContainer::add_fb2));
+
+    /* Each side-by-side output has its own DisplayBuffer, which are built concurrently */
+    Expectation const all_built =
+        EXPECT_CALL(*report, report_successful_display_construction())
+            .Times(num_connected_outputs);
+
+    /* Other modesets, such as restoring the CRTCs at teardown */
+    EXPECT_CALL(mock_drm, drmModeSetCrtc(_, _, Not(IsValidFB(&fb_id_container)), _, _, _, _, _))
+        .Times(AnyNumber());
+
+    for (int i = 0; i < num_connected_outputs; i++)
+    {
+        EXPECT_CALL(mock_drm, drmModeSetCrtc(mtd::IsFdOfDevice(drm_device),
+                                             crtc_ids[i],
+                                             IsValidFB(&fb_id_container),
+                                             _, _,
+                                             Pointee(connector_ids[i]),
+                                             _, _))
+            .Times(1)
+            .After(all_built);
+    }
+
+    auto display = create_display_side_by_side(create_platform(report));
+}
+
 TEST_F(MesaDisplayMultiMonitorTest, configure_clears_unused_connected_outputs)
 {
     using namespace testing;
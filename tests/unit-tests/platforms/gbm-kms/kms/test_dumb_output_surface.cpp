@@ -0,0 +1,266 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/report/null_report_factory.h"
+#include "src/platforms/gbm-kms/server/kms/display_buffer.h"
+#include "src/platforms/gbm-kms/server/kms/dumb_output_surface.h"
+#include "src/platforms/gbm-kms/server/kms/fb_handle.h"
+#include "mir/test/doubles/mock_drm.h"
+#include "mir/test/doubles/stub_buffer.h"
+#include "mir/test/doubles/fake_renderable.h"
+#include "mir/graphics/transformation.h"
+#include "mir/fd.h"
+#include "mock_kms_output.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <xf86drm.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace testing;
+using namespace mir::test;
+using namespace mir::test::doubles;
+namespace mg = mir::graphics;
+namespace mgg = mir::graphics::gbm;
+namespace geom = mir::geometry;
+using mir::report::null_display_report;
+
+namespace
+{
+// Page aligned, and big enough for any buffer in these tests
+off_t const dumb_buffer_spacing = 1024 * 1024;
+uint32_t const first_fb_id = 100;
+
+class DumbOutputSurfaceTest : public Test
+{
+public:
+    DumbOutputSurfaceTest()
+    {
+        // Dumb buffers are mapped through the DRM fd, so give them some real memory to live in
+        if (ftruncate(drm_fd, 4 * dumb_buffer_spacing) != 0)
+        {
+            throw std::system_error{errno, std::system_category(), "Failed to size fake DRM device"};
+        }
+
+        ON_CALL(mock_drm, drmIoctl(_, _, _))
+            .WillByDefault(Invoke(
+                [this](int, unsigned long request, void* arg)
+                {
+                    switch (request)
+                    {
+                    case DRM_IOCTL_MODE_CREATE_DUMB:
+                    {
+                        auto const params = static_cast<drm_mode_create_dumb*>(arg);
+                        params->handle = ++handles_created;
+                        params->pitch = params->width * params->bpp / 8 + pitch_padding;
+                        params->size = params->pitch * params->height;
+                        return 0;
+                    }
+                    case DRM_IOCTL_MODE_MAP_DUMB:
+                    {
+                        auto const params = static_cast<drm_mode_map_dumb*>(arg);
+                        params->offset = (params->handle - 1) * dumb_buffer_spacing;
+                        return 0;
+                    }
+                    case DRM_IOCTL_MODE_DESTROY_DUMB:
+                        ++handles_destroyed;
+                        return 0;
+                    default:
+                        return -1;
+                    }
+                }));
+        ON_CALL(mock_drm, drmModeAddFB2(_, _, _, _, _, _, _, _, _))
+            .WillByDefault(Invoke(
+                [](int, uint32_t, uint32_t, uint32_t, uint32_t const handles[4], uint32_t const*, uint32_t const*,
+                   uint32_t* fb_id, uint32_t)
+                {
+                    *fb_id = first_fb_id + handles[0];
+                    return 0;
+                }));
+    }
+
+    auto pixel(mir::renderer::software::Mapping<unsigned char>& mapping, int x, int y) -> uint32_t
+    {
+        return *reinterpret_cast<uint32_t*>(mapping.data() + y * mapping.stride().as_int() + x * 4);
+    }
+
+    auto filled_buffer(geom::Size size, MirPixelFormat format, uint32_t colour, geom::Stride stride)
+        -> std::shared_ptr<StubBuffer>
+    {
+        auto const buffer = std::make_shared<StubBuffer>(
+            nullptr, mg::BufferProperties{size, format, mg::BufferUsage::software}, stride);
+        for (int y = 0; y < size.height.as_int(); ++y)
+        {
+            auto const row = reinterpret_cast<uint32_t*>(buffer->written_pixels.data() + y * stride.as_int());
+            std::fill_n(row, size.width.as_int(), colour);
+        }
+        return buffer;
+    }
+
+    geom::Size const size{16, 8};
+    uint32_t const pitch_padding{64};
+    mir::Fd const drm_fd{memfd_create("fake-drm", 0)};
+    NiceMock<MockDRM> mock_drm;
+    uint32_t handles_created{0};
+    int handles_destroyed{0};
+};
+}
+
+TEST_F(DumbOutputSurfaceTest, maps_back_buffer_as_xrgb_with_dumb_buffer_pitch)
+{
+    mgg::DumbOutputSurface surface{drm_fd, size, 2};
+
+    auto const mapping = surface.map_back_buffer();
+
+    EXPECT_THAT(mapping->format(), Eq(mir_pixel_format_xrgb_8888));
+    EXPECT_THAT(mapping->size(), Eq(size));
+    EXPECT_THAT(mapping->stride(), Eq(geom::Stride{size.width.as_int() * 4 + pitch_padding}));
+    EXPECT_THAT(mapping->len(), Ge(mapping->stride().as_uint32_t() * size.height.as_uint32_t()));
+}
+
+TEST_F(DumbOutputSurfaceTest, back_buffer_age_counts_frames_since_buffer_was_drawn)
+{
+    mgg::DumbOutputSurface surface{drm_fd, size, 2};
+
+    EXPECT_THAT(surface.back_buffer_age(), Eq(0u));
+    surface.swap_buffers();
+    EXPECT_THAT(surface.back_buffer_age(), Eq(0u));
+    surface.swap_buffers();
+    EXPECT_THAT(surface.back_buffer_age(), Eq(2u));
+    surface.swap_buffers();
+    EXPECT_THAT(surface.back_buffer_age(), Eq(2u));
+}
+
+TEST_F(DumbOutputSurfaceTest, front_fb_is_the_buffer_last_swapped)
+{
+    mgg::DumbOutputSurface surface{drm_fd, size, 3};
+
+    surface.swap_buffers();
+    EXPECT_THAT(surface.front_fb()->get_drm_fb_id(), Eq(first_fb_id + 1));
+    surface.swap_buffers();
+    EXPECT_THAT(surface.front_fb()->get_drm_fb_id(), Eq(first_fb_id + 2));
+    surface.swap_buffers();
+    surface.swap_buffers();
+    EXPECT_THAT(surface.front_fb()->get_drm_fb_id(), Eq(first_fb_id + 1));
+}
+
+TEST_F(DumbOutputSurfaceTest, copies_frame_into_back_buffer_and_swaps_it_to_the_front)
+{
+    mgg::DumbOutputSurface surface{drm_fd, size, 2};
+    auto const source = filled_buffer(size, mir_pixel_format_argb_8888, 0xff123456, geom::Stride{size.width.as_int() * 4});
+
+    EXPECT_TRUE(surface.copy_frame_from(*source));
+
+    EXPECT_THAT(surface.front_fb()->get_drm_fb_id(), Eq(first_fb_id + 1));
+    surface.swap_buffers();
+    auto const mapping = surface.map_back_buffer();
+    EXPECT_THAT(pixel(*mapping, 0, 0), Eq(0xff123456u));
+    EXPECT_THAT(pixel(*mapping, 15, 7), Eq(0xff123456u));
+}
+
+TEST_F(DumbOutputSurfaceTest, copies_frame_with_a_different_stride_row_by_row)
+{
+    mgg::DumbOutputSurface surface{drm_fd, size, 1};
+    auto const source = filled_buffer(size, mir_pixel_format_xrgb_8888, 0x00abcdef, geom::Stride{size.width.as_int() * 4 + 4});
+
+    EXPECT_TRUE(surface.copy_frame_from(*source));
+
+    auto const mapping = surface.map_back_buffer();
+    EXPECT_THAT(pixel(*mapping, 15, 0), Eq(0x00abcdefu));
+    EXPECT_THAT(pixel(*mapping, 0, 7), Eq(0x00abcdefu));
+    // The padding at the end of each dumb buffer row is untouched
+    EXPECT_THAT(pixel(*mapping, 16, 0), Eq(0u));
+}
+
+TEST_F(DumbOutputSurfaceTest, refuses_to_copy_frames_it_cannot_scan_out_as_is)
+{
+    mgg::DumbOutputSurface surface{drm_fd, size, 2};
+    auto const wrong_size = filled_buffer({8, 8}, mir_pixel_format_argb_8888, 0xff123456, geom::Stride{32});
+    auto const wrong_format = filled_buffer(size, mir_pixel_format_abgr_8888, 0xff123456, geom::Stride{64});
+
+    EXPECT_FALSE(surface.copy_frame_from(*wrong_size));
+    EXPECT_FALSE(surface.copy_frame_from(*wrong_format));
+    EXPECT_THAT(surface.back_buffer_age(), Eq(0u));
+}
+
+TEST_F(DumbOutputSurfaceTest, releases_fbs_and_dumb_buffers_on_destruction)
+{
+    EXPECT_CALL(mock_drm, drmModeRmFB(_, first_fb_id + 1));
+    EXPECT_CALL(mock_drm, drmModeRmFB(_, first_fb_id + 2));
+
+    {
+        mgg::DumbOutputSurface surface{drm_fd, size, 2};
+    }
+
+    EXPECT_THAT(handles_destroyed, Eq(2));
+}
+
+TEST_F(DumbOutputSurfaceTest, display_buffer_renders_into_dumb_buffers_on_the_cpu)
+{
+    auto const output = std::make_shared<NiceMock<MockKMSOutput>>();
+    mgg::DisplayBuffer db{
+        mgg::BypassOption::prohibited,
+        null_display_report(),
+        {output},
+        std::make_unique<mgg::DumbOutputSurface>(drm_fd, size, 2),
+        {{0, 0}, size},
+        glm::mat2{1}};
+
+    EXPECT_THAT(dynamic_cast<mir::renderer::software::RenderTarget*>(db.native_display_buffer()), NotNull());
+    EXPECT_THAT(dynamic_cast<mir::renderer::gl::RenderTarget*>(db.native_display_buffer()), IsNull());
+}
+
+TEST_F(DumbOutputSurfaceTest, display_buffer_copies_fullscreen_shm_buffer_instead_of_compositing)
+{
+    auto const output = std::make_shared<NiceMock<MockKMSOutput>>();
+    ON_CALL(*output, schedule_page_flip_thunk(_)).WillByDefault(Return(true));
+    ON_CALL(*output, max_refresh_rate()).WillByDefault(Return(60));
+    geom::Rectangle const area{{0, 0}, size};
+    mgg::DisplayBuffer db{
+        mgg::BypassOption::prohibited,
+        null_display_report(),
+        {output},
+        std::make_unique<mgg::DumbOutputSurface>(drm_fd, size, 2),
+        area,
+        glm::mat2{1}};
+    auto const renderable = std::make_shared<FakeRenderable>(area);
+    renderable->set_buffer(filled_buffer(size, mir_pixel_format_xrgb_8888, 0x00123456, geom::Stride{64}));
+
+    EXPECT_CALL(*output, schedule_page_flip_thunk(Truly(
+        [](mgg::FBHandle const* fb) { return fb->get_drm_fb_id() == first_fb_id + 1; })));
+
+    EXPECT_TRUE(db.overlay({renderable}));
+    db.post();
+}
+
+TEST_F(DumbOutputSurfaceTest, display_buffer_composites_when_output_is_rotated)
+{
+    auto const output = std::make_shared<NiceMock<MockKMSOutput>>();
+    geom::Rectangle const area{{0, 0}, size};
+    mgg::DisplayBuffer db{
+        mgg::BypassOption::prohibited,
+        null_display_report(),
+        {output},
+        std::make_unique<mgg::DumbOutputSurface>(drm_fd, geom::Size{size.height.as_int(), size.width.as_int()}, 2),
+        area,
+        mg::transformation(mir_orientation_left)};
+    auto const renderable = std::make_shared<FakeRenderable>(area);
+    renderable->set_buffer(filled_buffer(size, mir_pixel_format_xrgb_8888, 0x00123456, geom::Stride{64}));
+
+    EXPECT_FALSE(db.overlay({renderable}));
+}
@@ -83,6 +83,7 @@ public:
                 *std::make_shared<mtd::StubConsoleServices>(),
                 *std::make_shared<mtd::NullEmergencyCleanup>(),
                 mgg::BypassOption::allowed,
+                mgg::CompositingOption::gl,
                 std::make_unique<mgg::Quirks>(mir::options::ProgramOption{}));
     }
 
@@ -0,0 +1,145 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/platforms/virtual/display_buffer.h"
+#include "src/platforms/virtual/render_targets.h"
+#include "src/server/report/null_report_factory.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <thread>
+
+namespace mg = mir::graphics;
+namespace mgv = mir::graphics::virt;
+namespace mrs = mir::renderer::software;
+namespace geom = mir::geometry;
+using mir::report::null_display_report;
+using namespace testing;
+using namespace std::chrono;
+
+namespace
+{
+auto display_buffer(double refresh_rate, bool unthrottled) -> std::unique_ptr<mgv::DisplayBuffer>
+{
+    geom::Size const size{16, 8};
+    return std::make_unique<mgv::DisplayBuffer>(
+        mg::DisplayConfigurationOutputId{1},
+        geom::Rectangle{{0, 0}, size},
+        std::make_unique<mgv::CPURenderTarget>(size),
+        refresh_rate,
+        unthrottled,
+        null_display_report());
+}
+
+auto ust_of(mg::Frame const& frame) -> nanoseconds
+{
+    return nanoseconds{frame.ust.nanoseconds};
+}
+}
+
+TEST(VirtualCPURenderTarget, maps_back_buffer_as_tightly_packed_xrgb)
+{
+    geom::Size const size{16, 8};
+    mgv::CPURenderTarget target{size};
+
+    auto const mapping = target.map_back_buffer();
+
+    EXPECT_THAT(mapping->format(), Eq(mir_pixel_format_xrgb_8888));
+    EXPECT_THAT(mapping->size(), Eq(size));
+    EXPECT_THAT(mapping->stride(), Eq(geom::Stride{16 * 4}));
+    EXPECT_THAT(mapping->len(), Eq(16u * 4 * 8));
+}
+
+TEST(VirtualCPURenderTarget, alternates_between_two_buffers)
+{
+    mgv::CPURenderTarget target{{16, 8}};
+
+    auto const first = target.map_back_buffer()->data();
+    target.swap_buffers();
+    auto const second = target.map_back_buffer()->data();
+    target.swap_buffers();
+
+    EXPECT_THAT(second, Ne(first));
+    EXPECT_THAT(target.map_back_buffer()->data(), Eq(first));
+}
+
+TEST(VirtualCPURenderTarget, back_buffer_age_counts_frames_since_buffer_was_drawn)
+{
+    mgv::CPURenderTarget target{{16, 8}};
+
+    EXPECT_THAT(target.back_buffer_age(), Eq(0u));
+    target.swap_buffers();
+    EXPECT_THAT(target.back_buffer_age(), Eq(0u));
+    target.swap_buffers();
+    EXPECT_THAT(target.back_buffer_age(), Eq(2u));
+    target.swap_buffers();
+    EXPECT_THAT(target.back_buffer_age(), Eq(2u));
+}
+
+TEST(VirtualDisplayBuffer, is_composited_by_the_software_renderer_on_cpu_render_target)
+{
+    auto const db = display_buffer(60, false);
+
+    EXPECT_THAT(dynamic_cast<mrs::RenderTarget*>(db->native_display_buffer()), NotNull());
+}
+
+TEST(VirtualDisplayBuffer, post_waits_for_the_simulated_vblank)
+{
+    double const refresh_rate{100};
+    auto const db = display_buffer(refresh_rate, false);
+
+    db->post();
+    auto const first = db->last_frame();
+    db->post();
+    auto const second = db->last_frame();
+
+    EXPECT_THAT(second.msc, Eq(first.msc + 1));
+    EXPECT_THAT(ust_of(second) - ust_of(first), Eq(nanoseconds{static_cast<int64_t>(1e9 / refresh_rate)}));
+    EXPECT_THAT(steady_clock::now().time_since_epoch(), Ge(ust_of(second)));
+}
+
+TEST(VirtualDisplayBuffer, vblank_timestamps_are_on_the_refresh_period_grid)
+{
+    nanoseconds const period{static_cast<int64_t>(1e9 / 50)};
+    auto const db = display_buffer(50, false);
+
+    db->post();
+    auto const first = db->last_frame();
+    std::this_thread::sleep_for(period * 3 / 2);
+    db->post();
+    auto const later = db->last_frame();
+
+    EXPECT_THAT(later.msc, Gt(first.msc + 1));
+    EXPECT_THAT(ust_of(later) - ust_of(first), Eq(period * (later.msc - first.msc)));
+}
+
+TEST(VirtualDisplayBuffer, unthrottled_post_does_not_wait_for_vblank)
+{
+    // At 1Hz, waiting for even one vblank would be obvious
+    auto const db = display_buffer(1, true);
+    auto const start = steady_clock::now();
+
+    for (int i = 0; i != 5; ++i)
+    {
+        db->post();
+    }
+
+    EXPECT_THAT(steady_clock::now() - start, Lt(seconds{1}));
+    EXPECT_THAT(db->last_frame().msc, Eq(5));
+}
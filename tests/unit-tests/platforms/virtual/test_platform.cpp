@@ -0,0 +1,88 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/platforms/virtual/platform.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mir
+{
+namespace graphics
+{
+namespace virt
+{
+auto operator==(OutputSpec const& a, OutputSpec const& b) -> bool
+{
+    return a.size == b.size &&
+           testing::Value(a.refresh_rate, testing::DoubleEq(b.refresh_rate));
+}
+
+auto operator<<(std::ostream& os, OutputSpec const& spec) -> std::ostream&
+{
+    return os << "size: " << spec.size << ", refresh rate: " << spec.refresh_rate;
+}
+}
+}
+}
+
+namespace mgv = mir::graphics::virt;
+using namespace testing;
+
+TEST(VirtualGraphicsPlatform, parses_output_size_with_default_refresh_rate)
+{
+    auto parsed = mgv::Platform::parse_output_specs("1280x720");
+
+    EXPECT_THAT(parsed, ElementsAre(mgv::OutputSpec{{1280, 720}, 60.0}));
+}
+
+TEST(VirtualGraphicsPlatform, parses_output_size_with_refresh_rate)
+{
+    auto parsed = mgv::Platform::parse_output_specs("1920x1080@143.9");
+
+    EXPECT_THAT(parsed, ElementsAre(mgv::OutputSpec{{1920, 1080}, 143.9}));
+}
+
+TEST(VirtualGraphicsPlatform, parses_multiple_outputs)
+{
+    auto parsed = mgv::Platform::parse_output_specs("1280x1024:600x600@30:30x750");
+
+    EXPECT_THAT(parsed, ElementsAre(
+        mgv::OutputSpec{{1280, 1024}, 60.0},
+        mgv::OutputSpec{{600, 600}, 30.0},
+        mgv::OutputSpec{{30, 750}, 60.0}));
+}
+
+TEST(VirtualGraphicsPlatform, output_parsing_throws_on_bad_input)
+{
+    EXPECT_THROW(mgv::Platform::parse_output_specs(""), std::runtime_error) << "Empty";
+    EXPECT_THROW(mgv::Platform::parse_output_specs("1280"), std::runtime_error) << "No height or 'x'";
+    EXPECT_THROW(mgv::Platform::parse_output_specs("1280x"), std::runtime_error) << "No height";
+    EXPECT_THROW(mgv::Platform::parse_output_specs("1280x@60"), std::runtime_error) << "No height before rate";
+    EXPECT_THROW(mgv::Platform::parse_output_specs("1280x720@"), std::runtime_error) << "No rate";
+    EXPECT_THROW(mgv::Platform::parse_output_specs("1280x720@0"), std::runtime_error) << "Zero rate";
+    EXPECT_THROW(mgv::Platform::parse_output_specs("1280x720@fast"), std::runtime_error) << "Rate not a number";
+    EXPECT_THROW(mgv::Platform::parse_output_specs("1280x720:"), std::runtime_error) << "Trailing colon";
+    EXPECT_THROW(mgv::Platform::parse_output_specs("-5x720"), std::runtime_error) << "Negative width";
+}
+
+TEST(VirtualGraphicsPlatform, parses_render_target)
+{
+    EXPECT_THAT(mgv::Platform::parse_render_target("gl"), Eq(mgv::RenderTargetType::gl));
+    EXPECT_THAT(mgv::Platform::parse_render_target("cpu"), Eq(mgv::RenderTargetType::cpu));
+    EXPECT_THROW(mgv::Platform::parse_render_target("vulkan"), std::runtime_error);
+}
@@ -25,9 +25,17 @@
 #include <mir/test/doubles/mock_gl.h>
 #include <mir/test/doubles/mock_egl.h>
 #include <src/renderers/gl/renderer.h>
+#include <src/renderers/gl/program_binary_cache.h>
 #include <mir/test/doubles/stub_gl_display_buffer.h>
 #include <mir/test/doubles/mock_gl_display_buffer.h>
 
+#include <GLES2/gl2ext.h>
+
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <stdlib.h>
+
 using testing::SetArgPointee;
 using testing::InSequence;
 using testing::Return;
@@ -36,6 +44,8 @@ using testing::Pointee;
 using testing::AnyNumber;
 using testing::AtLeast;
 using testing::DoAll;
+using testing::Invoke;
+using testing::StrEq;
 using testing::_;
 
 namespace mt=mir::test;
@@ -452,3 +462,169 @@ TEST_F(GLRenderer, sets_viewport_downscaled_wide)
     mrg::Renderer renderer(mock_display_buffer);
     renderer.set_viewport(view_area);
 }
+
+namespace
+{
+/// The state of our fake GL_OES_get_program_binary implementation
+struct FakeProgramBinaries
+{
+    static inline int restored{0};
+    static inline bool last_program_was_restored{false};
+
+    static void GL_APIENTRY get_program_binary(
+        GLuint, GLsizei buf_size, GLsizei* length, GLenum* format, void* binary)
+    {
+        static char const data[] = "binary";
+        auto const size = std::min(buf_size, static_cast<GLsizei>(sizeof data));
+        memcpy(binary, data, size);
+        *length = size;
+        *format = 0x1234;
+    }
+
+    static void GL_APIENTRY program_binary(GLuint, GLenum, void const*, GLint)
+    {
+        ++restored;
+        last_program_was_restored = true;
+    }
+};
+
+class GLRendererProgramBinaryCache : public GLRenderer
+{
+public:
+    GLRendererProgramBinaryCache()
+    {
+        FakeProgramBinaries::restored = 0;
+        FakeProgramBinaries::last_program_was_restored = false;
+
+        ON_CALL(mock_gl, glGetString(GL_EXTENSIONS))
+            .WillByDefault(Return(reinterpret_cast<GLubyte const*>("GL_OES_EGL_image GL_OES_get_program_binary")));
+        ON_CALL(mock_gl, glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, _))
+            .WillByDefault(SetArgPointee<1>(1));
+        ON_CALL(mock_egl, eglGetProcAddress(StrEq("glGetProgramBinaryOES")))
+            .WillByDefault(Return(reinterpret_cast<mtd::MockEGL::generic_function_pointer_t>(
+                &FakeProgramBinaries::get_program_binary)));
+        ON_CALL(mock_egl, eglGetProcAddress(StrEq("glProgramBinaryOES")))
+            .WillByDefault(Return(reinterpret_cast<mtd::MockEGL::generic_function_pointer_t>(
+                &FakeProgramBinaries::program_binary)));
+
+        ON_CALL(mock_gl, glLinkProgram(_))
+            .WillByDefault(Invoke([](GLuint) { FakeProgramBinaries::last_program_was_restored = false; }));
+        ON_CALL(mock_gl, glGetProgramiv(_, GL_PROGRAM_BINARY_LENGTH_OES, _))
+            .WillByDefault(SetArgPointee<2>(64));
+    }
+
+    ~GLRendererProgramBinaryCache()
+    {
+        std::error_code ec;
+        std::filesystem::remove_all(cache_directory, ec);
+    }
+
+    void reject_restored_programs()
+    {
+        ON_CALL(mock_gl, glGetProgramiv(_, GL_LINK_STATUS, _))
+            .WillByDefault(Invoke(
+                [](GLuint, GLenum, GLint* status)
+                {
+                    *status = FakeProgramBinaries::last_program_was_restored ? GL_FALSE : GL_TRUE;
+                }));
+    }
+
+    auto cached_entries() const -> size_t
+    {
+        size_t count{0};
+        if (std::filesystem::exists(cache_directory))
+        {
+            for ([[maybe_unused]] auto const& entry : std::filesystem::directory_iterator{cache_directory})
+                ++count;
+        }
+        return count;
+    }
+
+    static auto make_temporary_directory() -> std::filesystem::path
+    {
+        char tmp_name[] = "/tmp/mir_gl_renderer_cache_XXXXXX";
+        if (mkdtemp(tmp_name) == NULL)
+        {
+            throw std::system_error{errno, std::system_category(), "Failed to create temporary directory"};
+        }
+        return tmp_name;
+    }
+
+    std::filesystem::path const cache_directory{make_temporary_directory()};
+    std::shared_ptr<mrg::ProgramBinaryCache> const binary_cache{
+        std::make_shared<mrg::ProgramBinaryCache>(cache_directory)};
+};
+}
+
+TEST_F(GLRendererProgramBinaryCache, stores_linked_programs)
+{
+    mrg::Renderer renderer(display_buffer, binary_cache);
+    renderer.render(renderable_list);
+
+    EXPECT_THAT(cached_entries(), testing::Gt(0u));
+}
+
+TEST_F(GLRendererProgramBinaryCache, restores_cached_programs_instead_of_compiling)
+{
+    {
+        mrg::Renderer renderer(display_buffer, binary_cache);
+        renderer.render(renderable_list);
+    }
+
+    EXPECT_CALL(mock_gl, glCompileShader(_)).Times(0);
+
+    mrg::Renderer renderer(display_buffer, binary_cache);
+    renderer.render(renderable_list);
+
+    EXPECT_THAT(FakeProgramBinaries::restored, testing::Gt(0));
+}
+
+TEST_F(GLRendererProgramBinaryCache, is_not_used_without_the_extension)
+{
+    ON_CALL(mock_gl, glGetString(GL_EXTENSIONS))
+        .WillByDefault(Return(reinterpret_cast<GLubyte const*>("GL_OES_EGL_image")));
+
+    EXPECT_CALL(mock_egl, eglGetProcAddress(StrEq("glGetProgramBinaryOES"))).Times(0);
+    EXPECT_CALL(mock_egl, eglGetProcAddress(StrEq("glProgramBinaryOES"))).Times(0);
+    EXPECT_CALL(mock_gl, glCompileShader(_)).Times(AtLeast(1));
+
+    mrg::Renderer renderer(display_buffer, binary_cache);
+    renderer.render(renderable_list);
+
+    EXPECT_THAT(cached_entries(), testing::Eq(0u));
+}
+
+TEST_F(GLRendererProgramBinaryCache, is_not_used_when_the_driver_supports_no_binary_formats)
+{
+    ON_CALL(mock_gl, glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, _))
+        .WillByDefault(SetArgPointee<1>(0));
+
+    EXPECT_CALL(mock_gl, glCompileShader(_)).Times(AtLeast(1));
+
+    mrg::Renderer renderer(display_buffer, binary_cache);
+    renderer.render(renderable_list);
+
+    EXPECT_THAT(cached_entries(), testing::Eq(0u));
+}
+
+TEST_F(GLRendererProgramBinaryCache, compiles_and_discards_entries_the_driver_rejects)
+{
+    {
+        mrg::Renderer renderer(display_buffer, binary_cache);
+        renderer.render(renderable_list);
+    }
+    ASSERT_THAT(cached_entries(), testing::Gt(0u));
+
+    reject_restored_programs();
+    // Don't store the recompiled programs, so we can see the rejected entries have gone
+    ON_CALL(mock_gl, glGetProgramiv(_, GL_PROGRAM_BINARY_LENGTH_OES, _))
+        .WillByDefault(SetArgPointee<2>(0));
+
+    EXPECT_CALL(mock_gl, glCompileShader(_)).Times(AtLeast(1));
+
+    mrg::Renderer renderer(display_buffer, binary_cache);
+    renderer.render(renderable_list);
+
+    EXPECT_THAT(FakeProgramBinaries::restored, testing::Gt(0));
+    EXPECT_THAT(cached_entries(), testing::Eq(0u));
+}
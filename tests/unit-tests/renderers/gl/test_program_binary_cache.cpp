@@ -0,0 +1,150 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <src/renderers/gl/program_binary_cache.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+#include <stdlib.h>
+
+namespace mrg = mir::renderer::gl;
+namespace fs = std::filesystem;
+using namespace testing;
+
+namespace
+{
+auto make_temporary_directory() -> fs::path
+{
+    char tmp_name[] = "/tmp/mir_program_cache_XXXXXX";
+    if (mkdtemp(tmp_name) == NULL)
+    {
+        throw std::system_error{errno, std::system_category(), "Failed to create temporary directory"};
+    }
+    return tmp_name;
+}
+
+struct ProgramBinaryCache : Test
+{
+    ~ProgramBinaryCache()
+    {
+        std::error_code ec;
+        fs::remove_all(temporary_directory, ec);
+    }
+
+    auto entries() const -> std::vector<fs::path>
+    {
+        std::vector<fs::path> result;
+        if (fs::exists(cache_directory()))
+        {
+            for (auto const& entry : fs::directory_iterator{cache_directory()})
+                result.push_back(entry.path());
+        }
+        return result;
+    }
+
+    auto cache_directory() const -> fs::path
+    {
+        return temporary_directory / "gl-programs";
+    }
+
+    fs::path const temporary_directory{make_temporary_directory()};
+    mrg::ProgramBinaryCache const cache{cache_directory()};
+
+    std::string const key{"Vendor\nRenderer\nVersion\nvoid main() {}"};
+    mrg::ProgramBinaryCache::Binary const binary{0x1234, {'a', 'b', 'c', '\0', 'd'}};
+};
+}
+
+TEST_F(ProgramBinaryCache, returns_nothing_for_unknown_key)
+{
+    EXPECT_THAT(cache.load(key), Eq(std::nullopt));
+}
+
+TEST_F(ProgramBinaryCache, returns_stored_binary)
+{
+    cache.store(key, binary);
+
+    auto const loaded = cache.load(key);
+    ASSERT_THAT(loaded, Ne(std::nullopt));
+    EXPECT_THAT(loaded->format, Eq(binary.format));
+    EXPECT_THAT(loaded->data, ContainerEq(binary.data));
+}
+
+TEST_F(ProgramBinaryCache, does_not_return_binary_stored_for_a_different_key)
+{
+    cache.store(key, binary);
+
+    EXPECT_THAT(cache.load(key + " "), Eq(std::nullopt));
+    EXPECT_THAT(cache.load("Other vendor\nRenderer\nVersion\nvoid main() {}"), Eq(std::nullopt));
+}
+
+TEST_F(ProgramBinaryCache, later_store_replaces_earlier)
+{
+    mrg::ProgramBinaryCache::Binary const replacement{0x5678, {'x', 'y'}};
+
+    cache.store(key, binary);
+    cache.store(key, replacement);
+
+    auto const loaded = cache.load(key);
+    ASSERT_THAT(loaded, Ne(std::nullopt));
+    EXPECT_THAT(loaded->format, Eq(replacement.format));
+    EXPECT_THAT(loaded->data, ContainerEq(replacement.data));
+    EXPECT_THAT(entries().size(), Eq(1u));
+}
+
+TEST_F(ProgramBinaryCache, discarded_binary_is_not_returned)
+{
+    cache.store(key, binary);
+    cache.discard(key);
+
+    EXPECT_THAT(cache.load(key), Eq(std::nullopt));
+    EXPECT_THAT(entries(), IsEmpty());
+}
+
+TEST_F(ProgramBinaryCache, truncated_entry_is_treated_as_missing)
+{
+    cache.store(key, binary);
+    ASSERT_THAT(entries().size(), Eq(1u));
+
+    auto const entry = entries().front();
+    fs::resize_file(entry, fs::file_size(entry) - 1);
+
+    EXPECT_THAT(cache.load(key), Eq(std::nullopt));
+}
+
+TEST_F(ProgramBinaryCache, corrupt_entry_is_treated_as_missing)
+{
+    cache.store(key, binary);
+    ASSERT_THAT(entries().size(), Eq(1u));
+
+    std::ofstream{entries().front(), std::ios::binary | std::ios::trunc} << "not a program binary";
+
+    EXPECT_THAT(cache.load(key), Eq(std::nullopt));
+}
+
+TEST_F(ProgramBinaryCache, store_to_unwritable_location_does_not_throw)
+{
+    std::ofstream{temporary_directory / "file"} << "in the way";
+    mrg::ProgramBinaryCache const blocked{temporary_directory / "file" / "gl-programs"};
+
+    EXPECT_NO_THROW(blocked.store(key, binary));
+    EXPECT_THAT(blocked.load(key), Eq(std::nullopt));
+}
@@ -0,0 +1,183 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/renderers/sw/pixel_kernels.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <random>
+#include <vector>
+
+namespace mrs = mir::renderer::software;
+using namespace testing;
+
+namespace
+{
+auto random_pixels(size_t count, std::mt19937& generator) -> std::vector<uint32_t>
+{
+    std::uniform_int_distribution<uint32_t> distribution;
+    std::vector<uint32_t> pixels(count);
+    for (auto& pixel : pixels)
+    {
+        pixel = distribution(generator);
+    }
+    return pixels;
+}
+
+// Sizes that exercise the vector loops and their scalar tails
+std::vector<size_t> const lengths{0, 1, 3, 4, 7, 8, 9, 15, 16, 17, 33, 257};
+
+struct PixelKernels : Test
+{
+    mrs::PixelKernels const& kernels = mrs::pixel_kernels();
+    std::mt19937 generator{42};
+};
+}
+
+TEST_F(PixelKernels, over_with_opaque_source_replaces_destination)
+{
+    std::vector<uint32_t> const src(9, 0xff123456);
+    std::vector<uint32_t> dst(9, 0xff654321);
+
+    kernels.over(dst.data(), src.data(), dst.size(), 255);
+
+    EXPECT_THAT(dst, Each(Eq(0xff123456u)));
+}
+
+TEST_F(PixelKernels, over_with_transparent_source_leaves_destination)
+{
+    std::vector<uint32_t> const src(9, 0x00000000);
+    std::vector<uint32_t> dst(9, 0xff654321);
+
+    kernels.over(dst.data(), src.data(), dst.size(), 255);
+
+    EXPECT_THAT(dst, Each(Eq(0xff654321u)));
+}
+
+TEST_F(PixelKernels, over_blends_premultiplied_source)
+{
+    // 50% white, premultiplied, over opaque black
+    std::vector<uint32_t> const src(9, 0x80808080);
+    std::vector<uint32_t> dst(9, 0xff000000);
+
+    kernels.over(dst.data(), src.data(), dst.size(), 255);
+
+    EXPECT_THAT(dst, Each(Eq(0xff808080u)));
+}
+
+TEST_F(PixelKernels, over_applies_global_alpha)
+{
+    std::vector<uint32_t> const src(9, 0xffffffff);
+    std::vector<uint32_t> dst(9, 0xff000000);
+
+    kernels.over(dst.data(), src.data(), dst.size(), 128);
+
+    EXPECT_THAT(dst, Each(Eq(0xff808080u)));
+}
+
+TEST_F(PixelKernels, over_matches_scalar_kernel)
+{
+    auto const& scalar = mrs::scalar_pixel_kernels();
+
+    for (auto const length : lengths)
+    {
+        for (auto const alpha : {0, 1, 77, 128, 254, 255})
+        {
+            auto const src = random_pixels(length, generator);
+            auto expected = random_pixels(length, generator);
+            auto actual = expected;
+
+            scalar.over(expected.data(), src.data(), length, alpha);
+            kernels.over(actual.data(), src.data(), length, alpha);
+
+            EXPECT_THAT(actual, ContainerEq(expected)) << "length=" << length << ", alpha=" << alpha;
+        }
+    }
+}
+
+TEST_F(PixelKernels, swap_red_blue_matches_scalar_kernel)
+{
+    auto const& scalar = mrs::scalar_pixel_kernels();
+
+    for (auto const length : lengths)
+    {
+        auto const src = random_pixels(length, generator);
+        std::vector<uint32_t> expected(length), actual(length);
+
+        scalar.swap_red_blue(expected.data(), src.data(), length);
+        kernels.swap_red_blue(actual.data(), src.data(), length);
+
+        EXPECT_THAT(actual, ContainerEq(expected)) << "length=" << length;
+    }
+
+    uint32_t const pixel = 0x11223344;
+    uint32_t swapped;
+    kernels.swap_red_blue(&swapped, &pixel, 1);
+    EXPECT_THAT(swapped, Eq(0x11443322u));
+}
+
+TEST_F(PixelKernels, make_opaque_matches_scalar_kernel)
+{
+    auto const& scalar = mrs::scalar_pixel_kernels();
+
+    for (auto const length : lengths)
+    {
+        auto const src = random_pixels(length, generator);
+        std::vector<uint32_t> expected(length), actual(length);
+
+        scalar.make_opaque(expected.data(), src.data(), length);
+        kernels.make_opaque(actual.data(), src.data(), length);
+
+        EXPECT_THAT(actual, ContainerEq(expected)) << "length=" << length;
+        EXPECT_THAT(actual, Each(Ge(0xff000000u)));
+    }
+}
+
+TEST_F(PixelKernels, converts_formats_to_argb)
+{
+    uint32_t result;
+
+    uint32_t const abgr = 0x80112233;
+    mrs::convert_row(kernels, mir_pixel_format_abgr_8888, reinterpret_cast<unsigned char const*>(&abgr), &result, 1, true);
+    EXPECT_THAT(result, Eq(0x80332211u));
+
+    uint32_t const xrgb = 0x00112233;
+    mrs::convert_row(kernels, mir_pixel_format_xrgb_8888, reinterpret_cast<unsigned char const*>(&xrgb), &result, 1, true);
+    EXPECT_THAT(result, Eq(0xff112233u));
+
+    unsigned char const rgb[] = {0x11, 0x22, 0x33};
+    mrs::convert_row(kernels, mir_pixel_format_rgb_888, rgb, &result, 1, false);
+    EXPECT_THAT(result, Eq(0xff112233u));
+
+    uint16_t const rgb565 = 0xf800;
+    mrs::convert_row(kernels, mir_pixel_format_rgb_565, reinterpret_cast<unsigned char const*>(&rgb565), &result, 1, false);
+    EXPECT_THAT(result, Eq(0xffff0000u));
+
+    uint16_t const rgba4444 = 0x0f08;
+    mrs::convert_row(kernels, mir_pixel_format_rgba_4444, reinterpret_cast<unsigned char const*>(&rgba4444), &result, 1, true);
+    EXPECT_THAT(result, Eq(0x8800ff00u));
+}
+
+TEST_F(PixelKernels, ignores_source_alpha_when_asked)
+{
+    uint32_t const argb = 0x40112233;
+    uint32_t result;
+
+    mrs::convert_row(kernels, mir_pixel_format_argb_8888, reinterpret_cast<unsigned char const*>(&argb), &result, 1, false);
+
+    EXPECT_THAT(result, Eq(0xff112233u));
+}
@@ -0,0 +1,279 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/renderers/sw/renderer.h"
+#include "mir/graphics/transformation.h"
+
+#include "mir/test/doubles/fake_renderable.h"
+#include "mir/test/doubles/stub_buffer.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstring>
+
+namespace mg = mir::graphics;
+namespace mrs = mir::renderer::software;
+namespace geom = mir::geometry;
+namespace mtd = mir::test::doubles;
+using namespace testing;
+
+namespace
+{
+uint32_t const black = 0xff000000;
+uint32_t const red = 0xffff0000;
+uint32_t const green = 0xff00ff00;
+uint32_t const marker = 0xff123456;
+
+class StubRenderTarget : public mrs::RenderTarget
+{
+public:
+    StubRenderTarget(geom::Size size, MirPixelFormat format)
+        : target_size{size},
+          target_format{format},
+          pixels(size.width.as_uint32_t() * size.height.as_uint32_t(), 0)
+    {
+    }
+
+    auto size() const -> geom::Size override
+    {
+        return target_size;
+    }
+
+    auto map_back_buffer() -> std::unique_ptr<mrs::Mapping<unsigned char>> override
+    {
+        class Mapping : public mrs::Mapping<unsigned char>
+        {
+        public:
+            Mapping(StubRenderTarget& target) : target{target} {}
+
+            auto format() const -> MirPixelFormat override { return target.target_format; }
+            auto stride() const -> geom::Stride override { return geom::Stride{target.target_size.width.as_int() * 4}; }
+            auto size() const -> geom::Size override { return target.target_size; }
+            auto data() -> unsigned char* override { return reinterpret_cast<unsigned char*>(target.pixels.data()); }
+            auto len() const -> size_t override { return target.pixels.size() * 4; }
+
+        private:
+            StubRenderTarget& target;
+        };
+
+        return std::make_unique<Mapping>(*this);
+    }
+
+    auto back_buffer_age() const -> unsigned override
+    {
+        return age;
+    }
+
+    void swap_buffers() override
+    {
+        ++swaps;
+    }
+
+    auto pixel(int x, int y) const -> uint32_t
+    {
+        return pixels[y * target_size.width.as_int() + x];
+    }
+
+    void set_pixel(int x, int y, uint32_t value)
+    {
+        pixels[y * target_size.width.as_int() + x] = value;
+    }
+
+    geom::Size const target_size;
+    MirPixelFormat const target_format;
+    std::vector<uint32_t> pixels;
+    // A single buffer, so it always holds the previous frame
+    unsigned age{1};
+    int swaps{0};
+};
+
+auto filled_buffer(geom::Size size, uint32_t colour) -> std::shared_ptr<mtd::StubBuffer>
+{
+    auto const buffer = std::make_shared<mtd::StubBuffer>(
+        mg::BufferProperties{size, mir_pixel_format_argb_8888, mg::BufferUsage::software});
+    auto const pixels = reinterpret_cast<uint32_t*>(buffer->written_pixels.data());
+    std::fill_n(pixels, size.width.as_uint32_t() * size.height.as_uint32_t(), colour);
+    return buffer;
+}
+
+auto renderable(geom::Rectangle position, uint32_t colour, float alpha = 1.0f, bool shaped = false)
+    -> std::shared_ptr<mtd::FakeRenderable>
+{
+    auto const result = std::make_shared<mtd::FakeRenderable>(position, alpha, !shaped);
+    result->set_buffer(filled_buffer(position.size, colour));
+    return result;
+}
+
+struct SoftwareRenderer : Test
+{
+    geom::Rectangle const viewport{{100, 100}, {8, 4}};
+    StubRenderTarget target{viewport.size, mir_pixel_format_argb_8888};
+    mrs::Renderer renderer{target};
+
+    SoftwareRenderer()
+    {
+        renderer.set_viewport(viewport);
+    }
+};
+}
+
+TEST_F(SoftwareRenderer, draws_renderable_at_its_screen_position)
+{
+    renderer.render({renderable({{102, 101}, {2, 2}}, red)});
+
+    EXPECT_THAT(target.pixel(2, 1), Eq(red));
+    EXPECT_THAT(target.pixel(3, 2), Eq(red));
+    EXPECT_THAT(target.pixel(1, 1), Eq(black));
+    EXPECT_THAT(target.pixel(4, 1), Eq(black));
+    EXPECT_THAT(target.pixel(2, 3), Eq(black));
+    EXPECT_THAT(target.swaps, Eq(1));
+}
+
+TEST_F(SoftwareRenderer, later_renderables_are_drawn_on_top)
+{
+    renderer.render({
+        renderable({{100, 100}, {4, 4}}, red),
+        renderable({{102, 100}, {4, 4}}, green)});
+
+    EXPECT_THAT(target.pixel(1, 0), Eq(red));
+    EXPECT_THAT(target.pixel(2, 0), Eq(green));
+    EXPECT_THAT(target.pixel(5, 0), Eq(green));
+}
+
+TEST_F(SoftwareRenderer, applies_renderable_alpha)
+{
+    renderer.render({renderable({{100, 100}, {8, 4}}, 0xffffffff, 0.5f)});
+
+    EXPECT_THAT(target.pixel(0, 0), Eq(0xff808080u));
+}
+
+TEST_F(SoftwareRenderer, blends_shaped_renderable_with_its_alpha_channel)
+{
+    renderer.render({
+        renderable({{100, 100}, {8, 4}}, red),
+        renderable({{100, 100}, {8, 4}}, 0x80008000, 1.0f, true)});
+
+    EXPECT_THAT(target.pixel(0, 0), Eq(0xff7f8000u));
+}
+
+TEST_F(SoftwareRenderer, ignores_alpha_channel_of_unshaped_renderable)
+{
+    renderer.render({
+        renderable({{100, 100}, {8, 4}}, red),
+        renderable({{100, 100}, {8, 4}}, 0x0000ff00)});
+
+    EXPECT_THAT(target.pixel(0, 0), Eq(green));
+}
+
+TEST_F(SoftwareRenderer, scales_buffer_to_screen_position)
+{
+    auto const scaled = renderable({{100, 100}, {4, 2}}, red);
+    auto const buffer = filled_buffer({2, 1}, red);
+    reinterpret_cast<uint32_t*>(buffer->written_pixels.data())[1] = green;
+    scaled->set_buffer(buffer);
+
+    renderer.render({scaled});
+
+    EXPECT_THAT(target.pixel(0, 0), Eq(red));
+    EXPECT_THAT(target.pixel(1, 1), Eq(red));
+    EXPECT_THAT(target.pixel(2, 0), Eq(green));
+    EXPECT_THAT(target.pixel(3, 1), Eq(green));
+}
+
+TEST_F(SoftwareRenderer, writes_red_first_formats)
+{
+    StubRenderTarget abgr_target{viewport.size, mir_pixel_format_abgr_8888};
+    mrs::Renderer abgr_renderer{abgr_target};
+    abgr_renderer.set_viewport(viewport);
+
+    abgr_renderer.render({renderable(viewport, red)});
+
+    EXPECT_THAT(abgr_target.pixel(0, 0), Eq(0xff0000ffu));
+}
+
+TEST_F(SoftwareRenderer, applies_output_rotation)
+{
+    StubRenderTarget rotated_target{{viewport.size.height.as_int(), viewport.size.width.as_int()}, mir_pixel_format_argb_8888};
+    mrs::Renderer rotated_renderer{rotated_target};
+    rotated_renderer.set_viewport(viewport);
+    rotated_renderer.set_output_transform(mg::transformation(mir_orientation_left));
+
+    rotated_renderer.render({renderable({viewport.top_left, {1, 1}}, red)});
+
+    // Rotated anticlockwise, the top left corner of the viewport ends up at the bottom left
+    EXPECT_THAT(rotated_target.pixel(0, 7), Eq(red));
+    EXPECT_THAT(rotated_target.pixel(0, 0), Eq(black));
+    EXPECT_THAT(rotated_target.pixel(3, 7), Eq(black));
+}
+
+TEST_F(SoftwareRenderer, applies_output_reflection)
+{
+    renderer.set_output_transform(mg::transformation(mir_mirror_mode_horizontal));
+
+    renderer.render({renderable({viewport.top_left, {1, 1}}, red)});
+
+    EXPECT_THAT(target.pixel(7, 0), Eq(red));
+    EXPECT_THAT(target.pixel(0, 0), Eq(black));
+}
+
+TEST_F(SoftwareRenderer, only_redraws_what_changed)
+{
+    auto const moving = renderable({{100, 100}, {1, 1}}, red);
+    auto const still = renderable({{106, 102}, {1, 1}}, green);
+    renderer.render({moving, still});
+
+    target.set_pixel(7, 3, marker);
+    auto const moved = renderable({{101, 100}, {1, 1}}, red);
+    renderer.render({moved, still});
+
+    EXPECT_THAT(target.pixel(0, 0), Eq(black));
+    EXPECT_THAT(target.pixel(1, 0), Eq(red));
+    EXPECT_THAT(target.pixel(6, 2), Eq(green));
+    EXPECT_THAT(target.pixel(7, 3), Eq(marker));
+}
+
+TEST_F(SoftwareRenderer, redraws_everything_when_back_buffer_content_is_unknown)
+{
+    auto const still = renderable({{106, 102}, {1, 1}}, green);
+    renderer.render({still});
+
+    target.set_pixel(0, 0, marker);
+    target.age = 0;
+    renderer.render({still});
+
+    EXPECT_THAT(target.pixel(0, 0), Eq(black));
+    EXPECT_THAT(target.pixel(6, 2), Eq(green));
+}
+
+TEST_F(SoftwareRenderer, redraws_damage_from_earlier_frames_into_older_back_buffers)
+{
+    auto const moving = renderable({{100, 100}, {1, 1}}, red);
+    renderer.render({moving});
+
+    auto const moved = renderable({{101, 100}, {1, 1}}, red);
+    renderer.render({moved});
+
+    // Pretend the back buffer now holds the frame before last: it needs both frames' damage
+    target.set_pixel(0, 0, marker);
+    target.set_pixel(7, 3, marker);
+    target.age = 2;
+    renderer.render({moved});
+
+    EXPECT_THAT(target.pixel(0, 0), Eq(black));
+    EXPECT_THAT(target.pixel(1, 0), Eq(red));
+    EXPECT_THAT(target.pixel(7, 3), Eq(marker));
+}
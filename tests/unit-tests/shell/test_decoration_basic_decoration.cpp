@@ -338,6 +338,15 @@ TEST_F(DecorationBasicDecoration, redrawn_on_focus_state_change)
     Mock::VerifyAndClearExpectations(&buffer_stream);
 }
 
+TEST_F(DecorationBasicDecoration, not_redrawn_on_resize)
+{
+    EXPECT_CALL(buffer_stream, submit_buffer(_))
+        .Times(0);
+    window_surface.resize({default_window_size.width + geom::DeltaX{50}, default_window_size.height + geom::DeltaY{30}});
+    executor.execute();
+    Mock::VerifyAndClearExpectations(&buffer_stream);
+}
+
 TEST_F(DecorationBasicDecoration, decoration_resized_on_window_resize)
 {
     geom::Size new_size{203, 305};
@@ -388,7 +397,7 @@ TEST_F(DecorationBasicDecoration, padding_comes_back_when_restored)
     EXPECT_THAT(window_surface.content_size().height, Lt(window_surface.window_size().height));
 }
 
-TEST_F(DecorationBasicDecoration, four_decoration_streams_when_restored)
+TEST_F(DecorationBasicDecoration, six_decoration_streams_when_restored)
 {
     window_surface.configure(mir_window_attrib_state, mir_window_state_maximized);
     executor.execute();
@@ -400,7 +409,7 @@ TEST_F(DecorationBasicDecoration, four_decoration_streams_when_restored)
     window_surface.configure(mir_window_attrib_state, mir_window_state_restored);
     executor.execute();
     ASSERT_TRUE(spec.streams.is_set());
-    EXPECT_THAT(spec.streams.value().size(), Eq(4)); // Titlebar and left, right and bottom borders
+    EXPECT_THAT(spec.streams.value().size(), Eq(6)); // Titlebar, title, buttons and left, right and bottom borders
 }
 
 TEST_F(DecorationBasicDecoration, input_area_contains_borders_when_restored)
@@ -433,7 +442,7 @@ TEST_F(DecorationBasicDecoration, only_has_titlebar_padding_when_maximized)
     EXPECT_THAT(window_surface.content_size().height, Lt(window_surface.window_size().height));
 }
 
-TEST_F(DecorationBasicDecoration, one_decoration_stream_when_maximized)
+TEST_F(DecorationBasicDecoration, three_decoration_streams_when_maximized)
 {
     std::shared_ptr<ms::Surface> decoration_surface_{mt::fake_shared(decoration_surface)};
     msh::SurfaceSpecification spec;
@@ -443,7 +452,7 @@ TEST_F(DecorationBasicDecoration, one_decoration_stream_when_maximized)
     window_surface.configure(mir_window_attrib_state, mir_window_state_maximized);
     executor.execute();
     ASSERT_TRUE(spec.streams.is_set());
-    EXPECT_THAT(spec.streams.value().size(), Eq(1)); // Titlebar only
+    EXPECT_THAT(spec.streams.value().size(), Eq(3)); // Titlebar, title and buttons only
 }
 
 TEST_F(DecorationBasicDecoration, input_area_contains_only_top_bar_when_maximized)
@@ -0,0 +1,104 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/server/shell/decoration/renderer.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace geom = mir::geometry;
+namespace msd = mir::shell::decoration;
+
+using namespace testing;
+
+namespace
+{
+using Pixel = msd::Renderer::Pixel;
+
+geom::Size const buffer_size{400, 30};
+geom::Point const title_top_left{4, 3};
+geom::Height const title_height{20};
+Pixel const text_color{0xFFFFFFFF};
+
+auto const title = "Hello, wörld! 0123456789 The quick brown fox";
+
+struct DecorationRendererText : Test
+{
+    void SetUp() override
+    {
+        if (uncached->width(title, title_height) == geom::Width{})
+        {
+            GTEST_SKIP() << "No font available to render with";
+        }
+    }
+
+    static auto render(msd::Renderer::Text& text) -> std::vector<Pixel>
+    {
+        std::vector<Pixel> pixels(buffer_size.width.as_int() * buffer_size.height.as_int());
+        text.render(pixels.data(), buffer_size, title, title_top_left, title_height, text_color);
+        return pixels;
+    }
+
+    std::shared_ptr<msd::Renderer::Text> const uncached{msd::Renderer::Text::create(0)};
+};
+}
+
+TEST_F(DecorationRendererText, renders_some_pixels)
+{
+    EXPECT_THAT(render(*uncached), Contains(Ne(Pixel{0})));
+}
+
+TEST_F(DecorationRendererText, cached_title_is_pixel_identical_to_uncached)
+{
+    auto const cached = msd::Renderer::Text::create(512);
+    auto const expected = render(*uncached);
+
+    EXPECT_THAT(render(*cached), Eq(expected));     // Rasterizes and caches the glyphs
+    EXPECT_THAT(render(*cached), Eq(expected));     // Uses the cached glyphs
+}
+
+TEST_F(DecorationRendererText, cached_width_is_the_same_as_uncached)
+{
+    auto const cached = msd::Renderer::Text::create(512);
+    auto const expected = uncached->width(title, title_height);
+
+    EXPECT_THAT(cached->width(title, title_height), Eq(expected));
+    EXPECT_THAT(cached->width(title, title_height), Eq(expected));
+}
+
+TEST_F(DecorationRendererText, title_is_unchanged_when_glyphs_are_evicted)
+{
+    // Far fewer entries than the title has distinct characters, so glyphs are evicted while rendering
+    auto const cached = msd::Renderer::Text::create(4);
+    auto const expected = render(*uncached);
+
+    EXPECT_THAT(render(*cached), Eq(expected));
+    EXPECT_THAT(render(*cached), Eq(expected));
+}
+
+TEST_F(DecorationRendererText, cache_holds_glyphs_of_different_sizes_separately)
+{
+    auto const cached = msd::Renderer::Text::create(512);
+    geom::Height const other_height{title_height * 2};
+    auto const expected = uncached->width(title, other_height);
+
+    cached->width(title, title_height);
+
+    EXPECT_THAT(cached->width(title, other_height), Eq(expected));
+}
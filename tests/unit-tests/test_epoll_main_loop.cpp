@@ -0,0 +1,1096 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/epoll_main_loop.h"
+#include "mir/time/steady_clock.h"
+
+#include "mir/test/signal.h"
+#include "mir/test/pipe.h"
+#include "mir/test/auto_unblock_thread.h"
+#include "mir/test/barrier.h"
+#include "mir_test_framework/process.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <thread>
+
+namespace mt = mir::test;
+
+namespace
+{
+
+template <typename T>
+std::vector<T> values_from_to(T f, T t)
+{
+    std::vector<T> v;
+    for (T i = f; i <= t; ++i)
+        v.push_back(i);
+    return v;
+}
+
+struct OnScopeExit
+{
+    ~OnScopeExit() { f(); }
+    std::function<void()> const f;
+};
+
+void execute_in_forked_process(
+    testing::Test* test,
+    std::function<void()> const& f,
+    std::function<void()> const& cleanup)
+{
+    auto const pid = fork();
+
+    if (!pid)
+    {
+        {
+            OnScopeExit on_scope_exit{cleanup};
+            f();
+        }
+        exit(test->HasFailure() ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
+    else
+    {
+        mir_test_framework::Process child{pid};
+        // Note: valgrind on armhf can very slow when dealing with forks,
+        // so give it enough time.
+        auto const result = child.wait_for_termination(std::chrono::seconds{30});
+        EXPECT_TRUE(result.succeeded());
+    }
+}
+
+struct EpollMainLoopTest : ::testing::Test
+{
+    mir::EpollMainLoop ml{std::make_shared<mir::time::SteadyClock>()};
+    std::function<void()> const destroy_epoll_main_loop{[this]{ ml.~EpollMainLoop(); }};
+};
+
+}
+
+TEST_F(EpollMainLoopTest, stops_from_within_handler)
+{
+    mt::Signal loop_finished;
+
+    mt::AutoJoinThread t{
+        [&]
+        {
+            int const owner{0};
+            ml.enqueue(&owner, [&] { ml.stop(); });
+            ml.run();
+            loop_finished.raise();
+        }};
+
+    EXPECT_TRUE(loop_finished.wait_for(std::chrono::seconds{5}));
+}
+
+TEST_F(EpollMainLoopTest, stops_from_outside_handler)
+{
+    mt::Signal loop_running;
+    mt::Signal loop_finished;
+
+    mt::AutoJoinThread t{
+        [&]
+        {
+            int const owner{0};
+            ml.enqueue(&owner, [&] { loop_running.raise(); });
+            ml.run();
+            loop_finished.raise();
+        }};
+
+    ASSERT_TRUE(loop_running.wait_for(std::chrono::seconds{5}));
+
+    ml.stop();
+
+    EXPECT_TRUE(loop_finished.wait_for(std::chrono::seconds{30}));
+}
+
+TEST_F(EpollMainLoopTest, ignores_handler_added_after_stop)
+{
+    int const owner{0};
+    bool handler_called{false};
+    mt::Signal loop_running;
+
+    std::thread t{
+        [&]
+        {
+            loop_running.wait();
+            ml.stop();
+            int const owner1{0};
+            ml.enqueue(&owner1, [&] { handler_called = true; });
+        }};
+
+    ml.enqueue(&owner, [&] { loop_running.raise(); });
+    ml.run();
+
+    t.join();
+
+    EXPECT_FALSE(handler_called);
+}
+
+TEST_F(EpollMainLoopTest, handles_signal)
+{
+    int const signum{SIGUSR1};
+    int handled_signum{0};
+
+    ml.register_signal_handler(
+        {signum},
+        [&handled_signum, this](int sig)
+        {
+           handled_signum = sig;
+           ml.stop();
+        });
+
+    kill(getpid(), signum);
+
+    ml.run();
+
+    ASSERT_EQ(signum, handled_signum);
+}
+
+TEST_F(EpollMainLoopTest, handles_multiple_signals)
+{
+    std::vector<int> const signals{SIGUSR1, SIGUSR2};
+    size_t const num_signals_to_send{10};
+    std::vector<int> handled_signals;
+    std::atomic<unsigned int> num_handled_signals{0};
+
+    ml.register_signal_handler(
+        {signals[0], signals[1]},
+        [&handled_signals, &num_handled_signals](int sig)
+        {
+           handled_signals.push_back(sig);
+           ++num_handled_signals;
+        });
+
+
+    std::thread signal_sending_thread(
+        [this, &signals, &num_handled_signals]
+        {
+            for (size_t i = 0; i < num_signals_to_send; i++)
+            {
+                kill(getpid(), signals[i % signals.size()]);
+                while (num_handled_signals <= i) std::this_thread::yield();
+            }
+            ml.stop();
+        });
+
+    ml.run();
+
+    signal_sending_thread.join();
+
+    ASSERT_EQ(num_signals_to_send, handled_signals.size());
+
+    for (size_t i = 0; i < num_signals_to_send; i++)
+        EXPECT_EQ(signals[i % signals.size()], handled_signals[i]) << " index " << i;
+}
+
+TEST_F(EpollMainLoopTest, invokes_all_registered_handlers_for_signal)
+{
+    using namespace testing;
+
+    int const signum{SIGUSR1};
+    std::vector<int> handled_signum{0,0,0};
+
+    ml.register_signal_handler(
+        {signum},
+        [&handled_signum, this](int sig)
+        {
+            handled_signum[0] = sig;
+            if (handled_signum[0] != 0 &&
+                handled_signum[1] != 0 &&
+                handled_signum[2] != 0)
+            {
+                ml.stop();
+            }
+        });
+
+    ml.register_signal_handler(
+        {signum},
+        [&handled_signum, this](int sig)
+        {
+            handled_signum[1] = sig;
+            if (handled_signum[0] != 0 &&
+                handled_signum[1] != 0 &&
+                handled_signum[2] != 0)
+            {
+                ml.stop();
+            }
+        });
+
+    ml.register_signal_handler(
+        {signum},
+        [&handled_signum, this](int sig)
+        {
+            handled_signum[2] = sig;
+            if (handled_signum[0] != 0 &&
+                handled_signum[1] != 0 &&
+                handled_signum[2] != 0)
+            {
+                ml.stop();
+            }
+        });
+
+    kill(getpid(), signum);
+
+    ml.run();
+
+    ASSERT_THAT(handled_signum, Each(signum));
+}
+
+TEST_F(EpollMainLoopTest, propagates_exception_from_signal_handler)
+{
+    // Execute in forked process to work around
+    // https://gcc.gnu.org/bugzilla/show_bug.cgi?id=61643
+    // causing subsequent tests to fail (e.g. MultiThreadedCompositor.*).
+    execute_in_forked_process(this,
+        [&]
+        {
+            int const signum{SIGUSR1};
+            ml.register_signal_handler(
+                {signum},
+                [&] (int) { throw std::runtime_error("signal handler error"); });
+
+            kill(getpid(), signum);
+
+            EXPECT_THROW({ ml.run(); }, std::runtime_error);
+        },
+        // Since we terminate the forked process with an exit() call, objects on
+        // the stack are not destroyed. We need to manually destroy the
+        // EpollMainLoop object to avoid fd leaks.
+        destroy_epoll_main_loop);
+}
+
+TEST_F(EpollMainLoopTest, handles_signal_with_unique_module_ptr_handler)
+{
+    int const signum{SIGUSR1};
+    int handled_signum{0};
+
+    ml.register_signal_handler(
+        {signum},
+        mir::make_module_ptr<std::function<void(int)>>(
+            [&handled_signum, this](int sig)
+            {
+               handled_signum = sig;
+               ml.stop();
+            }));
+
+    kill(getpid(), signum);
+
+    ml.run();
+
+    ASSERT_EQ(signum, handled_signum);
+}
+
+TEST_F(EpollMainLoopTest, handles_fd)
+{
+    mt::Pipe p;
+    char const data_to_write{'a'};
+    int handled_fd{0};
+    char data_read{0};
+
+    ml.register_fd_handler(
+        {p.read_fd()},
+        this,
+        [&handled_fd, &data_read, this](int fd)
+        {
+            handled_fd = fd;
+            EXPECT_EQ(1, read(fd, &data_read, 1));
+            ml.stop();
+        });
+
+    EXPECT_EQ(1, write(p.write_fd(), &data_to_write, 1));
+
+    ml.run();
+
+    EXPECT_EQ(data_to_write, data_read);
+}
+
+TEST_F(EpollMainLoopTest, multiple_fds_with_single_handler_handled)
+{
+    using namespace testing;
+
+    std::vector<mt::Pipe> const pipes(2);
+    size_t const num_elems_to_send{10};
+    std::vector<int> handled_fds;
+    std::vector<size_t> elems_read;
+    std::atomic<unsigned int> num_handled_fds{0};
+
+    ml.register_fd_handler(
+        {pipes[0].read_fd(), pipes[1].read_fd()},
+        this,
+        [&handled_fds, &elems_read, &num_handled_fds](int fd)
+        {
+            handled_fds.push_back(fd);
+
+            size_t i;
+            EXPECT_EQ(static_cast<ssize_t>(sizeof(i)),
+                      read(fd, &i, sizeof(i)));
+            elems_read.push_back(i);
+
+            ++num_handled_fds;
+        });
+
+    std::thread fd_writing_thread{
+        [this, &pipes, &num_handled_fds]
+        {
+            for (size_t i = 0; i < num_elems_to_send; i++)
+            {
+                EXPECT_EQ(static_cast<ssize_t>(sizeof(i)),
+                          write(pipes[i % pipes.size()].write_fd(), &i, sizeof(i)));
+                while (num_handled_fds <= i) std::this_thread::yield();
+            }
+            ml.stop();
+        }};
+
+    ml.run();
+
+    fd_writing_thread.join();
+
+    ASSERT_EQ(num_elems_to_send, handled_fds.size());
+    for (size_t i = 0; i < num_elems_to_send; i++)
+        EXPECT_EQ(pipes[i % pipes.size()].read_fd(), handled_fds[i]) << " index " << i;
+
+    EXPECT_THAT(elems_read, ContainerEq(values_from_to<size_t>(0, num_elems_to_send - 1)));
+}
+
+TEST_F(EpollMainLoopTest, multiple_fd_handlers_are_called)
+{
+    using namespace testing;
+
+    std::vector<mt::Pipe> const pipes(3);
+    std::vector<int> const elems_to_send{10,11,12};
+    std::vector<int> handled_fds{0,0,0};
+    std::vector<int> elems_read{0,0,0};
+
+    ml.register_fd_handler(
+        {pipes[0].read_fd()},
+        this,
+        [&handled_fds, &elems_read, this](int fd)
+        {
+            EXPECT_EQ(static_cast<ssize_t>(sizeof(elems_read[0])),
+                      read(fd, &elems_read[0], sizeof(elems_read[0])));
+            handled_fds[0] = fd;
+            if (handled_fds[0] != 0 &&
+                handled_fds[1] != 0 &&
+                handled_fds[2] != 0)
+            {
+                ml.stop();
+            }
+        });
+
+    ml.register_fd_handler(
+        {pipes[1].read_fd()},
+        this,
+        [&handled_fds, &elems_read, this](int fd)
+        {
+            EXPECT_EQ(static_cast<ssize_t>(sizeof(elems_read[1])),
+                      read(fd, &elems_read[1], sizeof(elems_read[1])));
+            handled_fds[1] = fd;
+            if (handled_fds[0] != 0 &&
+                handled_fds[1] != 0 &&
+                handled_fds[2] != 0)
+            {
+                ml.stop();
+            }
+        });
+
+    ml.register_fd_handler(
+        {pipes[2].read_fd()},
+        this,
+        [&handled_fds, &elems_read, this](int fd)
+        {
+            EXPECT_EQ(static_cast<ssize_t>(sizeof(elems_read[2])),
+                      read(fd, &elems_read[2], sizeof(elems_read[2])));
+            handled_fds[2] = fd;
+            if (handled_fds[0] != 0 &&
+                handled_fds[1] != 0 &&
+                handled_fds[2] != 0)
+            {
+                ml.stop();
+            }
+        });
+
+    EXPECT_EQ(static_cast<ssize_t>(sizeof(elems_to_send[0])),
+              write(pipes[0].write_fd(), &elems_to_send[0], sizeof(elems_to_send[0])));
+    EXPECT_EQ(static_cast<ssize_t>(sizeof(elems_to_send[1])),
+              write(pipes[1].write_fd(), &elems_to_send[1], sizeof(elems_to_send[1])));
+    EXPECT_EQ(static_cast<ssize_t>(sizeof(elems_to_send[2])),
+              write(pipes[2].write_fd(), &elems_to_send[2], sizeof(elems_to_send[2])));
+
+    ml.run();
+
+    EXPECT_THAT(handled_fds,
+                ElementsAre(
+                    pipes[0].read_fd(),
+                    pipes[1].read_fd(),
+                    pipes[2].read_fd()));
+
+    EXPECT_THAT(elems_read, ContainerEq(elems_to_send));
+}
+
+TEST_F(EpollMainLoopTest,
+       unregister_prevents_callback_and_does_not_harm_other_callbacks)
+{
+    mt::Pipe p1, p2;
+    char const data_to_write{'a'};
+    int p2_handler_executes{-1};
+    char data_read{0};
+
+    ml.register_fd_handler(
+        {p1.read_fd()},
+        this,
+        [this](int)
+        {
+            FAIL() << "unregistered handler called";
+            ml.stop();
+        });
+
+    ml.register_fd_handler(
+        {p2.read_fd()},
+        this+2,
+        [&p2_handler_executes,&data_read,this](int fd)
+        {
+            p2_handler_executes = fd;
+            EXPECT_EQ(1, read(fd, &data_read, 1));
+            ml.stop();
+        });
+
+    ml.unregister_fd_handler(this);
+
+    EXPECT_EQ(1, write(p1.write_fd(), &data_to_write, 1));
+    EXPECT_EQ(1, write(p2.write_fd(), &data_to_write, 1));
+
+    ml.run();
+
+    EXPECT_EQ(data_to_write, data_read);
+    EXPECT_EQ(p2.read_fd(), p2_handler_executes);
+}
+
+TEST_F(EpollMainLoopTest, unregister_does_not_close_fds)
+{
+    mt::Pipe p1, p2;
+    char const data_to_write{'b'};
+    char data_read{0};
+
+    ml.register_fd_handler(
+        {p1.read_fd()},
+        this,
+        [this](int)
+        {
+            FAIL() << "unregistered handler called";
+            ml.stop();
+        });
+
+    ml.unregister_fd_handler(this);
+
+    ml.register_fd_handler(
+        {p1.read_fd()},
+        this,
+        [this,&data_read](int fd)
+        {
+            EXPECT_EQ(1, read(fd, &data_read, 1));
+            ml.stop();
+        });
+
+    EXPECT_EQ(1, write(p1.write_fd(), &data_to_write, 1));
+
+    ml.run();
+
+    EXPECT_EQ(data_to_write, data_read);
+}
+
+TEST_F(EpollMainLoopTest, propagates_exception_from_fd_handler)
+{
+    // Execute in forked process to work around
+    // https://gcc.gnu.org/bugzilla/show_bug.cgi?id=61643
+    // causing subsequent tests to fail (e.g. MultiThreadedCompositor.*)
+    execute_in_forked_process(this,
+        [&]
+        {
+            mt::Pipe p;
+            char const data_to_write{'a'};
+
+            ml.register_fd_handler(
+                {p.read_fd()},
+                this,
+                [] (int) { throw std::runtime_error("fd handler error"); });
+
+            EXPECT_EQ(1, write(p.write_fd(), &data_to_write, 1));
+
+            EXPECT_THROW({ ml.run(); }, std::runtime_error);
+        },
+        // Since we terminate the forked process with an exit() call, objects on
+        // the stack are not destroyed. We need to manually destroy the
+        // EpollMainLoop object to avoid fd leaks.
+        destroy_epoll_main_loop);
+}
+
+TEST_F(EpollMainLoopTest, can_unregister_fd_from_within_fd_handler)
+{
+    mt::Pipe p1;
+
+    ml.register_fd_handler(
+        {p1.read_fd()},
+        this,
+        [this](int)
+        {
+            ml.unregister_fd_handler(this);
+            ml.stop();
+        });
+
+    EXPECT_EQ(1, write(p1.write_fd(), "a", 1));
+
+    ml.run();
+}
+
+TEST_F(EpollMainLoopTest, handles_fd_with_unique_module_ptr_handler)
+{
+    mt::Pipe p;
+    char const data_to_write{'a'};
+    int handled_fd{0};
+    char data_read{0};
+
+    ml.register_fd_handler(
+        {p.read_fd()},
+        this,
+        mir::make_module_ptr<std::function<void(int)>>(
+            [&handled_fd, &data_read, this](int fd)
+            {
+                handled_fd = fd;
+                EXPECT_EQ(1, read(fd, &data_read, 1));
+                ml.stop();
+            }));
+
+    EXPECT_EQ(1, write(p.write_fd(), &data_to_write, 1));
+
+    ml.run();
+
+    EXPECT_EQ(data_to_write, data_read);
+}
+
+TEST_F(EpollMainLoopTest, dispatches_action)
+{
+    using namespace testing;
+
+    int num_actions{0};
+    int const owner{0};
+
+    ml.enqueue(
+        &owner,
+        [&]
+        {
+            ++num_actions;
+            ml.stop();
+        });
+
+    ml.run();
+
+    EXPECT_THAT(num_actions, Eq(1));
+}
+
+TEST_F(EpollMainLoopTest, dispatches_multiple_actions_in_order)
+{
+    using namespace testing;
+
+    int const num_actions{5};
+    std::vector<int> actions;
+    int const owner{0};
+
+    for (int i = 0; i < num_actions; ++i)
+    {
+        ml.enqueue(
+            &owner,
+            [&,i]
+            {
+                actions.push_back(i);
+                if (i == num_actions - 1)
+                    ml.stop();
+            });
+    }
+
+    ml.run();
+
+    EXPECT_THAT(actions, ContainerEq(values_from_to(0, num_actions - 1)));
+}
+
+TEST_F(EpollMainLoopTest, does_not_dispatch_paused_actions)
+{
+    using namespace testing;
+
+    std::vector<int> actions;
+    int const owner1{0};
+    int const owner2{0};
+
+    ml.enqueue(
+        &owner1,
+        [&]
+        {
+            int const id = 0;
+            actions.push_back(id);
+        });
+
+    ml.enqueue(
+        &owner2,
+        [&]
+        {
+            int const id = 1;
+            actions.push_back(id);
+        });
+
+    ml.enqueue(
+        &owner1,
+        [&]
+        {
+            int const id = 2;
+            actions.push_back(id);
+        });
+
+    ml.enqueue(
+        &owner2,
+        [&]
+        {
+            int const id = 3;
+            actions.push_back(id);
+            ml.stop();
+        });
+
+    ml.pause_processing_for(&owner1);
+
+    ml.run();
+
+    EXPECT_THAT(actions, ElementsAre(1, 3));
+}
+
+TEST_F(EpollMainLoopTest, dispatches_actions_resumed_from_within_another_action)
+{
+    using namespace testing;
+
+    std::vector<int> actions;
+    void const* const owner1_ptr{&actions};
+    int const owner2{0};
+
+    ml.enqueue(
+        owner1_ptr,
+        [&]
+        {
+            int const id = 0;
+            actions.push_back(id);
+            ml.stop();
+        });
+
+    ml.enqueue(
+        &owner2,
+        [&]
+        {
+            int const id = 1;
+            actions.push_back(id);
+            ml.resume_processing_for(owner1_ptr);
+        });
+
+    ml.pause_processing_for(owner1_ptr);
+
+    ml.run();
+
+    EXPECT_THAT(actions, ElementsAre(1, 0));
+}
+
+TEST_F(EpollMainLoopTest, handles_enqueue_from_within_action)
+{
+    using namespace testing;
+
+    std::vector<int> actions;
+    int const num_actions{10};
+    void const* const owner{&num_actions};
+
+    ml.enqueue(
+        owner,
+        [&]
+        {
+            int const id = 0;
+            actions.push_back(id);
+
+            for (int i = 1; i < num_actions; ++i)
+            {
+                ml.enqueue(
+                    owner,
+                    [&,i]
+                    {
+                        actions.push_back(i);
+                        if (i == num_actions - 1)
+                            ml.stop();
+                    });
+            }
+        });
+
+    ml.run();
+
+    EXPECT_THAT(actions, ContainerEq(values_from_to(0, num_actions - 1)));
+}
+
+TEST_F(EpollMainLoopTest, dispatches_actions_resumed_externally)
+{
+    using namespace testing;
+
+    std::vector<int> actions;
+    void const* const owner1_ptr{&actions};
+    int const owner2{0};
+    mt::Signal action_with_id_1_done;
+
+    ml.enqueue(
+        owner1_ptr,
+        [&]
+        {
+            int const id = 0;
+            actions.push_back(id);
+            ml.stop();
+        });
+
+    ml.enqueue(
+        &owner2,
+        [&]
+        {
+            int const id = 1;
+            actions.push_back(id);
+            action_with_id_1_done.raise();
+        });
+
+    ml.pause_processing_for(owner1_ptr);
+
+    std::thread t{
+        [&]
+        {
+            action_with_id_1_done.wait_for(std::chrono::seconds{5});
+            ml.resume_processing_for(owner1_ptr);
+        }};
+
+    ml.run();
+
+    t.join();
+
+    EXPECT_TRUE(action_with_id_1_done.raised());
+    EXPECT_THAT(actions, ElementsAre(1, 0));
+}
+
+TEST_F(EpollMainLoopTest, propagates_exception_from_server_action)
+{
+    // Execute in forked process to work around
+    // https://gcc.gnu.org/bugzilla/show_bug.cgi?id=61643
+    // causing subsequent tests to fail (e.g. MultiThreadedCompositor.*)
+    execute_in_forked_process(this,
+        [&]
+        {
+            ml.enqueue(this, [] { throw std::runtime_error("server action error"); });
+
+            EXPECT_THROW({ ml.run(); }, std::runtime_error);
+        },
+        // Since we terminate the forked process with an exit() call, objects on
+        // the stack are not destroyed. We need to manually destroy the
+        // EpollMainLoop object to avoid fd leaks.
+        destroy_epoll_main_loop);
+}
+
+TEST_F(EpollMainLoopTest, can_be_rerun_after_exception)
+{
+    // Execute in forked process to work around
+    // https://gcc.gnu.org/bugzilla/show_bug.cgi?id=61643
+    // causing subsequent tests to fail (e.g. MultiThreadedCompositor.*)
+    execute_in_forked_process(this,
+        [&]
+        {
+            ml.enqueue(this, [] { throw std::runtime_error("server action exception"); });
+
+            EXPECT_THROW({
+                ml.run();
+            }, std::runtime_error);
+
+            ml.enqueue(this, [&] { ml.stop(); });
+            ml.run();
+        },
+        // Since we terminate the forked process with an exit() call, objects on
+        // the stack are not destroyed. We need to manually destroy the
+        // EpollMainLoop object to avoid fd leaks.
+        destroy_epoll_main_loop);
+}
+
+TEST_F(EpollMainLoopTest, enqueue_with_guaranteed_execution_executes_before_run)
+{
+    using namespace testing;
+
+    int num_actions{0};
+
+    ml.enqueue_with_guaranteed_execution(
+        [&num_actions]
+        {
+            ++num_actions;
+        });
+
+    EXPECT_THAT(num_actions, Eq(1));
+}
+
+TEST_F(EpollMainLoopTest, enqueue_with_guaranteed_execution_executes_after_stop)
+{
+    using namespace testing;
+
+    int num_actions{0};
+
+    ml.enqueue(
+        nullptr,
+        [this]()
+        {
+            ml.stop();
+        });
+
+    ml.run();
+
+    ml.enqueue_with_guaranteed_execution(
+        [&num_actions]
+        {
+            ++num_actions;
+        });
+
+    EXPECT_THAT(num_actions, Eq(1));
+}
+
+TEST_F(EpollMainLoopTest, enqueue_with_guaranteed_execution_can_be_called_from_guaranteed_action)
+{
+    using namespace testing;
+
+    int num_actions{0};
+
+    ml.enqueue_with_guaranteed_execution(
+        [this, &num_actions]
+        {
+            ++num_actions;
+            ml.enqueue_with_guaranteed_execution(
+                [&num_actions]
+                {
+                    ++num_actions;
+                });
+        });
+
+    EXPECT_THAT(num_actions, Eq(2));
+}
+
+TEST_F(EpollMainLoopTest, enqueue_with_guaranteed_execution_can_be_called_from_action_run_on_halt)
+{
+    using namespace testing;
+
+    mt::Signal loop_running;
+    mt::Signal loop_finished;
+    std::atomic<int> num_actions{0};
+
+    ml.enqueue(
+        nullptr,
+        [&loop_running]() { loop_running.raise(); });
+
+    mt::AutoJoinThread t{
+        [&]
+        {
+            ml.run();
+            loop_finished.raise();
+        }};
+
+    ASSERT_TRUE(loop_running.wait_for(std::chrono::seconds{5}));
+
+    ml.pause_processing_for(nullptr);
+    ml.enqueue_with_guaranteed_execution(
+        [this, &num_actions]
+        {
+            ++num_actions;
+            ml.enqueue_with_guaranteed_execution(
+                [&num_actions]
+                {
+                    ++num_actions;
+                });
+        });
+
+    ml.stop();
+
+    ASSERT_TRUE(loop_finished.wait_for(std::chrono::seconds{30}));
+    EXPECT_THAT(num_actions, Eq(2));
+}
+
+TEST_F(EpollMainLoopTest, enqueue_with_guaranteed_execution_executes_on_mainloop)
+{
+    using namespace testing;
+
+    mt::Signal loop_running;
+    mt::Signal loop_finished;
+
+    ml.enqueue(
+        nullptr,
+        [&loop_running]() { loop_running.raise(); });
+
+    mt::AutoJoinThread t{
+        [&]
+        {
+            ml.run();
+            loop_finished.raise();
+        }};
+
+    ASSERT_TRUE(loop_running.wait_for(std::chrono::seconds{5}));
+
+    ml.enqueue_with_guaranteed_execution(
+        [main_thread = std::this_thread::get_id()]()
+        {
+            EXPECT_THAT(std::this_thread::get_id(), Ne(main_thread));
+        });
+
+    ml.stop();
+
+    EXPECT_TRUE(loop_finished.wait_for(std::chrono::seconds{30}));
+}
+
+namespace
+{
+struct UnblockMainLoop : mt::AutoUnblockThread
+{
+    UnblockMainLoop(mir::EpollMainLoop& loop)
+        : mt::AutoUnblockThread([&loop]() {loop.stop();},
+                                [&loop]() {loop.run();})
+    {}
+};
+}
+
+TEST_F(EpollMainLoopTest, alarm_fires_on_main_loop_thread)
+{
+    using namespace testing;
+
+    UnblockMainLoop unblocker{ml};
+
+    mt::Signal loop_running;
+    std::thread::id loop_thread;
+    ml.enqueue(this, [&] { loop_thread = std::this_thread::get_id(); loop_running.raise(); });
+    ASSERT_TRUE(loop_running.wait_for(std::chrono::seconds{5}));
+
+    mt::Signal alarm_fired;
+    std::thread::id alarm_thread;
+    auto const alarm = ml.create_alarm([&] { alarm_thread = std::this_thread::get_id(); alarm_fired.raise(); });
+    alarm->reschedule_in(std::chrono::milliseconds{10});
+
+    ASSERT_TRUE(alarm_fired.wait_for(std::chrono::seconds{5}));
+    EXPECT_THAT(alarm_thread, Eq(loop_thread));
+    EXPECT_THAT(alarm->state(), Eq(mir::time::Alarm::triggered));
+}
+
+TEST_F(EpollMainLoopTest, cancelled_alarm_doesnt_fire)
+{
+    using namespace testing;
+
+    UnblockMainLoop unblocker{ml};
+
+    auto const alarm = ml.create_alarm([] { FAIL() << "Alarm handler of cancelled alarm called"; });
+    alarm->reschedule_in(std::chrono::milliseconds{50});
+    EXPECT_TRUE(alarm->cancel());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds{100});
+    EXPECT_THAT(alarm->state(), Eq(mir::time::Alarm::cancelled));
+}
+
+TEST_F(EpollMainLoopTest, propagates_exception_from_alarm)
+{
+    execute_in_forked_process(this,
+        [&]
+        {
+            auto const alarm = ml.create_alarm([] { throw std::runtime_error("Alarm error"); });
+            alarm->reschedule_in(std::chrono::milliseconds{10});
+
+            EXPECT_THROW({ ml.run(); }, std::runtime_error);
+        },
+        destroy_epoll_main_loop);
+}
+
+TEST_F(EpollMainLoopTest, stress_emits_alarm_notification_with_zero_timeout)
+{
+    UnblockMainLoop unblocker{ml};
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        mt::Signal notification_called;
+
+        auto alarm = ml.create_alarm([&]{ notification_called.raise(); });
+        alarm->reschedule_in(std::chrono::milliseconds{0});
+
+        EXPECT_TRUE(notification_called.wait_for(std::chrono::seconds{15}));
+    }
+}
+
+TEST_F(EpollMainLoopTest, running_returns_false_when_not_running)
+{
+    EXPECT_FALSE(ml.running());
+}
+
+TEST_F(EpollMainLoopTest, running_returns_true_from_ml)
+{
+    UnblockMainLoop unblocker{ml};
+
+    auto signal = std::make_shared<mt::Signal>();
+    ml.spawn(
+        [signal, this]()
+        {
+            EXPECT_TRUE(ml.running());
+            signal->raise();
+        });
+
+    EXPECT_TRUE(signal->wait_for(std::chrono::seconds{30}));
+}
+
+TEST_F(EpollMainLoopTest, running_returns_true_from_outside_ml_while_running)
+{
+    UnblockMainLoop unblocker{ml};
+
+    auto signal = std::make_shared<mt::Signal>();
+    ml.spawn(
+        [signal]()
+        {
+            signal->raise();
+        });
+
+    ASSERT_TRUE(signal->wait_for(std::chrono::seconds{30}));
+    EXPECT_TRUE(ml.running());
+}
+
+TEST_F(EpollMainLoopTest, running_returns_false_after_stopping)
+{
+    UnblockMainLoop unblocker{ml};
+
+    auto started = std::make_shared<mt::Signal>();
+    ml.spawn(
+        [started]()
+        {
+            started->raise();
+        });
+
+    ASSERT_TRUE(started->wait_for(std::chrono::seconds{30}));
+
+    auto stopped = std::make_shared<mt::Signal>();
+    ml.stop();
+    /*
+     * We rely on this source being enqueued after the ::stop() source:
+     * Either the ml.stop() has been processed, and this runs immediately, or
+     * it is queued and run during ml.stop() proccessing.
+     */
+    ml.enqueue_with_guaranteed_execution(
+        [stopped]()
+        {
+            stopped->raise();
+        });
+
+    ASSERT_TRUE(stopped->wait_for(std::chrono::seconds{30}));
+    EXPECT_FALSE(ml.running());
+}
@@ -1690,3 +1690,53 @@ TEST(GLibMainLoopForkTest, handles_signals_when_created_in_forked_process)
     auto const no_cleanup = []{};
     execute_in_forked_process(this, [&] { check_mainloop_signal_handling(); }, no_cleanup);
 }
+
+namespace
+{
+struct GLibMainLoopTimerWheelAlarmTest : ::testing::Test
+{
+    mir::GLibMainLoop ml{
+        std::make_shared<mir::time::SteadyClock>(),
+        mir::GLibMainLoop::AlarmStrategy::timer_wheel};
+};
+}
+
+TEST_F(GLibMainLoopTimerWheelAlarmTest, alarm_fires_on_main_loop_thread)
+{
+    using namespace std::literals::chrono_literals;
+
+    std::thread::id loop_thread_id;
+    mt::Signal loop_running;
+    ml.enqueue(this, [&] { loop_thread_id = std::this_thread::get_id(); loop_running.raise(); });
+
+    UnblockMainLoop unblocker{ml};
+    ASSERT_TRUE(loop_running.wait_for(10s));
+
+    mt::Signal alarm_fired;
+    std::thread::id alarm_thread_id;
+    auto const alarm = ml.create_alarm(
+        [&]
+        {
+            alarm_thread_id = std::this_thread::get_id();
+            alarm_fired.raise();
+        });
+
+    alarm->reschedule_in(10ms);
+
+    EXPECT_TRUE(alarm_fired.wait_for(10s));
+    EXPECT_THAT(alarm->state(), testing::Eq(mir::time::Alarm::triggered));
+    EXPECT_THAT(alarm_thread_id, testing::Eq(loop_thread_id));
+}
+
+TEST_F(GLibMainLoopTimerWheelAlarmTest, propagates_exception_from_alarm)
+{
+    execute_in_forked_process(this,
+        [&]
+        {
+            auto alarm = ml.create_alarm([] { throw std::runtime_error("alarm error"); });
+            alarm->reschedule_in(std::chrono::milliseconds{0});
+
+            EXPECT_THROW({ ml.run(); }, std::runtime_error);
+        },
+        [this]{ ml.~GLibMainLoop(); });
+}
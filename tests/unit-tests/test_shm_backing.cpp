@@ -26,7 +26,10 @@
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
+#include <atomic>
 #include <system_error>
+#include <thread>
+#include <vector>
 #include <unistd.h>
 
 namespace mtf = mir_test_framework;
@@ -336,6 +339,44 @@ TEST(ShmBacking, access_fault_is_true_after_invaild_write)
     EXPECT_TRUE(map->access_fault());
 }
 
+TEST(ShmBacking, invalid_accesses_from_concurrent_threads_are_all_prevented)
+{
+    using namespace testing;
+
+    size_t const page_size = sysconf(_SC_PAGE_SIZE);
+    int const thread_count{8};
+    int const iterations{50};
+
+    std::atomic<int> faults_prevented{0};
+    std::vector<std::thread> threads;
+    for (auto i = 0; i != thread_count; ++i)
+    {
+        threads.emplace_back(
+            [&]()
+            {
+                for (auto j = 0; j != iterations; ++j)
+                {
+                    // Each thread lies about its own backing, so every fault is in a range it mapped
+                    auto backing = mir::shm::rw_pool_from_fd(make_shm_fd(page_size), 2 * page_size);
+                    auto range = backing->get_rw_range(page_size, page_size);
+                    auto map = range->map_ro();
+
+                    if ((*map)[0] == std::byte{0} && (*map)[page_size - 1] == std::byte{0} && map->access_fault())
+                    {
+                        ++faults_prevented;
+                    }
+                }
+            });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_THAT(faults_prevented, Eq(thread_count * iterations));
+}
+
 TEST(ShmBacking, access_into_invalid_range_works_even_after_backing_destroyed)
 {
     using namespace testing;
@@ -407,6 +448,37 @@ TEST(ShmBacking, doesnt_install_sigbus_handler_when_backing_is_safe)
     EXPECT_THAT(new_sigbus_handler, SignalHandlerIsEqual(initial_sigbus_handler));
 }
 
+TEST(ShmBacking, reinstalls_sigbus_handler_if_it_has_been_replaced)
+{
+    using namespace testing;
+
+    size_t const shm_size = sysconf(_SC_PAGE_SIZE);
+    size_t const claimed_size = shm_size + 1;    // Lie about our backing size
+    auto shm_fd = make_shm_fd(shm_size);
+    auto backing = mir::shm::rw_pool_from_fd(shm_fd, claimed_size);
+
+    auto range = backing->get_rw_range(0, claimed_size);
+
+    // Install our SIGBUS handler, then have something else replace it
+    range->map_ro();
+    struct sigaction replacement{};
+    replacement.sa_handler = SIG_DFL;
+    struct sigaction ours;
+    sigaction(SIGBUS, &replacement, &ours);
+
+    auto map = range->map_ro();
+
+    for (auto const& a : *map)
+    {
+        EXPECT_THAT(a, Eq(std::byte{0}));
+    }
+    EXPECT_TRUE(map->access_fault());
+
+    struct sigaction current;
+    sigaction(SIGBUS, nullptr, &current);
+    EXPECT_THAT(current, SignalHandlerIsEqual(ours));
+}
+
 TEST(ShmBacking, can_resize_pool)
 {
     using namespace testing;
@@ -498,6 +570,66 @@ TEST(ShmBacking, mapping_remains_valid_after_resize)
     }
 }
 
+TEST(ShmBacking, mappings_remain_valid_over_repeated_growth)
+{
+    using namespace testing;
+
+    size_t const page_size = sysconf(_SC_PAGE_SIZE);
+    size_t const initial_size = 4000;   // Deliberately not a multiple of the page size
+
+    auto shm_fd = make_shm_fd(initial_size);
+    auto backing = mir::shm::rw_pool_from_fd(shm_fd, initial_size);
+
+    std::vector<std::unique_ptr<mir::shm::Mapping<std::byte>>> maps;
+    maps.push_back(backing->get_rw_range(0, initial_size)->map_rw());
+    (*maps.back())[0] = std::byte{1};
+
+    size_t size = initial_size;
+    for (auto i = 2; i != 10; ++i)
+    {
+        size += page_size / 2;
+        if (ftruncate(shm_fd, size) == -1)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to resize shm fd"}));
+        }
+        backing->resize(size);
+
+        maps.push_back(backing->get_rw_range(0, size)->map_rw());
+        (*maps.back())[size - 1] = static_cast<std::byte>(i);
+    }
+
+    // Every mapping sees the writes made through every other
+    for (auto const& map : maps)
+    {
+        EXPECT_THAT((*map)[0], Eq(std::byte{1}));
+        EXPECT_FALSE(map->access_fault());
+    }
+    EXPECT_THAT((*maps.front())[initial_size - 1], Eq((*maps.back())[initial_size - 1]));
+    EXPECT_THAT((*maps.back())[size - 1], Eq(std::byte{9}));
+}
+
+// A client can grow its pool a byte at a time; that must not build up state per resize
+TEST(ShmBacking, can_be_destroyed_after_many_tiny_resizes)
+{
+    size_t const initial_size = 100000;
+    size_t const resizes = 100000;
+
+    auto shm_fd = make_shm_fd(initial_size + resizes);
+    auto backing = mir::shm::rw_pool_from_fd(shm_fd, initial_size);
+
+    for (size_t size = initial_size + 1; size <= initial_size + resizes; ++size)
+    {
+        backing->resize(size);
+    }
+
+    auto const map = backing->get_rw_range(0, initial_size + resizes)->map_rw();
+    (*map)[initial_size + resizes - 1] = std::byte{42};
+
+    backing.reset();
+
+    EXPECT_THAT((*map)[initial_size + resizes - 1], testing::Eq(std::byte{42}));
+}
+
 TEST(ShmBacking, resize_rechecks_backing_size)
 {
     using namespace testing;
@@ -0,0 +1,329 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/time/timer_wheel.h"
+#include "mir/time/steady_clock.h"
+
+#include "mir/test/signal.h"
+#include "mir/test/doubles/advanceable_clock.h"
+#include "mir/test/doubles/mock_lockable_callback.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <poll.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace mt = mir::test;
+namespace mtd = mir::test::doubles;
+using namespace std::chrono_literals;
+using namespace testing;
+
+namespace
+{
+struct TimerWheelTest : Test
+{
+    std::shared_ptr<mtd::AdvanceableClock> const clock = std::make_shared<mtd::AdvanceableClock>();
+    int exceptions{0};
+    mir::time::TimerWheel wheel{clock, [this] { ++exceptions; }};
+
+    void advance_by(mir::time::Duration step)
+    {
+        clock->advance_by(step);
+        wheel.dispatch(mir::dispatch::FdEvent::readable);
+    }
+
+    /// Advance in small steps so that every tick of the wheel is visited
+    void advance_in_steps(mir::time::Duration total, mir::time::Duration step)
+    {
+        for (mir::time::Duration elapsed{0}; elapsed < total; elapsed += step)
+            advance_by(step);
+    }
+};
+}
+
+TEST_F(TimerWheelTest, alarm_starts_in_cancelled_state)
+{
+    auto const alarm = wheel.create_alarm([]{});
+
+    EXPECT_THAT(alarm->state(), Eq(mir::time::Alarm::cancelled));
+}
+
+TEST_F(TimerWheelTest, alarm_fires_at_correct_time_point)
+{
+    int calls{0};
+    auto const alarm = wheel.create_alarm([&]{ ++calls; });
+    alarm->reschedule_in(120ms);
+
+    advance_by(119ms);
+    EXPECT_THAT(alarm->state(), Eq(mir::time::Alarm::pending));
+    EXPECT_THAT(calls, Eq(0));
+
+    advance_by(1ms);
+    EXPECT_THAT(alarm->state(), Eq(mir::time::Alarm::triggered));
+    EXPECT_THAT(calls, Eq(1));
+}
+
+TEST_F(TimerWheelTest, alarm_never_fires_early_for_sub_tick_delays)
+{
+    auto const alarm = wheel.create_alarm([]{});
+    alarm->reschedule_for(clock->now() + 1500us);
+
+    advance_by(1ms);
+    EXPECT_THAT(alarm->state(), Eq(mir::time::Alarm::pending));
+
+    advance_by(1ms);
+    EXPECT_THAT(alarm->state(), Eq(mir::time::Alarm::triggered));
+}
+
+TEST_F(TimerWheelTest, alarms_fire_across_every_level_of_the_wheel)
+{
+    std::vector<std::chrono::milliseconds> const delays{
+        1ms, 63ms, 64ms, 65ms, 4095ms, 4096ms, 4097ms, 262143ms, 262144ms, 262145ms};
+
+    std::vector<std::unique_ptr<mir::time::Alarm>> alarms;
+    std::vector<mir::time::Timestamp> fired_at(delays.size());
+    auto const start = clock->now();
+
+    for (auto i = 0u; i != delays.size(); ++i)
+    {
+        alarms.push_back(wheel.create_alarm([&, i] { fired_at[i] = clock->now(); }));
+        alarms.back()->reschedule_in(delays[i]);
+    }
+
+    advance_in_steps(delays.back() + 1ms, 1ms);
+
+    for (auto i = 0u; i != delays.size(); ++i)
+    {
+        EXPECT_THAT(alarms[i]->state(), Eq(mir::time::Alarm::triggered)) << "delay: " << delays[i].count();
+        EXPECT_THAT(fired_at[i] - start, Eq(delays[i])) << "delay: " << delays[i].count();
+    }
+}
+
+TEST_F(TimerWheelTest, alarms_beyond_the_wheel_span_fire)
+{
+    auto const alarm = wheel.create_alarm([]{});
+    alarm->reschedule_in(std::chrono::hours{6});
+
+    advance_in_steps(std::chrono::hours{6} - 1s, 1s);
+    EXPECT_THAT(alarm->state(), Eq(mir::time::Alarm::pending));
+
+    advance_in_steps(1s, 1ms);
+    EXPECT_THAT(alarm->state(), Eq(mir::time::Alarm::triggered));
+}
+
+TEST_F(TimerWheelTest, alarms_due_on_a_skipped_tick_fire_on_next_dispatch)
+{
+    auto const alarm = wheel.create_alarm([]{});
+    alarm->reschedule_in(5000ms);
+
+    advance_by(10min);
+
+    EXPECT_THAT(alarm->state(), Eq(mir::time::Alarm::triggered));
+}
+
+TEST_F(TimerWheelTest, alarms_due_together_are_dispatched_together)
+{
+    int const alarm_count{1000};
+    int calls{0};
+    std::vector<std::unique_ptr<mir::time::Alarm>> alarms;
+
+    for (auto i = 0; i != alarm_count; ++i)
+    {
+        alarms.push_back(wheel.create_alarm([&]{ ++calls; }));
+        alarms.back()->reschedule_for(clock->now() + 100ms + std::chrono::microseconds{i % 1000});
+    }
+
+    advance_by(101ms);
+
+    EXPECT_THAT(calls, Eq(alarm_count));
+}
+
+TEST_F(TimerWheelTest, cancelled_alarm_doesnt_fire)
+{
+    auto const alarm = wheel.create_alarm([]{ FAIL() << "Alarm handler of cancelled alarm called"; });
+    alarm->reschedule_in(100ms);
+
+    EXPECT_TRUE(alarm->cancel());
+    EXPECT_THAT(alarm->state(), Eq(mir::time::Alarm::cancelled));
+
+    advance_by(100ms);
+    EXPECT_THAT(alarm->state(), Eq(mir::time::Alarm::cancelled));
+}
+
+TEST_F(TimerWheelTest, destroyed_alarm_doesnt_fire)
+{
+    auto alarm = wheel.create_alarm([]{ FAIL() << "Alarm handler of destroyed alarm called"; });
+    alarm->reschedule_in(200ms);
+
+    alarm.reset();
+    advance_by(200ms);
+}
+
+TEST_F(TimerWheelTest, rescheduled_alarm_cancels_previous_scheduling)
+{
+    int calls{0};
+    auto const alarm = wheel.create_alarm([&]{ ++calls; });
+    alarm->reschedule_in(100ms);
+
+    advance_by(90ms);
+    EXPECT_TRUE(alarm->reschedule_in(100ms));
+
+    advance_by(20ms);
+    EXPECT_THAT(calls, Eq(0));
+    EXPECT_THAT(alarm->state(), Eq(mir::time::Alarm::pending));
+
+    advance_by(80ms);
+    EXPECT_THAT(calls, Eq(1));
+    EXPECT_THAT(alarm->state(), Eq(mir::time::Alarm::triggered));
+}
+
+TEST_F(TimerWheelTest, reschedule_returns_false_when_it_didnt_reset_a_previous_schedule)
+{
+    auto const alarm = wheel.create_alarm([]{});
+
+    EXPECT_FALSE(alarm->reschedule_in(5s));
+    advance_by(5s);
+    EXPECT_FALSE(alarm->reschedule_in(5s));
+}
+
+TEST_F(TimerWheelTest, cancelling_a_triggered_alarm_has_no_effect)
+{
+    auto const alarm = wheel.create_alarm([]{});
+    alarm->reschedule_in(0ms);
+    advance_by(1ms);
+
+    EXPECT_FALSE(alarm->cancel());
+    EXPECT_THAT(alarm->state(), Eq(mir::time::Alarm::triggered));
+}
+
+TEST_F(TimerWheelTest, alarm_callback_preserves_lock_ordering)
+{
+    auto handler = std::make_unique<mtd::MockLockableCallback>();
+    {
+        InSequence s;
+        EXPECT_CALL(*handler, lock());
+        EXPECT_CALL(*handler, functor());
+        EXPECT_CALL(*handler, unlock());
+    }
+
+    auto const alarm = wheel.create_alarm(std::move(handler));
+    alarm->reschedule_in(10ms);
+    advance_by(11ms);
+}
+
+TEST_F(TimerWheelTest, can_reschedule_alarm_from_within_alarm_callback)
+{
+    int calls{0};
+    std::unique_ptr<mir::time::Alarm> alarm;
+    alarm = wheel.create_alarm(
+        [&]
+        {
+            if (++calls < 3)
+                alarm->reschedule_in(10ms);
+        });
+    alarm->reschedule_in(10ms);
+
+    advance_in_steps(50ms, 5ms);
+
+    EXPECT_THAT(calls, Eq(3));
+}
+
+TEST_F(TimerWheelTest, can_cancel_and_destroy_alarm_from_callback)
+{
+    mir::time::Alarm* raw_alarm{nullptr};
+    bool called{false};
+    auto alarm = wheel.create_alarm(
+        [&]
+        {
+            raw_alarm->cancel();
+            delete raw_alarm;
+            called = true;
+        });
+    alarm->reschedule_in(0ms);
+    raw_alarm = alarm.release();
+
+    advance_by(1ms);
+
+    EXPECT_TRUE(called);
+}
+
+TEST_F(TimerWheelTest, exception_from_callback_is_reported_and_other_alarms_still_fire)
+{
+    bool called{false};
+    auto const throwing = wheel.create_alarm([]{ throw std::runtime_error{"alarm error"}; });
+    auto const other = wheel.create_alarm([&]{ called = true; });
+    throwing->reschedule_in(10ms);
+    other->reschedule_in(10ms);
+
+    advance_by(10ms);
+
+    EXPECT_THAT(exceptions, Eq(1));
+    EXPECT_TRUE(called);
+}
+
+TEST(TimerWheelFdTest, watch_fd_becomes_readable_when_alarm_is_due)
+{
+    mir::time::TimerWheel wheel{std::make_shared<mir::time::SteadyClock>(), []{}};
+
+    mt::Signal fired;
+    auto const alarm = wheel.create_alarm([&]{ fired.raise(); });
+
+    auto const start = std::chrono::steady_clock::now();
+    alarm->reschedule_in(20ms);
+
+    while (!fired.raised())
+    {
+        pollfd fd{wheel.watch_fd(), POLLIN, 0};
+        ASSERT_THAT(poll(&fd, 1, 5000), Gt(0));
+        wheel.dispatch(mir::dispatch::FdEvent::readable);
+    }
+
+    EXPECT_THAT(std::chrono::steady_clock::now() - start, Ge(20ms));
+}
+
+TEST(TimerWheelFdTest, cancel_blocks_until_in_progress_callback_completes)
+{
+    mir::time::TimerWheel wheel{std::make_shared<mir::time::SteadyClock>(), []{}};
+
+    mt::Signal in_callback;
+    std::atomic<bool> callback_complete{false};
+    auto const alarm = wheel.create_alarm(
+        [&]
+        {
+            in_callback.raise();
+            std::this_thread::sleep_for(100ms);
+            callback_complete = true;
+        });
+    alarm->reschedule_in(0ms);
+
+    std::thread dispatcher{
+        [&]
+        {
+            pollfd fd{wheel.watch_fd(), POLLIN, 0};
+            poll(&fd, 1, 5000);
+            wheel.dispatch(mir::dispatch::FdEvent::readable);
+        }};
+
+    ASSERT_TRUE(in_callback.wait_for(5s));
+    alarm->cancel();
+    EXPECT_TRUE(callback_complete);
+
+    dispatcher.join();
+}
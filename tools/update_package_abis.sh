@@ -23,6 +23,7 @@ packages="\
     mir-platform-input-evdev:MIR_SERVER_INPUT_PLATFORM_ABI\
     libmirwayland:MIRWAYLAND_ABI\
     mir-platform-graphics-wayland:MIR_SERVER_GRAPHICS_PLATFORM_ABI\
+    mir-platform-graphics-virtual:MIR_SERVER_GRAPHICS_PLATFORM_ABI\
     mir-platform-rendering-egl-generic:MIR_SERVER_GRAPHICS_PLATFORM_ABI"
 
 package_name()